@@ -1,6 +1,8 @@
 #include "agent/agent_loop.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
@@ -14,6 +16,7 @@
 #include "agent/tools/plan_work.hpp"
 #include "agent/tools/shell.hpp"
 #include "agent/tools/spawn.hpp"
+#include "agent/tools/tool_context.hpp"
 #include "agent/tools/todo.hpp"
 #include "agent/tools/tts.hpp"
 #include "agent/tools/web.hpp"
@@ -23,6 +26,8 @@
 namespace kabot::agent {
 namespace {
 
+constexpr std::size_t kSessionLockPruneThreshold = 256;
+
 std::string Trim(std::string value) {
     auto not_space = [](unsigned char ch) { return !std::isspace(ch); };
     value.erase(value.begin(), std::find_if(value.begin(), value.end(), not_space));
@@ -45,6 +50,104 @@ std::string ExtractMemoryBlock(const std::string& content) {
     return Trim(raw);
 }
 
+kabot::session::SessionCacheOptions SessionCacheOptionsFor(const kabot::config::AgentDefaults& config) {
+    kabot::session::SessionCacheOptions options{};
+    if (config.session_cache_mb > 0) {
+        options.max_bytes = static_cast<std::size_t>(config.session_cache_mb) * 1024 * 1024;
+    }
+    return options;
+}
+
+ContextBudgetOptions ContextBudgetOptionsFor(const kabot::config::AgentDefaults& config) {
+    ContextBudgetOptions options{};
+    if (config.context_window_tokens > 0) {
+        options.context_window_tokens = static_cast<std::size_t>(config.context_window_tokens);
+    }
+    for (const auto& [model, tokens] : config.model_context_windows) {
+        if (tokens > 0) {
+            options.model_context_windows[model] = static_cast<std::size_t>(tokens);
+        }
+    }
+    options.reserve_output_tokens = static_cast<std::size_t>(std::max(config.max_tokens, 0));
+    options.tokenizer_vocab = config.tokenizer_vocab;
+    return options;
+}
+
+bool SupportsStreamingEdits(const std::string& channel) {
+    return channel == "telegram";
+}
+
+std::string NextStreamId() {
+    static std::atomic<std::uint64_t> sequence{0};
+    return "stream-" + std::to_string(sequence.fetch_add(1) + 1);
+}
+
+// Text shown while a reply is still streaming: everything before the memory
+// block, without a trailing fragment that may turn into its opening tag.
+std::string PartialReplyText(const std::string& text) {
+    static const std::string open_tag = "<kabot_memory";
+    auto visible = text.substr(0, text.find(open_tag));
+    const auto last_tag = visible.rfind('<');
+    if (last_tag != std::string::npos && open_tag.compare(0, visible.size() - last_tag, visible, last_tag) == 0) {
+        visible.erase(last_tag);
+    }
+    return Trim(visible);
+}
+
+// Streams the reply of one turn into a single channel message: the first
+// chunk is sent right away and later ones are published as edits no more
+// often than `interval`. The final outbound carries the same stream id.
+class PartialReplyPublisher {
+public:
+    PartialReplyPublisher(kabot::bus::MessageBus& bus,
+                          const kabot::bus::InboundMessage& msg,
+                          std::chrono::milliseconds interval)
+        : bus_(bus)
+        , msg_(msg)
+        , stream_id_(NextStreamId())
+        , interval_(interval) {}
+
+    const std::string& StreamId() const { return stream_id_; }
+    bool Started() const { return published_ > 0; }
+
+    // Each model call streams a fresh reply that replaces the previous one.
+    void Reset() { text_.clear(); }
+
+    void Append(const std::string& delta) {
+        text_ += delta;
+        const auto now = std::chrono::steady_clock::now();
+        if (published_ > 0 && now - last_publish_ < interval_) {
+            return;
+        }
+        auto visible = PartialReplyText(text_);
+        if (visible.empty() || visible == last_content_) {
+            return;
+        }
+        kabot::bus::OutboundMessage partial{};
+        partial.channel = msg_.channel;
+        partial.channel_instance = msg_.channel_instance;
+        partial.agent_name = msg_.agent_name;
+        partial.chat_id = msg_.chat_id;
+        partial.content = visible;
+        partial.metadata["stream_id"] = stream_id_;
+        partial.metadata["stream_state"] = "partial";
+        last_content_ = std::move(visible);
+        last_publish_ = now;
+        published_ += 1;
+        bus_.PublishOutbound(std::move(partial));
+    }
+
+private:
+    kabot::bus::MessageBus& bus_;
+    const kabot::bus::InboundMessage& msg_;
+    std::string stream_id_;
+    std::chrono::milliseconds interval_;
+    std::string text_;
+    std::string last_content_;
+    std::chrono::steady_clock::time_point last_publish_{};
+    int published_ = 0;
+};
+
 std::string PhaseSummary(DirectExecutionPhase phase) {
     switch (phase) {
     case DirectExecutionPhase::kReceived:
@@ -275,17 +378,19 @@ AgentLoop::AgentLoop(
     , config_(std::move(config))
     , qmd_(std::move(qmd))
     , task_system_(std::move(task_system))
-    , context_(workspace_, qmd_)
-    , sessions_(workspace_)
-    , memory_(workspace_)
+    , context_(workspace_, qmd_, ContextBudgetOptionsFor(config_))
+    , sessions_(workspace_, SessionCacheOptionsFor(config_))
+    , memory_(workspace_, MemoryStoreOptions{config_.memory_fsync_interval_ms})
     , cron_(cron) {
     subagent_service_ = std::make_unique<kabot::subagent::SubagentService>(
         provider_, tools_, workspace_, static_cast<kabot::config::AgentDefaults>(config_));
     subagent_service_->SetTaskCompletionHandler([this](const kabot::subagent::AgentTaskRecord& task) {
         if (task.parent_session_id.empty()) return;
-        auto session_opt = sessions_.Get(task.parent_session_id);
-        if (!session_opt) return;
-        auto session = *session_opt;
+        const auto session_lock = SessionLock(task.parent_session_id);
+        std::lock_guard<std::mutex> guard(*session_lock);
+        auto session_handle = sessions_.Get(task.parent_session_id);
+        if (!session_handle) return;
+        auto& session = *session_handle;
         std::string status_str = "completed";
         if (task.status == kabot::subagent::SubagentStatus::kFailed) {
             status_str = "failed";
@@ -327,7 +432,7 @@ void AgentLoop::Run() {
         }
 
         auto outbound = HandleInbound(msg);
-        bus_.PublishOutbound(outbound);
+        bus_.PublishOutbound(std::move(outbound));
     }
 }
 
@@ -335,6 +440,25 @@ void AgentLoop::Stop() {
     running_ = false;
 }
 
+std::shared_ptr<std::mutex> AgentLoop::SessionLock(const std::string& session_key) {
+    std::lock_guard<std::mutex> lock(session_locks_mutex_);
+    auto mutex = session_locks_[session_key].lock();
+    if (!mutex) {
+        mutex = std::make_shared<std::mutex>();
+        session_locks_[session_key] = mutex;
+    }
+    if (session_locks_.size() > kSessionLockPruneThreshold) {
+        for (auto it = session_locks_.begin(); it != session_locks_.end();) {
+            if (it->second.expired()) {
+                it = session_locks_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return mutex;
+}
+
 kabot::bus::OutboundMessage AgentLoop::HandleInbound(
     const kabot::bus::InboundMessage& msg,
     const DirectExecutionObserver& observer,
@@ -376,8 +500,13 @@ std::vector<std::string> AgentLoop::RegisteredTools() const {
 }
 
 kabot::session::Session AgentLoop::GetSession(const std::string& session_key) {
-    auto session = sessions_.GetOrCreate(session_key);
-    return session;
+    const auto session_lock = SessionLock(session_key);
+    std::lock_guard<std::mutex> guard(*session_lock);
+    return *sessions_.GetOrCreate(session_key);
+}
+
+kabot::session::SessionCacheStats AgentLoop::SessionCacheStats() const {
+    return sessions_.CacheStats();
 }
 
 std::string AgentLoop::ProcessDirect(const std::string& content,
@@ -386,27 +515,17 @@ std::string AgentLoop::ProcessDirect(const std::string& content,
                                      const DirectExecutionTarget& target,
                                      const DirectOutboundObserver& outbound_observer,
                                      const kabot::CancelToken& cancel_token) {
-    std::lock_guard<std::mutex> guard(process_mutex_);
-    if (auto* tool = tools_.Get("send_message")) {
-        if (auto* message_tool = dynamic_cast<kabot::agent::tools::SendMessageTool*>(tool)) {
-            const auto target_channel = target.channel_instance.empty() ? target.channel : target.channel_instance;
-            message_tool->SetContext(target_channel, target.chat_id);
-            message_tool->SetObserver(outbound_observer);
-        }
-    }
-    if (auto* tool = tools_.Get("plan_work")) {
-        if (auto* plan_tool = dynamic_cast<kabot::agent::tools::PlanWorkTool*>(tool)) {
-            const auto target_channel = target.channel_instance.empty() ? target.channel : target.channel_instance;
-            plan_tool->SetContext(target.channel, target.channel_instance, target.chat_id, {});
-        }
-    }
-    if (auto* tool = tools_.Get("cron")) {
-        if (auto* cron_tool = dynamic_cast<kabot::agent::tools::CronTool*>(tool)) {
-            const auto target_channel = target.channel_instance.empty() ? target.channel : target.channel_instance;
-            cron_tool->SetContext({}, target_channel, target.chat_id);
-        }
-    }
-    auto session = sessions_.GetOrCreate(session_key);
+    const auto session_lock = SessionLock(session_key);
+    std::lock_guard<std::mutex> guard(*session_lock);
+    kabot::agent::tools::ToolInvocationContext tool_context{};
+    tool_context.channel = target.channel;
+    tool_context.channel_instance = target.channel_instance;
+    tool_context.chat_id = target.chat_id;
+    tool_context.session_key = session_key;
+    tool_context.outbound_observer = outbound_observer;
+    kabot::agent::tools::ToolContextScope tool_scope(std::move(tool_context));
+    const auto session_handle = sessions_.GetOrCreate(session_key);
+    auto& session = *session_handle;
     auto history = session.GetHistory(static_cast<std::size_t>(config_.max_history_messages));
     auto messages = context_.BuildMessages(history, content, {});
     session.AddMessage("user", content);
@@ -460,6 +579,7 @@ std::string AgentLoop::ProcessDirect(const std::string& content,
     std::string final_content;
     bool message_sent = false;
     const auto model = config_.model.empty() ? provider_.GetDefaultModel() : config_.model;
+    const auto prompt_budget = context_.PromptBudget(model, tools_.GetDefinitions());
     const bool requires_tool_guardrail = RequiresToolGuardrail(content);
     bool tool_called = false;
     bool guardrail_retry_used = false;
@@ -479,7 +599,8 @@ std::string AgentLoop::ProcessDirect(const std::string& content,
         }
         iteration += 1;
 
-        auto projected = context_.ProjectMessages(messages);
+        context_.AnnotateTokenCounts(messages);
+        auto projected = context_.ProjectMessages(messages, prompt_budget);
         const auto estimated_tokens = context_.EstimateTokens(projected);
         LOG_DEBUG("[agent] estimated_tokens={} session={}", estimated_tokens, session_key);
 
@@ -556,7 +677,8 @@ std::string AgentLoop::ProcessDirect(const std::string& content,
 
 kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundMessage& msg,
                                                        const DirectExecutionObserver& observer) {
-    std::lock_guard<std::mutex> guard(process_mutex_);
+    const auto session_lock = SessionLock(msg.SessionKey());
+    std::lock_guard<std::mutex> guard(*session_lock);
     const auto send_typing = [&]() {
         if (msg.channel != "telegram") {
             return;
@@ -567,25 +689,16 @@ kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundM
         typing.agent_name = msg.agent_name;
         typing.chat_id = msg.chat_id;
         typing.metadata["action"] = "typing";
-        bus_.PublishOutbound(typing);
+        bus_.PublishOutbound(std::move(typing));
     };
     send_typing();
-    if (auto* tool = tools_.Get("send_message")) {
-        if (auto* message_tool = dynamic_cast<kabot::agent::tools::SendMessageTool*>(tool)) {
-            message_tool->SetContext(msg.channel, msg.chat_id);
-            message_tool->SetObserver({});
-        }
-    }
-    if (auto* tool = tools_.Get("cron")) {
-        if (auto* cron_tool = dynamic_cast<kabot::agent::tools::CronTool*>(tool)) {
-            cron_tool->SetContext(msg.agent_name, msg.channel_instance.empty() ? msg.channel : msg.channel_instance, msg.chat_id);
-        }
-    }
-    if (auto* tool = tools_.Get("plan_work")) {
-        if (auto* plan_tool = dynamic_cast<kabot::agent::tools::PlanWorkTool*>(tool)) {
-            plan_tool->SetContext(msg.channel, msg.channel_instance, msg.chat_id, msg.agent_name);
-        }
-    }
+    kabot::agent::tools::ToolInvocationContext tool_context{};
+    tool_context.agent_name = msg.agent_name;
+    tool_context.channel = msg.channel;
+    tool_context.channel_instance = msg.channel_instance;
+    tool_context.chat_id = msg.chat_id;
+    tool_context.session_key = msg.SessionKey();
+    kabot::agent::tools::ToolContextScope tool_scope(std::move(tool_context));
     std::string content = msg.content;
     bool reset_session = false;
     if (content.rfind("/new", 0) == 0) {
@@ -610,7 +723,8 @@ kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundM
             return outbound;
         }
     }
-    auto session = sessions_.GetOrCreate(msg.SessionKey());
+    const auto session_handle = sessions_.GetOrCreate(msg.SessionKey());
+    auto& session = *session_handle;
 
     auto history = session.GetHistory(static_cast<std::size_t>(config_.max_history_messages));
     auto messages = context_.BuildMessages(
@@ -630,13 +744,21 @@ kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundM
     std::string final_content;
     bool message_sent = false;
     const auto model = config_.model.empty() ? provider_.GetDefaultModel() : config_.model;
+    const auto prompt_budget = context_.PromptBudget(model, tools_.GetDefinitions());
     const bool requires_tool_guardrail = RequiresToolGuardrail(content);
     bool tool_called = false;
     bool guardrail_retry_used = false;
     bool post_tool_reminder_used = false;
 
-    LOG_INFO("[agent] process_message tool_guardrail={} session={}",
+    std::unique_ptr<PartialReplyPublisher> partial_reply;
+    if (config_.stream_replies && SupportsStreamingEdits(msg.channel)) {
+        partial_reply = std::make_unique<PartialReplyPublisher>(
+            bus_, msg, std::chrono::milliseconds(std::max(0, config_.stream_edit_interval_ms)));
+    }
+
+    LOG_INFO("[agent] process_message tool_guardrail={} stream={} session={}",
              (requires_tool_guardrail ? "true" : "false"),
+             (partial_reply ? "true" : "false"),
              msg.SessionKey());
     DirectExecutionPhase last_phase = DirectExecutionPhase::kReceived;
     const auto notify_phase = [&](DirectExecutionPhase phase) {
@@ -657,16 +779,29 @@ kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundM
     while (iteration < config_.max_iterations) {
         iteration += 1;
 
-        auto projected = context_.ProjectMessages(messages);
+        context_.AnnotateTokenCounts(messages);
+        auto projected = context_.ProjectMessages(messages, prompt_budget);
         const auto estimated_tokens = context_.EstimateTokens(projected);
         LOG_DEBUG("[agent] estimated_tokens={} session={}", estimated_tokens, msg.SessionKey());
 
-        auto response = provider_.Chat(
-            projected,
-            tools_.GetDefinitions(),
-            model,
-            config_.max_tokens,
-            config_.temperature);
+        kabot::providers::LLMResponse response;
+        if (partial_reply) {
+            partial_reply->Reset();
+            response = provider_.ChatStream(
+                projected,
+                tools_.GetDefinitions(),
+                model,
+                config_.max_tokens,
+                config_.temperature,
+                [&partial_reply](const std::string& delta) { partial_reply->Append(delta); });
+        } else {
+            response = provider_.Chat(
+                projected,
+                tools_.GetDefinitions(),
+                model,
+                config_.max_tokens,
+                config_.temperature);
+        }
 
         if (response.HasToolCalls()) {
             tool_called = true;
@@ -734,6 +869,10 @@ kabot::bus::OutboundMessage AgentLoop::ProcessMessage(const kabot::bus::InboundM
         outbound.agent_name = msg.agent_name;
         outbound.chat_id = msg.chat_id;
         outbound.content = final_content;
+        if (partial_reply && partial_reply->Started()) {
+            outbound.metadata["stream_id"] = partial_reply->StreamId();
+            outbound.metadata["stream_state"] = "final";
+        }
     }
     return outbound;
 }
@@ -754,7 +893,10 @@ void AgentLoop::RegisterDefaultTools() {
     tools_.Register(std::make_unique<kabot::agent::tools::ListDirTool>());
     tools_.Register(std::make_unique<kabot::agent::tools::GlobTool>());
     tools_.Register(std::make_unique<kabot::agent::tools::GrepTool>());
-    tools_.Register(std::make_unique<kabot::agent::tools::BashTool>(workspace_));
+    tools_.Register(std::make_unique<kabot::agent::tools::BashTool>(
+        workspace_,
+        config_.persistent_shell,
+        std::chrono::seconds(std::max(1, config_.shell_idle_timeout_s))));
     if (!config_.brave_api_key.empty()) {
         const auto size = config_.brave_api_key.size();
         const auto prefix = size > 4 ? config_.brave_api_key.substr(0, 4) : config_.brave_api_key;
@@ -791,11 +933,13 @@ void AgentLoop::AppendMemoryEntry(const std::string& session_key,
     for (const auto& line : lines) {
         entry << "- [" << session_key << "] " << line << "\n";
     }
+    std::lock_guard<std::mutex> lock(memory_mutex_);
     memory_.AppendToday(entry.str());
 }
 
 void AgentLoop::UpdateQmdIndex() const {
-    if (!qmd_.enabled || !qmd_.update_on_write) {
+    // The builtin index picks up memory writes itself.
+    if (!qmd_.enabled || !qmd_.update_on_write || qmd_.engine != "qmd") {
         return;
     }
     std::ostringstream cmd;
@@ -818,7 +962,6 @@ void AgentLoop::UpdateQmdIndex() const {
 }
 
 kabot::bus::OutboundMessage AgentLoop::ProcessSystemMessage(const kabot::bus::InboundMessage& msg) {
-    std::lock_guard<std::mutex> guard(process_mutex_);
     std::string origin_channel = "cli";
     std::string origin_chat_id = msg.chat_id;
     const auto delimiter = msg.chat_id.find(':');
@@ -827,20 +970,17 @@ kabot::bus::OutboundMessage AgentLoop::ProcessSystemMessage(const kabot::bus::In
         origin_chat_id = msg.chat_id.substr(delimiter + 1);
     }
 
-    if (auto* tool = tools_.Get("send_message")) {
-        if (auto* message_tool = dynamic_cast<kabot::agent::tools::SendMessageTool*>(tool)) {
-            message_tool->SetContext(origin_channel, origin_chat_id);
-            message_tool->SetObserver({});
-        }
-    }
-    if (auto* tool = tools_.Get("cron")) {
-        if (auto* cron_tool = dynamic_cast<kabot::agent::tools::CronTool*>(tool)) {
-            cron_tool->SetContext(msg.agent_name, origin_channel, origin_chat_id);
-        }
-    }
-
     const auto session_key = origin_channel + ":" + origin_chat_id;
-    auto session = sessions_.GetOrCreate(session_key);
+    const auto session_lock = SessionLock(session_key);
+    std::lock_guard<std::mutex> guard(*session_lock);
+    kabot::agent::tools::ToolInvocationContext tool_context{};
+    tool_context.agent_name = msg.agent_name;
+    tool_context.channel = origin_channel;
+    tool_context.chat_id = origin_chat_id;
+    tool_context.session_key = session_key;
+    kabot::agent::tools::ToolContextScope tool_scope(std::move(tool_context));
+    const auto session_handle = sessions_.GetOrCreate(session_key);
+    auto& session = *session_handle;
     auto messages = context_.BuildMessages(session.GetHistory(), msg.content, {});
     session.AddMessage("user", "[System] " + msg.content);
     for (const auto& notif : session.TakePendingNotifications()) {
@@ -855,6 +995,7 @@ kabot::bus::OutboundMessage AgentLoop::ProcessSystemMessage(const kabot::bus::In
     std::string final_content;
     bool message_sent = false;
     const auto model = config_.model.empty() ? provider_.GetDefaultModel() : config_.model;
+    const auto prompt_budget = context_.PromptBudget(model, tools_.GetDefinitions());
     const bool requires_tool_guardrail = RequiresToolGuardrail(msg.content);
     bool tool_called = false;
     bool guardrail_retry_used = false;
@@ -867,7 +1008,8 @@ kabot::bus::OutboundMessage AgentLoop::ProcessSystemMessage(const kabot::bus::In
     while (iteration < config_.max_iterations) {
         iteration += 1;
 
-        auto projected = context_.ProjectMessages(messages);
+        context_.AnnotateTokenCounts(messages);
+        auto projected = context_.ProjectMessages(messages, prompt_budget);
         const auto estimated_tokens = context_.EstimateTokens(projected);
         LOG_DEBUG("[agent] estimated_tokens={} session={}", estimated_tokens, session_key);
 
@@ -957,12 +1099,6 @@ std::string AgentLoop::ExecuteToolWithGuardrails(kabot::session::Session& sessio
         }
     }
 
-    if (call.name == "agent") {
-        if (auto* agent_tool = dynamic_cast<kabot::agent::tools::AgentTool*>(tools_.Get("agent"))) {
-            agent_tool->SetSessionKey(session.Key());
-        }
-    }
-
     auto result = tools_.Execute(call.name, call.arguments);
 
     if (call.name == "read_file") {
@@ -4,6 +4,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 
 #include "agent/context_builder.hpp"
 #include "agent/memory_store.hpp"
@@ -68,6 +69,7 @@ public:
     std::string SpawnSubagent(const kabot::subagent::AgentSpawnInput& input,
                               const std::string& session_key = "");
     kabot::session::Session GetSession(const std::string& session_key);
+    kabot::session::SessionCacheStats SessionCacheStats() const;
 
 private:
     kabot::bus::MessageBus& bus_;
@@ -84,7 +86,12 @@ private:
     kabot::relay::RelayManager* relay_manager_ = nullptr;
     std::unique_ptr<kabot::subagent::SubagentService> subagent_service_;
     bool running_ = false;
-    std::mutex process_mutex_;
+    // Turns are serialized per session key only; different chats run in parallel.
+    std::mutex session_locks_mutex_;
+    std::unordered_map<std::string, std::weak_ptr<std::mutex>> session_locks_;
+    std::mutex memory_mutex_;
+
+    std::shared_ptr<std::mutex> SessionLock(const std::string& session_key);
 
     kabot::bus::OutboundMessage ProcessMessage(const kabot::bus::InboundMessage& msg,
                                                const DirectExecutionObserver& observer = {});
@@ -1,6 +1,8 @@
 #include "agent/agent_registry.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
 #include <utility>
 
 #include "utils/logging.hpp"
@@ -8,6 +10,11 @@
 namespace kabot::agent {
 namespace {
 
+constexpr std::size_t kInboundDrainBatch = 64;
+// How long the dispatcher waits on one full shard before dropping the
+// message, so a stuck chat cannot stall the fan-out to every other shard.
+constexpr auto kShardFullTimeout = std::chrono::seconds(5);
+
 std::string EffectiveChannelInstance(const kabot::bus::InboundMessage& msg) {
     return msg.channel_instance.empty() ? msg.channel : msg.channel_instance;
 }
@@ -84,30 +91,146 @@ void AgentRegistry::Start() {
         return;
     }
     running_ = true;
+    const auto shard_count = static_cast<std::size_t>(std::max(1, config_.agents.dispatch_workers));
+    shard_capacity_ = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::max(1, config_.bus.inbound_capacity)) / shard_count);
+    shards_.clear();
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<DispatchShard>());
+    }
+    for (auto& shard : shards_) {
+        auto* raw = shard.get();
+        shard->worker = std::thread([this, raw] { RunShard(*raw); });
+    }
+    LOG_INFO("[agent] inbound dispatch started shards={} shard_capacity={}", shard_count, shard_capacity_);
     worker_ = std::thread([this] { RunLoop(); });
 }
 
 void AgentRegistry::Stop() {
     running_ = false;
+    // Taking each shard mutex orders the flag change with the predicate
+    // checks, so neither a shard worker nor the dispatcher blocked on a full
+    // shard can miss the wakeup. This must happen before joining the
+    // dispatcher, which may be the one waiting.
+    for (auto& shard : shards_) {
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+        }
+        shard->cv.notify_all();
+        shard->not_full.notify_all();
+    }
     if (worker_.joinable()) {
         worker_.join();
     }
+    for (auto& shard : shards_) {
+        if (shard->worker.joinable()) {
+            shard->worker.join();
+        }
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& pending : shard->queue) {
+            LOG_WARN("[agent] inbound dispatch stopped, dropped message channel={} chat_id={} session={}",
+                     pending.msg.channel_instance.empty() ? pending.msg.channel : pending.msg.channel_instance,
+                     pending.msg.chat_id,
+                     pending.msg.SessionKey());
+        }
+        shard->queue.clear();
+        shard->stats.queue_depth = 0;
+    }
     for (auto& [_, agent] : agents_) {
         agent->Stop();
     }
 }
 
 void AgentRegistry::RunLoop() {
+    std::vector<kabot::bus::InboundMessage> batch;
     while (running_) {
-        kabot::bus::InboundMessage msg{};
-        if (!bus_.TryConsumeInbound(msg, std::chrono::milliseconds(1000))) {
+        batch.clear();
+        if (bus_.DrainInbound(batch, kInboundDrainBatch, std::chrono::milliseconds(1000)) == 0) {
             continue;
         }
-        auto outbound = HandleInbound(std::move(msg));
-        bus_.PublishOutbound(outbound);
+        for (auto& msg : batch) {
+            msg.agent_name = ResolveAgentName(msg);
+            auto& shard = ShardFor(msg.SessionKey());
+            {
+                std::unique_lock<std::mutex> lock(shard.mutex);
+                const bool has_room = shard.not_full.wait_for(lock, kShardFullTimeout, [this, &shard] {
+                    return !running_ || shard.queue.size() < shard_capacity_;
+                });
+                if (!running_) {
+                    LOG_WARN("[agent] inbound dispatch stopped, dropped message channel={} chat_id={} session={}",
+                             msg.channel_instance.empty() ? msg.channel : msg.channel_instance,
+                             msg.chat_id,
+                             msg.SessionKey());
+                    continue;
+                }
+                if (!has_room) {
+                    shard.stats.dropped_inbound += 1;
+                    LOG_ERROR("[agent] shard queue full, dropped message channel={} chat_id={} session={}",
+                              msg.channel_instance.empty() ? msg.channel : msg.channel_instance,
+                              msg.chat_id,
+                              msg.SessionKey());
+                    continue;
+                }
+                shard.queue.push_back({std::move(msg), std::chrono::steady_clock::now()});
+                shard.stats.queue_depth = shard.queue.size();
+            }
+            shard.cv.notify_one();
+        }
+    }
+}
+
+void AgentRegistry::RunShard(DispatchShard& shard) {
+    while (true) {
+        DispatchShard::Pending pending;
+        {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.cv.wait(lock, [this, &shard] { return !running_ || !shard.queue.empty(); });
+            if (!running_) {
+                return;
+            }
+            pending = std::move(shard.queue.front());
+            shard.queue.pop_front();
+            shard.not_full.notify_one();
+            const auto wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - pending.enqueued_at).count();
+            shard.stats.queue_depth = shard.queue.size();
+            shard.stats.busy = true;
+            shard.stats.last_wait_ms = wait_ms;
+            shard.stats.max_wait_ms = std::max(shard.stats.max_wait_ms, static_cast<std::int64_t>(wait_ms));
+            shard.stats.total_wait_ms += wait_ms;
+        }
+        const auto session_key = pending.msg.SessionKey();
+        auto outbound = HandleInbound(std::move(pending.msg));
+        const bool published = bus_.PublishOutbound(std::move(outbound));
+        if (!published) {
+            LOG_ERROR("[agent] reply dropped, outbound queue full session={}", session_key);
+        }
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.stats.busy = false;
+            shard.stats.processed += 1;
+            if (!published) {
+                shard.stats.dropped_replies += 1;
+            }
+        }
     }
 }
 
+AgentRegistry::DispatchShard& AgentRegistry::ShardFor(const std::string& session_key) {
+    const auto index = std::hash<std::string>{}(session_key) % shards_.size();
+    return *shards_[index];
+}
+
+std::vector<DispatchShardStats> AgentRegistry::DispatchStats() const {
+    std::vector<DispatchShardStats> stats;
+    stats.reserve(shards_.size());
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.push_back(shard->stats);
+    }
+    return stats;
+}
+
 kabot::bus::OutboundMessage AgentRegistry::HandleInbound(kabot::bus::InboundMessage msg) {
     msg.agent_name = ResolveAgentName(msg);
 
@@ -198,6 +321,14 @@ kabot::session::Session AgentRegistry::GetSession(const std::string& agent_name,
     return it->second->GetSession(session_key);
 }
 
+std::unordered_map<std::string, kabot::session::SessionCacheStats> AgentRegistry::SessionCacheStats() const {
+    std::unordered_map<std::string, kabot::session::SessionCacheStats> stats;
+    for (const auto& [name, agent] : agents_) {
+        stats.emplace(name, agent->SessionCacheStats());
+    }
+    return stats;
+}
+
 const kabot::config::AgentInstanceConfig* AgentRegistry::GetAgentConfig(const std::string& name) const {
     return config_.FindAgent(name);
 }
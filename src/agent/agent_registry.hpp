@@ -1,11 +1,17 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "agent/agent_loop.hpp"
 #include "bus/message_bus.hpp"
@@ -19,6 +25,17 @@ class RelayManager;
 
 namespace kabot::agent {
 
+struct DispatchShardStats {
+    std::size_t queue_depth = 0;
+    bool busy = false;
+    std::uint64_t processed = 0;
+    std::int64_t last_wait_ms = 0;
+    std::int64_t max_wait_ms = 0;
+    std::int64_t total_wait_ms = 0;
+    std::uint64_t dropped_replies = 0;
+    std::uint64_t dropped_inbound = 0;  // shard stayed full past the dispatch timeout
+};
+
 class AgentRegistry {
 public:
     using InboundExecutionReporter = std::function<void(const std::string&,
@@ -52,13 +69,32 @@ public:
                               const kabot::CancelToken& cancel_token = {});
     kabot::session::Session GetSession(const std::string& agent_name,
                                        const std::string& session_key);
+    std::vector<DispatchShardStats> DispatchStats() const;
+    std::unordered_map<std::string, kabot::session::SessionCacheStats> SessionCacheStats() const;
     const kabot::config::AgentInstanceConfig* GetAgentConfig(const std::string& name) const;
     std::string ResolveAgentName(const kabot::bus::InboundMessage& msg) const;
     std::string DefaultAgentName() const;
 
 private:
+    // Inbound messages are sharded by session key so that one chat is always
+    // handled by the same worker (in order) while different chats run in parallel.
+    struct DispatchShard {
+        struct Pending {
+            kabot::bus::InboundMessage msg;
+            std::chrono::steady_clock::time_point enqueued_at;
+        };
+        mutable std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable not_full;
+        std::deque<Pending> queue;
+        DispatchShardStats stats;
+        std::thread worker;
+    };
+
     void InitAgents();
     void RunLoop();
+    void RunShard(DispatchShard& shard);
+    DispatchShard& ShardFor(const std::string& session_key);
 
     kabot::bus::MessageBus& bus_;
     kabot::providers::LLMProvider& provider_;
@@ -71,6 +107,10 @@ private:
     InboundPostProcessor inbound_post_processor_;
     std::atomic<bool> running_{false};
     std::thread worker_;
+    std::vector<std::unique_ptr<DispatchShard>> shards_;
+    // Shards share the inbound bus capacity; the dispatcher blocks on a full
+    // shard so backpressure reaches publishers through the bounded bus queue.
+    std::size_t shard_capacity_ = 1;
 };
 
 }  // namespace kabot::agent
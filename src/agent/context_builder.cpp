@@ -16,17 +16,38 @@
 
 namespace kabot::agent {
 
-ContextBuilder::ContextBuilder(std::string workspace, kabot::config::QmdConfig qmd)
+ContextBuilder::ContextBuilder(std::string workspace,
+                               kabot::config::QmdConfig qmd,
+                               ContextBudgetOptions budget)
     : workspace_(std::move(workspace))
     , memory_(workspace_)
     , skills_(workspace_)
-    , qmd_(std::move(qmd)) {}
+    , qmd_(std::move(qmd))
+    , budget_(std::move(budget))
+    , tokenizer_(nullptr) {
+    auto vocab = budget_.tokenizer_vocab;
+    if (!vocab.empty() && std::filesystem::path(vocab).is_relative()) {
+        vocab = (std::filesystem::path(workspace_) / vocab).string();
+    }
+    tokenizer_ = Tokenizer::Shared(vocab);
+    if (qmd_.enabled && qmd_.engine != "qmd") {
+        memory_index_ = MemoryIndex::Shared(workspace_, qmd_.paths);
+    }
+}
 
 std::string ContextBuilder::BuildSystemPrompt(const std::vector<std::string>& skill_names) const {
     return BuildSystemPrompt(skill_names, "", {});
 }
 
 std::string ContextBuilder::BuildSystemPrompt(
+    const std::vector<std::string>& skill_names,
+    const std::string& current_message,
+    const std::string& working_directory) const {
+    auto parts = BuildSystemPromptParts(skill_names, current_message, working_directory);
+    return parts.stable_prefix + parts.volatile_suffix;
+}
+
+SystemPromptParts ContextBuilder::BuildSystemPromptParts(
     const std::vector<std::string>& skill_names,
     const std::string& current_message,
     const std::string& working_directory) const {
@@ -34,12 +55,6 @@ std::string ContextBuilder::BuildSystemPrompt(
     oss << "# kabot\n\n";
     oss << "## Workspace\n";
     oss << "Your workspace is at: " << workspace_ << "\n\n";
-    if (!working_directory.empty()) {
-        oss << "## Project Context\n";
-        oss << "You are working inside a cloned git repository at: " << working_directory << "\n";
-        oss << "All file operations and shell commands should be relative to this directory unless explicitly directed otherwise.\n";
-        oss << "Commit your changes when done.\n\n";
-    }
 #if defined(_WIN32)
     oss << "## Execution Environment\n";
     oss << "Host OS: Windows\n";
@@ -60,8 +75,6 @@ std::string ContextBuilder::BuildSystemPrompt(
         oss << bootstrap << "\n\n";
     }
 
-    
-
     oss << "## Tool Use\n";
     oss << "When the user asks you to inspect files, read code, modify code, write files, run commands, browse the web, fetch external data, send messages, or schedule work, do not claim the task is completed unless you have already called the relevant tool and received its result.\n";
     oss << "If tools are required but unavailable or insufficient, explicitly say what is missing instead of pretending success.\n";
@@ -76,7 +89,6 @@ std::string ContextBuilder::BuildSystemPrompt(
     oss << "## Daily Memory\n";
     oss << "Daily memory is stored at: " << workspace_ << "/memory/YYYY-MM-DD.md\n\n";
 
-
     auto active_names = skill_names;
     if (active_names.empty()) {
         active_names = skills_.GetAlwaysSkills();
@@ -93,6 +105,19 @@ std::string ContextBuilder::BuildSystemPrompt(
         oss << summary << "\n";
     }
 
+    SystemPromptParts parts;
+    parts.stable_prefix = oss.str();
+    oss.str({});
+
+    // Everything below changes between turns or sessions and must stay after
+    // the stable prefix.
+    if (!working_directory.empty()) {
+        oss << "## Project Context\n";
+        oss << "You are working inside a cloned git repository at: " << working_directory << "\n";
+        oss << "All file operations and shell commands should be relative to this directory unless explicitly directed otherwise.\n";
+        oss << "Commit your changes when done.\n\n";
+    }
+
     const auto now = std::chrono::system_clock::now();
     const auto now_time = std::chrono::system_clock::to_time_t(now);
     std::tm now_tm{};
@@ -122,7 +147,8 @@ std::string ContextBuilder::BuildSystemPrompt(
         oss << "# Memory\n\n" << memory << "\n\n";
     }
 
-    return oss.str();
+    parts.volatile_suffix = oss.str();
+    return parts;
 }
 
 std::vector<kabot::providers::Message> ContextBuilder::BuildMessages(
@@ -132,8 +158,17 @@ std::vector<kabot::providers::Message> ContextBuilder::BuildMessages(
     std::vector<kabot::providers::Message> messages;
     kabot::providers::Message system_message{};
     system_message.role = "system";
-    system_message.content = BuildSystemPrompt({}, current_message);
-    messages.push_back(system_message);
+    auto prompt = BuildSystemPromptParts({}, current_message);
+    kabot::providers::ContentPart prefix_part{};
+    prefix_part.type = "text";
+    prefix_part.text = std::move(prompt.stable_prefix);
+    prefix_part.cache_breakpoint = true;
+    system_message.content_parts.push_back(std::move(prefix_part));
+    kabot::providers::ContentPart suffix_part{};
+    suffix_part.type = "text";
+    suffix_part.text = std::move(prompt.volatile_suffix);
+    system_message.content_parts.push_back(std::move(suffix_part));
+    messages.push_back(std::move(system_message));
 
     messages.insert(messages.end(), history.begin(), history.end());
 
@@ -177,48 +212,54 @@ std::vector<kabot::providers::Message> ContextBuilder::AddAssistantMessage(
 
 namespace {
 
-std::size_t RoughEstimateMessageTokens(const kabot::providers::Message& msg) {
-    std::size_t chars = 0;
-    if (!msg.content.empty()) {
-        chars += msg.content.size();
-    }
-    for (const auto& part : msg.content_parts) {
-        if (!part.text.empty()) {
-            chars += part.text.size();
-        }
-        if (!part.image_url.empty()) {
-            chars += 256; // rough estimate for image reference
-        }
-    }
-    for (const auto& call : msg.tool_calls) {
-        chars += call.name.size();
-        for (const auto& [k, v] : call.arguments) {
-            chars += k.size() + v.size();
-        }
-    }
-    return chars / 4 + 1;
-}
-
-} // namespace
-
-namespace {
-
 constexpr std::size_t kToolResultMaxChars = 12000;
+// Framing cost per message, and a flat cost per image: providers bill images
+// by resolution, not by the size of the data URL.
+constexpr std::size_t kMessageOverheadTokens = 4;
+constexpr std::size_t kImageTokens = 1024;
+// Slack for request framing the tokenizer does not see.
+constexpr std::size_t kBudgetSafetyTokens = 512;
+// Tool results in the current turn are never truncated below this.
+constexpr std::size_t kMinToolResultChars = 2000;
+// Room for the marker TruncateContent appends.
+constexpr std::size_t kTruncationMarkerChars = 64;
 
 std::string TruncateContent(const std::string& value, std::size_t max_len) {
     if (value.size() <= max_len) {
         return value;
     }
+    // Back off to a UTF-8 boundary; a split sequence makes the payload
+    // unserializable.
+    while (max_len > 0 && (static_cast<unsigned char>(value[max_len]) & 0xC0) == 0x80) {
+        --max_len;
+    }
     return value.substr(0, max_len) +
            "\n...[truncated, original size=" +
            std::to_string(value.size()) +
            " chars]...";
 }
 
+// What a cached token count is keyed on; +1 so an empty message still reads
+// as counted.
+std::size_t PayloadBytes(const kabot::providers::Message& msg) {
+    std::size_t bytes = msg.content.size() + 1;
+    for (const auto& part : msg.content_parts) {
+        bytes += part.text.size() + part.image_url.size();
+    }
+    for (const auto& call : msg.tool_calls) {
+        bytes += call.name.size();
+        for (const auto& [k, v] : call.arguments) {
+            bytes += k.size() + v.size();
+        }
+    }
+    return bytes;
+}
+
 } // namespace
 
 std::vector<kabot::providers::Message> ContextBuilder::ProjectMessages(
-    std::vector<kabot::providers::Message> messages) const {
+    std::vector<kabot::providers::Message> messages,
+    std::size_t budget_tokens) const {
     // 1. Remove virtual messages
     messages.erase(
         std::remove_if(messages.begin(), messages.end(),
@@ -281,16 +322,11 @@ std::vector<kabot::providers::Message> ContextBuilder::ProjectMessages(
         }
     }
 
-    // 4. Snip: physically drop old messages outside the protected tail,
-    //    but keep system messages at the head.
-    std::vector<kabot::providers::Message> snipped;
-    snipped.reserve(messages.size());
-    for (std::size_t idx = 0; idx < messages.size(); ++idx) {
-        if (messages[idx].role == "system" || idx >= protected_start) {
-            snipped.push_back(std::move(messages[idx]));
-        }
+    // 4. Keep the newest whole turns that fit the budget. A turn starts at a
+    //    user message, so assistant tool calls stay with their results.
+    if (budget_tokens > 0) {
+        messages = FitToBudget(std::move(messages), budget_tokens);
     }
-    messages = std::move(snipped);
 
     // 5. Force pair tool_use/tool_result blocks.
     std::unordered_set<std::string> pending_tool_use_ids;
@@ -332,32 +368,166 @@ std::vector<kabot::providers::Message> ContextBuilder::ProjectMessages(
     return merged;
 }
 
-std::size_t ContextBuilder::EstimateTokens(
-    const std::vector<kabot::providers::Message>& messages) const {
-    // Look backwards for the last assistant message with a recorded usage baseline.
-    for (auto it = messages.rbegin(); it != messages.rend(); ++it) {
-        if (it->role == "assistant") {
-            auto usage_it = it->usage.find("total_tokens");
-            if (usage_it != it->usage.end() && usage_it->second > 0) {
-                std::size_t baseline = static_cast<std::size_t>(usage_it->second);
-                std::size_t anchor_index = static_cast<std::size_t>(
-                    std::distance(it, messages.rend()) - 1);
-                std::size_t added_est = 0;
-                for (std::size_t i = anchor_index + 1; i < messages.size(); ++i) {
-                    added_est += RoughEstimateMessageTokens(messages[i]);
-                }
-                return baseline + added_est;
-            }
+std::size_t ContextBuilder::PromptBudget(
+    const std::string& model,
+    const std::vector<kabot::providers::ToolDefinition>& tools) const {
+    std::size_t window = budget_.context_window_tokens;
+    std::size_t best_match = 0;
+    for (const auto& [key, tokens] : budget_.model_context_windows) {
+        if (!key.empty() && key.size() > best_match && model.find(key) != std::string::npos) {
+            window = tokens;
+            best_match = key.size();
         }
     }
-    // No baseline found: rough estimate everything.
+    std::size_t tool_tokens = 0;
+    for (const auto& tool : tools) {
+        tool_tokens += tool.openai_json
+            ? tokenizer_->Count(*tool.openai_json)
+            : tokenizer_->Count(tool.name) + tokenizer_->Count(tool.description) + tokenizer_->Count(tool.parameters_json);
+    }
+    const auto reserved = budget_.reserve_output_tokens + tool_tokens + kBudgetSafetyTokens;
+    if (window <= reserved) {
+        LOG_WARN("[context] context window {} leaves no room for messages (reserved={}) model={}",
+                 window, reserved, model);
+        return 1;
+    }
+    return window - reserved;
+}
+
+void ContextBuilder::AnnotateTokenCounts(std::vector<kabot::providers::Message>& messages) const {
+    for (auto& msg : messages) {
+        const auto bytes = PayloadBytes(msg);
+        if (msg.token_count_bytes != bytes) {
+            msg.token_count = CountTokens(msg);
+            msg.token_count_bytes = bytes;
+        }
+    }
+}
+
+std::size_t ContextBuilder::CountTokens(const kabot::providers::Message& msg) const {
+    if (msg.token_count_bytes == PayloadBytes(msg)) {
+        return msg.token_count;
+    }
+    std::size_t tokens = kMessageOverheadTokens + tokenizer_->Count(msg.content);
+    for (const auto& part : msg.content_parts) {
+        tokens += tokenizer_->Count(part.text);
+        if (!part.image_url.empty()) {
+            tokens += kImageTokens;
+        }
+    }
+    for (const auto& call : msg.tool_calls) {
+        tokens += tokenizer_->Count(call.name);
+        for (const auto& [k, v] : call.arguments) {
+            tokens += tokenizer_->Count(k) + tokenizer_->Count(v);
+        }
+    }
+    return tokens;
+}
+
+std::size_t ContextBuilder::EstimateTokens(
+    const std::vector<kabot::providers::Message>& messages) const {
     std::size_t total = 0;
     for (const auto& msg : messages) {
-        total += RoughEstimateMessageTokens(msg);
+        total += CountTokens(msg);
     }
     return total;
 }
 
+std::vector<kabot::providers::Message> ContextBuilder::FitToBudget(
+    std::vector<kabot::providers::Message> messages,
+    std::size_t budget_tokens) const {
+    std::vector<std::size_t> counts(messages.size());
+    std::size_t used = 0;
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        counts[i] = CountTokens(messages[i]);
+        used += counts[i];
+    }
+    if (used <= budget_tokens) {
+        return messages;
+    }
+
+    // The current turn starts at the last user message.
+    std::size_t current_start = 0;
+    for (std::size_t i = messages.size(); i-- > 0;) {
+        if (messages[i].role == "user") {
+            current_start = i;
+            break;
+        }
+    }
+    used = 0;
+    for (std::size_t i = 0; i < messages.size(); ++i) {
+        if (messages[i].role == "system" || i >= current_start) {
+            used += counts[i];
+        }
+    }
+    std::size_t keep_from = current_start;
+    std::size_t turn_tokens = 0;
+    for (std::size_t i = current_start; i-- > 0;) {
+        if (messages[i].role == "system") {
+            continue;
+        }
+        turn_tokens += counts[i];
+        if (messages[i].role == "user") {
+            if (used + turn_tokens > budget_tokens) {
+                break;
+            }
+            used += turn_tokens;
+            turn_tokens = 0;
+            keep_from = i;
+        }
+    }
+
+    std::vector<kabot::providers::Message> kept;
+    kept.reserve(messages.size());
+    std::size_t dropped = 0;
+    for (std::size_t idx = 0; idx < messages.size(); ++idx) {
+        if (messages[idx].role == "system" || idx >= keep_from) {
+            kept.push_back(std::move(messages[idx]));
+        } else {
+            dropped += 1;
+        }
+    }
+    LOG_DEBUG("[context] budget={} kept_tokens={} dropped_messages={}", budget_tokens, used, dropped);
+
+    // Still over: cut the largest tool results of the current turn, sized by
+    // each message's own chars-per-token ratio.
+    std::vector<std::string> originals(kept.size());
+    std::vector<std::size_t> retained(kept.size(), 0);
+    std::vector<bool> exhausted(kept.size(), false);
+    while (used > budget_tokens) {
+        std::size_t largest = kept.size();
+        for (std::size_t idx = 0; idx < kept.size(); ++idx) {
+            const auto& msg = kept[idx];
+            if (!exhausted[idx] && msg.role == "tool" && msg.content.size() > kMinToolResultChars &&
+                (largest == kept.size() || msg.content.size() > kept[largest].content.size())) {
+                largest = idx;
+            }
+        }
+        if (largest == kept.size()) {
+            LOG_WARN("[context] current turn exceeds budget tokens={} budget={}", used, budget_tokens);
+            break;
+        }
+        auto& msg = kept[largest];
+        if (retained[largest] == 0) {
+            originals[largest] = msg.content;
+            retained[largest] = msg.content.size();
+        }
+        // Always cut from the original so the marker is not truncated again.
+        const auto before = CountTokens(msg);
+        const auto excess = used - budget_tokens;
+        const auto chars_per_token = static_cast<double>(msg.content.size()) / static_cast<double>(before);
+        const auto cut = static_cast<std::size_t>(static_cast<double>(excess) * chars_per_token) + kTruncationMarkerChars;
+        const auto target = retained[largest] > cut + kMinToolResultChars
+            ? retained[largest] - cut
+            : kMinToolResultChars;
+        exhausted[largest] = target == kMinToolResultChars;
+        retained[largest] = target;
+        msg.content = TruncateContent(originals[largest], target);
+        used = used - before + CountTokens(msg);
+    }
+    return kept;
+}
+
 std::string ContextBuilder::LoadBootstrapFiles() const {
     static const std::vector<std::string> files = {
         "AGENTS.md", "SOUL.md", "USER.md", "TOOLS.md", "IDENTITY.md"
@@ -365,12 +535,10 @@ std::string ContextBuilder::LoadBootstrapFiles() const {
     std::ostringstream oss;
     bool has_content = false;
     for (const auto& filename : files) {
-        std::filesystem::path path = std::filesystem::path(workspace_) / filename;
-        if (std::filesystem::exists(path)) {
-            std::ifstream file(path);
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            oss << "## " << filename << "\n\n" << buffer.str() << "\n\n";
+        // One stat per file per turn; contents are re-read only after an edit.
+        const auto content = bootstrap_files_.Read(std::filesystem::path(workspace_) / filename);
+        if (!content.empty()) {
+            oss << "## " << filename << "\n\n" << content << "\n\n";
             has_content = true;
         }
     }
@@ -381,6 +549,9 @@ std::string ContextBuilder::BuildQmdContext(const std::string& query) const {
     if (!qmd_.enabled || query.empty()) {
         return {};
     }
+    if (memory_index_) {
+        return BuildIndexedMemoryContext(query);
+    }
 
     std::string escaped;
     escaped.reserve(query.size());
@@ -424,6 +595,21 @@ std::string ContextBuilder::BuildQmdContext(const std::string& query) const {
     return result.output;
 }
 
+std::string ContextBuilder::BuildIndexedMemoryContext(const std::string& query) const {
+    const auto hits = memory_index_->Search(
+        query,
+        static_cast<std::size_t>(std::max(qmd_.max_results, 0)),
+        qmd_.min_score);
+    LOG_DEBUG("[context] memory_index hits={}", hits.size());
+    std::ostringstream oss;
+    for (const auto& hit : hits) {
+        oss << "### " << hit.path << ":" << hit.line
+            << " (score " << std::fixed << std::setprecision(2) << hit.score << ")\n\n"
+            << hit.text << "\n\n";
+    }
+    return oss.str();
+}
+
 std::vector<kabot::providers::ContentPart> ContextBuilder::BuildUserContent(
     const std::string& text,
     const std::vector<std::string>& media) const {
@@ -1,24 +1,56 @@
 #pragma once
 
+#include <cstddef>
+#include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "agent/file_cache.hpp"
+#include "agent/memory_index.hpp"
 #include "agent/memory_store.hpp"
 #include "agent/skills_loader.hpp"
+#include "agent/tokenizer.hpp"
 #include "config/config_schema.hpp"
 #include "providers/llm_provider.hpp"
 
 namespace kabot::agent {
 
+// The system prompt as two pieces: a prefix that stays byte-identical across
+// turns (identity, environment, rules, skills) so provider-side prompt caches
+// can reuse it, and a suffix with everything that changes per turn (time,
+// project directory, memory).
+struct SystemPromptParts {
+    std::string stable_prefix;
+    std::string volatile_suffix;
+};
+
+// Inputs for the token budget ProjectMessages fits history into.
+struct ContextBudgetOptions {
+    std::size_t context_window_tokens = 128000;
+    // Per-model windows; a key applies when it equals or is contained in the
+    // model name, the longest matching key winning.
+    std::map<std::string, std::size_t> model_context_windows;
+    std::size_t reserve_output_tokens = 8192;
+    // tiktoken-format vocabulary; empty uses the built-in estimate.
+    std::string tokenizer_vocab;
+};
+
 class ContextBuilder {
 public:
-    ContextBuilder(std::string workspace, kabot::config::QmdConfig qmd);
+    ContextBuilder(std::string workspace,
+                   kabot::config::QmdConfig qmd,
+                   ContextBudgetOptions budget = {});
     std::string BuildSystemPrompt(const std::vector<std::string>& skill_names = {}) const;
     std::string BuildSystemPrompt(
         const std::vector<std::string>& skill_names,
         const std::string& current_message,
         const std::string& working_directory = {}) const;
+    SystemPromptParts BuildSystemPromptParts(
+        const std::vector<std::string>& skill_names,
+        const std::string& current_message,
+        const std::string& working_directory = {}) const;
     std::vector<kabot::providers::Message> BuildMessages(
         const std::vector<kabot::providers::Message>& history,
         const std::string& current_message,
@@ -33,8 +65,22 @@ public:
         const std::string& content,
         const std::vector<kabot::providers::ToolCallRequest>& tool_calls,
         const std::unordered_map<std::string, int>& usage = {}) const;
+    // Drops virtual messages, shrinks stale tool output and images, then keeps
+    // the newest whole turns that fit budget_tokens (0 = no budget). System
+    // messages and the current turn are always kept; if the current turn alone
+    // is over budget its largest tool results are truncated.
     std::vector<kabot::providers::Message> ProjectMessages(
-        std::vector<kabot::providers::Message> messages) const;
+        std::vector<kabot::providers::Message> messages,
+        std::size_t budget_tokens = 0) const;
+    // Tokens available for messages: the model's window minus the output
+    // reserve and the tool definitions.
+    std::size_t PromptBudget(
+        const std::string& model,
+        const std::vector<kabot::providers::ToolDefinition>& tools) const;
+    // Stores each message's count on the message so later iterations of the
+    // tool loop only count what is new.
+    void AnnotateTokenCounts(std::vector<kabot::providers::Message>& messages) const;
+    std::size_t CountTokens(const kabot::providers::Message& message) const;
     std::size_t EstimateTokens(
         const std::vector<kabot::providers::Message>& messages) const;
 
@@ -43,9 +89,17 @@ private:
     MemoryStore memory_;
     SkillsLoader skills_;
     kabot::config::QmdConfig qmd_;
+    FileContentCache bootstrap_files_;
+    ContextBudgetOptions budget_;
+    std::shared_ptr<const Tokenizer> tokenizer_;
+    std::shared_ptr<MemoryIndex> memory_index_;
 
     std::string LoadBootstrapFiles() const;
+    std::vector<kabot::providers::Message> FitToBudget(
+        std::vector<kabot::providers::Message> messages,
+        std::size_t budget_tokens) const;
     std::string BuildQmdContext(const std::string& query) const;
+    std::string BuildIndexedMemoryContext(const std::string& query) const;
     std::vector<kabot::providers::ContentPart> BuildUserContent(
         const std::string& text,
         const std::vector<std::string>& media) const;
@@ -0,0 +1,302 @@
+#include "agent/file_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kabot::agent {
+
+FileStamp StampFile(const std::filesystem::path& path) {
+    FileStamp stamp;
+    std::error_code ec;
+    const auto status = std::filesystem::status(path, ec);
+    if (ec || !std::filesystem::exists(status)) {
+        return stamp;
+    }
+    stamp.exists = true;
+    stamp.mtime = std::filesystem::last_write_time(path, ec);
+    if (std::filesystem::is_regular_file(status)) {
+        stamp.size = std::filesystem::file_size(path, ec);
+    }
+    return stamp;
+}
+
+std::string FileContentCache::Read(const std::filesystem::path& path) const {
+    const auto key = path.string();
+    const auto stamp = StampFile(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end() && it->second.stamp == stamp) {
+            stats_.hits += 1;
+            return it->second.content;
+        }
+        stats_.misses += 1;
+        if (!stamp.exists) {
+            entries_[key] = Entry{stamp, {}};
+            return {};
+        }
+    }
+
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return {};
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto content = buffer.str();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_[key] = Entry{stamp, content};
+    return content;
+}
+
+void FileContentCache::Append(const std::filesystem::path& path, const std::string& data) const {
+    const auto stamp = StampFile(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path.string());
+    if (it == entries_.end()) {
+        return;
+    }
+    auto& entry = it->second;
+    if (!stamp.exists || entry.content.size() + data.size() != stamp.size) {
+        entries_.erase(it);
+        return;
+    }
+    entry.content += data;
+    entry.stamp = stamp;
+}
+
+void FileContentCache::Invalidate(const std::filesystem::path& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.erase(path.string());
+}
+
+FileCacheStats FileContentCache::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+namespace {
+
+constexpr std::size_t kIndexChunkBytes = 1024 * 1024;
+
+#if !defined(_WIN32)
+// Reads up to length bytes at offset; fewer if the file ends first or
+// shrank. Returns false on a read error.
+bool ReadAt(int fd, std::size_t offset, std::size_t length, std::string& out) {
+    out.resize(length);
+    std::size_t filled = 0;
+    while (filled < length) {
+        const auto n = ::pread(fd, out.data() + filled, length - filled, static_cast<off_t>(offset + filled));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            out.clear();
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        filled += static_cast<std::size_t>(n);
+    }
+    out.resize(filled);
+    return true;
+}
+#endif
+
+// Appends the start of every line after the first found in chunk, which
+// begins at byte base of the file.
+void IndexChunk(std::string_view chunk, std::size_t base, std::vector<std::size_t>& starts) {
+    const char* cursor = chunk.data();
+    const char* end = chunk.data() + chunk.size();
+    while (const auto* newline = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor))) {
+        cursor = newline + 1;
+        starts.push_back(base + static_cast<std::size_t>(cursor - chunk.data()));
+    }
+}
+
+}  // namespace
+
+std::shared_ptr<const IndexedFile> IndexedFile::Load(const std::filesystem::path& path, FileStamp stamp) {
+    std::shared_ptr<IndexedFile> file(new IndexedFile());
+    file->stamp_ = stamp;
+    auto& starts = file->line_starts_;
+    starts.push_back(0);
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (size < kabot::MappedFile::kMapThreshold) {
+        const bool ok = ReadAt(fd, 0, size, file->content_);
+        ::close(fd);
+        if (!ok) {
+            return nullptr;
+        }
+        file->size_ = file->content_.size();
+        IndexChunk(file->content_, 0, starts);
+    } else {
+        file->fd_ = fd;  // closed by the destructor
+        std::string chunk;
+        while (file->size_ < size) {
+            if (!ReadAt(fd, file->size_, std::min(kIndexChunkBytes, size - file->size_), chunk)) {
+                return nullptr;
+            }
+            if (chunk.empty()) {
+                break;  // shrank since fstat
+            }
+            IndexChunk(chunk, file->size_, starts);
+            file->size_ += chunk.size();
+            file->trailing_newline_ = chunk.back() == '\n';
+        }
+    }
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        return nullptr;
+    }
+    std::ostringstream stream;
+    stream << input.rdbuf();
+    file->content_ = stream.str();
+    file->size_ = file->content_.size();
+    IndexChunk(file->content_, 0, starts);
+#endif
+    if (file->Resident()) {
+        file->trailing_newline_ = !file->content_.empty() && file->content_.back() == '\n';
+    }
+    // A terminating newline does not open another line; an empty file has none.
+    if (!starts.empty() && starts.back() == file->size_) {
+        starts.pop_back();
+    }
+    return file;
+}
+
+IndexedFile::~IndexedFile() {
+#if !defined(_WIN32)
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#endif
+}
+
+std::string IndexedFile::Read(std::size_t offset, std::size_t length) const {
+    if (offset >= size_) {
+        return {};
+    }
+    length = std::min(length, size_ - offset);
+    if (Resident()) {
+        return content_.substr(offset, length);
+    }
+    std::string out;
+#if !defined(_WIN32)
+    ReadAt(fd_, offset, length, out);
+#endif
+    return out;
+}
+
+std::size_t IndexedFile::LineEnd(std::size_t line) const {
+    if (line < line_starts_.size()) {
+        return line_starts_[line] - 1;
+    }
+    return trailing_newline_ ? size_ - 1 : size_;
+}
+
+std::string IndexedFile::Line(std::size_t line) const {
+    return Lines(line, line);
+}
+
+std::string IndexedFile::Lines(std::size_t first, std::size_t last) const {
+    if (first == 0 || first > last || first > line_starts_.size()) {
+        return {};
+    }
+    last = std::min(last, line_starts_.size());
+    const auto begin = line_starts_[first - 1];
+    return Read(begin, LineEnd(last) - begin);
+}
+
+std::size_t IndexedFile::LineAt(std::size_t offset) const {
+    return static_cast<std::size_t>(
+        std::upper_bound(line_starts_.begin(), line_starts_.end(), offset) - line_starts_.begin());
+}
+
+IndexedFileCache::IndexedFileCache(std::size_t max_files)
+    : max_files_(std::max<std::size_t>(max_files, 1)) {}
+
+IndexedFileCache& IndexedFileCache::Shared() {
+    static IndexedFileCache cache;
+    return cache;
+}
+
+std::shared_ptr<const IndexedFile> IndexedFileCache::Open(const std::filesystem::path& path) const {
+    const auto key = path.string();
+    const auto stamp = StampFile(path);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) {
+            if (it->second.file->Stamp() == stamp) {
+                stats_.hits += 1;
+                lru_.splice(lru_.begin(), lru_, it->second.position);
+                return it->second.file;
+            }
+            lru_.erase(it->second.position);
+            entries_.erase(it);
+        }
+        stats_.misses += 1;
+    }
+    if (!stamp.exists) {
+        return nullptr;
+    }
+
+    auto file = IndexedFile::Load(path, stamp);
+    if (!file) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+        lru_.erase(it->second.position);
+        entries_.erase(it);
+    }
+    lru_.push_front(key);
+    entries_[key] = Entry{file, lru_.begin()};
+    while (entries_.size() > max_files_) {
+        entries_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    return file;
+}
+
+void IndexedFileCache::Invalidate(const std::filesystem::path& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path.string());
+    if (it != entries_.end()) {
+        lru_.erase(it->second.position);
+        entries_.erase(it);
+    }
+}
+
+FileCacheStats IndexedFileCache::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+}  // namespace kabot::agent
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/mapped_file.hpp"
+
+namespace kabot::agent {
+
+// What a single stat() tells us about a file: enough to decide whether a
+// previously read copy is still current without opening it again.
+struct FileStamp {
+    bool exists = false;
+    std::filesystem::file_time_type mtime{};
+    std::uintmax_t size = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return exists == other.exists && mtime == other.mtime && size == other.size;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+FileStamp StampFile(const std::filesystem::path& path);
+
+struct FileCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+};
+
+// Caches file contents by path. Every Read() costs one stat; the file is
+// only re-read when its size or mtime changed since the cached copy.
+// Missing files read as empty. Safe to share between threads.
+class FileContentCache {
+public:
+    std::string Read(const std::filesystem::path& path) const;
+    // Records bytes the caller just appended to path, so the cached copy stays
+    // current without a re-read. Drops the entry if the file's new size shows
+    // someone else wrote to it too.
+    void Append(const std::filesystem::path& path, const std::string& data) const;
+    void Invalidate(const std::filesystem::path& path) const;
+    FileCacheStats Stats() const;
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        std::string content;
+    };
+
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<std::string, Entry> entries_;
+    mutable FileCacheStats stats_;
+};
+
+// A file whose line-start offsets are computed once when it is loaded, so
+// any window of lines is found in O(log n) and read in O(window). Files under
+// kabot::MappedFile::kMapThreshold are held in memory; larger ones keep only
+// the index and an open descriptor and read windows with pread, so a
+// truncation underneath shortens the read instead of faulting.
+// Lines follow std::getline: split on '\n', the terminator not included.
+class IndexedFile {
+public:
+    // nullptr when path is not a readable regular file.
+    static std::shared_ptr<const IndexedFile> Load(const std::filesystem::path& path, FileStamp stamp);
+    ~IndexedFile();
+    IndexedFile(const IndexedFile&) = delete;
+    IndexedFile& operator=(const IndexedFile&) = delete;
+
+    const FileStamp& Stamp() const { return stamp_; }
+    std::size_t Size() const { return size_; }
+    bool Resident() const { return fd_ < 0; }
+    // Bytes [offset, offset + length), clamped to the end of the file.
+    std::string Read(std::size_t offset, std::size_t length) const;
+    std::size_t LineCount() const { return line_starts_.size(); }
+    // 1-based; empty for a line past the end.
+    std::string Line(std::size_t line) const;
+    // Lines first..last (1-based, inclusive) joined with '\n', in one read.
+    std::string Lines(std::size_t first, std::size_t last) const;
+    // 1-based line containing byte offset.
+    std::size_t LineAt(std::size_t offset) const;
+
+private:
+    IndexedFile() = default;
+
+    FileStamp stamp_;
+    std::size_t size_ = 0;
+    std::string content_;  // the whole file while Resident()
+    int fd_ = -1;
+    bool trailing_newline_ = false;
+    std::vector<std::size_t> line_starts_;
+
+    std::size_t LineEnd(std::size_t line) const;
+};
+
+// Shares IndexedFiles across tools and calls. Open() stats the file and
+// hands back the cached entry while size and mtime are unchanged, so paging
+// through a file never re-reads or re-indexes it. Keeps the most recently
+// used max_files entries; none of them holds a memory mapping.
+class IndexedFileCache {
+public:
+    explicit IndexedFileCache(std::size_t max_files = 64);
+
+    static IndexedFileCache& Shared();
+
+    // nullptr when the path is not a readable regular file.
+    std::shared_ptr<const IndexedFile> Open(const std::filesystem::path& path) const;
+    void Invalidate(const std::filesystem::path& path) const;
+    FileCacheStats Stats() const;
+
+private:
+    using Lru = std::list<std::string>;
+    struct Entry {
+        std::shared_ptr<const IndexedFile> file;
+        Lru::iterator position;
+    };
+
+    std::size_t max_files_;
+    mutable std::mutex mutex_;
+    mutable Lru lru_;
+    mutable std::unordered_map<std::string, Entry> entries_;
+    mutable FileCacheStats stats_;
+};
+
+}  // namespace kabot::agent
@@ -0,0 +1,478 @@
+#include "agent/memory_index.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "nlohmann/json.hpp"
+#include "utils/logging.hpp"
+
+namespace kabot::agent {
+namespace {
+
+constexpr double kBm25K1 = 1.2;
+constexpr double kBm25B = 0.75;
+constexpr std::size_t kMaxChunkChars = 800;
+constexpr int kSnapshotVersion = 1;
+constexpr auto kSnapshotInterval = std::chrono::seconds(30);
+
+bool IsCjk(char32_t cp) {
+    return (cp >= 0x2E80 && cp <= 0x9FFF) ||
+           (cp >= 0xAC00 && cp <= 0xD7AF) ||
+           (cp >= 0xF900 && cp <= 0xFAFF) ||
+           (cp >= 0x20000 && cp <= 0x2FFFF);
+}
+
+// Lowercased ASCII alphanumeric runs (non-ASCII letters stay inside the run),
+// with every CJK character as a term of its own since CJK text has no spaces.
+std::vector<std::string> Tokenize(const std::string& text) {
+    std::vector<std::string> terms;
+    std::string current;
+    const auto flush = [&] {
+        if (!current.empty()) {
+            terms.push_back(std::move(current));
+            current.clear();
+        }
+    };
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        if (lead < 0x80) {
+            if (std::isalnum(lead)) {
+                current.push_back(static_cast<char>(std::tolower(lead)));
+            } else {
+                flush();
+            }
+            ++i;
+            continue;
+        }
+        std::size_t len = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        len = std::min(len, text.size() - i);
+        char32_t cp = len == 4 ? (lead & 0x07) : len == 3 ? (lead & 0x0F) : (lead & 0x1F);
+        for (std::size_t k = 1; k < len; ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        if (IsCjk(cp)) {
+            flush();
+            terms.emplace_back(text, i, len);
+        } else {
+            current.append(text, i, len);
+        }
+        i += len;
+    }
+    flush();
+    return terms;
+}
+
+std::vector<std::pair<std::string, std::uint32_t>> CountTerms(const std::string& text, std::uint32_t& length) {
+    std::unordered_map<std::string, std::uint32_t> counts;
+    const auto terms = Tokenize(text);
+    for (const auto& term : terms) {
+        counts[term] += 1;
+    }
+    length = static_cast<std::uint32_t>(terms.size());
+    return {counts.begin(), counts.end()};
+}
+
+bool IsBlank(const std::string& line) {
+    return line.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+// Splits markdown into chunks at blank lines and headings, capping each at
+// kMaxChunkChars on a line boundary. Returns (first line, text) pairs.
+std::vector<std::pair<std::size_t, std::string>> SplitChunks(const std::string& content) {
+    std::vector<std::pair<std::size_t, std::string>> chunks;
+    std::istringstream input(content);
+    std::string line;
+    std::string current;
+    std::size_t current_line = 0;
+    std::size_t line_no = 0;
+    const auto flush = [&] {
+        if (!current.empty()) {
+            chunks.emplace_back(current_line, std::move(current));
+            current.clear();
+        }
+    };
+    // A heading stays with the paragraph under it.
+    bool heading_only = false;
+    while (std::getline(input, line)) {
+        ++line_no;
+        if (IsBlank(line)) {
+            if (!heading_only) {
+                flush();
+            }
+            continue;
+        }
+        const bool heading = line[0] == '#';
+        if ((heading && !heading_only) || current.size() + line.size() > kMaxChunkChars) {
+            flush();
+        }
+        heading_only = heading && (current.empty() || heading_only);
+        if (current.empty()) {
+            current_line = line_no;
+        } else {
+            current.push_back('\n');
+        }
+        current += line;
+    }
+    flush();
+    return chunks;
+}
+
+std::int64_t MtimeTicks(const std::filesystem::path& path, std::error_code& ec) {
+    return static_cast<std::int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+}
+
+std::mutex& RegistryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::unordered_map<std::string, std::weak_ptr<MemoryIndex>>& Registry() {
+    static std::unordered_map<std::string, std::weak_ptr<MemoryIndex>> registry;
+    return registry;
+}
+
+}  // namespace
+
+MemoryIndex::MemoryIndex(std::string workspace, std::vector<std::string> roots)
+    : workspace_(std::move(workspace))
+    , roots_(std::move(roots))
+    , snapshot_path_((std::filesystem::path(workspace_) / "memory" / ".bm25-index.json").string()) {}
+
+MemoryIndex::~MemoryIndex() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_) {
+        SaveSnapshotLocked();
+    }
+}
+
+std::shared_ptr<MemoryIndex> MemoryIndex::Shared(const std::string& workspace,
+                                                 const std::vector<std::string>& roots) {
+    std::string key = workspace;
+    for (const auto& root : roots) {
+        key += '\n' + root;
+    }
+    std::lock_guard<std::mutex> lock(RegistryMutex());
+    auto& slot = Registry()[key];
+    if (auto existing = slot.lock()) {
+        return existing;
+    }
+    auto index = std::make_shared<MemoryIndex>(workspace, roots);
+    slot = index;
+    return index;
+}
+
+void MemoryIndex::Touch(const std::string& path) {
+    std::vector<std::shared_ptr<MemoryIndex>> live;
+    {
+        std::lock_guard<std::mutex> lock(RegistryMutex());
+        for (const auto& [key, weak] : Registry()) {
+            if (auto index = weak.lock()) {
+                live.push_back(std::move(index));
+            }
+        }
+    }
+    for (const auto& index : live) {
+        const auto relative = std::filesystem::path(path).lexically_relative(index->workspace_).generic_string();
+        std::lock_guard<std::mutex> lock(index->mutex_);
+        if (!index->loaded_ || relative.empty() || relative.rfind("..", 0) == 0 || !index->CoversLocked(relative)) {
+            continue;
+        }
+        index->touched_.insert(relative);
+    }
+}
+
+std::vector<MemoryHit> MemoryIndex::Search(const std::string& query,
+                                           std::size_t max_results,
+                                           double min_score) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EnsureLoadedLocked();
+    RefreshLocked();
+    if (live_chunks_ == 0 || max_results == 0) {
+        return {};
+    }
+
+    auto terms = Tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    const auto n = static_cast<double>(live_chunks_);
+    const auto avg_length = std::max(1.0, static_cast<double>(total_length_) / n);
+    std::unordered_map<std::uint32_t, double> scores;
+    // Reference score: every indexed query term occurring once in a chunk of
+    // average length. Dividing by it (capped at 1) keeps min_score on the same
+    // 0..1 scale qmd used. Terms absent from the index are left out so chatty
+    // queries are not penalized.
+    double max_score = 0.0;
+    for (const auto& term : terms) {
+        auto it = postings_.find(term);
+        if (it == postings_.end()) {
+            continue;
+        }
+        const auto df = static_cast<double>(it->second.size());
+        const auto idf = std::log(1.0 + (n - df + 0.5) / (df + 0.5));
+        max_score += idf;
+        for (const auto& posting : it->second) {
+            const auto tf = static_cast<double>(posting.tf);
+            const auto length = static_cast<double>(chunks_[posting.chunk].length);
+            scores[posting.chunk] += idf * tf * (kBm25K1 + 1.0) /
+                (tf + kBm25K1 * (1.0 - kBm25B + kBm25B * length / avg_length));
+        }
+    }
+    if (max_score <= 0.0) {
+        return {};
+    }
+
+    std::vector<std::pair<double, std::uint32_t>> ranked;
+    ranked.reserve(scores.size());
+    for (const auto& [chunk, score] : scores) {
+        const auto normalized = std::min(1.0, score / max_score);
+        if (normalized >= min_score) {
+            ranked.emplace_back(normalized, chunk);
+        }
+    }
+    const auto take = std::min(max_results, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(take), ranked.end(),
+                      [](const auto& a, const auto& b) {
+                          return a.first != b.first ? a.first > b.first : a.second < b.second;
+                      });
+
+    std::vector<MemoryHit> hits;
+    hits.reserve(take);
+    for (std::size_t i = 0; i < take; ++i) {
+        const auto& chunk = chunks_[ranked[i].second];
+        hits.push_back(MemoryHit{chunk.path, chunk.line, chunk.text, ranked[i].first});
+    }
+    return hits;
+}
+
+void MemoryIndex::Refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    EnsureLoadedLocked();
+    RefreshLocked();
+}
+
+void MemoryIndex::SaveSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SaveSnapshotLocked();
+}
+
+std::size_t MemoryIndex::ChunkCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_chunks_;
+}
+
+void MemoryIndex::EnsureLoadedLocked() {
+    if (loaded_) {
+        return;
+    }
+    loaded_ = true;
+    LoadSnapshotLocked();
+}
+
+void MemoryIndex::RefreshLocked() {
+    std::unordered_map<std::string, bool> seen;
+    for (const auto& root : roots_) {
+        const auto root_path = std::filesystem::path(workspace_) / root;
+        std::error_code ec;
+        if (!std::filesystem::is_directory(root_path, ec)) {
+            continue;
+        }
+        for (std::filesystem::recursive_directory_iterator it(root_path, ec), end; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file(ec) || it->path().extension() != ".md") {
+                continue;
+            }
+            const auto relative = it->path().lexically_relative(workspace_).generic_string();
+            seen[relative] = true;
+            const auto size = it->file_size(ec);
+            const auto mtime = MtimeTicks(it->path(), ec);
+            if (ec) {
+                continue;
+            }
+            auto existing = files_.find(relative);
+            if (existing == files_.end() || existing->second.size != size || existing->second.mtime != mtime ||
+                touched_.count(relative)) {
+                IndexFileLocked(relative, mtime, size);
+            }
+        }
+    }
+    touched_.clear();
+    std::vector<std::string> removed;
+    for (const auto& [relative, entry] : files_) {
+        if (!seen.count(relative)) {
+            removed.push_back(relative);
+        }
+    }
+    for (const auto& relative : removed) {
+        RemoveFileLocked(relative);
+    }
+    if (dirty_ && std::chrono::steady_clock::now() - last_saved_ >= kSnapshotInterval) {
+        SaveSnapshotLocked();
+    }
+}
+
+bool MemoryIndex::CoversLocked(const std::string& relative) const {
+    for (const auto& root : roots_) {
+        if (relative.size() > root.size() && relative.compare(0, root.size(), root) == 0 &&
+            relative[root.size()] == '/') {
+            return std::filesystem::path(relative).extension() == ".md";
+        }
+    }
+    return false;
+}
+
+void MemoryIndex::IndexFileLocked(const std::string& relative, std::int64_t mtime, std::uintmax_t size) {
+    std::ifstream file(std::filesystem::path(workspace_) / relative);
+    if (!file.is_open()) {
+        RemoveFileLocked(relative);
+        return;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+
+    RemoveFileLocked(relative);
+    auto& entry = files_[relative];
+    entry.mtime = mtime;
+    entry.size = size;
+    for (auto& [line, text] : SplitChunks(buffer.str())) {
+        std::uint32_t length = 0;
+        auto terms = CountTerms(text, length);
+        AddChunkLocked(entry, relative, line, std::move(text), std::move(terms));
+    }
+    dirty_ = true;
+    LOG_DEBUG("[memory_index] indexed path={} chunks={}", relative, entry.chunks.size());
+}
+
+void MemoryIndex::RemoveFileLocked(const std::string& relative) {
+    auto it = files_.find(relative);
+    if (it == files_.end()) {
+        return;
+    }
+    for (const auto id : it->second.chunks) {
+        auto& chunk = chunks_[id];
+        for (const auto& [term, tf] : chunk.terms) {
+            auto posting = postings_.find(term);
+            if (posting == postings_.end()) {
+                continue;
+            }
+            auto& list = posting->second;
+            list.erase(std::remove_if(list.begin(), list.end(),
+                                      [id](const Posting& p) { return p.chunk == id; }),
+                       list.end());
+            if (list.empty()) {
+                postings_.erase(posting);
+            }
+        }
+        total_length_ -= chunk.length;
+        live_chunks_ -= 1;
+        chunk = Chunk{};
+        free_chunks_.push_back(id);
+    }
+    files_.erase(it);
+    dirty_ = true;
+}
+
+void MemoryIndex::AddChunkLocked(FileEntry& entry,
+                                 const std::string& relative,
+                                 std::size_t line,
+                                 std::string text,
+                                 std::vector<std::pair<std::string, std::uint32_t>> terms) {
+    std::uint32_t id = 0;
+    if (!free_chunks_.empty()) {
+        id = free_chunks_.back();
+        free_chunks_.pop_back();
+    } else {
+        id = static_cast<std::uint32_t>(chunks_.size());
+        chunks_.emplace_back();
+    }
+    auto& chunk = chunks_[id];
+    chunk.path = relative;
+    chunk.line = line;
+    chunk.text = std::move(text);
+    chunk.terms = std::move(terms);
+    chunk.length = 0;
+    for (const auto& [term, tf] : chunk.terms) {
+        postings_[term].push_back(Posting{id, tf});
+        chunk.length += tf;
+    }
+    entry.chunks.push_back(id);
+    total_length_ += chunk.length;
+    live_chunks_ += 1;
+}
+
+void MemoryIndex::LoadSnapshotLocked() {
+    std::ifstream file(snapshot_path_);
+    if (!file.is_open()) {
+        return;
+    }
+    try {
+        const auto data = nlohmann::json::parse(file);
+        if (data.value("version", 0) != kSnapshotVersion || !data.contains("files")) {
+            return;
+        }
+        for (const auto& [relative, file_data] : data["files"].items()) {
+            auto& entry = files_[relative];
+            entry.mtime = file_data.value("mtime", std::int64_t{0});
+            entry.size = file_data.value("size", std::uintmax_t{0});
+            for (const auto& chunk_data : file_data["chunks"]) {
+                std::vector<std::pair<std::string, std::uint32_t>> terms;
+                for (const auto& [term, tf] : chunk_data["terms"].items()) {
+                    terms.emplace_back(term, tf.get<std::uint32_t>());
+                }
+                AddChunkLocked(entry,
+                               relative,
+                               chunk_data.value("line", std::size_t{0}),
+                               chunk_data.value("text", std::string{}),
+                               std::move(terms));
+            }
+        }
+        LOG_INFO("[memory_index] loaded snapshot files={} chunks={}", files_.size(), live_chunks_);
+    } catch (const std::exception& ex) {
+        LOG_WARN("[memory_index] ignoring snapshot {}: {}", snapshot_path_, ex.what());
+        files_.clear();
+        chunks_.clear();
+        free_chunks_.clear();
+        postings_.clear();
+        live_chunks_ = 0;
+        total_length_ = 0;
+    }
+}
+
+void MemoryIndex::SaveSnapshotLocked() {
+    nlohmann::json files = nlohmann::json::object();
+    for (const auto& [relative, entry] : files_) {
+        nlohmann::json chunks = nlohmann::json::array();
+        for (const auto id : entry.chunks) {
+            const auto& chunk = chunks_[id];
+            nlohmann::json terms = nlohmann::json::object();
+            for (const auto& [term, tf] : chunk.terms) {
+                terms[term] = tf;
+            }
+            chunks.push_back({{"line", chunk.line}, {"text", chunk.text}, {"terms", std::move(terms)}});
+        }
+        files[relative] = {{"mtime", entry.mtime}, {"size", entry.size}, {"chunks", std::move(chunks)}};
+    }
+    const nlohmann::json data = {{"version", kSnapshotVersion}, {"files", std::move(files)}};
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(snapshot_path_).parent_path(), ec);
+    const auto tmp_path = snapshot_path_ + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::trunc);
+        if (!out.is_open()) {
+            return;
+        }
+        out << data.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    }
+    std::filesystem::rename(tmp_path, snapshot_path_, ec);
+    if (!ec) {
+        dirty_ = false;
+        last_saved_ = std::chrono::steady_clock::now();
+    }
+}
+
+}  // namespace kabot::agent
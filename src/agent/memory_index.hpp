@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace kabot::agent {
+
+struct MemoryHit {
+    std::string path;      // relative to the workspace
+    std::size_t line = 0;  // first line of the chunk, 1-based
+    std::string text;
+    double score = 0.0;    // BM25 normalized to [0, 1]
+};
+
+// In-process BM25 index over the markdown files under a workspace's memory
+// roots. Files are split into paragraph-sized chunks. Each Search() stats the
+// roots and re-reads only files whose size or mtime changed, so writes from
+// any MemoryStore are picked up without a rebuild. The index is persisted as
+// a snapshot next to the memory files so a restart only re-reads what changed
+// while the process was down.
+class MemoryIndex {
+public:
+    MemoryIndex(std::string workspace, std::vector<std::string> roots);
+    ~MemoryIndex();
+    MemoryIndex(const MemoryIndex&) = delete;
+    MemoryIndex& operator=(const MemoryIndex&) = delete;
+
+    // One index per workspace and root set, shared by every ContextBuilder.
+    static std::shared_ptr<MemoryIndex> Shared(const std::string& workspace,
+                                               const std::vector<std::string>& roots);
+    // Marks path stale in every live index that covers it, so the next search
+    // reindexes it without depending on mtime granularity. Called by writers;
+    // does no file I/O itself.
+    static void Touch(const std::string& path);
+
+    std::vector<MemoryHit> Search(const std::string& query,
+                                  std::size_t max_results,
+                                  double min_score);
+    void Refresh();
+    void SaveSnapshot();
+    std::size_t ChunkCount() const;
+
+private:
+    struct Chunk {
+        std::string path;
+        std::size_t line = 0;
+        std::string text;
+        std::vector<std::pair<std::string, std::uint32_t>> terms;
+        std::uint32_t length = 0;
+    };
+    struct Posting {
+        std::uint32_t chunk = 0;
+        std::uint32_t tf = 0;
+    };
+    struct FileEntry {
+        std::int64_t mtime = 0;
+        std::uintmax_t size = 0;
+        std::vector<std::uint32_t> chunks;
+    };
+
+    std::string workspace_;
+    std::vector<std::string> roots_;
+    std::string snapshot_path_;
+
+    mutable std::mutex mutex_;
+    bool loaded_ = false;
+    bool dirty_ = false;
+    std::chrono::steady_clock::time_point last_saved_{};
+    std::vector<Chunk> chunks_;
+    std::vector<std::uint32_t> free_chunks_;
+    std::unordered_map<std::string, std::vector<Posting>> postings_;
+    std::unordered_map<std::string, FileEntry> files_;
+    std::unordered_set<std::string> touched_;  // reindexed on the next refresh
+    std::size_t live_chunks_ = 0;
+    std::uint64_t total_length_ = 0;
+
+    void EnsureLoadedLocked();
+    void RefreshLocked();
+    bool CoversLocked(const std::string& relative) const;
+    void IndexFileLocked(const std::string& relative, std::int64_t mtime, std::uintmax_t size);
+    void RemoveFileLocked(const std::string& relative);
+    void AddChunkLocked(FileEntry& entry,
+                        const std::string& relative,
+                        std::size_t line,
+                        std::string text,
+                        std::vector<std::pair<std::string, std::uint32_t>> terms);
+    void LoadSnapshotLocked();
+    void SaveSnapshotLocked();
+};
+
+}  // namespace kabot::agent
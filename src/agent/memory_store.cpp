@@ -1,15 +1,107 @@
 #include "agent/memory_store.hpp"
 
+#include <cerrno>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "agent/memory_index.hpp"
+#include "utils/logging.hpp"
+#include "utils/timer_service.hpp"
 
 namespace kabot::agent {
 
-MemoryStore::MemoryStore(std::string workspace)
+struct MemoryStore::Journal {
+    std::mutex write_mutex;
+    FileContentCache files;
+    std::string open_path;
+    int fd = -1;
+    bool unsynced = false;
+    bool flush_scheduled = false;
+    std::chrono::steady_clock::time_point last_sync{};
+
+    ~Journal() {
+        CloseLocked();
+    }
+
+    void SyncLocked() {
+        if (fd >= 0 && unsynced) {
+            FsyncLocked();
+            last_sync = std::chrono::steady_clock::now();
+            unsynced = false;
+        }
+    }
+
+    // A failed fsync is not retried: the kernel may already have dropped the
+    // dirty pages, so the only useful thing left is to report it.
+    void FsyncLocked() const {
+        if (::fsync(fd) != 0) {
+            LOG_ERROR("[memory] fsync failed path={} errno={}", open_path, errno);
+        }
+    }
+
+    void CloseLocked() {
+        if (fd < 0) {
+            return;
+        }
+        SyncLocked();
+        ::close(fd);
+        fd = -1;
+        open_path.clear();
+    }
+
+    // Keeps the day file open across appends; reopens on rollover or when the
+    // file was removed underneath us.
+    bool OpenLocked(const std::string& path) {
+        if (fd >= 0 && open_path == path) {
+            struct stat st {};
+            if (::fstat(fd, &st) == 0 && st.st_nlink > 0) {
+                return true;
+            }
+        }
+        CloseLocked();
+        fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        open_path = path;
+        return true;
+    }
+};
+
+namespace {
+
+bool WriteAll(int fd, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        const auto n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+}  // namespace
+
+MemoryStore::MemoryStore(std::string workspace, MemoryStoreOptions options)
     : workspace_(std::move(workspace))
-    , memory_dir_(workspace_ + "/memory") {
+    , memory_dir_(workspace_ + "/memory")
+    , options_(options)
+    , journal_(SharedJournal(memory_dir_)) {
     std::filesystem::create_directories(memory_dir_);
 }
 
@@ -35,20 +127,44 @@ std::string MemoryStore::ReadToday() const {
 
 void MemoryStore::AppendToday(const std::string& content) const {
     const auto path = TodayFilePath();
-    std::string updated = content;
-    if (std::filesystem::exists(path)) {
-        const auto existing = ReadFileIfExists(path);
-        if (!existing.empty()) {
-            updated = existing + "\n" + content;
-        }
-    } else {
-        const auto header = "# " + TodayDate() + "\n\n";
-        updated = header + content;
+    if (AppendJournal(path, content)) {
+        MemoryIndex::Touch(path);
     }
-    std::ofstream file(path, std::ios::trunc);
-    if (file.is_open()) {
-        file << updated;
+}
+
+bool MemoryStore::AppendJournal(const std::string& path, const std::string& content) const {
+    std::lock_guard<std::mutex> lock(journal_->write_mutex);
+    if (!journal_->OpenLocked(path)) {
+        LOG_WARN("[memory] failed to open journal path={} errno={}", path, errno);
+        return false;
     }
+    // flock keeps appends from other processes on this workspace whole.
+    ::flock(journal_->fd, LOCK_EX);
+    struct stat st {};
+    const bool fresh = ::fstat(journal_->fd, &st) == 0 && st.st_size == 0;
+    const auto entry = fresh ? "# " + TodayDate() + "\n\n" + content : "\n" + content;
+    const bool ok = WriteAll(journal_->fd, entry);
+    ::flock(journal_->fd, LOCK_UN);
+    if (!ok) {
+        LOG_WARN("[memory] failed to append journal path={} errno={}", path, errno);
+        journal_->files.Invalidate(path);
+        return false;
+    }
+    journal_->files.Append(path, entry);
+
+    if (options_.fsync_interval_ms >= 0) {
+        const auto interval = std::chrono::milliseconds(options_.fsync_interval_ms);
+        const auto now = std::chrono::steady_clock::now();
+        if (now - journal_->last_sync >= interval) {
+            journal_->FsyncLocked();
+            journal_->last_sync = now;
+            journal_->unsynced = false;
+        } else {
+            journal_->unsynced = true;
+            ScheduleFlushLocked(journal_->last_sync + interval);
+        }
+    }
+    return true;
 }
 
 std::string MemoryStore::ReadLongTerm() const {
@@ -56,10 +172,51 @@ std::string MemoryStore::ReadLongTerm() const {
 }
 
 void MemoryStore::WriteLongTerm(const std::string& content) const {
-    std::ofstream file(MemoryFilePath(), std::ios::trunc);
-    if (file.is_open()) {
-        file << content;
+    const auto path = MemoryFilePath();
+    const auto tmp_path = path + ".tmp";
+    {
+        std::lock_guard<std::mutex> lock(journal_->write_mutex);
+        {
+            std::ofstream file(tmp_path, std::ios::trunc);
+            if (!file.is_open()) {
+                return;
+            }
+            file << content;
+        }
+        // Replace atomically so a crash leaves either the old or the new file.
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) {
+            LOG_WARN("[memory] failed to replace {}: {}", path, ec.message());
+        }
+        journal_->files.Invalidate(path);
+    }
+    MemoryIndex::Touch(path);
+}
+
+void MemoryStore::Flush() const {
+    std::lock_guard<std::mutex> lock(journal_->write_mutex);
+    journal_->SyncLocked();
+}
+
+// The last append of a burst would otherwise stay unsynced until the next
+// append or shutdown; one deferred flush per interval closes that window.
+void MemoryStore::ScheduleFlushLocked(std::chrono::steady_clock::time_point deadline) const {
+    if (journal_->flush_scheduled) {
+        return;
     }
+    journal_->flush_scheduled = true;
+    std::weak_ptr<Journal> weak = journal_;
+    kabot::TimerService::Shared().ScheduleAt(deadline, [weak] {
+        // fsync may block on the disk; keep it off the timer thread.
+        std::thread([weak] {
+            if (auto journal = weak.lock()) {
+                std::lock_guard<std::mutex> lock(journal->write_mutex);
+                journal->flush_scheduled = false;
+                journal->SyncLocked();
+            }
+        }).detach();
+    });
 }
 
 std::string MemoryStore::GetRecentMemories(int days) const {
@@ -81,13 +238,7 @@ std::string MemoryStore::GetRecentMemories(int days) const {
 }
 
 std::string MemoryStore::ReadFileIfExists(const std::string& path) const {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return {};
-    }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return journal_->files.Read(path);
 }
 
 std::string MemoryStore::TodayDate() const {
@@ -126,4 +277,17 @@ std::string MemoryStore::DateStringDaysAgo(int days) const {
     return std::string(buffer);
 }
 
+std::shared_ptr<MemoryStore::Journal> MemoryStore::SharedJournal(const std::string& memory_dir) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::weak_ptr<MemoryStore::Journal>> journals;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& slot = journals[memory_dir];
+    if (auto existing = slot.lock()) {
+        return existing;
+    }
+    auto journal = std::make_shared<MemoryStore::Journal>();
+    slot = journal;
+    return journal;
+}
+
 }  // namespace kabot::agent
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
 
+#include "agent/file_cache.hpp"
+
 namespace kabot::agent {
 
+struct MemoryStoreOptions {
+    // < 0 leaves syncing to the OS, 0 fsyncs every append, > 0 lets appends
+    // within the interval share one fsync.
+    int fsync_interval_ms = -1;
+};
+
+// Daily notes are an append-only journal: AppendToday writes only the new
+// entry. Every MemoryStore on a workspace shares one writer lock, one open
+// journal descriptor and one read cache, so readers see appends without
+// re-reading the day file.
 class MemoryStore {
 public:
-    explicit MemoryStore(std::string workspace);
+    explicit MemoryStore(std::string workspace, MemoryStoreOptions options = {});
 
     std::string GetMemoryContext() const;
     std::string GetRecentMemories(int days = 7) const;
@@ -14,11 +28,22 @@ public:
     void AppendToday(const std::string& content) const;
     std::string ReadLongTerm() const;
     void WriteLongTerm(const std::string& content) const;
+    // Syncs appends still waiting on a grouped fsync. Skipped syncs are also
+    // flushed by a deferred timer once the interval has passed.
+    void Flush() const;
 
 private:
+    struct Journal;
+
     std::string workspace_;
     std::string memory_dir_;
+    MemoryStoreOptions options_;
+    std::shared_ptr<Journal> journal_;
 
+    static std::shared_ptr<Journal> SharedJournal(const std::string& memory_dir);
+    // Appends under the journal lock; false when nothing was written.
+    bool AppendJournal(const std::string& path, const std::string& content) const;
+    void ScheduleFlushLocked(std::chrono::steady_clock::time_point deadline) const;
     std::string ReadFileIfExists(const std::string& path) const;
     std::string TodayDate() const;
     std::string DateStringDaysAgo(int days) const;
@@ -1,6 +1,7 @@
 #include "agent/skills_loader.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -8,6 +9,7 @@
 #include <sstream>
 
 #include "nlohmann/json.hpp"
+#include "utils/logging.hpp"
 
 namespace kabot::agent {
 
@@ -22,86 +24,37 @@ SkillsLoader::SkillsLoader(std::string workspace)
     }
 }
 
-std::vector<SkillsLoader::SkillInfo> SkillsLoader::ListSkills(bool filter_unavailable) const {
-    std::vector<SkillInfo> skills;
-    std::filesystem::path workspace_path(skills_dir_);
-    if (std::filesystem::exists(workspace_path)) {
-        for (const auto& entry : std::filesystem::directory_iterator(workspace_path)) {
-            if (!entry.is_directory()) {
-                continue;
-            }
-            const auto skill_file = entry.path() / "SKILL.md";
-            if (!std::filesystem::exists(skill_file)) {
-                continue;
-            }
-            skills.push_back(SkillInfo{
-                entry.path().filename().string(),
-                skill_file.string(),
-                "workspace"});
-        }
-    }
+namespace {
 
-    std::filesystem::path builtin_path(builtin_skills_dir_);
-    if (std::filesystem::exists(builtin_path)) {
-        for (const auto& entry : std::filesystem::directory_iterator(builtin_path)) {
-            if (!entry.is_directory()) {
-                continue;
-            }
-            const auto name = entry.path().filename().string();
-            const auto skill_file = entry.path() / "SKILL.md";
-            if (!std::filesystem::exists(skill_file)) {
-                continue;
-            }
-            const auto exists = std::any_of(skills.begin(), skills.end(), [&](const SkillInfo& info) {
-                return info.name == name;
-            });
-            if (!exists) {
-                skills.push_back(SkillInfo{name, skill_file.string(), "builtin"});
-            }
-        }
-    }
+// Binaries can appear on PATH without PATH itself changing, so requirement
+// checks are redone at least this often even when no skill file changed.
+constexpr auto kRequirementsRecheckInterval = std::chrono::seconds(60);
 
-    if (!filter_unavailable) {
-        return skills;
-    }
-    std::vector<SkillInfo> filtered;
-    filtered.reserve(skills.size());
-    for (const auto& skill : skills) {
-        if (CheckRequirements(GetSkillMeta(skill.name))) {
-            filtered.push_back(skill);
+std::string CurrentPathEnv() {
+    const auto* path_env = std::getenv("PATH");
+    return path_env ? std::string(path_env) : std::string();
+}
+
+}  // namespace
+
+std::vector<SkillsLoader::SkillInfo> SkillsLoader::ListSkills(bool filter_unavailable) const {
+    const auto snapshot = CurrentSnapshot();
+    std::vector<SkillInfo> skills;
+    skills.reserve(snapshot->skills.size());
+    for (const auto& skill : snapshot->skills) {
+        if (!filter_unavailable || skill.available) {
+            skills.push_back(skill.info);
         }
     }
-    return filtered;
+    return skills;
 }
 
 std::vector<std::string> SkillsLoader::LoadSkillNames() const {
+    const auto snapshot = CurrentSnapshot();
     std::vector<std::string> skills;
-    std::filesystem::path workspace_path(skills_dir_);
-    if (std::filesystem::exists(workspace_path)) {
-        for (const auto& entry : std::filesystem::directory_iterator(workspace_path)) {
-            if (entry.is_directory()) {
-                const auto skill_file = entry.path() / "SKILL.md";
-                if (std::filesystem::exists(skill_file)) {
-                    skills.push_back(entry.path().filename().string());
-                }
-            }
-        }
-    }
-
-    std::filesystem::path builtin_path(builtin_skills_dir_);
-    if (std::filesystem::exists(builtin_path)) {
-        for (const auto& entry : std::filesystem::directory_iterator(builtin_path)) {
-            if (entry.is_directory()) {
-                const auto name = entry.path().filename().string();
-                const auto skill_file = entry.path() / "SKILL.md";
-                if (!std::filesystem::exists(skill_file)) {
-                    continue;
-                }
-                if (std::find(skills.begin(), skills.end(), name) == skills.end()) {
-                    skills.push_back(name);
-                }
-            }
-        }
+    skills.reserve(snapshot->skills.size());
+    for (const auto& skill : snapshot->skills) {
+        skills.push_back(skill.info.name);
     }
     return skills;
 }
@@ -126,9 +79,117 @@ std::string SkillsLoader::LoadSkillsForContext(const std::vector<std::string>& s
 }
 
 std::string SkillsLoader::BuildSkillsSummary() const {
-    std::ostringstream oss;
-    auto skills = ListSkills(false);
-    if (skills.empty()) {
+    return CurrentSnapshot()->summary;
+}
+
+std::vector<std::string> SkillsLoader::GetAlwaysSkills() const {
+    const auto snapshot = CurrentSnapshot();
+    std::vector<std::string> result;
+    for (const auto& skill : snapshot->skills) {
+        if (skill.meta.always && skill.available) {
+            result.push_back(skill.info.name);
+        }
+    }
+    return result;
+}
+
+std::optional<std::unordered_map<std::string, std::string>> SkillsLoader::GetSkillMetadata(
+    const std::string& name) const {
+    const auto content = LoadSkillContent(name);
+    if (content.empty()) {
+        return std::nullopt;
+    }
+    if (content.rfind("---", 0) != 0) {
+        return std::nullopt;
+    }
+    const auto end = content.find("---", 3);
+    if (end == std::string::npos) {
+        return std::nullopt;
+    }
+    return ParseFrontmatter(content);
+}
+
+std::string SkillsLoader::LoadSkillContent(const std::string& name) const {
+    const auto snapshot = CurrentSnapshot();
+    const auto* skill = FindSkill(*snapshot, name);
+    return skill ? skill->content : std::string();
+}
+
+std::shared_ptr<const SkillsLoader::Snapshot> SkillsLoader::CurrentSnapshot() const {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (snapshot_ && StampsCurrent(*snapshot_)) {
+        const auto stale = std::chrono::steady_clock::now() - snapshot_->checked_at >= kRequirementsRecheckInterval;
+        if (!stale && snapshot_->path_env == CurrentPathEnv()) {
+            return snapshot_;
+        }
+        auto refreshed = std::make_shared<Snapshot>(*snapshot_);
+        RefreshAvailability(*refreshed);
+        snapshot_ = std::move(refreshed);
+        return snapshot_;
+    }
+    snapshot_ = ScanSkills();
+    LOG_DEBUG("[skills] rescanned skills={}", snapshot_->skills.size());
+    return snapshot_;
+}
+
+std::shared_ptr<SkillsLoader::Snapshot> SkillsLoader::ScanSkills() const {
+    auto snapshot = std::make_shared<Snapshot>();
+    auto scan_root = [&](const std::string& root, const char* source) {
+        const std::filesystem::path root_path(root);
+        snapshot->stamps.emplace_back(root, StampFile(root_path));
+        std::error_code ec;
+        if (!std::filesystem::is_directory(root_path, ec)) {
+            return;
+        }
+        std::vector<std::filesystem::path> dirs;
+        for (const auto& entry : std::filesystem::directory_iterator(root_path, ec)) {
+            if (entry.is_directory(ec)) {
+                dirs.push_back(entry.path());
+            }
+        }
+        // Directory iteration order is unspecified; sort so the rendered
+        // summary is byte-identical across rescans.
+        std::sort(dirs.begin(), dirs.end());
+        for (const auto& dir : dirs) {
+            const auto skill_file = dir / "SKILL.md";
+            // Absent SKILL.md files are stamped too, so creating one later
+            // invalidates the snapshot.
+            const auto stamp = StampFile(skill_file);
+            snapshot->stamps.emplace_back(skill_file.string(), stamp);
+            const auto name = dir.filename().string();
+            if (!stamp.exists || FindSkill(*snapshot, name)) {
+                continue;
+            }
+            std::ifstream file(skill_file);
+            if (!file.is_open()) {
+                continue;
+            }
+            std::stringstream buffer;
+            buffer << file.rdbuf();
+            SkillEntry entry;
+            entry.info = SkillInfo{name, skill_file.string(), source};
+            entry.content = buffer.str();
+            entry.meta = ParseSkillMeta(entry.content);
+            snapshot->skills.push_back(std::move(entry));
+        }
+    };
+    scan_root(skills_dir_, "workspace");
+    scan_root(builtin_skills_dir_, "builtin");
+    RefreshAvailability(*snapshot);
+    return snapshot;
+}
+
+void SkillsLoader::RefreshAvailability(Snapshot& snapshot) const {
+    for (auto& skill : snapshot.skills) {
+        skill.available = CheckRequirements(skill.meta);
+    }
+    snapshot.path_env = CurrentPathEnv();
+    snapshot.checked_at = std::chrono::steady_clock::now();
+    snapshot.summary = RenderSummary(snapshot);
+}
+
+std::string SkillsLoader::RenderSummary(const Snapshot& snapshot) const {
+    if (snapshot.skills.empty()) {
         return {};
     }
     auto escape_xml = [](const std::string& input) {
@@ -144,16 +205,16 @@ std::string SkillsLoader::BuildSkillsSummary() const {
         }
         return out;
     };
+    std::ostringstream oss;
     oss << "<skills>\n";
-    for (const auto& skill : skills) {
-        const auto meta = GetSkillMeta(skill.name);
-        const auto available = CheckRequirements(meta);
-        const auto description = meta.description.empty() ? skill.name : meta.description;
-        oss << "  <skill available=\"" << (available ? "true" : "false") << "\">\n";
-        oss << "    <name>" << escape_xml(skill.name) << "</name>\n";
+    for (const auto& skill : snapshot.skills) {
+        const auto& meta = skill.meta;
+        const auto description = meta.description.empty() ? skill.info.name : meta.description;
+        oss << "  <skill available=\"" << (skill.available ? "true" : "false") << "\">\n";
+        oss << "    <name>" << escape_xml(skill.info.name) << "</name>\n";
         oss << "    <description>" << escape_xml(description) << "</description>\n";
-        oss << "    <location>" << escape_xml(skill.path) << "</location>\n";
-        if (!available) {
+        oss << "    <location>" << escape_xml(skill.info.path) << "</location>\n";
+        if (!skill.available) {
             const auto missing = MissingRequirements(meta);
             if (!missing.empty()) {
                 oss << "    <requires>" << escape_xml(missing) << "</requires>\n";
@@ -165,52 +226,22 @@ std::string SkillsLoader::BuildSkillsSummary() const {
     return oss.str();
 }
 
-std::vector<std::string> SkillsLoader::GetAlwaysSkills() const {
-    std::vector<std::string> result;
-    for (const auto& skill : ListSkills(true)) {
-        const auto meta = GetSkillMeta(skill.name);
-        if (meta.always && CheckRequirements(meta)) {
-            result.push_back(skill.name);
+bool SkillsLoader::StampsCurrent(const Snapshot& snapshot) const {
+    for (const auto& [path, stamp] : snapshot.stamps) {
+        if (StampFile(path) != stamp) {
+            return false;
         }
     }
-    return result;
-}
-
-std::optional<std::unordered_map<std::string, std::string>> SkillsLoader::GetSkillMetadata(
-    const std::string& name) const {
-    const auto content = LoadSkillContent(name);
-    if (content.empty()) {
-        return std::nullopt;
-    }
-    if (content.rfind("---", 0) != 0) {
-        return std::nullopt;
-    }
-    const auto end = content.find("---", 3);
-    if (end == std::string::npos) {
-        return std::nullopt;
-    }
-    return ParseFrontmatter(content);
+    return true;
 }
 
-std::string SkillsLoader::LoadSkillContent(const std::string& name) const {
-    std::filesystem::path workspace_path = std::filesystem::path(skills_dir_) / name / "SKILL.md";
-    std::filesystem::path builtin_path = std::filesystem::path(builtin_skills_dir_) / name / "SKILL.md";
-    std::filesystem::path path;
-    if (std::filesystem::exists(workspace_path)) {
-        path = workspace_path;
-    } else if (std::filesystem::exists(builtin_path)) {
-        path = builtin_path;
-    } else {
-        return {};
-    }
-
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        return {};
+const SkillsLoader::SkillEntry* SkillsLoader::FindSkill(const Snapshot& snapshot, const std::string& name) const {
+    for (const auto& skill : snapshot.skills) {
+        if (skill.info.name == name) {
+            return &skill;
+        }
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return nullptr;
 }
 
 std::unordered_map<std::string, std::string> SkillsLoader::ParseFrontmatter(
@@ -271,9 +302,8 @@ std::string SkillsLoader::StripFrontmatter(const std::string& content) const {
     return stripped;
 }
 
-SkillsLoader::SkillMeta SkillsLoader::GetSkillMeta(const std::string& name) const {
+SkillsLoader::SkillMeta SkillsLoader::ParseSkillMeta(const std::string& content) const {
     SkillMeta meta;
-    const auto content = LoadSkillContent(name);
     if (content.empty()) {
         return meta;
     }
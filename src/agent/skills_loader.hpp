@@ -1,10 +1,15 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <optional>
 #include <unordered_map>
 
+#include "agent/file_cache.hpp"
+
 namespace kabot::agent {
 
 class SkillsLoader {
@@ -26,22 +31,50 @@ public:
         const std::string& name) const;
 
 private:
+    struct SkillMeta {
+        std::string description;
+        bool always = false;
+        std::vector<std::string> bins;
+        std::vector<std::string> envs;
+    };
+
+    struct SkillEntry {
+        SkillInfo info;
+        std::string content;
+        SkillMeta meta;
+        bool available = true;
+    };
+
+    // Everything read from the skills directories, rebuilt only when one of
+    // the stamped paths (skill roots, skill folders, SKILL.md files) changes.
+    // Requirement checks depend on PATH and installed binaries rather than
+    // files we stamp, so they are refreshed separately.
+    struct Snapshot {
+        std::vector<std::pair<std::string, FileStamp>> stamps;
+        std::vector<SkillEntry> skills;
+        std::string path_env;
+        std::chrono::steady_clock::time_point checked_at{};
+        std::string summary;
+    };
+
     std::string workspace_;
     std::string skills_dir_;
     std::string builtin_skills_dir_;
+    mutable std::mutex snapshot_mutex_;
+    mutable std::shared_ptr<const Snapshot> snapshot_;
+
+    std::shared_ptr<const Snapshot> CurrentSnapshot() const;
+    std::shared_ptr<Snapshot> ScanSkills() const;
+    void RefreshAvailability(Snapshot& snapshot) const;
+    std::string RenderSummary(const Snapshot& snapshot) const;
+    bool StampsCurrent(const Snapshot& snapshot) const;
+    const SkillEntry* FindSkill(const Snapshot& snapshot, const std::string& name) const;
 
     std::string LoadSkillContent(const std::string& name) const;
     std::unordered_map<std::string, std::string> ParseFrontmatter(const std::string& content) const;
     std::string StripFrontmatter(const std::string& content) const;
 
-    struct SkillMeta {
-        std::string description;
-        bool always = false;
-        std::vector<std::string> bins;
-        std::vector<std::string> envs;
-    };
-
-    SkillMeta GetSkillMeta(const std::string& name) const;
+    SkillMeta ParseSkillMeta(const std::string& content) const;
     SkillMeta ParseKabotMetadata(const std::string& raw) const;
     bool CheckRequirements(const SkillMeta& meta) const;
     std::string MissingRequirements(const SkillMeta& meta) const;
@@ -2,6 +2,7 @@
 
 #include <thread>
 #include <chrono>
+#include <optional>
 
 #include "agent/subagent/async_attribution.hpp"
 #include "agent/subagent/subagent_tool_filter.hpp"
@@ -22,13 +23,28 @@ SubagentRunner::SubagentRunner(kabot::providers::LLMProvider& provider,
     , workspace_(std::move(workspace))
     , defaults_(std::move(defaults)) {}
 
+namespace {
+
+RunAgentParams WithInvocationContext(const RunAgentParams& params) {
+    RunAgentParams result = params;
+    if (!result.invocation_context) {
+        if (const auto* current = kabot::agent::tools::ToolContextScope::Current()) {
+            result.invocation_context = *current;
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
 SubagentRunSummary SubagentRunner::RunSync(const RunAgentParams& params,
                                            const SubagentMessageHandler& on_message,
                                            const std::string& task_id) {
     return DoRun(params, on_message, task_id);
 }
 
-std::string SubagentRunner::RunAsync(const RunAgentParams& params) {
+std::string SubagentRunner::RunAsync(const RunAgentParams& params_in) {
+    auto params = WithInvocationContext(params_in);
     std::string task_id = task_manager_.RegisterTask(
         params.tool_use_context.agent_id,
         params.description,
@@ -104,6 +120,17 @@ SubagentRunSummary SubagentRunner::DoRun(const RunAgentParams& params,
     const auto& agent_def = params.agent_definition;
     const auto& child_ctx = params.tool_use_context;
 
+    std::optional<kabot::agent::tools::ToolContextScope> invocation_scope;
+    if (params.invocation_context) {
+        auto context = *params.invocation_context;
+        if (params.is_async) {
+            // The observer may capture the parent turn's locals by reference,
+            // and an async run outlives that turn.
+            context.outbound_observer = nullptr;
+        }
+        invocation_scope.emplace(std::move(context));
+    }
+
     std::string model = agent_def.model;
     if (model.empty() || model == "inherit") {
         model = defaults_.model.empty() ? provider_.GetDefaultModel() : defaults_.model;
@@ -126,6 +153,7 @@ SubagentRunSummary SubagentRunner::DoRun(const RunAgentParams& params,
         messages.insert(messages.begin(), sys_msg);
     } else if (agent_def.get_system_prompt) {
         messages[0].content = agent_def.get_system_prompt();
+        messages[0].content_parts.clear();
     }
 
     auto all_tools = tools_.GetDefinitions();
@@ -309,6 +337,9 @@ std::string SubagentRunner::Resume(const std::string& agent_id,
     params.tool_use_context.parent_session_id = meta.parent_session_id;
     params.worktree_path = meta.worktree_path;
     params.is_async = true;
+    if (const auto* current = kabot::agent::tools::ToolContextScope::Current()) {
+        params.invocation_context = *current;
+    }
 
     auto task = task_manager_.GetTaskByAgentId(agent_id);
     std::string task_id = task ? task->task_id : "";
@@ -88,6 +88,9 @@ SubagentService::SpawnResult SubagentService::Spawn(
     run_params.max_turns = agent_def.max_turns;
     run_params.description = input.description;
     run_params.worktree_path = input.cwd;
+    if (const auto* current = kabot::agent::tools::ToolContextScope::Current()) {
+        run_params.invocation_context = *current;
+    }
     
     if (should_run_async) {
         std::string task_id = runner_->RunAsync(run_params);
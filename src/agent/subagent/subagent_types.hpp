@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "agent/tools/tool_context.hpp"
 #include "providers/llm_provider.hpp"
 
 namespace kabot::subagent {
@@ -89,6 +90,9 @@ struct RunAgentParams {
     std::string description;
     std::string worktree_path;
     std::function<void()> on_query_progress;
+    // Routing of the parent turn; reinstalled on the subagent thread so that
+    // send_message/cron/spawn target the parent's channel and chat.
+    std::optional<kabot::agent::tools::ToolInvocationContext> invocation_context;
 };
 
 struct AgentTaskRecord {
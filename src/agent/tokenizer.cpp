@@ -0,0 +1,322 @@
+#include "agent/tokenizer.hpp"
+
+#include <climits>
+#include <fstream>
+#include <vector>
+
+#include "utils/logging.hpp"
+
+namespace kabot::agent {
+namespace {
+
+// Pieces longer than this are cut before merging; BPE over a piece is
+// quadratic and long unbroken runs (CJK text has no spaces) would stall.
+constexpr std::size_t kMaxPieceBytes = 128;
+constexpr std::size_t kMaxCachedPieces = 1 << 16;
+
+bool IsLetter(unsigned char ch) {
+    // Every non-ASCII byte counts as a letter; close enough to \p{L} for
+    // budgeting and keeps multibyte characters inside one piece.
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch >= 0x80;
+}
+
+bool IsDigit(unsigned char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+bool IsNewline(unsigned char ch) {
+    return ch == '\r' || ch == '\n';
+}
+
+bool IsSpace(unsigned char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\v' || ch == '\f' || IsNewline(ch);
+}
+
+bool IsPunct(unsigned char ch) {
+    return !IsSpace(ch) && !IsLetter(ch) && !IsDigit(ch);
+}
+
+char ToLowerAscii(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+std::size_t MatchContraction(std::string_view text, std::size_t pos) {
+    if (text[pos] != '\'' || pos + 1 >= text.size()) {
+        return 0;
+    }
+    for (const char* suffix : {"re", "ve", "ll", "s", "t", "m", "d"}) {
+        const std::string_view want(suffix);
+        if (pos + 1 + want.size() > text.size()) {
+            continue;
+        }
+        bool matched = true;
+        for (std::size_t i = 0; i < want.size(); ++i) {
+            if (ToLowerAscii(text[pos + 1 + i]) != want[i]) {
+                matched = false;
+                break;
+            }
+        }
+        if (matched) {
+            return 1 + want.size();
+        }
+    }
+    return 0;
+}
+
+// Length of the pre-tokenizer piece starting at pos, following the shape of
+// the cl100k pattern: contractions, letter runs with one optional leading
+// symbol, 1-3 digit groups, symbol runs, and whitespace runs.
+std::size_t NextPiece(std::string_view text, std::size_t pos) {
+    const auto n = text.size();
+    const auto at = [&](std::size_t i) { return static_cast<unsigned char>(text[i]); };
+
+    if (const auto len = MatchContraction(text, pos)) {
+        return len;
+    }
+    if (IsLetter(at(pos)) ||
+        (pos + 1 < n && !IsNewline(at(pos)) && !IsDigit(at(pos)) && IsLetter(at(pos + 1)))) {
+        auto end = pos + 1;
+        while (end < n && IsLetter(at(end))) {
+            ++end;
+        }
+        return end - pos;
+    }
+    if (IsDigit(at(pos))) {
+        auto end = pos;
+        while (end < n && end - pos < 3 && IsDigit(at(end))) {
+            ++end;
+        }
+        return end - pos;
+    }
+    if (IsPunct(at(pos)) || (at(pos) == ' ' && pos + 1 < n && IsPunct(at(pos + 1)))) {
+        auto end = at(pos) == ' ' ? pos + 1 : pos;
+        while (end < n && IsPunct(at(end))) {
+            ++end;
+        }
+        while (end < n && IsNewline(at(end))) {
+            ++end;
+        }
+        return end - pos;
+    }
+
+    auto end = pos;
+    std::size_t last_newline = std::string_view::npos;
+    while (end < n && IsSpace(at(end))) {
+        if (IsNewline(at(end))) {
+            last_newline = end;
+        }
+        ++end;
+    }
+    if (last_newline != std::string_view::npos) {
+        return last_newline + 1 - pos;
+    }
+    if (end < n && end - pos > 1) {
+        // Leave the last space to prefix the following word.
+        return end - pos - 1;
+    }
+    return end - pos;
+}
+
+bool DecodeBase64(const std::string& input, std::string& output) {
+    static const auto table = [] {
+        std::vector<int> values(256, -1);
+        const std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (std::size_t i = 0; i < alphabet.size(); ++i) {
+            values[static_cast<unsigned char>(alphabet[i])] = static_cast<int>(i);
+        }
+        return values;
+    }();
+    output.clear();
+    int buffer = 0;
+    int bits = 0;
+    for (const char ch : input) {
+        if (ch == '=') {
+            break;
+        }
+        const int value = table[static_cast<unsigned char>(ch)];
+        if (value < 0) {
+            return false;
+        }
+        buffer = (buffer << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+bool IsCjk(char32_t cp) {
+    return (cp >= 0x2E80 && cp <= 0x9FFF) ||   // CJK radicals, punctuation, kana, unified ideographs
+           (cp >= 0xAC00 && cp <= 0xD7AF) ||   // Hangul syllables
+           (cp >= 0xF900 && cp <= 0xFAFF) ||   // compatibility ideographs
+           (cp >= 0xFF00 && cp <= 0xFFEF) ||   // full-width forms
+           (cp >= 0x20000 && cp <= 0x2FFFF);   // extension planes
+}
+
+}  // namespace
+
+std::shared_ptr<const Tokenizer> Tokenizer::Shared(const std::string& vocab_path) {
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const Tokenizer>> instances;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = instances.find(vocab_path);
+    if (it != instances.end()) {
+        return it->second;
+    }
+    auto tokenizer = std::make_shared<Tokenizer>();
+    if (!vocab_path.empty()) {
+        if (tokenizer->LoadVocabulary(vocab_path)) {
+            LOG_INFO("[tokenizer] loaded vocab={} tokens={}", vocab_path, tokenizer->ranks_.size());
+        } else {
+            LOG_WARN("[tokenizer] failed to load vocab={}, falling back to estimates", vocab_path);
+        }
+    }
+    instances.emplace(vocab_path, tokenizer);
+    return tokenizer;
+}
+
+bool Tokenizer::LoadVocabulary(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::unordered_map<std::string, int> ranks;
+    std::string line;
+    std::string token;
+    while (std::getline(file, line)) {
+        const auto space = line.find(' ');
+        if (space == std::string::npos) {
+            continue;
+        }
+        if (!DecodeBase64(line.substr(0, space), token) || token.empty()) {
+            return false;
+        }
+        try {
+            ranks[token] = std::stoi(line.substr(space + 1));
+        } catch (...) {
+            return false;
+        }
+    }
+    if (ranks.empty()) {
+        return false;
+    }
+    ranks_ = std::move(ranks);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    piece_cache_.clear();
+    return true;
+}
+
+std::size_t Tokenizer::Count(std::string_view text) const {
+    if (text.empty()) {
+        return 0;
+    }
+    if (ranks_.empty()) {
+        return Estimate(text);
+    }
+    std::size_t total = 0;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        const auto len = NextPiece(text, pos);
+        auto piece = text.substr(pos, len);
+        pos += len;
+        while (piece.size() > kMaxPieceBytes) {
+            auto cut = kMaxPieceBytes;
+            // Do not split inside a UTF-8 sequence.
+            while (cut > 1 && (static_cast<unsigned char>(piece[cut]) & 0xC0) == 0x80) {
+                --cut;
+            }
+            total += CountPiece(piece.substr(0, cut));
+            piece.remove_prefix(cut);
+        }
+        total += CountPiece(piece);
+    }
+    return total;
+}
+
+std::size_t Tokenizer::CountPiece(std::string_view piece) const {
+    if (piece.empty()) {
+        return 0;
+    }
+    std::string key(piece);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = piece_cache_.find(key);
+        if (it != piece_cache_.end()) {
+            return it->second;
+        }
+    }
+    const auto count = MergePiece(piece);
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    if (piece_cache_.size() >= kMaxCachedPieces) {
+        piece_cache_.clear();
+    }
+    piece_cache_.emplace(std::move(key), count);
+    return count;
+}
+
+std::size_t Tokenizer::MergePiece(std::string_view piece) const {
+    if (ranks_.find(std::string(piece)) != ranks_.end()) {
+        return 1;
+    }
+    // Byte-level BPE: repeatedly merge the adjacent pair with the lowest rank.
+    std::vector<std::size_t> bounds(piece.size() + 1);
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+        bounds[i] = i;
+    }
+    std::string pair;
+    while (bounds.size() > 2) {
+        int best_rank = INT_MAX;
+        std::size_t best = 0;
+        for (std::size_t i = 0; i + 2 < bounds.size(); ++i) {
+            pair.assign(piece.data() + bounds[i], bounds[i + 2] - bounds[i]);
+            auto it = ranks_.find(pair);
+            if (it != ranks_.end() && it->second < best_rank) {
+                best_rank = it->second;
+                best = i;
+            }
+        }
+        if (best_rank == INT_MAX) {
+            break;
+        }
+        bounds.erase(bounds.begin() + static_cast<std::ptrdiff_t>(best + 1));
+    }
+    return bounds.size() - 1;
+}
+
+std::size_t Tokenizer::Estimate(std::string_view text) {
+    std::size_t cjk = 0;
+    std::size_t other_bytes = 0;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        std::size_t len = 1;
+        char32_t cp = lead;
+        if (lead >= 0xF0) {
+            len = 4;
+            cp = lead & 0x07;
+        } else if (lead >= 0xE0) {
+            len = 3;
+            cp = lead & 0x0F;
+        } else if (lead >= 0xC0) {
+            len = 2;
+            cp = lead & 0x1F;
+        }
+        if (i + len > text.size()) {
+            len = text.size() - i;
+        }
+        for (std::size_t k = 1; k < len; ++k) {
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        if (len > 1 && IsCjk(cp)) {
+            cjk += 1;
+        } else {
+            other_bytes += len;
+        }
+        i += len;
+    }
+    return cjk + (other_bytes + 3) / 4;
+}
+
+}  // namespace kabot::agent
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace kabot::agent {
+
+// Counts tokens for context budgeting. With a tiktoken-format vocabulary
+// (one "<base64 token bytes> <rank>" pair per line, e.g. cl100k_base.tiktoken)
+// text is split with an approximation of the cl100k pre-tokenizer and each
+// piece is merged with byte-level BPE. Without a vocabulary it falls back to
+// an estimate that counts CJK characters individually instead of chars/4.
+class Tokenizer {
+public:
+    Tokenizer() = default;
+    Tokenizer(const Tokenizer&) = delete;
+    Tokenizer& operator=(const Tokenizer&) = delete;
+
+    // Returns one instance per vocabulary path, loaded on first use. An empty
+    // path, or a vocabulary that fails to load, yields the estimator.
+    static std::shared_ptr<const Tokenizer> Shared(const std::string& vocab_path);
+
+    bool LoadVocabulary(const std::string& path);
+    bool HasVocabulary() const { return !ranks_.empty(); }
+    std::size_t Count(std::string_view text) const;
+
+private:
+    std::unordered_map<std::string, int> ranks_;
+    mutable std::mutex cache_mutex_;
+    mutable std::unordered_map<std::string, std::size_t> piece_cache_;
+
+    std::size_t CountPiece(std::string_view piece) const;
+    std::size_t MergePiece(std::string_view piece) const;
+    static std::size_t Estimate(std::string_view text);
+};
+
+}  // namespace kabot::agent
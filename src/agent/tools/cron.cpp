@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 
+#include "agent/tools/tool_context.hpp"
 #include "nlohmann/json.hpp"
 
 namespace kabot::agent::tools {
@@ -235,14 +236,15 @@ std::string CronTool::Execute(const std::unordered_map<std::string, std::string>
         job.payload.agent = GetParam(params, "agent");
         job.payload.channel = GetParam(params, "channel");
         job.payload.to = GetParam(params, "to");
+        const auto* context = ToolContextScope::Current();
         if (job.payload.agent.empty()) {
-            job.payload.agent = default_agent_;
+            job.payload.agent = context ? context->agent_name : default_agent_;
         }
         if (job.payload.channel.empty()) {
-            job.payload.channel = default_channel_;
+            job.payload.channel = context ? context->EffectiveChannel() : default_channel_;
         }
         if (job.payload.to.empty()) {
-            job.payload.to = default_to_;
+            job.payload.to = context ? context->chat_id : default_to_;
         }
         if (job.payload.deliver) {
             if (job.payload.channel.empty() || job.payload.to.empty()) {
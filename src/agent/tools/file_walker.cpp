@@ -0,0 +1,269 @@
+#include "agent/tools/file_walker.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "agent/tools/glob_match.hpp"
+
+namespace kabot::agent::tools {
+namespace {
+
+std::string DirectoryKey(const std::filesystem::path& dir) {
+    auto key = dir.generic_string();
+    if (key.empty() || key.back() != '/') {
+        key.push_back('/');
+    }
+    return key;
+}
+
+std::size_t WalkerThreads(std::size_t requested) {
+    if (requested > 0) {
+        return requested;
+    }
+    const auto hardware = std::thread::hardware_concurrency();
+    return std::clamp<std::size_t>(hardware == 0 ? 4 : hardware, 1, 8);
+}
+
+}  // namespace
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::Load(std::shared_ptr<const IgnoreRules> parent,
+                                                     const std::filesystem::path& base,
+                                                     const std::vector<std::filesystem::path>& files) {
+    auto rules = std::make_shared<IgnoreRules>();
+    rules->parent_ = std::move(parent);
+    rules->base_ = DirectoryKey(base);
+    for (const auto& file : files) {
+        std::ifstream input(file);
+        std::string line;
+        while (std::getline(input, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            while (!line.empty() && line.back() == ' ' && (line.size() < 2 || line[line.size() - 2] != '\\')) {
+                line.pop_back();
+            }
+            if (line.empty() || line.front() == '#') {
+                continue;
+            }
+            Rule rule;
+            if (line.front() == '!') {
+                rule.negated = true;
+                line.erase(0, 1);
+            } else if (line.front() == '\\') {
+                line.erase(0, 1);
+            }
+            if (!line.empty() && line.back() == '/') {
+                rule.directory_only = true;
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+            rule.anchored = line.find('/') != std::string::npos;
+            if (line.front() == '/') {
+                line.erase(0, 1);
+            }
+            rule.pattern = std::move(line);
+            rules->rules_.push_back(std::move(rule));
+        }
+    }
+    if (rules->rules_.empty()) {
+        return rules->parent_;
+    }
+    return rules;
+}
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::ForDirectory(const std::filesystem::path& dir) {
+    std::error_code ec;
+    auto absolute = std::filesystem::absolute(dir, ec).lexically_normal();
+    if (ec) {
+        return nullptr;
+    }
+    std::vector<std::filesystem::path> chain;
+    for (auto current = absolute;; current = current.parent_path()) {
+        chain.push_back(current);
+        if (std::filesystem::exists(current / ".git", ec) || current == current.root_path()
+            || !current.has_relative_path()) {
+            break;
+        }
+    }
+    std::reverse(chain.begin(), chain.end());
+    if (!std::filesystem::exists(chain.front() / ".git", ec)) {
+        // Not inside a repository: only the directory's own file applies.
+        chain.erase(chain.begin(), chain.end() - 1);
+    }
+
+    std::shared_ptr<const IgnoreRules> rules;
+    for (std::size_t i = 0; i < chain.size(); ++i) {
+        std::vector<std::filesystem::path> files;
+        if (i == 0) {
+            files.push_back(chain[i] / ".git" / "info" / "exclude");
+        }
+        files.push_back(chain[i] / ".gitignore");
+        rules = Load(std::move(rules), chain[i], files);
+    }
+    return rules;
+}
+
+std::shared_ptr<const IgnoreRules> IgnoreRules::Enter(std::shared_ptr<const IgnoreRules> parent,
+                                                      const std::filesystem::path& dir) {
+    const auto file = dir / ".gitignore";
+    std::error_code ec;
+    if (!std::filesystem::is_regular_file(file, ec)) {
+        return parent;
+    }
+    return Load(std::move(parent), dir, {file});
+}
+
+bool IgnoreRules::IsIgnored(const std::string& path, bool is_directory) const {
+    for (const auto* level = this; level; level = level->parent_.get()) {
+        if (path.compare(0, level->base_.size(), level->base_) != 0) {
+            continue;
+        }
+        const std::string_view relative(path.data() + level->base_.size(), path.size() - level->base_.size());
+        const auto slash = relative.rfind('/');
+        const auto name = slash == std::string_view::npos ? relative : relative.substr(slash + 1);
+        // Later rules win, and deeper files override shallower ones.
+        for (auto it = level->rules_.rbegin(); it != level->rules_.rend(); ++it) {
+            if (it->directory_only && !is_directory) {
+                continue;
+            }
+            if (MatchGlob(it->pattern, it->anchored ? relative : name)) {
+                return !it->negated;
+            }
+        }
+    }
+    return false;
+}
+
+void WalkFiles(const std::filesystem::path& root,
+               const WalkOptions& options,
+               const std::function<void(const WalkEntry&)>& visit) {
+    struct Directory {
+        std::filesystem::path path;
+        std::string relative;
+        std::shared_ptr<const IgnoreRules> rules;
+    };
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Directory> pending;
+    std::size_t busy = 0;
+    std::exception_ptr failure;  // first exception from visit or descend; ends the walk
+
+    std::error_code ec;
+    const auto absolute_root = std::filesystem::absolute(root, ec).lexically_normal();
+    pending.push_back(Directory{
+        root, {}, options.respect_gitignore ? IgnoreRules::ForDirectory(absolute_root) : nullptr});
+
+    auto scan = [&](const Directory& dir, std::vector<Directory>& found) {
+        std::error_code iter_ec;
+        std::filesystem::directory_iterator it(dir.path, iter_ec);
+        if (iter_ec) {
+            return;
+        }
+        const auto absolute_path = dir.relative.empty() ? absolute_root : absolute_root / dir.relative;
+        auto rules = dir.rules;
+        if (options.respect_gitignore && !dir.relative.empty()) {
+            rules = IgnoreRules::Enter(std::move(rules), absolute_path);
+        }
+        const auto absolute_dir = DirectoryKey(absolute_path);
+        for (; it != std::filesystem::directory_iterator(); it.increment(iter_ec)) {
+            if (iter_ec) {
+                break;
+            }
+            const auto& entry = *it;
+            const auto name = entry.path().filename().string();
+            std::error_code type_ec;
+            const bool is_directory = entry.is_directory(type_ec) && !entry.is_symlink(type_ec);
+            if (is_directory && name == ".git") {
+                continue;
+            }
+            if (!is_directory && !entry.is_regular_file(type_ec)) {
+                continue;
+            }
+            if (rules && rules->IsIgnored(absolute_dir + name, is_directory)) {
+                continue;
+            }
+            WalkEntry walk_entry{entry.path(), dir.relative.empty() ? name : dir.relative + "/" + name, is_directory};
+            if (is_directory) {
+                if (options.include_directories) {
+                    visit(walk_entry);
+                }
+                if (!options.descend || options.descend(walk_entry.relative)) {
+                    found.push_back(Directory{std::move(walk_entry.path), std::move(walk_entry.relative), rules});
+                }
+            } else {
+                visit(walk_entry);
+            }
+        }
+    };
+
+    // Threads share one LIFO of directories: each pops a directory, lists
+    // it, visits its files and pushes its subdirectories for any idle
+    // thread to pick up. The walk ends when the stack is empty and no
+    // thread is still listing, or as soon as a callback throws; the first
+    // exception is rethrown on the calling thread once every helper joined.
+    auto worker = [&] {
+        std::vector<Directory> found;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            cv.wait(lock, [&] { return failure || !pending.empty() || busy == 0; });
+            if (failure || pending.empty()) {
+                cv.notify_all();
+                return;
+            }
+            auto dir = std::move(pending.back());
+            pending.pop_back();
+            ++busy;
+            lock.unlock();
+            std::exception_ptr error;
+            try {
+                scan(dir, found);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            lock.lock();
+            --busy;
+            if (error) {
+                if (!failure) {
+                    failure = error;
+                }
+                pending.clear();
+                cv.notify_all();
+                return;
+            }
+            for (auto& child : found) {
+                pending.push_back(std::move(child));
+            }
+            found.clear();
+            cv.notify_all();
+        }
+    };
+
+    const auto threads = WalkerThreads(options.threads);
+    std::vector<std::thread> helpers;
+    helpers.reserve(threads - 1);
+    try {
+        for (std::size_t i = 1; i < threads; ++i) {
+            helpers.emplace_back(worker);
+        }
+    } catch (const std::system_error&) {
+        // Walk with the threads that did start.
+    }
+    worker();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+}  // namespace kabot::agent::tools
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kabot::agent::tools {
+
+// The .gitignore rules in force for one directory: its own file layered
+// over its parent's. Immutable once built, so walker threads share them.
+class IgnoreRules {
+public:
+    // Rules for dir, loaded from every .gitignore between the enclosing
+    // repository's top level (plus .git/info/exclude) and dir itself.
+    static std::shared_ptr<const IgnoreRules> ForDirectory(const std::filesystem::path& dir);
+    // Rules for a subdirectory; returns parent unchanged when dir has no
+    // .gitignore of its own.
+    static std::shared_ptr<const IgnoreRules> Enter(std::shared_ptr<const IgnoreRules> parent,
+                                                    const std::filesystem::path& dir);
+
+    // path is absolute and '/'-separated.
+    bool IsIgnored(const std::string& path, bool is_directory) const;
+
+private:
+    struct Rule {
+        std::string pattern;
+        bool negated = false;
+        bool directory_only = false;
+        bool anchored = false;  // matched against the whole relative path, not the basename
+    };
+
+    std::shared_ptr<const IgnoreRules> parent_;
+    std::string base_;  // directory the rules are relative to, with a trailing '/'
+    std::vector<Rule> rules_;
+
+    static std::shared_ptr<const IgnoreRules> Load(std::shared_ptr<const IgnoreRules> parent,
+                                                   const std::filesystem::path& base,
+                                                   const std::vector<std::filesystem::path>& files);
+};
+
+struct WalkEntry {
+    std::filesystem::path path;
+    std::string relative;  // to the walk root, '/'-separated
+    bool is_directory = false;
+};
+
+struct WalkOptions {
+    std::size_t threads = 0;  // 0 picks from hardware_concurrency, capped at 8
+    bool respect_gitignore = true;
+    bool include_directories = false;
+    // Return false to skip a directory and everything under it.
+    std::function<bool(const std::string& relative)> descend;
+};
+
+// Walks root on several threads, never entering .git, ignored paths or
+// symlinked directories. visit runs concurrently and in no particular
+// order; callers sort what they collect.
+void WalkFiles(const std::filesystem::path& root,
+               const WalkOptions& options,
+               const std::function<void(const WalkEntry&)>& visit);
+
+}  // namespace kabot::agent::tools
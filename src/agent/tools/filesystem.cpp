@@ -1,9 +1,17 @@
 #include "agent/tools/filesystem.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <regex>
 #include <sstream>
+#include <vector>
+
+#include "agent/file_cache.hpp"
+#include "agent/tools/file_walker.hpp"
+#include "agent/tools/glob_match.hpp"
+#include "agent/tools/text_search.hpp"
 
 namespace kabot::agent::tools {
 namespace {
@@ -46,43 +54,32 @@ std::string ReadFileTool::Execute(const std::unordered_map<std::string, std::str
     if (path.empty()) {
         return "Error: path is required";
     }
-    const int start_line = GetParamInt(params, "line", 1);
+    const int start_line = std::max(1, GetParamInt(params, "line", 1));
     const int max_lines = GetParamInt(params, "limit", -1);
 
-    std::ifstream file(path, std::ios::in);
-    if (!file.is_open()) {
+    const auto file = kabot::agent::IndexedFileCache::Shared().Open(path);
+    if (!file) {
         return "Error: failed to open file";
     }
-
-    std::string line;
-    int line_num = 0;
-    int lines_read = 0;
-    std::ostringstream oss;
-
-    while (std::getline(file, line)) {
-        ++line_num;
-        if (line_num < start_line) {
-            continue;
-        }
-        if (max_lines >= 0 && lines_read >= max_lines) {
-            int remaining = 0;
-            while (std::getline(file, line)) {
-                ++remaining;
-            }
-            oss << "\n... (truncated after " << max_lines << " lines; total " << (line_num + remaining) << " lines) ...";
-            break;
-        }
-        if (lines_read > 0) {
-            oss << '\n';
-        }
-        oss << line;
-        ++lines_read;
+    const auto total = file->LineCount();
+    const auto first = static_cast<std::size_t>(start_line);
+    if (first > total) {
+        return "[Empty file or start line beyond end of file]";
     }
-
-    if (lines_read == 0) {
+    auto last = total;
+    if (max_lines >= 0) {
+        last = std::min(total, first - 1 + static_cast<std::size_t>(max_lines));
+    }
+    if (last < first) {
         return "[Empty file or start line beyond end of file]";
     }
-    return oss.str();
+
+    auto out = file->Lines(first, last);
+    if (last < total) {
+        out += "\n... (truncated after " + std::to_string(max_lines) + " lines; total " + std::to_string(total) +
+               " lines) ...";
+    }
+    return out;
 }
 
 std::string WriteFileTool::ParametersJson() const {
@@ -95,6 +92,7 @@ std::string WriteFileTool::Execute(const std::unordered_map<std::string, std::st
     if (path.empty()) {
         return "Error: path is required";
     }
+    kabot::agent::IndexedFileCache::Shared().Invalidate(path);
     std::ofstream file(path, std::ios::out | std::ios::trunc);
     if (!file.is_open()) {
         return "Error: failed to open file";
@@ -114,21 +112,23 @@ std::string EditFileTool::Execute(const std::unordered_map<std::string, std::str
     if (path.empty()) {
         return "Error: path is required";
     }
-    std::ifstream in(path, std::ios::in);
-    if (!in.is_open()) {
+    auto& cache = kabot::agent::IndexedFileCache::Shared();
+    const auto file = cache.Open(path);
+    if (!file) {
         return "Error: failed to open file";
     }
-    std::stringstream buffer;
-    buffer << in.rdbuf();
-    auto content = buffer.str();
-    in.close();
-
-    auto pos = content.find(old_str);
+    const auto current = file->Read(0, file->Size());
+    const auto pos = current.find(old_str);
     if (pos == std::string::npos) {
         return "Error: old_string not found";
     }
-    content.replace(pos, old_str.size(), new_str);
+    std::string content;
+    content.reserve(current.size() - old_str.size() + new_str.size());
+    content.append(current, 0, pos);
+    content.append(new_str);
+    content.append(current, pos + old_str.size());
 
+    cache.Invalidate(path);
     std::ofstream out(path, std::ios::out | std::ios::trunc);
     if (!out.is_open()) {
         return "Error: failed to write file";
@@ -171,57 +171,80 @@ std::string GlobTool::ParametersJson() const {
 }
 
 std::string GlobTool::Execute(const std::unordered_map<std::string, std::string>& params) {
-    const auto pattern = GetParam(params, "pattern");
+    auto pattern = GetParam(params, "pattern");
     const auto base = GetParam(params, "path");
     if (pattern.empty()) {
         return "Error: pattern is required";
     }
+    std::replace(pattern.begin(), pattern.end(), '\\', '/');
     std::filesystem::path root = base.empty() ? std::filesystem::current_path() : std::filesystem::path(base);
-    if (!std::filesystem::exists(root)) {
+
+    // Leading segments without wildcards only name where to start: walk
+    // from there instead of filtering the whole tree. Results keep the
+    // prefix, so they stay relative to the requested base (or absolute).
+    std::string prefix;
+    if (!pattern.empty() && pattern.front() == '/') {
+        root = "/";
+        prefix = "/";
+        pattern.erase(0, 1);
+    }
+    while (pattern.rfind("./", 0) == 0) {
+        pattern.erase(0, 2);
+    }
+    for (auto slash = pattern.find('/'); slash != std::string::npos; slash = pattern.find('/')) {
+        const auto segment = pattern.substr(0, slash);
+        if (segment.find_first_of("*?[{\\") != std::string::npos) {
+            break;
+        }
+        root /= segment;
+        prefix += segment + "/";
+        pattern.erase(0, slash + 1);
+    }
+    std::error_code ec;
+    if (!std::filesystem::is_directory(root, ec)) {
         return "Error: path does not exist";
     }
 
-    // Convert glob to regex
-    std::string re_str;
-    for (char c : pattern) {
-        if (c == '*') {
-            re_str += ".*";
-        } else if (c == '?') {
-            re_str += ".";
-        } else if (c == '.') {
-            re_str += "\\.";
-        } else if (c == '/' || c == '\\') {
-            re_str += "[/\\\\]";
-        } else {
-            re_str += c;
+    const GlobPattern glob(pattern);
+    struct Hit {
+        std::string path;
+        std::filesystem::file_time_type mtime;
+    };
+    std::mutex mutex;
+    std::vector<Hit> hits;
+    WalkOptions options;
+    options.include_directories = true;
+    options.descend = [&glob](const std::string& relative) { return glob.CouldMatchBelow(relative); };
+    WalkFiles(root, options, [&](const WalkEntry& entry) {
+        if (!glob.Matches(entry.relative)) {
+            return;
         }
+        std::error_code time_ec;
+        const auto mtime = std::filesystem::last_write_time(entry.path, time_ec);
+        std::lock_guard<std::mutex> lock(mutex);
+        hits.push_back(Hit{prefix + entry.relative, mtime});
+    });
+    if (hits.empty()) {
+        return "No files matched.";
     }
-    std::regex re(re_str);
 
+    // Most recently modified first: usually what the agent is working on.
+    std::sort(hits.begin(), hits.end(), [](const Hit& left, const Hit& right) {
+        return left.mtime != right.mtime ? left.mtime > right.mtime : left.path < right.path;
+    });
+    constexpr std::size_t kMaxResults = 100;
     std::ostringstream oss;
-    int count = 0;
-    const auto root_str = root.string();
-    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
-        auto rel = std::filesystem::relative(entry.path(), root).string();
-        // Normalize separators for matching
-        std::replace(rel.begin(), rel.end(), '\\', '/');
-        if (std::regex_match(rel, re)) {
-            oss << rel << "\n";
-            ++count;
-            if (count >= 100) {
-                oss << "... (truncated at 100 results)\n";
-                break;
-            }
-        }
+    for (std::size_t i = 0; i < hits.size() && i < kMaxResults; ++i) {
+        oss << hits[i].path << "\n";
     }
-    if (count == 0) {
-        return "No files matched.";
+    if (hits.size() > kMaxResults) {
+        oss << "... (truncated at " << kMaxResults << " results)\n";
     }
     return oss.str();
 }
 
 std::string GrepTool::ParametersJson() const {
-    return R"({"type":"object","properties":{"pattern":{"type":"string","description":"Regex pattern to search"},"path":{"type":"string","description":"File or directory to search"}},"required":["pattern","path"]})";
+    return R"({"type":"object","properties":{"pattern":{"type":"string","description":"Regex pattern to search"},"path":{"type":"string","description":"File or directory to search"},"context":{"type":"integer","minimum":0,"maximum":5,"description":"Lines of context to show around each match"}},"required":["pattern","path"]})";
 }
 
 std::string GrepTool::Execute(const std::unordered_map<std::string, std::string>& params) {
@@ -231,48 +254,70 @@ std::string GrepTool::Execute(const std::unordered_map<std::string, std::string>
         return "Error: pattern and path are required";
     }
     try {
-        std::regex re(pattern);
+        const std::filesystem::path target(path_str);
+        if (!std::filesystem::is_regular_file(target) && !std::filesystem::is_directory(target)) {
+            return "Error: path is not a file or directory";
+        }
+        TextSearchOptions options;
+        options.max_matches = 50;
+        const auto result = SearchText(pattern, target, std::filesystem::current_path(), options);
+        if (result.matches.empty()) {
+            return "No matches found.";
+        }
+        const auto context = static_cast<std::size_t>(std::clamp(GetParamInt(params, "context", 0), 0, 5));
         std::ostringstream oss;
-        int matches = 0;
-        std::filesystem::path target(path_str);
-
-        auto search_file = [&](const std::filesystem::path& p) {
-            std::ifstream file(p, std::ios::in);
-            if (!file.is_open()) return;
-            std::string line;
-            int line_no = 0;
-            while (std::getline(file, line)) {
-                ++line_no;
-                if (std::regex_search(line, re)) {
-                    oss << std::filesystem::relative(p, std::filesystem::current_path()).string()
-                       << ":" << line_no << ": " << line << "\n";
-                    ++matches;
-                    if (matches >= 50) {
-                        oss << "... (truncated at 50 matches)\n";
-                        return;
+        if (context == 0) {
+            for (const auto& match : result.matches) {
+                oss << match.path << ":" << match.line << ": " << match.text << "\n";
+            }
+        } else {
+            // Context comes from the shared line index, so each window is a
+            // couple of lookups rather than a rescan of the file.
+            auto is_match = [&result](const std::string& path, std::size_t line) {
+                return std::any_of(result.matches.begin(), result.matches.end(), [&](const TextMatch& match) {
+                    return match.path == path && match.line == line;
+                });
+            };
+            std::string previous_path;
+            std::size_t printed_through = 0;
+            for (const auto& match : result.matches) {
+                if (match.path == previous_path && match.line <= printed_through) {
+                    continue;
+                }
+                const auto file = kabot::agent::IndexedFileCache::Shared().Open(match.path);
+                auto first = match.line > context ? match.line - context : 1;
+                const auto last = file ? std::min(file->LineCount(), match.line + context) : match.line;
+                if (match.path == previous_path) {
+                    first = std::max(first, printed_through + 1);
+                }
+                if (oss.tellp() > 0 && (match.path != previous_path || first > printed_through + 1)) {
+                    oss << "--\n";
+                }
+                for (auto line = first; line <= last; ++line) {
+                    if (!file || line == match.line) {
+                        oss << match.path << ":" << line << ": " << match.text << "\n";
+                        continue;
+                    }
+                    auto text = file->Line(line);
+                    if (!text.empty() && text.back() == '\r') {
+                        text.pop_back();
                     }
+                    oss << match.path << (is_match(match.path, line) ? ":" : "-") << line
+                        << (is_match(match.path, line) ? ": " : "- ") << text.substr(0, options.max_line_bytes)
+                        << "\n";
                 }
+                previous_path = match.path;
+                printed_through = last;
             }
-        };
-
-        if (std::filesystem::is_regular_file(target)) {
-            search_file(target);
-        } else if (std::filesystem::is_directory(target)) {
-            for (const auto& entry : std::filesystem::recursive_directory_iterator(target)) {
-                if (!entry.is_regular_file()) continue;
-                search_file(entry.path());
-                if (matches >= 50) break;
-            }
-        } else {
-            return "Error: path is not a file or directory";
         }
-
-        if (matches == 0) {
-            return "No matches found.";
+        if (result.truncated) {
+            oss << "... (truncated at " << options.max_matches << " matches)\n";
         }
         return oss.str();
     } catch (const std::regex_error& ex) {
         return std::string("Error: invalid regex: ") + ex.what();
+    } catch (const std::filesystem::filesystem_error& ex) {
+        return std::string("Error: ") + ex.what();
     }
 }
 
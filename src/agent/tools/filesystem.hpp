@@ -41,7 +41,7 @@ public:
 class GlobTool : public Tool {
 public:
     std::string Name() const override { return "glob"; }
-    std::string Description() const override { return "Find files matching a glob pattern."; }
+    std::string Description() const override { return "Find files matching a glob pattern (supports **, {a,b} and [...]); skips .gitignore'd paths and lists newest first."; }
     std::string ParametersJson() const override;
     std::string Execute(const std::unordered_map<std::string, std::string>& params) override;
 };
@@ -49,7 +49,7 @@ public:
 class GrepTool : public Tool {
 public:
     std::string Name() const override { return "grep"; }
-    std::string Description() const override { return "Search file contents with regex."; }
+    std::string Description() const override { return "Search file contents with regex; optionally show context lines around matches."; }
     std::string ParametersJson() const override;
     std::string Execute(const std::unordered_map<std::string, std::string>& params) override;
 };
@@ -0,0 +1,250 @@
+#include "agent/tools/glob_match.hpp"
+
+namespace kabot::agent::tools {
+namespace {
+
+constexpr std::size_t kMaxBraceExpansions = 256;
+
+std::vector<std::string> SplitSegments(std::string_view path) {
+    std::vector<std::string> segments;
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        const auto slash = path.find('/', start);
+        const auto end = slash == std::string_view::npos ? path.size() : slash;
+        if (end > start) {
+            segments.emplace_back(path.substr(start, end - start));
+        }
+        if (slash == std::string_view::npos) {
+            break;
+        }
+        start = slash + 1;
+    }
+    return segments;
+}
+
+// Index of the '}' closing the '{' at open, or npos.
+std::size_t FindBraceClose(std::string_view pattern, std::size_t open) {
+    int depth = 0;
+    for (auto i = open; i < pattern.size(); ++i) {
+        if (pattern[i] == '\\') {
+            ++i;
+        } else if (pattern[i] == '{') {
+            ++depth;
+        } else if (pattern[i] == '}' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+bool SegmentsCouldMatch(const std::vector<std::string>& pattern,
+                        std::size_t pattern_index,
+                        const std::vector<std::string>& directory,
+                        std::size_t directory_index) {
+    if (pattern_index < pattern.size() && pattern[pattern_index].find("**") != std::string::npos) {
+        return true;
+    }
+    if (directory_index == directory.size()) {
+        return pattern_index < pattern.size();
+    }
+    if (pattern_index == pattern.size()) {
+        return false;
+    }
+    return MatchGlob(pattern[pattern_index], directory[directory_index])
+        && SegmentsCouldMatch(pattern, pattern_index + 1, directory, directory_index + 1);
+}
+
+// Matches one `[...]` class at pattern[pos] against ch. Returns the index
+// just past the closing ']', or npos when the class is unterminated.
+std::size_t MatchClass(std::string_view pattern, std::size_t pos, char ch, bool& matched) {
+    std::size_t i = pos + 1;
+    bool negated = false;
+    if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^')) {
+        negated = true;
+        ++i;
+    }
+    matched = false;
+    bool first = true;
+    while (i < pattern.size() && (first || pattern[i] != ']')) {
+        first = false;
+        char low = pattern[i];
+        if (low == '\\' && i + 1 < pattern.size()) {
+            low = pattern[++i];
+        }
+        char high = low;
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            high = pattern[i + 2];
+            if (high == '\\' && i + 3 < pattern.size()) {
+                high = pattern[i + 3];
+                ++i;
+            }
+            i += 2;
+        }
+        if (low <= ch && ch <= high) {
+            matched = true;
+        }
+        ++i;
+    }
+    if (i >= pattern.size()) {
+        return std::string_view::npos;
+    }
+    matched = matched != negated;
+    return i + 1;
+}
+
+}  // namespace
+
+bool MatchGlob(std::string_view pattern, std::string_view path) {
+    std::size_t pi = 0;
+    std::size_t si = 0;
+    while (pi < pattern.size()) {
+        const char ch = pattern[pi];
+        if (ch == '*') {
+            if (pi + 1 < pattern.size() && pattern[pi + 1] == '*') {
+                const auto next = pi + 2;
+                if (next < pattern.size() && pattern[next] == '/') {
+                    const auto rest = pattern.substr(next + 1);
+                    if (MatchGlob(rest, path.substr(si))) {
+                        return true;
+                    }
+                    for (auto k = si; k < path.size(); ++k) {
+                        if (path[k] == '/' && MatchGlob(rest, path.substr(k + 1))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+                const auto rest = pattern.substr(next);
+                for (auto k = si; k <= path.size(); ++k) {
+                    if (MatchGlob(rest, path.substr(k))) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+            const auto rest = pattern.substr(pi + 1);
+            for (auto k = si; k <= path.size(); ++k) {
+                if (MatchGlob(rest, path.substr(k))) {
+                    return true;
+                }
+                if (k < path.size() && path[k] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+        if (si >= path.size()) {
+            return false;
+        }
+        if (ch == '?') {
+            if (path[si] == '/') {
+                return false;
+            }
+            ++pi;
+            ++si;
+            continue;
+        }
+        if (ch == '[') {
+            bool matched = false;
+            const auto end = MatchClass(pattern, pi, path[si], matched);
+            if (end != std::string_view::npos) {
+                if (!matched || path[si] == '/') {
+                    return false;
+                }
+                pi = end;
+                ++si;
+                continue;
+            }
+        }
+        char literal = ch;
+        if (ch == '\\' && pi + 1 < pattern.size()) {
+            literal = pattern[++pi];
+        }
+        if (literal != path[si]) {
+            return false;
+        }
+        ++pi;
+        ++si;
+    }
+    return si == path.size();
+}
+
+std::vector<std::string> ExpandBraces(std::string_view pattern) {
+    std::size_t open = std::string_view::npos;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        if (pattern[i] == '\\') {
+            ++i;
+        } else if (pattern[i] == '{') {
+            open = i;
+            break;
+        }
+    }
+    const auto close = open == std::string_view::npos ? open : FindBraceClose(pattern, open);
+    if (close == std::string_view::npos) {
+        return {std::string(pattern)};
+    }
+
+    // Split the set on top-level commas.
+    std::vector<std::string_view> options;
+    int depth = 0;
+    auto start = open + 1;
+    for (auto i = start; i < close; ++i) {
+        if (pattern[i] == '\\') {
+            ++i;
+        } else if (pattern[i] == '{') {
+            ++depth;
+        } else if (pattern[i] == '}') {
+            --depth;
+        } else if (pattern[i] == ',' && depth == 0) {
+            options.push_back(pattern.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+    options.push_back(pattern.substr(start, close - start));
+
+    const auto prefix = pattern.substr(0, open);
+    const auto suffix = pattern.substr(close + 1);
+    std::vector<std::string> expanded;
+    for (const auto option : options) {
+        std::string candidate(prefix);
+        candidate.append(option);
+        candidate.append(suffix);
+        for (auto& result : ExpandBraces(candidate)) {
+            if (expanded.size() >= kMaxBraceExpansions) {
+                return expanded;
+            }
+            expanded.push_back(std::move(result));
+        }
+    }
+    return expanded;
+}
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+    for (auto& expanded : ExpandBraces(pattern)) {
+        Alternative alternative;
+        alternative.segments = SplitSegments(expanded);
+        alternative.pattern = std::move(expanded);
+        alternatives_.push_back(std::move(alternative));
+    }
+}
+
+bool GlobPattern::Matches(std::string_view path) const {
+    for (const auto& alternative : alternatives_) {
+        if (MatchGlob(alternative.pattern, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GlobPattern::CouldMatchBelow(std::string_view directory) const {
+    const auto segments = SplitSegments(directory);
+    for (const auto& alternative : alternatives_) {
+        if (SegmentsCouldMatch(alternative.segments, 0, segments, 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace kabot::agent::tools
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kabot::agent::tools {
+
+// Shell-style match of a '/'-separated path. `*`, `?` and `[...]` never
+// cross a '/', `**` does, and a `**/` segment also matches no directory.
+bool MatchGlob(std::string_view pattern, std::string_view path);
+
+// Expands `{a,b}` sets, including nested ones, into separate patterns.
+std::vector<std::string> ExpandBraces(std::string_view pattern);
+
+// A glob compiled once per query: brace sets expanded up front and every
+// alternative split into segments, so a directory walk can prune subtrees
+// that no alternative can reach.
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string_view pattern);
+
+    bool Matches(std::string_view path) const;
+    // False when nothing below directory (relative, '/'-separated) can match.
+    bool CouldMatchBelow(std::string_view directory) const;
+
+private:
+    struct Alternative {
+        std::string pattern;
+        std::vector<std::string> segments;
+    };
+
+    std::vector<Alternative> alternatives_;
+};
+
+}  // namespace kabot::agent::tools
@@ -1,5 +1,7 @@
 #include "agent/tools/message.hpp"
 
+#include "agent/tools/tool_context.hpp"
+
 namespace kabot::agent::tools {
 namespace {
 
@@ -39,9 +41,20 @@ std::string SendMessageTool::Execute(const std::unordered_map<std::string, std::
 
     const bool has_explicit_target = !requested_channel.empty() && !requested_chat_id.empty();
 
+    const auto* context = ToolContextScope::Current();
     kabot::bus::OutboundMessage msg{};
-    msg.channel = has_explicit_target ? requested_channel : default_channel_;
-    msg.chat_id = has_explicit_target ? requested_chat_id : default_chat_id_;
+    if (has_explicit_target) {
+        msg.channel = requested_channel;
+        msg.chat_id = requested_chat_id;
+    } else if (context) {
+        msg.channel = context->channel.empty() ? context->channel_instance : context->channel;
+        msg.channel_instance = context->channel_instance;
+        msg.agent_name = context->agent_name;
+        msg.chat_id = context->chat_id;
+    } else {
+        msg.channel = default_channel_;
+        msg.chat_id = default_chat_id_;
+    }
     msg.content = content;
 
     if (!media_raw.empty()) {
@@ -74,7 +87,11 @@ std::string SendMessageTool::Execute(const std::unordered_map<std::string, std::
     }
 
     callback_(msg);
-    if (observer_) {
+    if (context) {
+        if (context->outbound_observer) {
+            context->outbound_observer(msg);
+        }
+    } else if (observer_) {
         observer_(msg);
     }
     return "Message sent";
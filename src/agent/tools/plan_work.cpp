@@ -3,6 +3,7 @@
 #include <sstream>
 
 #include "agent/planning/task_decomposer.hpp"
+#include "agent/tools/tool_context.hpp"
 #include "relay/relay_manager.hpp"
 #include "config/config_schema.hpp"
 #include "utils/logging.hpp"
@@ -113,6 +114,15 @@ std::string PlanWorkTool::Execute(const std::unordered_map<std::string, std::str
         return "Error: relay manager not available for task submission";
     }
 
+    std::string channel = channel_;
+    std::string channel_instance = channel_instance_;
+    std::string chat_id = chat_id_;
+    if (const auto* context = ToolContextScope::Current()) {
+        channel = context->channel;
+        channel_instance = context->channel_instance;
+        chat_id = context->chat_id;
+    }
+
     std::size_t success_count = 0;
     std::size_t failure_count = 0;
     std::ostringstream summary;
@@ -132,10 +142,10 @@ std::string PlanWorkTool::Execute(const std::unordered_map<std::string, std::str
             create.project.project_id = plan.project_id;
         }
 
-        if (!channel_.empty()) {
-            create.interaction.channel = channel_;
-            create.interaction.channel_instance = channel_instance_.empty() ? channel_ : channel_instance_;
-            create.interaction.chat_id = chat_id_;
+        if (!channel.empty()) {
+            create.interaction.channel = channel;
+            create.interaction.channel_instance = channel_instance.empty() ? channel : channel_instance;
+            create.interaction.chat_id = chat_id;
         }
 
         if (!task.depends_on.empty()) {
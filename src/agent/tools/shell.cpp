@@ -1,5 +1,6 @@
 #include "agent/tools/shell.hpp"
 
+#include "agent/tools/tool_context.hpp"
 #include "sandbox/sandbox_executor.hpp"
 #include "utils/logging.hpp"
 
@@ -8,6 +9,13 @@ namespace kabot::agent::tools {
 BashTool::BashTool(std::string working_dir)
     : working_dir_(std::move(working_dir)) {}
 
+BashTool::BashTool(std::string working_dir, bool persistent_shell, std::chrono::seconds shell_idle_timeout)
+    : working_dir_(std::move(working_dir)) {
+    if (persistent_shell) {
+        shells_ = std::make_unique<kabot::sandbox::ShellSessionPool>(working_dir_, shell_idle_timeout);
+    }
+}
+
 std::string BashTool::ParametersJson() const {
     return R"({"type":"object","properties":{"command":{"type":"string","description":"Shell command to execute"}},"required":["command"]})";
 }
@@ -18,10 +26,11 @@ std::string BashTool::Execute(const std::unordered_map<std::string, std::string>
         return "Error: missing command";
     }
 
-    const auto result = kabot::sandbox::SandboxExecutor::Run(
-        it->second,
-        working_dir_,
-        std::chrono::seconds(180));
+    constexpr auto kTimeout = std::chrono::seconds(180);
+    const auto* context = ToolContextScope::Current();
+    const auto result = shells_ && context && !context->session_key.empty()
+        ? shells_->Run(context->session_key, it->second, kTimeout)
+        : kabot::sandbox::SandboxExecutor::Run(it->second, working_dir_, kTimeout);
 
     if (result.blocked) {
         return result.error.empty() ? "Error: command blocked by policy" : result.error;
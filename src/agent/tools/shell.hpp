@@ -1,14 +1,21 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
 #include <string>
 
 #include "agent/tools/tool.hpp"
+#include "sandbox/shell_session.hpp"
 
 namespace kabot::agent::tools {
 
 class BashTool : public Tool {
 public:
     explicit BashTool(std::string working_dir);
+    // With a persistent shell, commands from one session share a shell
+    // process (and so its cwd and exports) until it sits idle for
+    // shell_idle_timeout.
+    BashTool(std::string working_dir, bool persistent_shell, std::chrono::seconds shell_idle_timeout);
 
     std::string Name() const override { return "bash"; }
     std::string Description() const override { return "Execute a shell command in the workspace. Can run read-only commands, builds, tests, git operations, and scripts."; }
@@ -18,6 +25,7 @@ public:
 
 private:
     std::string working_dir_;
+    std::unique_ptr<kabot::sandbox::ShellSessionPool> shells_;
 };
 
 }  // namespace kabot::agent::tools
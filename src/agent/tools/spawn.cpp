@@ -1,5 +1,6 @@
 #include "agent/tools/spawn.hpp"
 
+#include "agent/tools/tool_context.hpp"
 #include "utils/logging.hpp"
 
 namespace kabot::agent::tools {
@@ -55,7 +56,10 @@ std::string AgentTool::Execute(const std::unordered_map<std::string, std::string
     if (auto iso = params.find("isolation"); iso != params.end()) {
         input.isolation = iso->second;
     }
-    if (!session_key_.empty()) {
+    const auto* context = ToolContextScope::Current();
+    if (context && !context->session_key.empty()) {
+        input.session_key = context->session_key;
+    } else if (!session_key_.empty()) {
         input.session_key = session_key_;
     }
 
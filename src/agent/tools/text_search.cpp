@@ -0,0 +1,247 @@
+#include "agent/tools/text_search.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <mutex>
+#include <regex>
+#include <string_view>
+#include <tuple>
+
+#include "agent/tools/file_walker.hpp"
+#include "utils/mapped_file.hpp"
+
+namespace kabot::agent::tools {
+namespace {
+
+constexpr std::size_t kBinaryProbeBytes = 8192;
+
+bool IsPlainLiteral(const std::string& pattern) {
+    return pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+}
+
+bool MatchLess(const TextMatch& left, const TextMatch& right) {
+    return std::tie(left.path, left.line) < std::tie(right.path, right.line);
+}
+
+class FileSearcher {
+public:
+    FileSearcher(const std::string& pattern, const TextSearchOptions& options)
+        : options_(options)
+        , literal_(RequiredLiteral(pattern))
+        , plain_(IsPlainLiteral(pattern)) {
+        if (!plain_) {
+            regex_ = std::regex(pattern, std::regex::ECMAScript | std::regex::optimize);
+        }
+    }
+
+    // Appends at most max_matches hits from one file; returns true when it
+    // stopped at that cap.
+    bool Search(const std::filesystem::path& path, const std::string& display, std::vector<TextMatch>& out) const {
+        kabot::MappedFile file;
+        if (!file.Open(path) || file.Size() > options_.max_file_bytes) {
+            return false;
+        }
+        const auto data = file.View();
+        if (std::memchr(data.data(), '\0', std::min(data.size(), kBinaryProbeBytes)) != nullptr) {
+            return false;
+        }
+
+        std::size_t found = 0;
+        std::size_t line_no = 1;
+        std::size_t counted = 0;
+        std::size_t pos = 0;
+        while (pos <= data.size() && found < options_.max_matches) {
+            std::size_t line_start = pos;
+            if (!literal_.empty()) {
+                const auto hit = data.find(literal_, pos);
+                if (hit == std::string_view::npos) {
+                    break;
+                }
+                const auto newline = data.rfind('\n', hit);
+                line_start = newline == std::string_view::npos || newline < pos ? pos : newline + 1;
+            } else if (pos == data.size()) {
+                break;
+            }
+            auto line_end = data.find('\n', line_start);
+            if (line_end == std::string_view::npos) {
+                line_end = data.size();
+            }
+            line_no += static_cast<std::size_t>(
+                std::count(data.begin() + static_cast<std::ptrdiff_t>(counted),
+                           data.begin() + static_cast<std::ptrdiff_t>(line_start),
+                           '\n'));
+            counted = line_start;
+
+            auto line = data.substr(line_start, line_end - line_start);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (plain_ || std::regex_search(line.begin(), line.end(), regex_)) {
+                auto text = std::string(line.substr(0, options_.max_line_bytes));
+                if (line.size() > options_.max_line_bytes) {
+                    text += "...";
+                }
+                out.push_back(TextMatch{display, line_no, std::move(text)});
+                ++found;
+            }
+            pos = line_end + 1;
+        }
+        return found >= options_.max_matches;
+    }
+
+private:
+    const TextSearchOptions& options_;
+    std::string literal_;
+    bool plain_;
+    std::regex regex_;
+};
+
+}  // namespace
+
+std::string RequiredLiteral(const std::string& pattern) {
+    std::string best;
+    std::string current;
+    auto commit = [&] {
+        if (current.size() > best.size()) {
+            best = current;
+        }
+        current.clear();
+    };
+
+    int depth = 0;
+    for (std::size_t i = 0; i < pattern.size(); ++i) {
+        const char ch = pattern[i];
+        if (ch == '\\' && i + 1 < pattern.size()) {
+            const char next = pattern[++i];
+            // \xHH, \uHHHH and \cX carry operands that are not literal text.
+            const std::size_t operand = next == 'x' ? 2 : next == 'u' ? 4 : next == 'c' ? 1 : 0;
+            i = std::min(i + operand, pattern.size() - 1);
+            if (depth == 0) {
+                if (std::isalnum(static_cast<unsigned char>(next))) {
+                    commit();  // \d, \b, \n, backreferences, ...
+                } else {
+                    current.push_back(next);
+                }
+            }
+            continue;
+        }
+        if (ch == '[') {
+            // Skip the class; a leading ']' (or '^]') is literal.
+            std::size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '^') {
+                ++j;
+            }
+            if (j < pattern.size() && pattern[j] == ']') {
+                ++j;
+            }
+            while (j < pattern.size() && pattern[j] != ']') {
+                j += pattern[j] == '\\' ? 2 : 1;
+            }
+            i = j;
+            if (depth == 0) {
+                commit();
+            }
+            continue;
+        }
+        if (ch == '(') {
+            ++depth;
+            commit();
+            continue;
+        }
+        if (ch == ')') {
+            depth = std::max(0, depth - 1);
+            continue;
+        }
+        if (depth > 0) {
+            continue;
+        }
+        switch (ch) {
+            case '|':
+                return {};
+            case '*':
+            case '?':
+            case '{':
+                // The preceding character may occur zero times.
+                if (!current.empty()) {
+                    current.pop_back();
+                }
+                commit();
+                if (ch == '{') {
+                    while (i < pattern.size() && pattern[i] != '}') {
+                        ++i;
+                    }
+                }
+                break;
+            case '+':
+            case '.':
+            case '^':
+            case '$':
+                commit();
+                break;
+            default:
+                current.push_back(ch);
+                break;
+        }
+    }
+    commit();
+    return best;
+}
+
+TextSearchResult SearchText(const std::string& pattern,
+                            const std::filesystem::path& target,
+                            const std::filesystem::path& display_base,
+                            const TextSearchOptions& options) {
+    const FileSearcher searcher(pattern, options);
+    TextSearchResult result;
+    std::error_code ec;
+    const auto absolute_target = std::filesystem::absolute(target, ec).lexically_normal();
+    const auto absolute_base = std::filesystem::absolute(display_base, ec).lexically_normal();
+
+    if (std::filesystem::is_regular_file(target, ec)) {
+        result.truncated = searcher.Search(
+            target, absolute_target.lexically_relative(absolute_base).generic_string(), result.matches);
+        result.files_searched = 1;
+    } else {
+        auto prefix = absolute_target.lexically_relative(absolute_base).generic_string();
+        if (prefix.empty()) {
+            prefix = absolute_target.generic_string();
+        }
+        prefix = prefix == "." ? std::string() : prefix + "/";
+
+        // Keep only the lowest matches seen so far so memory stays bounded
+        // on huge trees, while the final top-N is the same on every run.
+        std::mutex mutex;
+        const auto keep = std::max<std::size_t>(options.max_matches, 1);
+        WalkOptions walk;
+        walk.threads = options.threads;
+        walk.respect_gitignore = options.respect_gitignore;
+        WalkFiles(target, walk, [&](const WalkEntry& entry) {
+            std::vector<TextMatch> local;
+            const bool capped = searcher.Search(entry.path, prefix + entry.relative, local);
+            std::lock_guard<std::mutex> lock(mutex);
+            ++result.files_searched;
+            result.truncated = result.truncated || capped;
+            if (local.empty()) {
+                return;
+            }
+            result.matches.insert(result.matches.end(),
+                                  std::make_move_iterator(local.begin()),
+                                  std::make_move_iterator(local.end()));
+            if (result.matches.size() > keep * 4) {
+                std::sort(result.matches.begin(), result.matches.end(), MatchLess);
+                result.matches.resize(keep);
+                result.truncated = true;
+            }
+        });
+    }
+
+    std::sort(result.matches.begin(), result.matches.end(), MatchLess);
+    if (result.matches.size() > options.max_matches) {
+        result.matches.resize(options.max_matches);
+        result.truncated = true;
+    }
+    return result;
+}
+
+}  // namespace kabot::agent::tools
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace kabot::agent::tools {
+
+struct TextMatch {
+    std::string path;  // as displayed: relative to the display base
+    std::size_t line = 0;
+    std::string text;
+};
+
+struct TextSearchOptions {
+    std::size_t max_matches = 50;
+    std::size_t max_line_bytes = 500;
+    std::size_t max_file_bytes = 64 * 1024 * 1024;
+    std::size_t threads = 0;
+    bool respect_gitignore = true;
+};
+
+struct TextSearchResult {
+    std::vector<TextMatch> matches;  // sorted by path, then line
+    bool truncated = false;
+    std::size_t files_searched = 0;
+};
+
+// The longest run of characters every match of an ECMAScript pattern must
+// contain, or "" when there is none (e.g. top-level alternation). Used to
+// skip lines with a plain substring search before running the regex.
+std::string RequiredLiteral(const std::string& pattern);
+
+// Searches a file, or every non-ignored text file under a directory, for
+// lines matching pattern. Binary files (a NUL in the first 8 KiB) are
+// skipped. Output does not depend on thread scheduling: matches are sorted
+// before the cap is applied. Throws std::regex_error for a bad pattern.
+TextSearchResult SearchText(const std::string& pattern,
+                            const std::filesystem::path& target,
+                            const std::filesystem::path& display_base,
+                            const TextSearchOptions& options = {});
+
+}  // namespace kabot::agent::tools
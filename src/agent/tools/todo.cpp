@@ -40,16 +40,21 @@ std::string TodoWriteTool::Execute(const std::unordered_map<std::string, std::st
         if (!j.is_array()) {
             return "Error: todos must be an array";
         }
-        items_.clear();
+        std::vector<TodoItem> items;
         for (const auto& item : j) {
             TodoItem todo;
             todo.id = item.value("id", "");
             todo.content = item.value("content", "");
             todo.status = item.value("status", "pending");
-            items_.push_back(todo);
+            items.push_back(todo);
+        }
+        const auto count = items.size();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_ = std::move(items);
         }
         std::ostringstream oss;
-        oss << "Updated " << items_.size() << " todo item(s).";
+        oss << "Updated " << count << " todo item(s).";
         return oss.str();
     } catch (const std::exception& ex) {
         return std::string("Error: ") + ex.what();
@@ -57,6 +62,7 @@ std::string TodoWriteTool::Execute(const std::unordered_map<std::string, std::st
 }
 
 std::vector<TodoWriteTool::TodoItem> TodoWriteTool::Items() const {
+    std::lock_guard<std::mutex> lock(mutex_);
     return items_;
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -27,6 +28,7 @@ public:
     std::vector<TodoItem> Items() const;
 
 private:
+    mutable std::mutex mutex_;
     mutable std::vector<TodoItem> items_;
 };
 
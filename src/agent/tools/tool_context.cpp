@@ -0,0 +1,26 @@
+#include "agent/tools/tool_context.hpp"
+
+#include <utility>
+
+namespace kabot::agent::tools {
+namespace {
+
+thread_local const ToolInvocationContext* current_context = nullptr;
+
+}  // namespace
+
+ToolContextScope::ToolContextScope(ToolInvocationContext context)
+    : context_(std::move(context))
+    , previous_(current_context) {
+    current_context = &context_;
+}
+
+ToolContextScope::~ToolContextScope() {
+    current_context = previous_;
+}
+
+const ToolInvocationContext* ToolContextScope::Current() {
+    return current_context;
+}
+
+}  // namespace kabot::agent::tools
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "bus/events.hpp"
+
+namespace kabot::agent::tools {
+
+// Routing information for the turn that is currently executing tools on this
+// thread. AgentLoop installs one per turn so that concurrent turns of the same
+// agent never observe each other's channel/chat target.
+struct ToolInvocationContext {
+    std::string agent_name;
+    std::string channel;
+    std::string channel_instance;
+    std::string chat_id;
+    std::string session_key;
+    std::function<void(const kabot::bus::OutboundMessage&)> outbound_observer;
+
+    const std::string& EffectiveChannel() const {
+        return channel_instance.empty() ? channel : channel_instance;
+    }
+};
+
+class ToolContextScope {
+public:
+    explicit ToolContextScope(ToolInvocationContext context);
+    ~ToolContextScope();
+
+    ToolContextScope(const ToolContextScope&) = delete;
+    ToolContextScope& operator=(const ToolContextScope&) = delete;
+
+    // Returns the innermost context installed on the calling thread, or nullptr
+    // when tools are executed outside of an agent turn.
+    static const ToolInvocationContext* Current();
+
+private:
+    ToolInvocationContext context_;
+    const ToolInvocationContext* previous_ = nullptr;
+};
+
+}  // namespace kabot::agent::tools
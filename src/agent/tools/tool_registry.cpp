@@ -1,13 +1,30 @@
 #include "agent/tools/tool_registry.hpp"
 
-#include "agent/tools/tool_schema_validator.hpp"
+#include <algorithm>
+
 #include "utils/logging.hpp"
 
 namespace kabot::agent::tools {
 
 void ToolRegistry::Register(std::unique_ptr<Tool> tool) {
     auto name = tool->Name();
-    tools_.emplace(std::move(name), std::move(tool));
+    if (tools_.find(name) != tools_.end()) {
+        return;
+    }
+    kabot::providers::ToolDefinition def{};
+    def.name = name;
+    def.description = tool->Description();
+    def.parameters_json = tool->ParametersJson();
+    kabot::providers::CompileToolDefinition(def);
+    auto schema = CompiledToolSchema::Compile(name, def.parameters_json);
+
+    const auto pos = std::lower_bound(
+        definitions_.begin(), definitions_.end(), name,
+        [](const kabot::providers::ToolDefinition& existing, const std::string& key) {
+            return existing.name < key;
+        });
+    definitions_.insert(pos, std::move(def));
+    tools_.emplace(std::move(name), Entry{std::move(tool), std::move(schema)});
 }
 
 Tool* ToolRegistry::Get(const std::string& name) {
@@ -15,34 +32,27 @@ Tool* ToolRegistry::Get(const std::string& name) {
     if (it == tools_.end()) {
         return nullptr;
     }
-    return it->second.get();
+    return it->second.tool.get();
 }
 
 bool ToolRegistry::Has(const std::string& name) const {
     return tools_.find(name) != tools_.end();
 }
 
-std::vector<kabot::providers::ToolDefinition> ToolRegistry::GetDefinitions() const {
-    std::vector<kabot::providers::ToolDefinition> defs;
-    for (const auto& [name, tool] : tools_) {
-        kabot::providers::ToolDefinition def{};
-        def.name = name;
-        def.description = tool->Description();
-        def.parameters_json = tool->ParametersJson();
-        defs.push_back(def);
-    }
-    return defs;
+const std::vector<kabot::providers::ToolDefinition>& ToolRegistry::GetDefinitions() const {
+    return definitions_;
 }
 
 std::string ToolRegistry::Execute(
     const std::string& name,
     const std::unordered_map<std::string, std::string>& params) {
-    auto tool = Get(name);
-    if (!tool) {
+    auto it = tools_.find(name);
+    if (it == tools_.end()) {
         return "Error: Tool '" + name + "' not found";
     }
+    auto* tool = it->second.tool.get();
 
-    auto validation_error = ValidateToolInput(tool, params);
+    auto validation_error = it->second.schema.Validate(params);
     if (!validation_error.empty()) {
         LOG_WARN("[tool] schema_validation_failed name={} error={}", name, validation_error);
         return validation_error;
@@ -71,8 +81,9 @@ std::string ToolRegistry::Execute(
 
 std::vector<std::string> ToolRegistry::List() const {
     std::vector<std::string> names;
-    for (const auto& [name, _] : tools_) {
-        names.push_back(name);
+    names.reserve(definitions_.size());
+    for (const auto& def : definitions_) {
+        names.push_back(def.name);
     }
     return names;
 }
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "agent/tools/tool.hpp"
+#include "agent/tools/tool_schema_validator.hpp"
 #include "providers/llm_provider.hpp"
 
 namespace kabot::agent::tools {
@@ -15,14 +16,23 @@ public:
     void Register(std::unique_ptr<Tool> tool);
     Tool* Get(const std::string& name);
     bool Has(const std::string& name) const;
-    std::vector<kabot::providers::ToolDefinition> GetDefinitions() const;
+    // Sorted by name and compiled at Register, so every request sends the
+    // same bytes without reparsing schemas. Tools are registered up front;
+    // the reference stays valid for the registry's lifetime.
+    const std::vector<kabot::providers::ToolDefinition>& GetDefinitions() const;
     std::string Execute(const std::string& name,
                         const std::unordered_map<std::string, std::string>& params);
 
     std::vector<std::string> List() const;
 
 private:
-    std::unordered_map<std::string, std::unique_ptr<Tool>> tools_;
+    struct Entry {
+        std::unique_ptr<Tool> tool;
+        CompiledToolSchema schema;
+    };
+
+    std::unordered_map<std::string, Entry> tools_;
+    std::vector<kabot::providers::ToolDefinition> definitions_;
 };
 
 }  // namespace kabot::agent::tools
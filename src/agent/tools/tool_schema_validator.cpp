@@ -1,5 +1,9 @@
 #include "agent/tools/tool_schema_validator.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
 #include "agent/tools/tool.hpp"
 #include "nlohmann/json.hpp"
 #include "utils/logging.hpp"
@@ -13,130 +17,140 @@ bool IsBooleanString(const std::string& value) {
 
 bool IsIntegerString(const std::string& value) {
     if (value.empty()) return false;
-    try {
-        size_t pos = 0;
-        (void)std::stoll(value, &pos);
-        return pos == value.size();
-    } catch (...) {
-        return false;
-    }
+    char* end = nullptr;
+    errno = 0;
+    (void)std::strtoll(value.c_str(), &end, 10);
+    return errno == 0 && end == value.c_str() + value.size();
 }
 
 bool IsNumberString(const std::string& value) {
     if (value.empty()) return false;
-    try {
-        size_t pos = 0;
-        (void)std::stod(value, &pos);
-        return pos == value.size();
-    } catch (...) {
-        return false;
-    }
+    char* end = nullptr;
+    errno = 0;
+    (void)std::strtod(value.c_str(), &end);
+    return errno == 0 && end == value.c_str() + value.size();
 }
 
-bool IsArrayString(const std::string& value) {
-    try {
-        auto j = nlohmann::json::parse(value);
-        return j.is_array();
-    } catch (...) {
+// Checks the leading bracket first so most mismatches never reach the
+// parser, then validates without building a DOM.
+bool IsJsonContainerString(const std::string& value, char open) {
+    const auto first = value.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos || value[first] != open) {
         return false;
     }
-}
-
-bool IsObjectString(const std::string& value) {
-    try {
-        auto j = nlohmann::json::parse(value);
-        return j.is_object();
-    } catch (...) {
-        return false;
-    }
-}
-
-bool IsEnumValid(const nlohmann::json& enum_values, const std::string& value) {
-    if (!enum_values.is_array()) return true;
-    for (const auto& ev : enum_values) {
-        if (ev.is_string() && ev.get<std::string>() == value) return true;
-        if (ev.is_boolean() && ((ev.get<bool>() && value == "true") || (!ev.get<bool>() && value == "false"))) return true;
-    }
-    return false;
+    return nlohmann::json::accept(value);
 }
 
 }  // namespace
 
-std::string ValidateToolInput(const Tool* tool,
-                               const std::unordered_map<std::string, std::string>& params) {
-    if (!tool) {
-        return "";
-    }
+CompiledToolSchema CompiledToolSchema::Compile(const std::string& tool_name, const std::string& parameters_json) {
+    CompiledToolSchema compiled;
+    compiled.tool_name_ = tool_name;
 
-    nlohmann::json schema;
-    try {
-        schema = nlohmann::json::parse(tool->ParametersJson());
-    } catch (const std::exception& ex) {
-        LOG_WARN("[tool] failed to parse parameters json for tool={} error={}", tool->Name(), ex.what());
-        return "";
+    const auto schema = nlohmann::json::parse(parameters_json, nullptr, false);
+    if (schema.is_discarded()) {
+        LOG_WARN("[tool] failed to parse parameters json for tool={}", tool_name);
+        return compiled;
+    }
+    if (!schema.is_object()) {
+        return compiled;
     }
 
-    // Check required fields
     if (schema.contains("required") && schema["required"].is_array()) {
         for (const auto& req : schema["required"]) {
-            if (!req.is_string()) continue;
-            auto key = req.get<std::string>();
-            auto it = params.find(key);
-            if (it == params.end() || it->second.empty()) {
-                return "Error: missing required parameter '" + key + "' for tool '" + tool->Name() + "'";
+            if (req.is_string()) {
+                compiled.required_.push_back(req.get<std::string>());
             }
         }
     }
 
-    // Validate individual fields if properties are defined
     if (schema.contains("properties") && schema["properties"].is_object()) {
-        for (const auto& [key, value] : params) {
-            if (value.empty()) continue;  // skip empty for validation (required already handled it)
-            auto prop_it = schema["properties"].find(key);
-            if (prop_it == schema["properties"].end()) {
-                // Unknown parameter: strict mode could reject, but we'll allow for now
-                continue;
-            }
-            const auto& prop = *prop_it;
+        for (const auto& [key, prop] : schema["properties"].items()) {
             if (!prop.is_object()) continue;
-
             auto type_it = prop.find("type");
             if (type_it == prop.end()) continue;
-            std::string type = type_it->is_string() ? type_it->get<std::string>() : "";
-
-            bool valid = false;
-            if (type == "string") {
-                valid = true;  // Any non-empty string is valid string in this flat representation
-            } else if (type == "boolean") {
-                valid = IsBooleanString(value);
-            } else if (type == "integer") {
-                valid = IsIntegerString(value);
-            } else if (type == "number") {
-                valid = IsNumberString(value);
-            } else if (type == "array") {
-                valid = IsArrayString(value);
-            } else if (type == "object") {
-                valid = IsObjectString(value);
-            } else {
-                valid = true;
-            }
 
-            if (!valid) {
-                return "Error: parameter '" + key + "' for tool '" + tool->Name() +
-                       "' expected type '" + type + "' but got value '" + value + "'";
+            Property property;
+            property.type_name = type_it->is_string() ? type_it->get<std::string>() : "";
+            if (property.type_name == "string") {
+                property.type = Type::kString;
+            } else if (property.type_name == "boolean") {
+                property.type = Type::kBoolean;
+            } else if (property.type_name == "integer") {
+                property.type = Type::kInteger;
+            } else if (property.type_name == "number") {
+                property.type = Type::kNumber;
+            } else if (property.type_name == "array") {
+                property.type = Type::kArray;
+            } else if (property.type_name == "object") {
+                property.type = Type::kObject;
             }
 
             auto enum_it = prop.find("enum");
-            if (enum_it != prop.end()) {
-                if (!IsEnumValid(*enum_it, value)) {
-                    return "Error: parameter '" + key + "' for tool '" + tool->Name() +
-                           "' has invalid enum value '" + value + "'";
+            if (enum_it != prop.end() && enum_it->is_array()) {
+                property.has_enum = true;
+                for (const auto& ev : *enum_it) {
+                    if (ev.is_string()) {
+                        property.enum_values.push_back(ev.get<std::string>());
+                    } else if (ev.is_boolean()) {
+                        property.enum_values.push_back(ev.get<bool>() ? "true" : "false");
+                    }
                 }
             }
+            compiled.properties_.emplace(key, std::move(property));
+        }
+    }
+    return compiled;
+}
+
+std::string CompiledToolSchema::Validate(const std::unordered_map<std::string, std::string>& params) const {
+    for (const auto& key : required_) {
+        auto it = params.find(key);
+        if (it == params.end() || it->second.empty()) {
+            return "Error: missing required parameter '" + key + "' for tool '" + tool_name_ + "'";
+        }
+    }
+
+    for (const auto& [key, value] : params) {
+        if (value.empty()) continue;  // skip empty for validation (required already handled it)
+        auto prop_it = properties_.find(key);
+        if (prop_it == properties_.end()) {
+            // Unknown parameter: strict mode could reject, but we'll allow for now
+            continue;
+        }
+        const auto& prop = prop_it->second;
+
+        bool valid = true;
+        switch (prop.type) {
+            case Type::kBoolean: valid = IsBooleanString(value); break;
+            case Type::kInteger: valid = IsIntegerString(value); break;
+            case Type::kNumber: valid = IsNumberString(value); break;
+            case Type::kArray: valid = IsJsonContainerString(value, '['); break;
+            case Type::kObject: valid = IsJsonContainerString(value, '{'); break;
+            case Type::kString:
+            case Type::kAny: break;
+        }
+        if (!valid) {
+            return "Error: parameter '" + key + "' for tool '" + tool_name_ +
+                   "' expected type '" + prop.type_name + "' but got value '" + value + "'";
+        }
+
+        if (prop.has_enum &&
+            std::find(prop.enum_values.begin(), prop.enum_values.end(), value) == prop.enum_values.end()) {
+            return "Error: parameter '" + key + "' for tool '" + tool_name_ +
+                   "' has invalid enum value '" + value + "'";
         }
     }
 
     return "";
 }
 
+std::string ValidateToolInput(const Tool* tool,
+                               const std::unordered_map<std::string, std::string>& params) {
+    if (!tool) {
+        return "";
+    }
+    return CompiledToolSchema::Compile(tool->Name(), tool->ParametersJson()).Validate(params);
+}
+
 }  // namespace kabot::agent::tools
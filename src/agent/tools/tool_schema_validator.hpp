@@ -2,11 +2,51 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace kabot::agent::tools {
 
 class Tool;
 
+// A tool's parameters schema reduced to what input validation checks: the
+// required keys plus the declared type and enum of each property. Compiled
+// once per tool so executing a tool does not reparse its schema.
+class CompiledToolSchema {
+public:
+    CompiledToolSchema() = default;
+
+    // A schema that fails to parse compiles to one that accepts any input.
+    static CompiledToolSchema Compile(const std::string& tool_name, const std::string& parameters_json);
+
+    // Returns an "Error: ..." message for the model, or empty when valid.
+    std::string Validate(const std::unordered_map<std::string, std::string>& params) const;
+
+private:
+    enum class Type {
+        kAny,
+        kString,
+        kBoolean,
+        kInteger,
+        kNumber,
+        kArray,
+        kObject
+    };
+
+    struct Property {
+        Type type = Type::kAny;
+        std::string type_name;
+        bool has_enum = false;
+        // String members of the enum; boolean members as "true"/"false".
+        std::vector<std::string> enum_values;
+    };
+
+    std::string tool_name_;
+    std::vector<std::string> required_;
+    std::unordered_map<std::string, Property> properties_;
+};
+
+// One-off validation that compiles the schema on every call; ToolRegistry
+// keeps compiled schemas instead.
 std::string ValidateToolInput(const Tool* tool,
                                const std::unordered_map<std::string, std::string>& params);
 
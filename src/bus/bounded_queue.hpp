@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace kabot::bus {
+
+struct QueueStats {
+    std::size_t size = 0;
+    std::size_t capacity = 0;
+    std::size_t high_watermark = 0;
+    std::uint64_t pushed = 0;
+    std::uint64_t dropped = 0;
+};
+
+// Bounded multi-producer/multi-consumer FIFO. Items are moved in and out, and
+// producers and consumers wait on separate condition variables so a push only
+// ever wakes a consumer of this queue.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity)
+        : capacity_(std::max<std::size_t>(1, capacity)) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Blocks while the queue is full for at most `timeout`. Returns false (and
+    // counts the item as dropped) when no slot frees up in time.
+    bool Push(T&& item, std::chrono::milliseconds timeout) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!not_full_.wait_for(lock, timeout, [this] { return items_.size() < capacity_; })) {
+                dropped_ += 1;
+                return false;
+            }
+            items_.push_back(std::move(item));
+            pushed_ += 1;
+            high_watermark_ = std::max(high_watermark_, items_.size());
+        }
+        not_empty_.notify_one();
+        return true;
+    }
+
+    void Pop(T& out) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [this] { return !items_.empty(); });
+            out = std::move(items_.front());
+            items_.pop_front();
+        }
+        not_full_.notify_one();
+    }
+
+    bool TryPop(T& out, std::chrono::milliseconds timeout) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!not_empty_.wait_for(lock, timeout, [this] { return !items_.empty(); })) {
+                return false;
+            }
+            out = std::move(items_.front());
+            items_.pop_front();
+        }
+        not_full_.notify_one();
+        return true;
+    }
+
+    // Waits up to `timeout` for the first item, then moves up to `max_items`
+    // already-queued items into `out` without further waiting.
+    std::size_t PopN(std::vector<T>& out, std::size_t max_items, std::chrono::milliseconds timeout) {
+        std::size_t taken = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!not_empty_.wait_for(lock, timeout, [this] { return !items_.empty(); })) {
+                return 0;
+            }
+            while (!items_.empty() && taken < max_items) {
+                out.push_back(std::move(items_.front()));
+                items_.pop_front();
+                taken += 1;
+            }
+        }
+        if (taken > 0) {
+            not_full_.notify_all();
+        }
+        return taken;
+    }
+
+    std::size_t Size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    QueueStats Stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        QueueStats stats{};
+        stats.size = items_.size();
+        stats.capacity = capacity_;
+        stats.high_watermark = high_watermark_;
+        stats.pushed = pushed_;
+        stats.dropped = dropped_;
+        return stats;
+    }
+
+private:
+    const std::size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    std::size_t high_watermark_ = 0;
+    std::uint64_t pushed_ = 0;
+    std::uint64_t dropped_ = 0;
+};
+
+}  // namespace kabot::bus
@@ -1,74 +1,90 @@
 #include "bus/message_bus.hpp"
 
-#include <iostream>
+#include <utility>
+
+#include "utils/logging.hpp"
 
 namespace kabot::bus {
 
-void MessageBus::PublishInbound(const InboundMessage& msg) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        inbound_.push(msg);
+MessageBus::MessageBus()
+    : MessageBus(kabot::config::BusConfig{}) {}
+
+MessageBus::MessageBus(const kabot::config::BusConfig& config)
+    : inbound_(static_cast<std::size_t>(config.inbound_capacity > 0 ? config.inbound_capacity : 1))
+    , outbound_(static_cast<std::size_t>(config.outbound_capacity > 0 ? config.outbound_capacity : 1))
+    , publish_timeout_(std::chrono::milliseconds(config.publish_timeout_ms > 0 ? config.publish_timeout_ms : 0)) {}
+
+bool MessageBus::PublishInbound(InboundMessage msg) {
+    const auto channel = msg.channel_instance.empty() ? msg.channel : msg.channel_instance;
+    const auto chat_id = msg.chat_id;
+    if (!inbound_.Push(std::move(msg), publish_timeout_)) {
+        LOG_WARN("[bus] inbound queue full, dropped message channel={} chat_id={}", channel, chat_id);
+        return false;
     }
-    cv_.notify_one();
+    return true;
 }
 
 InboundMessage MessageBus::ConsumeInbound() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return !inbound_.empty(); });
-    auto msg = inbound_.front();
-    inbound_.pop();
+    InboundMessage msg{};
+    inbound_.Pop(msg);
     return msg;
 }
 
 bool MessageBus::TryConsumeInbound(InboundMessage& msg, std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (!cv_.wait_for(lock, timeout, [this] { return !inbound_.empty(); })) {
-        return false;
-    }
-    msg = inbound_.front();
-    inbound_.pop();
-    return true;
+    return inbound_.TryPop(msg, timeout);
+}
+
+std::size_t MessageBus::DrainInbound(std::vector<InboundMessage>& out,
+                                     std::size_t max_messages,
+                                     std::chrono::milliseconds timeout) {
+    return inbound_.PopN(out, max_messages, timeout);
 }
 
 std::size_t MessageBus::InboundSize() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return inbound_.size();
+    return inbound_.Size();
 }
 
-void MessageBus::PublishOutbound(const OutboundMessage& msg) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        outbound_.push(msg);
+QueueStats MessageBus::InboundStats() const {
+    return inbound_.Stats();
+}
+
+bool MessageBus::PublishOutbound(OutboundMessage msg) {
+    const auto channel = msg.channel_instance.empty() ? msg.channel : msg.channel_instance;
+    const auto chat_id = msg.chat_id;
+    if (!outbound_.Push(std::move(msg), publish_timeout_)) {
+        LOG_WARN("[bus] outbound queue full, dropped message channel={} chat_id={}", channel, chat_id);
+        return false;
     }
-    cv_.notify_one();
+    return true;
 }
 
 OutboundMessage MessageBus::ConsumeOutbound() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return !outbound_.empty(); });
-    auto msg = outbound_.front();
-    outbound_.pop();
+    OutboundMessage msg{};
+    outbound_.Pop(msg);
     return msg;
 }
 
 bool MessageBus::TryConsumeOutbound(OutboundMessage& msg, std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (!cv_.wait_for(lock, timeout, [this] { return !outbound_.empty(); })) {
-        return false;
-    }
-    msg = outbound_.front();
-    outbound_.pop();
-    return true;
+    return outbound_.TryPop(msg, timeout);
+}
+
+std::size_t MessageBus::DrainOutbound(std::vector<OutboundMessage>& out,
+                                      std::size_t max_messages,
+                                      std::chrono::milliseconds timeout) {
+    return outbound_.PopN(out, max_messages, timeout);
 }
 
 std::size_t MessageBus::OutboundSize() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return outbound_.size();
+    return outbound_.Size();
+}
+
+QueueStats MessageBus::OutboundStats() const {
+    return outbound_.Stats();
 }
 
 void MessageBus::SubscribeOutbound(const std::string& channel,
                                    std::function<void(const OutboundMessage&)> callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
     subscribers_[channel].push_back(std::move(callback));
 }
 
@@ -81,7 +97,7 @@ void MessageBus::DispatchOutbound() {
         }
         std::vector<std::function<void(const OutboundMessage&)>> callbacks;
         {
-            std::lock_guard<std::mutex> lock(mutex_);
+            std::lock_guard<std::mutex> lock(subscribers_mutex_);
             auto it = subscribers_.find(msg.channel);
             if (it != subscribers_.end()) {
                 callbacks = it->second;
@@ -1,38 +1,52 @@
 #pragma once
 
-#include <queue>
 #include <mutex>
-#include <condition_variable>
 #include <cstddef>
 #include <chrono>
 #include <atomic>
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
+#include "bus/bounded_queue.hpp"
 #include "bus/events.hpp"
+#include "config/config_schema.hpp"
 
 namespace kabot::bus {
 
 class MessageBus {
 public:
-    void PublishInbound(const InboundMessage& msg);
+    MessageBus();
+    explicit MessageBus(const kabot::config::BusConfig& config);
+
+    // Publishing moves the message into the queue. When the queue is full the
+    // caller waits up to bus.publishTimeoutMs before the message is dropped.
+    bool PublishInbound(InboundMessage msg);
     InboundMessage ConsumeInbound();
     bool TryConsumeInbound(InboundMessage& msg, std::chrono::milliseconds timeout);
+    std::size_t DrainInbound(std::vector<InboundMessage>& out,
+                             std::size_t max_messages,
+                             std::chrono::milliseconds timeout);
     std::size_t InboundSize() const;
-    void PublishOutbound(const OutboundMessage& msg);
+    QueueStats InboundStats() const;
+    bool PublishOutbound(OutboundMessage msg);
     OutboundMessage ConsumeOutbound();
     bool TryConsumeOutbound(OutboundMessage& msg, std::chrono::milliseconds timeout);
+    std::size_t DrainOutbound(std::vector<OutboundMessage>& out,
+                              std::size_t max_messages,
+                              std::chrono::milliseconds timeout);
     std::size_t OutboundSize() const;
+    QueueStats OutboundStats() const;
     void SubscribeOutbound(const std::string& channel,
                            std::function<void(const OutboundMessage&)> callback);
     void DispatchOutbound();
     void Stop();
 
 private:
-    std::queue<InboundMessage> inbound_;
-    std::queue<OutboundMessage> outbound_;
-    mutable std::mutex mutex_;
-    std::condition_variable cv_;
+    BoundedQueue<InboundMessage> inbound_;
+    BoundedQueue<OutboundMessage> outbound_;
+    std::chrono::milliseconds publish_timeout_;
+    std::mutex subscribers_mutex_;
     std::unordered_map<std::string, std::vector<std::function<void(const OutboundMessage&)>>> subscribers_;
     std::atomic<bool> running_{false};
 };
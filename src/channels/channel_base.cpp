@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <utility>
 
 #include "utils/logging.hpp"
 
@@ -58,7 +59,7 @@ void ChannelBase::HandleMessage(
     msg.content = content;
     msg.media = media;
     msg.metadata = metadata;
-    bus_.PublishInbound(msg);
+    bus_.PublishInbound(std::move(msg));
 }
 
 }  // namespace kabot::channels
@@ -1,5 +1,6 @@
 #include "channels/channel_manager.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <thread>
 
@@ -16,8 +17,57 @@ namespace kabot::channels {
 
 namespace {
 
-constexpr int kMaxSendAttempts = 3;
-constexpr auto kRetryDelay = std::chrono::milliseconds(800);
+OutboundSenderOptions SenderOptionsFor(const kabot::config::ChannelSenderConfig& config) {
+    OutboundSenderOptions options{};
+    options.queue_capacity = static_cast<std::size_t>(std::max(1, config.queue_capacity));
+    options.max_attempts = std::max(1, config.max_attempts);
+    options.retry_delay = std::chrono::milliseconds(std::max(0, config.retry_delay_ms));
+    options.max_retry_delay = std::chrono::milliseconds(std::max(config.retry_delay_ms, config.max_retry_delay_ms));
+    options.rate_per_second = std::max(0.0, config.rate_per_second);
+    options.burst = std::max(1, config.burst);
+    options.chat_rate_per_second = std::max(0.0, config.chat_rate_per_second);
+    options.chat_burst = std::max(1, config.chat_burst);
+    options.coalesce_window = std::chrono::milliseconds(std::max(0, config.coalesce_window_ms));
+    options.max_message_chars = static_cast<std::size_t>(std::max(0, config.max_message_chars));
+    return options;
+}
+
+// Fills unset rate limits with what each platform tolerates before it
+// starts answering 429s, and the message size limit with the platform's.
+kabot::config::ChannelSenderConfig WithRateDefaults(kabot::config::ChannelSenderConfig config,
+                                                    const std::string& type) {
+    struct Limits {
+        double rate;
+        int burst;
+        double chat_rate;
+        int chat_burst;
+        int max_chars;
+    };
+    Limits limits{0, 1, 0, 1, 4096};
+    if (type == "telegram") {
+        limits = {25, 30, 1, 3, 4096};
+    } else if (type == "lark") {
+        limits = {50, 50, 5, 5, 30000};
+    } else if (type == "qqbot") {
+        limits = {5, 5, 1, 2, 2000};
+    }
+    if (config.rate_per_second < 0) {
+        config.rate_per_second = limits.rate;
+    }
+    if (config.burst < 0) {
+        config.burst = limits.burst;
+    }
+    if (config.chat_rate_per_second < 0) {
+        config.chat_rate_per_second = limits.chat_rate;
+    }
+    if (config.chat_burst < 0) {
+        config.chat_burst = limits.chat_burst;
+    }
+    if (config.max_message_chars < 0) {
+        config.max_message_chars = limits.max_chars;
+    }
+    return config;
+}
 
 }  // namespace
 
@@ -36,6 +86,11 @@ void ChannelManager::InitChannels() {
 
 void ChannelManager::Register(std::unique_ptr<ChannelBase> channel) {
     auto name = channel->Name();
+    auto config = sender_configs_.find(name);
+    auto sender = std::make_unique<OutboundSender>(
+        *channel,
+        SenderOptionsFor(config == sender_configs_.end() ? config_.channels.sender : config->second));
+    senders_[name] = std::move(sender);
     channels_.emplace(std::move(name), std::move(channel));
 }
 
@@ -48,10 +103,13 @@ ChannelBase* ChannelManager::GetChannel(const std::string& name) {
 }
 
 void ChannelManager::DispatchOutbound(const kabot::bus::OutboundMessage& msg) {
-    SendWithRetry(msg);
+    Route(msg);
 }
 
 void ChannelManager::StartAll() {
+    for (auto& [_, sender] : senders_) {
+        sender->Start();
+    }
     if (!dispatch_running_) {
         dispatch_running_ = true;
         dispatch_thread_ = std::thread([this] { RunOutboundDispatcher(); });
@@ -66,6 +124,9 @@ void ChannelManager::StopAll() {
     if (dispatch_thread_.joinable()) {
         dispatch_thread_.join();
     }
+    for (auto& [_, sender] : senders_) {
+        sender->Stop();
+    }
     for (auto& [_, channel] : channels_) {
         channel->Stop();
     }
@@ -79,8 +140,16 @@ std::unordered_map<std::string, bool> ChannelManager::Status() const {
     return status;
 }
 
-bool ChannelManager::SendWithRetry(const kabot::bus::OutboundMessage& msg) {
-    if (msg.content.empty() && msg.media.empty()) {
+std::unordered_map<std::string, OutboundSenderStats> ChannelManager::OutboundStats() const {
+    std::unordered_map<std::string, OutboundSenderStats> stats;
+    for (const auto& [name, sender] : senders_) {
+        stats[name] = sender->Stats();
+    }
+    return stats;
+}
+
+bool ChannelManager::Route(kabot::bus::OutboundMessage msg) {
+    if (!IsDeliverable(msg)) {
         LOG_WARN("[channel] skip empty outbound message channel={} chat_id={} reply_to={}",
                  msg.channel_instance.empty() ? msg.channel : msg.channel_instance,
                  msg.chat_id,
@@ -88,54 +157,29 @@ bool ChannelManager::SendWithRetry(const kabot::bus::OutboundMessage& msg) {
         return true;
     }
 
-    const auto& channel_name = msg.channel_instance.empty() ? msg.channel : msg.channel_instance;
-    auto channel = GetChannel(channel_name);
-    if (!channel) {
+    const auto channel_name = msg.channel_instance.empty() ? msg.channel : msg.channel_instance;
+    auto sender = senders_.find(channel_name);
+    if (sender == senders_.end()) {
         LOG_ERROR("[channel] outbound send failed: unknown channel={} chat_id={}",
                   channel_name,
                   msg.chat_id);
         return false;
     }
-
-    const bool is_typing = [&]() {
-        auto it = msg.metadata.find("action");
-        return it != msg.metadata.end() && it->second == "typing";
-    }();
-    const int max_attempts = is_typing ? 1 : kMaxSendAttempts;
-
-    for (int attempt = 1; attempt <= max_attempts; ++attempt) {
-        const bool sent = channel->Send(msg);
-        if (sent) {
-            if (attempt > 1) {
-                LOG_WARN("[channel] outbound send recovered after retry channel={} chat_id={} attempt={}",
-                         channel_name,
-                         msg.chat_id,
-                         attempt);
-            }
-            return true;
-        }
-
-        LOG_ERROR("[channel] outbound send failed channel={} chat_id={} attempt={}/{} reply_to={} content_size={} media_count={}",
+    const auto chat_id = msg.chat_id;
+    if (!sender->second->Enqueue(std::move(msg))) {
+        LOG_ERROR("[channel] outbound queue full, dropping message channel={} chat_id={}",
                   channel_name,
-                  msg.chat_id,
-                  attempt,
-                  max_attempts,
-                  msg.reply_to,
-                  msg.content.size(),
-                  msg.media.size());
-
-        if (attempt < max_attempts) {
-            std::this_thread::sleep_for(kRetryDelay);
-        }
+                  chat_id);
+        return false;
     }
-
-    return false;
+    return true;
 }
 
 void ChannelManager::RegisterInstance(const kabot::config::ChannelInstanceConfig& config) {
     if (!config.enabled) {
         return;
     }
+    sender_configs_[config.name] = WithRateDefaults(config.sender, config.type);
     if (config.type == "telegram") {
         Register(std::make_unique<TelegramChannel>(config.telegram, bus_));
     } else if (config.type == "lark") {
@@ -167,7 +211,7 @@ void ChannelManager::RunOutboundDispatcher() {
         if (!bus_.TryConsumeOutbound(msg, std::chrono::milliseconds(1000))) {
             continue;
         }
-        SendWithRetry(msg);
+        Route(std::move(msg));
     }
 }
 
@@ -6,6 +6,7 @@
 #include <unordered_map>
 
 #include "channels/channel_base.hpp"
+#include "channels/outbound_sender.hpp"
 #include "config/config_schema.hpp"
 
 namespace kabot::channels {
@@ -21,10 +22,12 @@ public:
     void StopAll();
 
     std::unordered_map<std::string, bool> Status() const;
+    std::unordered_map<std::string, OutboundSenderStats> OutboundStats() const;
 
 private:
     void InitChannels();
-    bool SendWithRetry(const kabot::bus::OutboundMessage& msg);
+    // Hands msg to its channel's sender; never blocks on the channel itself.
+    bool Route(kabot::bus::OutboundMessage msg);
     void RegisterInstance(const kabot::config::ChannelInstanceConfig& config);
     void RunOutboundDispatcher();
 
@@ -35,6 +38,8 @@ private:
 
 private:
     std::unordered_map<std::string, std::unique_ptr<ChannelBase>> channels_;
+    std::unordered_map<std::string, kabot::config::ChannelSenderConfig> sender_configs_;
+    std::unordered_map<std::string, std::unique_ptr<OutboundSender>> senders_;
 };
 
 }  // namespace kabot::channels
@@ -0,0 +1,374 @@
+#include "channels/outbound_sender.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+
+#include "utils/logging.hpp"
+
+namespace kabot::channels {
+
+namespace {
+
+constexpr double kLatencySmoothing = 0.2;
+constexpr std::size_t kMaxChatBuckets = 4096;
+constexpr const char* kMergeSeparator = "\n\n";
+
+// Metadata the channels read when sending. Other keys (inbound ids and
+// similar bookkeeping) do not change how a message is delivered, so they do
+// not prevent merging.
+constexpr const char* kSendMetadataKeys[] = {
+    "action",
+    "stream_id",
+    "stream_state",
+    "receive_id",
+    "receive_id_type",
+    "event_name",
+    "qqbot_chat_type",
+    "qqbot_channel_id",
+    "qqbot_guild_id",
+    "qqbot_group_openid",
+    "qqbot_user_openid",
+    "qqbot_message_id",
+};
+
+bool SameSendMetadata(const kabot::bus::OutboundMessage& a, const kabot::bus::OutboundMessage& b) {
+    for (const char* key : kSendMetadataKeys) {
+        const auto in_a = a.metadata.find(key);
+        const auto in_b = b.metadata.find(key);
+        const bool has_a = in_a != a.metadata.end();
+        const bool has_b = in_b != b.metadata.end();
+        if (has_a != has_b || (has_a && in_a->second != in_b->second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+bool IsTyping(const kabot::bus::OutboundMessage& msg) {
+    auto it = msg.metadata.find("action");
+    return it != msg.metadata.end() && it->second == "typing";
+}
+
+bool IsDeliverable(const kabot::bus::OutboundMessage& msg) {
+    return !msg.content.empty() || !msg.media.empty() || IsTyping(msg);
+}
+
+TokenBucket::TokenBucket(double rate_per_second, double burst)
+    : rate_(std::max(0.0, rate_per_second))
+    , burst_(std::max(1.0, burst))
+    , tokens_(burst_)
+    , last_(Clock::now()) {}
+
+void TokenBucket::Refill(Clock::time_point now) {
+    if (rate_ <= 0.0 || now <= last_) {
+        return;
+    }
+    const auto elapsed = std::chrono::duration<double>(now - last_).count();
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+    last_ = now;
+}
+
+TokenBucket::Clock::duration TokenBucket::WaitTime(Clock::time_point now) {
+    if (rate_ <= 0.0) {
+        return Clock::duration::zero();
+    }
+    Refill(now);
+    if (tokens_ >= 1.0) {
+        return Clock::duration::zero();
+    }
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>((1.0 - tokens_) / rate_));
+}
+
+void TokenBucket::Take(Clock::time_point now) {
+    if (rate_ <= 0.0) {
+        return;
+    }
+    Refill(now);
+    tokens_ -= 1.0;
+}
+
+bool TokenBucket::Full(Clock::time_point now) {
+    Refill(now);
+    return rate_ <= 0.0 || tokens_ >= burst_;
+}
+
+OutboundSender::OutboundSender(ChannelBase& channel, OutboundSenderOptions options)
+    : channel_(channel)
+    , options_(options)
+    , channel_bucket_(options.rate_per_second, options.burst) {}
+
+OutboundSender::~OutboundSender() {
+    Stop();
+}
+
+void OutboundSender::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    worker_ = std::thread([this] { RunWorker(); });
+}
+
+void OutboundSender::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queued_ > 0) {
+        LOG_WARN("[channel] outbound sender stopped with pending messages channel={} pending={}",
+                 channel_.Name(),
+                 queued_);
+    }
+}
+
+bool OutboundSender::Enqueue(kabot::bus::OutboundMessage msg) {
+    const auto chat_id = msg.chat_id;
+    const auto now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& chat = chats_[chat_id];
+        if (CoalesceLocked(chat, msg, now)) {
+            stats_.coalesced += 1;
+            return true;
+        }
+        if (queued_ >= options_.queue_capacity) {
+            stats_.dropped += 1;
+            if (chat.items.empty() && chat.state == ChatState::kIdle) {
+                chats_.erase(chat_id);
+            }
+            return false;
+        }
+        Pending pending{};
+        pending.max_attempts = IsTyping(msg) ? 1 : std::max(1, options_.max_attempts);
+        pending.msg = std::move(msg);
+        pending.enqueued_at = now;
+        chat.items.push_back(std::move(pending));
+        queued_ += 1;
+        if (chat.state == ChatState::kIdle) {
+            chat.state = ChatState::kReady;
+            ready_.push_back(chat_id);
+        }
+    }
+    cv_.notify_one();
+    return true;
+}
+
+OutboundSenderStats OutboundSender::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    stats.queued = queued_;
+    stats.delayed_chats = delayed_.size();
+    return stats;
+}
+
+void OutboundSender::RunWorker() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        PromoteDueLocked(Clock::now());
+        if (ready_.empty()) {
+            if (delayed_.empty()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, delayed_.begin()->first);
+            }
+            continue;
+        }
+
+        const auto chat_id = std::move(ready_.front());
+        ready_.pop_front();
+        // unordered_map references survive rehashing; the chat is never
+        // erased while one of its messages is in flight.
+        auto& chat = chats_[chat_id];
+        const auto picked_at = Clock::now();
+        auto& chat_bucket = ChatBucketLocked(chat_id, picked_at);
+        const auto wait = std::max(chat_bucket.WaitTime(picked_at), channel_bucket_.WaitTime(picked_at));
+        if (wait > Clock::duration::zero()) {
+            chat.state = ChatState::kDelayed;
+            delayed_.emplace(picked_at + wait, chat_id);
+            stats_.throttled += 1;
+            continue;
+        }
+        chat_bucket.Take(picked_at);
+        channel_bucket_.Take(picked_at);
+        chat.state = ChatState::kInFlight;
+        auto pending = std::move(chat.items.front());
+        chat.items.pop_front();
+        queued_ -= 1;
+        stats_.in_flight += 1;
+
+        lock.unlock();
+        pending.attempt += 1;
+        bool sent = false;
+        try {
+            sent = channel_.Send(pending.msg);
+        } catch (const std::exception& ex) {
+            LOG_ERROR("[channel] outbound send threw channel={} chat_id={} error={}",
+                      channel_.Name(),
+                      chat_id,
+                      ex.what());
+        }
+        const auto now = Clock::now();
+        lock.lock();
+        stats_.in_flight -= 1;
+
+        if (sent) {
+            const auto latency_ms =
+                std::chrono::duration<double, std::milli>(now - pending.enqueued_at).count();
+            stats_.sent += 1;
+            stats_.avg_latency_ms = stats_.sent == 1
+                ? latency_ms
+                : stats_.avg_latency_ms + kLatencySmoothing * (latency_ms - stats_.avg_latency_ms);
+            stats_.max_latency_ms = std::max(stats_.max_latency_ms, latency_ms);
+            if (pending.attempt > 1) {
+                LOG_WARN("[channel] outbound send recovered after retry channel={} chat_id={} attempt={}",
+                         channel_.Name(),
+                         chat_id,
+                         pending.attempt);
+            }
+            FinishLocked(chat_id, chat);
+            continue;
+        }
+
+        LOG_ERROR("[channel] outbound send failed channel={} chat_id={} attempt={}/{} reply_to={} content_size={} media_count={}",
+                  channel_.Name(),
+                  chat_id,
+                  pending.attempt,
+                  pending.max_attempts,
+                  pending.msg.reply_to,
+                  pending.msg.content.size(),
+                  pending.msg.media.size());
+        if (pending.attempt < pending.max_attempts) {
+            // Park the whole chat until the retry is due so its later
+            // messages cannot overtake this one.
+            const auto delay = BackoffFor(pending.attempt);
+            stats_.retried += 1;
+            chat.items.push_front(std::move(pending));
+            queued_ += 1;
+            chat.state = ChatState::kDelayed;
+            delayed_.emplace(now + delay, chat_id);
+            continue;
+        }
+        stats_.failed += 1;
+        FinishLocked(chat_id, chat);
+    }
+}
+
+bool OutboundSender::CoalesceLocked(ChatQueue& chat,
+                                    kabot::bus::OutboundMessage& msg,
+                                    Clock::time_point now) {
+    if (chat.items.empty()) {
+        return false;
+    }
+    // Real content is already queued; a typing indicator would only cost a
+    // request and be replaced immediately.
+    if (IsTyping(msg)) {
+        return true;
+    }
+    for (auto it = chat.items.begin(); it != chat.items.end();) {
+        if (it->attempt == 0 && IsTyping(it->msg)) {
+            it = chat.items.erase(it);
+            queued_ -= 1;
+            stats_.coalesced += 1;
+        } else {
+            ++it;
+        }
+    }
+    if (chat.items.empty()) {
+        return false;
+    }
+
+    auto& tail = chat.items.back();
+    if (tail.attempt > 0) {
+        return false;
+    }
+    const auto stream = msg.metadata.find("stream_id");
+    if (stream != msg.metadata.end()) {
+        // Stream updates carry the whole reply so far, so a queued partial
+        // is simply replaced by the newer update.
+        const auto tail_stream = tail.msg.metadata.find("stream_id");
+        const auto tail_state = tail.msg.metadata.find("stream_state");
+        if (tail_stream != tail.msg.metadata.end() && tail_stream->second == stream->second &&
+            tail_state != tail.msg.metadata.end() && tail_state->second == "partial") {
+            tail.msg = std::move(msg);
+            return true;
+        }
+        return false;
+    }
+    if (options_.coalesce_window <= std::chrono::milliseconds::zero() ||
+        now - tail.enqueued_at > options_.coalesce_window) {
+        return false;
+    }
+    if (!msg.media.empty() || !tail.msg.media.empty() ||
+        !SameSendMetadata(msg, tail.msg) ||
+        msg.reply_to != tail.msg.reply_to || msg.agent_name != tail.msg.agent_name) {
+        return false;
+    }
+    const auto merged_size = tail.msg.content.size() + std::char_traits<char>::length(kMergeSeparator) +
+                             msg.content.size();
+    if (options_.max_message_chars > 0 && merged_size > options_.max_message_chars) {
+        return false;
+    }
+    tail.msg.content += kMergeSeparator + msg.content;
+    return true;
+}
+
+TokenBucket& OutboundSender::ChatBucketLocked(const std::string& chat_id, Clock::time_point now) {
+    if (options_.chat_rate_per_second <= 0.0) {
+        static TokenBucket unlimited;
+        return unlimited;
+    }
+    auto it = chat_buckets_.find(chat_id);
+    if (it != chat_buckets_.end()) {
+        return it->second;
+    }
+    if (chat_buckets_.size() >= kMaxChatBuckets) {
+        // A full bucket is indistinguishable from a fresh one.
+        for (auto bucket = chat_buckets_.begin(); bucket != chat_buckets_.end();) {
+            bucket = bucket->second.Full(now) ? chat_buckets_.erase(bucket) : std::next(bucket);
+        }
+    }
+    return chat_buckets_.emplace(chat_id, TokenBucket(options_.chat_rate_per_second, options_.chat_burst))
+        .first->second;
+}
+
+void OutboundSender::PromoteDueLocked(Clock::time_point now) {
+    while (!delayed_.empty() && delayed_.begin()->first <= now) {
+        auto chat_id = std::move(delayed_.begin()->second);
+        delayed_.erase(delayed_.begin());
+        chats_[chat_id].state = ChatState::kReady;
+        ready_.push_back(std::move(chat_id));
+    }
+}
+
+void OutboundSender::FinishLocked(const std::string& chat_id, ChatQueue& chat) {
+    if (chat.items.empty()) {
+        chats_.erase(chat_id);
+        return;
+    }
+    chat.state = ChatState::kReady;
+    ready_.push_back(chat_id);
+    cv_.notify_one();
+}
+
+std::chrono::milliseconds OutboundSender::BackoffFor(int attempt) const {
+    auto delay = options_.retry_delay;
+    for (int i = 1; i < attempt && delay < options_.max_retry_delay; ++i) {
+        delay *= 2;
+    }
+    return std::min(delay, options_.max_retry_delay);
+}
+
+}  // namespace kabot::channels
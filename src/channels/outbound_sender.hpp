@@ -0,0 +1,141 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "bus/events.hpp"
+#include "channels/channel_base.hpp"
+
+namespace kabot::channels {
+
+// Classic token bucket; a rate of 0 never throttles.
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TokenBucket() = default;
+    TokenBucket(double rate_per_second, double burst);
+
+    // Time until a token is available; zero when one is available now.
+    Clock::duration WaitTime(Clock::time_point now);
+    void Take(Clock::time_point now);
+    bool Full(Clock::time_point now);
+
+private:
+    double rate_ = 0.0;
+    double burst_ = 1.0;
+    double tokens_ = 1.0;
+    Clock::time_point last_{};
+
+    void Refill(Clock::time_point now);
+};
+
+struct OutboundSenderOptions {
+    std::size_t queue_capacity = 1024;
+    int max_attempts = 3;
+    std::chrono::milliseconds retry_delay{800};
+    std::chrono::milliseconds max_retry_delay{10000};
+    // Sends per second across the channel and within one chat; 0 = unlimited.
+    double rate_per_second = 0.0;
+    double burst = 1.0;
+    double chat_rate_per_second = 0.0;
+    double chat_burst = 1.0;
+    // Queued plain-text messages to one chat younger than this absorb the
+    // next one instead of costing another send. 0 disables merging.
+    std::chrono::milliseconds coalesce_window{1000};
+    // Text is not merged past this many bytes (the platform's message
+    // limit). 0 is unlimited.
+    std::size_t max_message_chars = 0;
+};
+
+struct OutboundSenderStats {
+    std::size_t queued = 0;
+    std::size_t in_flight = 0;
+    std::size_t delayed_chats = 0;
+    std::uint64_t sent = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t retried = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t coalesced = 0;  // merged into or superseded by another message
+    std::uint64_t throttled = 0;  // times a chat waited on a rate limit
+    double avg_latency_ms = 0.0;  // enqueue to successful send, EWMA
+    double max_latency_ms = 0.0;
+};
+
+// Chat actions carry metadata["action"] and no content.
+bool IsTyping(const kabot::bus::OutboundMessage& msg);
+// False when msg has nothing to send. Typing actions are deliverable even
+// though they are empty; before per-channel senders they were skipped as
+// empty messages, so typing indicators never reached the chat.
+bool IsDeliverable(const kabot::bus::OutboundMessage& msg);
+
+// Delivers outbound messages for one channel instance on its own thread, so
+// a slow or failing endpoint only delays its own traffic. Channel Send paths
+// are not thread-safe, so each channel gets exactly one sender thread.
+// Messages for the same chat are sent strictly in order: while a chat's head
+// message waits on a retry, later messages for that chat wait behind it, but
+// other chats keep flowing. Retries and rate limits are scheduled as timers rather than slept
+// on by the worker. While a chat has a backlog, new text is merged into its
+// queued tail, a newer stream update replaces the queued one, and typing
+// indicators are dropped once real content is queued.
+class OutboundSender {
+public:
+    OutboundSender(ChannelBase& channel, OutboundSenderOptions options);
+    ~OutboundSender();
+    OutboundSender(const OutboundSender&) = delete;
+    OutboundSender& operator=(const OutboundSender&) = delete;
+
+    void Start();
+    void Stop();
+    // Returns false when the channel's queue is full.
+    bool Enqueue(kabot::bus::OutboundMessage msg);
+    OutboundSenderStats Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        kabot::bus::OutboundMessage msg;
+        int attempt = 0;
+        int max_attempts = 1;
+        Clock::time_point enqueued_at{};
+    };
+    enum class ChatState { kIdle, kReady, kInFlight, kDelayed };
+    struct ChatQueue {
+        std::deque<Pending> items;
+        ChatState state = ChatState::kIdle;
+    };
+
+    ChannelBase& channel_;
+    OutboundSenderOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_ = false;
+    std::thread worker_;
+    std::unordered_map<std::string, ChatQueue> chats_;
+    std::deque<std::string> ready_;
+    std::multimap<Clock::time_point, std::string> delayed_;
+    std::size_t queued_ = 0;
+    OutboundSenderStats stats_;
+    TokenBucket channel_bucket_;
+    std::unordered_map<std::string, TokenBucket> chat_buckets_;
+
+    void RunWorker();
+    bool CoalesceLocked(ChatQueue& chat, kabot::bus::OutboundMessage& msg, Clock::time_point now);
+    TokenBucket& ChatBucketLocked(const std::string& chat_id, Clock::time_point now);
+    void PromoteDueLocked(Clock::time_point now);
+    void FinishLocked(const std::string& chat_id, ChatQueue& chat);
+    std::chrono::milliseconds BackoffFor(int attempt) const;
+};
+
+}  // namespace kabot::channels
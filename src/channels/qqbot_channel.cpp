@@ -252,7 +252,7 @@ void QQBotChannel::ReportTerminalState(const std::string& event_name,
     msg.metadata["system_event"] = "qqbot_terminal";
     msg.metadata["qqbot_rebuild"] = "scheduled";
     msg.metadata["qqbot_terminal_payload"] = payload;
-    bus_.PublishInbound(msg);
+    bus_.PublishInbound(std::move(msg));
 }
 
 void QQBotChannel::ScheduleClientRebuild(std::uint64_t generation,
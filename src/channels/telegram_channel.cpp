@@ -1,6 +1,7 @@
 #include "channels/telegram_channel.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <regex>
@@ -11,6 +12,14 @@
 
 namespace kabot::channels {
 
+namespace {
+
+// A stream that has not been updated for this long lost its final update
+// (turn error, reply sent through a tool); its message id is forgotten.
+constexpr auto kStreamIdleTimeout = std::chrono::minutes(10);
+
+}  // namespace
+
 TelegramChannel::TelegramChannel(const kabot::config::TelegramConfig& config,
                                  kabot::bus::MessageBus& bus)
     : ChannelBase(config.name.empty() ? "telegram" : config.name,
@@ -230,6 +239,18 @@ bool TelegramChannel::Send(const kabot::bus::OutboundMessage& msg) {
             reply_to_message_id = 0;
         }
     }
+    auto it_stream = msg.metadata.find("stream_id");
+    if (it_stream != msg.metadata.end()) {
+        auto it_state = msg.metadata.find("stream_state");
+        const bool is_final = it_state == msg.metadata.end() || it_state->second != "partial";
+        if (SendStreamUpdate(chat_id, it_stream->second, msg.content, is_final, reply_to_message_id)) {
+            return true;
+        }
+        if (!is_final) {
+            // Partial updates are best effort; the final reply supersedes them.
+            return true;
+        }
+    }
     const auto html = ConvertMarkdownToHtml(msg.content);
     try {
         bot_->getApi().sendMessage(static_cast<std::int64_t>(std::stoll(chat_id)),
@@ -260,6 +281,92 @@ bool TelegramChannel::Send(const kabot::bus::OutboundMessage& msg) {
     }
 }
 
+// Partial updates are sent as plain text (their markdown may be unbalanced)
+// and edited in place; the final update switches the message to HTML.
+// Returns false when nothing was delivered so the caller can fall back to a
+// regular send.
+bool TelegramChannel::SendStreamUpdate(const std::string& chat_id,
+                                       const std::string& stream_id,
+                                       const std::string& content,
+                                       bool is_final,
+                                       long long reply_to_message_id) {
+    std::int64_t numeric_chat_id = 0;
+    try {
+        numeric_chat_id = static_cast<std::int64_t>(std::stoll(chat_id));
+    } catch (const std::exception&) {
+        return false;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    long long message_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        PruneStaleStreamsLocked(now);
+        auto it = stream_message_ids_.find(stream_id);
+        if (it != stream_message_ids_.end()) {
+            message_id = it->second.message_id;
+            if (is_final) {
+                stream_message_ids_.erase(it);
+            } else {
+                it->second.updated_at = now;
+            }
+        }
+    }
+    if (message_id == 0) {
+        if (is_final) {
+            return false;
+        }
+        try {
+            auto sent = bot_->getApi().sendMessage(numeric_chat_id,
+                                                   content,
+                                                   false,
+                                                   static_cast<std::int64_t>(reply_to_message_id));
+            if (sent) {
+                std::lock_guard<std::mutex> lock(stream_mutex_);
+                stream_message_ids_[stream_id] = StreamMessage{sent->messageId, now};
+            }
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    if (is_final) {
+        try {
+            bot_->getApi().editMessageText(ConvertMarkdownToHtml(content),
+                                           numeric_chat_id,
+                                           static_cast<std::int32_t>(message_id),
+                                           "",
+                                           "HTML");
+            return true;
+        } catch (const std::exception&) {
+        }
+    }
+    try {
+        bot_->getApi().editMessageText(content,
+                                       numeric_chat_id,
+                                       static_cast<std::int32_t>(message_id));
+        return true;
+    } catch (const std::exception& ex) {
+        // "message is not modified" and rate limit errors land here; a missed
+        // partial edit is superseded by the next one. A message that can no
+        // longer be edited ends the stream.
+        if (!is_final && std::string(ex.what()).find("not found") != std::string::npos) {
+            std::lock_guard<std::mutex> lock(stream_mutex_);
+            stream_message_ids_.erase(stream_id);
+        }
+        return !is_final;
+    }
+}
+
+void TelegramChannel::PruneStaleStreamsLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = stream_message_ids_.begin(); it != stream_message_ids_.end();) {
+        if (now - it->second.updated_at > kStreamIdleTimeout) {
+            it = stream_message_ids_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 void TelegramChannel::HandleIncomingMessage(
     const std::string& sender_id,
     const std::string& chat_id,
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <atomic>
@@ -37,12 +39,26 @@ private:
     std::unordered_map<std::string, std::string> chat_ids_;
     std::unordered_map<std::string, std::string> message_chat_ids_;
     std::unordered_map<std::string, long long> last_message_ids_;
+    struct StreamMessage {
+        long long message_id = 0;
+        std::chrono::steady_clock::time_point updated_at;
+    };
+    // Streamed reply id -> Telegram message that is edited as text arrives.
+    // Entries whose stream never sends a final update are expired.
+    std::mutex stream_mutex_;
+    std::unordered_map<std::string, StreamMessage> stream_message_ids_;
     std::unique_ptr<TgBot::HttpClient> http_client_;
     std::unique_ptr<TgBot::Bot> bot_;
     std::unique_ptr<TgBot::TgLongPoll> long_poll_;
     std::unique_ptr<std::thread> polling_thread_;
     std::atomic<bool> polling_{false};
 
+    bool SendStreamUpdate(const std::string& chat_id,
+                          const std::string& stream_id,
+                          const std::string& content,
+                          bool is_final,
+                          long long reply_to_message_id);
+    void PruneStaleStreamsLocked(std::chrono::steady_clock::time_point now);
     std::string ConvertMarkdownToHtml(const std::string& text) const;
     std::string GetMediaExtension(const std::string& media_type, const std::string& mime_type) const;
     std::string JoinParts(const std::vector<std::string>& parts) const;
@@ -10,6 +10,7 @@
 #include <optional>
 #include <string>
 #include <thread>
+#include <utility>
 #include <cstdlib>
 #include <cctype>
 
@@ -242,7 +243,7 @@ int RunGateway() {
         return 1;
     }
 
-    kabot::bus::MessageBus bus;
+    kabot::bus::MessageBus bus(config.bus);
     const std::string default_agent_name = config.agents.instances.empty()
         ? std::string("default")
         : config.agents.instances.front().name;
@@ -267,7 +268,7 @@ int RunGateway() {
                 outbound.agent_name = job.payload.agent;
                 outbound.chat_id = ResolveCronTo(config, outbound.channel_instance, job.payload.to);
                 outbound.content = job.payload.message;
-                bus.PublishOutbound(outbound);
+                bus.PublishOutbound(std::move(outbound));
             }
             return job.payload.message;
         },
@@ -318,7 +319,7 @@ int RunGateway() {
             outbound.agent_name = resolved_agent_name;
             outbound.chat_id = ResolveCronTo(config, outbound.channel_instance, job.payload.to);
             outbound.content = job.payload.message;
-            bus.PublishOutbound(outbound);
+            bus.PublishOutbound(std::move(outbound));
             return job.payload.message;
         } else {
             kabot::CancelToken cancel_token{};
@@ -336,7 +337,7 @@ int RunGateway() {
             outbound.agent_name = resolved_agent_name;
             outbound.chat_id = ResolveCronTo(config, outbound.channel_instance, job.payload.to);
             outbound.content = response;
-            bus.PublishOutbound(outbound);
+            bus.PublishOutbound(std::move(outbound));
             return response;
         }
     };
@@ -378,6 +379,76 @@ int RunGateway() {
         res.set_content(task_runtime.DumpStateJson(), "application/json");
     });
 
+    http_server.Get("/bus", [&bus, &channels](const httplib::Request&, httplib::Response& res) {
+        const auto to_json = [](const kabot::bus::QueueStats& stats) {
+            return nlohmann::json{
+                {"size", stats.size},
+                {"capacity", stats.capacity},
+                {"high_watermark", stats.high_watermark},
+                {"pushed", stats.pushed},
+                {"dropped", stats.dropped}
+            };
+        };
+        nlohmann::json senders = nlohmann::json::object();
+        for (const auto& [name, stats] : channels.OutboundStats()) {
+            senders[name] = {
+                {"queued", stats.queued},
+                {"in_flight", stats.in_flight},
+                {"delayed_chats", stats.delayed_chats},
+                {"sent", stats.sent},
+                {"failed", stats.failed},
+                {"retried", stats.retried},
+                {"dropped", stats.dropped},
+                {"coalesced", stats.coalesced},
+                {"throttled", stats.throttled},
+                {"avg_latency_ms", stats.avg_latency_ms},
+                {"max_latency_ms", stats.max_latency_ms}
+            };
+        }
+        nlohmann::json json = {
+            {"inbound", to_json(bus.InboundStats())},
+            {"outbound", to_json(bus.OutboundStats())},
+            {"senders", senders}
+        };
+        res.set_content(json.dump(2), "application/json");
+    });
+
+    http_server.Get("/agents/dispatch", [&agents](const httplib::Request&, httplib::Response& res) {
+        nlohmann::json json = nlohmann::json::array();
+        const auto stats = agents.DispatchStats();
+        for (std::size_t i = 0; i < stats.size(); ++i) {
+            const auto& shard = stats[i];
+            json.push_back({
+                {"shard", i},
+                {"queue_depth", shard.queue_depth},
+                {"busy", shard.busy},
+                {"processed", shard.processed},
+                {"last_wait_ms", shard.last_wait_ms},
+                {"max_wait_ms", shard.max_wait_ms},
+                {"dropped_replies", shard.dropped_replies},
+                {"dropped_inbound", shard.dropped_inbound},
+                {"avg_wait_ms", shard.processed == 0 ? 0 : shard.total_wait_ms / static_cast<std::int64_t>(shard.processed)}
+            });
+        }
+        res.set_content(json.dump(2), "application/json");
+    });
+
+    http_server.Get("/agents/session-cache", [&agents](const httplib::Request&, httplib::Response& res) {
+        nlohmann::json json = nlohmann::json::object();
+        for (const auto& [name, stats] : agents.SessionCacheStats()) {
+            json[name] = {
+                {"entries", stats.entries},
+                {"bytes", stats.bytes},
+                {"max_bytes", stats.max_bytes},
+                {"hits", stats.hits},
+                {"misses", stats.misses},
+                {"evictions", stats.evictions},
+                {"evicted_bytes", stats.evicted_bytes}
+            };
+        }
+        res.set_content(json.dump(2), "application/json");
+    });
+
     http_server.Get(R"(/sessions/(.+))", [&sessions](const httplib::Request& req, httplib::Response& res) {
         if (req.matches.size() < 2) {
             res.status = 400;
@@ -386,7 +457,7 @@ int RunGateway() {
         }
         const auto session_id = httplib::detail::decode_url(req.matches[1], false);
         const auto session = sessions.Get(session_id);
-        if (!session.has_value()) {
+        if (!session) {
             res.status = 404;
             res.set_content("session not found", "text/plain");
             return;
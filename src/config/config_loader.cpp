@@ -117,6 +117,37 @@ void ApplyAgentDefaults(AgentDefaults& target, const nlohmann::json& source) {
     if (source.contains("maxHistoryMessages") && source["maxHistoryMessages"].is_number_integer()) {
         target.max_history_messages = source["maxHistoryMessages"].get<int>();
     }
+    if (source.contains("streamReplies") && source["streamReplies"].is_boolean()) {
+        target.stream_replies = source["streamReplies"].get<bool>();
+    }
+    if (source.contains("streamEditIntervalMs") && source["streamEditIntervalMs"].is_number_integer()) {
+        target.stream_edit_interval_ms = source["streamEditIntervalMs"].get<int>();
+    }
+    if (source.contains("sessionCacheMb") && source["sessionCacheMb"].is_number_integer()) {
+        target.session_cache_mb = source["sessionCacheMb"].get<int>();
+    }
+    if (source.contains("contextWindowTokens") && source["contextWindowTokens"].is_number_integer()) {
+        target.context_window_tokens = source["contextWindowTokens"].get<int>();
+    }
+    if (source.contains("modelContextWindows") && source["modelContextWindows"].is_object()) {
+        for (const auto& [model, tokens] : source["modelContextWindows"].items()) {
+            if (tokens.is_number_integer()) {
+                target.model_context_windows[model] = tokens.get<int>();
+            }
+        }
+    }
+    if (source.contains("tokenizerVocab") && source["tokenizerVocab"].is_string()) {
+        target.tokenizer_vocab = source["tokenizerVocab"].get<std::string>();
+    }
+    if (source.contains("memoryFsyncIntervalMs") && source["memoryFsyncIntervalMs"].is_number_integer()) {
+        target.memory_fsync_interval_ms = source["memoryFsyncIntervalMs"].get<int>();
+    }
+    if (source.contains("persistentShell") && source["persistentShell"].is_boolean()) {
+        target.persistent_shell = source["persistentShell"].get<bool>();
+    }
+    if (source.contains("shellIdleTimeoutS") && source["shellIdleTimeoutS"].is_number_integer()) {
+        target.shell_idle_timeout_s = source["shellIdleTimeoutS"].get<int>();
+    }
 }
 
 void ApplyRelayConnectionDefaults(RelayConnectionDefaults& target, const nlohmann::json& source) {
@@ -150,6 +181,12 @@ void ApplyRelayConnectionDefaults(RelayConnectionDefaults& target, const nlohman
     if (source.contains("reconnectMaxDelayMs") && source["reconnectMaxDelayMs"].is_number_integer()) {
         target.reconnect_max_delay_ms = source["reconnectMaxDelayMs"].get<int>();
     }
+    if (source.contains("maxConcurrentCommands") && source["maxConcurrentCommands"].is_number_integer()) {
+        target.max_concurrent_commands = source["maxConcurrentCommands"].get<int>();
+    }
+    if (source.contains("maxQueuedCommands") && source["maxQueuedCommands"].is_number_integer()) {
+        target.max_queued_commands = source["maxQueuedCommands"].get<int>();
+    }
 }
 
 void ApplyRelayManagedAgentConfig(RelayManagedAgentConfig& target, const nlohmann::json& source) {
@@ -200,11 +237,53 @@ void ApplyRelayManagedAgentConfig(RelayManagedAgentConfig& target, const nlohman
     if (source.contains("reconnectMaxDelayMs") && source["reconnectMaxDelayMs"].is_number_integer()) {
         target.reconnect_max_delay_ms = source["reconnectMaxDelayMs"].get<int>();
     }
+    if (source.contains("maxConcurrentCommands") && source["maxConcurrentCommands"].is_number_integer()) {
+        target.max_concurrent_commands = source["maxConcurrentCommands"].get<int>();
+    }
+    if (source.contains("maxQueuedCommands") && source["maxQueuedCommands"].is_number_integer()) {
+        target.max_queued_commands = source["maxQueuedCommands"].get<int>();
+    }
     if (source.contains("autoClaimTasks") && source["autoClaimTasks"].is_boolean()) {
         target.auto_claim_tasks = source["autoClaimTasks"].get<bool>();
     }
 }
 
+void ApplyChannelSenderConfig(ChannelSenderConfig& target, const nlohmann::json& source) {
+    if (!source.is_object()) {
+        return;
+    }
+    if (source.contains("queueCapacity") && source["queueCapacity"].is_number_integer()) {
+        target.queue_capacity = source["queueCapacity"].get<int>();
+    }
+    if (source.contains("maxAttempts") && source["maxAttempts"].is_number_integer()) {
+        target.max_attempts = source["maxAttempts"].get<int>();
+    }
+    if (source.contains("retryDelayMs") && source["retryDelayMs"].is_number_integer()) {
+        target.retry_delay_ms = source["retryDelayMs"].get<int>();
+    }
+    if (source.contains("maxRetryDelayMs") && source["maxRetryDelayMs"].is_number_integer()) {
+        target.max_retry_delay_ms = source["maxRetryDelayMs"].get<int>();
+    }
+    if (source.contains("ratePerSecond") && source["ratePerSecond"].is_number()) {
+        target.rate_per_second = source["ratePerSecond"].get<double>();
+    }
+    if (source.contains("burst") && source["burst"].is_number_integer()) {
+        target.burst = source["burst"].get<int>();
+    }
+    if (source.contains("chatRatePerSecond") && source["chatRatePerSecond"].is_number()) {
+        target.chat_rate_per_second = source["chatRatePerSecond"].get<double>();
+    }
+    if (source.contains("chatBurst") && source["chatBurst"].is_number_integer()) {
+        target.chat_burst = source["chatBurst"].get<int>();
+    }
+    if (source.contains("coalesceWindowMs") && source["coalesceWindowMs"].is_number_integer()) {
+        target.coalesce_window_ms = source["coalesceWindowMs"].get<int>();
+    }
+    if (source.contains("maxMessageChars") && source["maxMessageChars"].is_number_integer()) {
+        target.max_message_chars = source["maxMessageChars"].get<int>();
+    }
+}
+
 void ApplyBindingConfig(ChannelBindingConfig& target, const nlohmann::json& source) {
     if (!source.is_object()) {
         return;
@@ -430,6 +509,12 @@ void NormalizeConfig(Config& config, const AgentDefaults& previous_defaults) {
         if (relay_agent.reconnect_max_delay_ms <= 0) {
             relay_agent.reconnect_max_delay_ms = config.relay.defaults.reconnect_max_delay_ms;
         }
+        if (relay_agent.max_concurrent_commands <= 0) {
+            relay_agent.max_concurrent_commands = config.relay.defaults.max_concurrent_commands;
+        }
+        if (relay_agent.max_queued_commands < 0) {
+            relay_agent.max_queued_commands = config.relay.defaults.max_queued_commands;
+        }
     }
 
     if (config.channels.instances.empty()) {
@@ -440,6 +525,7 @@ void NormalizeConfig(Config& config, const AgentDefaults& previous_defaults) {
             instance.enabled = config.channels.telegram.enabled;
             instance.allow_from = config.channels.telegram.allow_from;
             instance.binding = config.channels.telegram.binding;
+            instance.sender = config.channels.sender;
             instance.telegram = config.channels.telegram;
             instance.telegram.name = instance.name;
             config.channels.instances.push_back(instance);
@@ -451,6 +537,7 @@ void NormalizeConfig(Config& config, const AgentDefaults& previous_defaults) {
             instance.enabled = config.channels.lark.enabled;
             instance.allow_from = config.channels.lark.allow_from;
             instance.binding = config.channels.lark.binding;
+            instance.sender = config.channels.sender;
             instance.lark = config.channels.lark;
             instance.lark.name = instance.name;
             config.channels.instances.push_back(instance);
@@ -462,6 +549,7 @@ void NormalizeConfig(Config& config, const AgentDefaults& previous_defaults) {
             instance.enabled = config.channels.qqbot.enabled;
             instance.allow_from = config.channels.qqbot.allow_from;
             instance.binding = config.channels.qqbot.binding;
+            instance.sender = config.channels.sender;
             instance.qqbot = config.channels.qqbot;
             instance.qqbot.name = instance.name;
             config.channels.instances.push_back(instance);
@@ -473,6 +561,7 @@ void NormalizeConfig(Config& config, const AgentDefaults& previous_defaults) {
             instance.enabled = config.channels.weixin.enabled;
             instance.allow_from = config.channels.weixin.allow_from;
             instance.binding = config.channels.weixin.binding;
+            instance.sender = config.channels.sender;
             instance.weixin = config.channels.weixin;
             instance.weixin.name = instance.name;
             config.channels.instances.push_back(instance);
@@ -554,6 +643,9 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
         if (agents.contains("defaults") && agents["defaults"].is_object()) {
             ApplyAgentDefaults(config.agents.defaults, agents["defaults"]);
         }
+        if (agents.contains("dispatchWorkers") && agents["dispatchWorkers"].is_number_integer()) {
+            config.agents.dispatch_workers = agents["dispatchWorkers"].get<int>();
+        }
         if (agents.contains("instances") && agents["instances"].is_array()) {
             config.agents.instances.clear();
             for (const auto& item : agents["instances"]) {
@@ -573,6 +665,9 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
 
     if (data.contains("relay") && data["relay"].is_object()) {
         const auto& relay = data["relay"];
+        if (relay.contains("ioThreads") && relay["ioThreads"].is_number_integer()) {
+            config.relay.io_threads = relay["ioThreads"].get<int>();
+        }
         if (relay.contains("defaults") && relay["defaults"].is_object()) {
             ApplyRelayConnectionDefaults(config.relay.defaults, relay["defaults"]);
         }
@@ -591,6 +686,9 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
 
     if (data.contains("channels") && data["channels"].is_object()) {
         const auto& channels = data["channels"];
+        if (channels.contains("sender")) {
+            ApplyChannelSenderConfig(config.channels.sender, channels["sender"]);
+        }
         if (channels.contains("telegram") && channels["telegram"].is_object()) {
             ApplyTelegramConfig(config.channels.telegram, channels["telegram"]);
         }
@@ -629,6 +727,10 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
                 if (item.contains("binding")) {
                     ApplyBindingConfig(instance.binding, item["binding"]);
                 }
+                instance.sender = config.channels.sender;
+                if (item.contains("sender")) {
+                    ApplyChannelSenderConfig(instance.sender, item["sender"]);
+                }
                 if (instance.type == "telegram") {
                     instance.telegram = config.channels.telegram;
                     ApplyTelegramConfig(instance.telegram, item);
@@ -655,6 +757,15 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
         if (providers.contains("userAgent") && providers["userAgent"].is_string()) {
             config.providers.user_agent = providers["userAgent"].get<std::string>();
         }
+        if (providers.contains("maxConnectionsPerHost") && providers["maxConnectionsPerHost"].is_number_integer()) {
+            config.providers.max_connections_per_host = providers["maxConnectionsPerHost"].get<int>();
+        }
+        if (providers.contains("connectionIdleTimeoutS") && providers["connectionIdleTimeoutS"].is_number_integer()) {
+            config.providers.connection_idle_timeout_s = providers["connectionIdleTimeoutS"].get<int>();
+        }
+        if (providers.contains("promptCaching") && providers["promptCaching"].is_boolean()) {
+            config.providers.prompt_caching = providers["promptCaching"].get<bool>();
+        }
         if (providers.contains("anthropic")) {
             ApplyProviderConfig(config.providers.anthropic, providers["anthropic"]);
         }
@@ -697,6 +808,19 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
         }
     }
 
+    if (data.contains("bus") && data["bus"].is_object()) {
+        const auto& bus = data["bus"];
+        if (bus.contains("inboundCapacity") && bus["inboundCapacity"].is_number_integer()) {
+            config.bus.inbound_capacity = bus["inboundCapacity"].get<int>();
+        }
+        if (bus.contains("outboundCapacity") && bus["outboundCapacity"].is_number_integer()) {
+            config.bus.outbound_capacity = bus["outboundCapacity"].get<int>();
+        }
+        if (bus.contains("publishTimeoutMs") && bus["publishTimeoutMs"].is_number_integer()) {
+            config.bus.publish_timeout_ms = bus["publishTimeoutMs"].get<int>();
+        }
+    }
+
     if (data.contains("taskSystem") && data["taskSystem"].is_object()) {
         const auto& task_system = data["taskSystem"];
         if (task_system.contains("enabled") && task_system["enabled"].is_boolean()) {
@@ -705,6 +829,9 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
         if (task_system.contains("pollIntervalS") && task_system["pollIntervalS"].is_number_integer()) {
             config.task_system.poll_interval_s = task_system["pollIntervalS"].get<int>();
         }
+        if (task_system.contains("maxPollIntervalS") && task_system["maxPollIntervalS"].is_number_integer()) {
+            config.task_system.max_poll_interval_s = task_system["maxPollIntervalS"].get<int>();
+        }
         if (task_system.contains("dailySummaryHourLocal") && task_system["dailySummaryHourLocal"].is_number_integer()) {
             config.task_system.daily_summary_hour_local = task_system["dailySummaryHourLocal"].get<int>();
         }
@@ -730,6 +857,17 @@ void ApplyConfigFromJson(Config& config, const nlohmann::json& data) {
         if (qmd.contains("enabled") && qmd["enabled"].is_boolean()) {
             config.qmd.enabled = qmd["enabled"].get<bool>();
         }
+        if (qmd.contains("engine") && qmd["engine"].is_string()) {
+            config.qmd.engine = qmd["engine"].get<std::string>();
+        }
+        if (qmd.contains("paths") && qmd["paths"].is_array()) {
+            config.qmd.paths.clear();
+            for (const auto& path : qmd["paths"]) {
+                if (path.is_string()) {
+                    config.qmd.paths.push_back(path.get<std::string>());
+                }
+            }
+        }
         if (qmd.contains("command") && qmd["command"].is_string()) {
             config.qmd.command = qmd["command"].get<std::string>();
         }
@@ -948,6 +1086,31 @@ Config LoadConfig(const std::filesystem::path& config_path) {
         config.providers.user_agent = user_agent;
     }
 
+    const auto max_connections_per_host = GetEnvFallback(
+        "KABOT_PROVIDERS__MAX_CONNECTIONS_PER_HOST",
+        "KABOT_PROVIDERS_MAX_CONNECTIONS_PER_HOST");
+    if (!max_connections_per_host.empty()) {
+        config.providers.max_connections_per_host = ParseInt(
+            max_connections_per_host,
+            config.providers.max_connections_per_host);
+    }
+
+    const auto connection_idle_timeout_s = GetEnvFallback(
+        "KABOT_PROVIDERS__CONNECTION_IDLE_TIMEOUT_S",
+        "KABOT_PROVIDERS_CONNECTION_IDLE_TIMEOUT_S");
+    if (!connection_idle_timeout_s.empty()) {
+        config.providers.connection_idle_timeout_s = ParseInt(
+            connection_idle_timeout_s,
+            config.providers.connection_idle_timeout_s);
+    }
+
+    const auto prompt_caching = GetEnvFallback(
+        "KABOT_PROVIDERS__PROMPT_CACHING",
+        "KABOT_PROVIDERS_PROMPT_CACHING");
+    if (!prompt_caching.empty()) {
+        config.providers.prompt_caching = ParseBool(prompt_caching);
+    }
+
     const auto anthropic_key = GetEnvFallback(
         "KABOT_PROVIDERS__ANTHROPIC__API_KEY",
         "KABOT_PROVIDERS_ANTHROPIC_API_KEY");
@@ -1064,6 +1227,72 @@ Config LoadConfig(const std::filesystem::path& config_path) {
             config.agents.defaults.max_history_messages);
     }
 
+    const auto stream_replies = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__STREAM_REPLIES",
+        "KABOT_AGENT_STREAM_REPLIES");
+    if (!stream_replies.empty()) {
+        config.agents.defaults.stream_replies = ParseBool(stream_replies);
+    }
+
+    const auto stream_edit_interval_ms = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__STREAM_EDIT_INTERVAL_MS",
+        "KABOT_AGENT_STREAM_EDIT_INTERVAL_MS");
+    if (!stream_edit_interval_ms.empty()) {
+        config.agents.defaults.stream_edit_interval_ms = ParseInt(
+            stream_edit_interval_ms,
+            config.agents.defaults.stream_edit_interval_ms);
+    }
+
+    const auto session_cache_mb = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__SESSION_CACHE_MB",
+        "KABOT_AGENT_SESSION_CACHE_MB");
+    if (!session_cache_mb.empty()) {
+        config.agents.defaults.session_cache_mb = ParseInt(
+            session_cache_mb,
+            config.agents.defaults.session_cache_mb);
+    }
+
+    const auto context_window_tokens = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__CONTEXT_WINDOW_TOKENS",
+        "KABOT_AGENT_CONTEXT_WINDOW_TOKENS");
+    if (!context_window_tokens.empty()) {
+        config.agents.defaults.context_window_tokens = ParseInt(
+            context_window_tokens,
+            config.agents.defaults.context_window_tokens);
+    }
+
+    const auto tokenizer_vocab = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__TOKENIZER_VOCAB",
+        "KABOT_AGENT_TOKENIZER_VOCAB");
+    if (!tokenizer_vocab.empty()) {
+        config.agents.defaults.tokenizer_vocab = tokenizer_vocab;
+    }
+
+    const auto memory_fsync_interval_ms = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__MEMORY_FSYNC_INTERVAL_MS",
+        "KABOT_AGENT_MEMORY_FSYNC_INTERVAL_MS");
+    if (!memory_fsync_interval_ms.empty()) {
+        config.agents.defaults.memory_fsync_interval_ms = ParseInt(
+            memory_fsync_interval_ms,
+            config.agents.defaults.memory_fsync_interval_ms);
+    }
+
+    const auto persistent_shell = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__PERSISTENT_SHELL",
+        "KABOT_AGENT_PERSISTENT_SHELL");
+    if (!persistent_shell.empty()) {
+        config.agents.defaults.persistent_shell = ParseBool(persistent_shell);
+    }
+
+    const auto shell_idle_timeout_s = GetEnvFallback(
+        "KABOT_AGENTS__DEFAULTS__SHELL_IDLE_TIMEOUT_S",
+        "KABOT_AGENT_SHELL_IDLE_TIMEOUT_S");
+    if (!shell_idle_timeout_s.empty()) {
+        config.agents.defaults.shell_idle_timeout_s = ParseInt(
+            shell_idle_timeout_s,
+            config.agents.defaults.shell_idle_timeout_s);
+    }
+
     const auto qmd_enabled = GetEnvFallback(
         "KABOT_QMD__ENABLED",
         "KABOT_QMD_ENABLED");
@@ -1071,6 +1300,13 @@ Config LoadConfig(const std::filesystem::path& config_path) {
         config.qmd.enabled = ParseBool(qmd_enabled);
     }
 
+    const auto qmd_engine = GetEnvFallback(
+        "KABOT_QMD__ENGINE",
+        "KABOT_QMD_ENGINE");
+    if (!qmd_engine.empty()) {
+        config.qmd.engine = qmd_engine;
+    }
+
     const auto qmd_command = GetEnvFallback(
         "KABOT_QMD__COMMAND",
         "KABOT_QMD_COMMAND");
@@ -1127,6 +1363,13 @@ Config LoadConfig(const std::filesystem::path& config_path) {
         config.qmd.update_embeddings = ParseBool(qmd_update_embeddings);
     }
 
+    const auto dispatch_workers = GetEnvFallback(
+        "KABOT_AGENTS__DISPATCH_WORKERS",
+        "KABOT_AGENT_DISPATCH_WORKERS");
+    if (!dispatch_workers.empty()) {
+        config.agents.dispatch_workers = ParseInt(dispatch_workers, config.agents.dispatch_workers);
+    }
+
     const auto max_tool_iterations = GetEnvFallback(
         "KABOT_AGENTS__DEFAULTS__MAX_TOOL_ITERATIONS",
         "KABOT_AGENT_MAX_TOOL_ITERATIONS");
@@ -1189,6 +1432,15 @@ Config LoadConfig(const std::filesystem::path& config_path) {
             config.task_system.poll_interval_s);
     }
 
+    const auto task_system_max_poll_interval = GetEnvFallback(
+        "KABOT_TASK_SYSTEM__MAX_POLL_INTERVAL_S",
+        "KABOT_TASK_SYSTEM_MAX_POLL_INTERVAL_S");
+    if (!task_system_max_poll_interval.empty()) {
+        config.task_system.max_poll_interval_s = ParseInt(
+            task_system_max_poll_interval,
+            config.task_system.max_poll_interval_s);
+    }
+
     const auto task_system_daily_summary_hour = GetEnvFallback(
         "KABOT_TASK_SYSTEM__DAILY_SUMMARY_HOUR_LOCAL",
         "KABOT_TASK_SYSTEM_DAILY_SUMMARY_HOUR_LOCAL");
@@ -1333,6 +1585,9 @@ std::vector<std::string> ValidateConfig(const Config& config) {
         if (relay_agent.reconnect_max_delay_ms < relay_agent.reconnect_initial_delay_ms) {
             errors.push_back("relay managed agent " + relay_agent.name + " has reconnectMaxDelayMs smaller than reconnectInitialDelayMs");
         }
+        if (relay_agent.max_concurrent_commands <= 0) {
+            errors.push_back("relay managed agent " + relay_agent.name + " has invalid maxConcurrentCommands");
+        }
         if (relay_agent.scheme != "ws" && relay_agent.scheme != "wss") {
             errors.push_back("relay managed agent " + relay_agent.name + " has unsupported scheme: " + relay_agent.scheme);
         }
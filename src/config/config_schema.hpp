@@ -58,12 +58,31 @@ struct WeixinConfig {
     std::string app_version = "1.0.0";
 };
 
+// Outbound delivery for one channel instance; see OutboundSender.
+struct ChannelSenderConfig {
+    int queue_capacity = 1024;
+    int max_attempts = 3;
+    int retry_delay_ms = 800;
+    int max_retry_delay_ms = 10000;
+    // Sends per second for the whole channel and per chat; 0 is unlimited,
+    // < 0 takes the platform default for the channel type.
+    double rate_per_second = -1;
+    int burst = -1;
+    double chat_rate_per_second = -1;
+    int chat_burst = -1;
+    int coalesce_window_ms = 1000;
+    // Merged text stays within this many bytes; 0 is unlimited, < 0 takes
+    // the platform's message limit.
+    int max_message_chars = -1;
+};
+
 struct ChannelInstanceConfig {
     std::string name;
     std::string type;
     bool enabled = true;
     std::vector<std::string> allow_from;
     ChannelBindingConfig binding;
+    ChannelSenderConfig sender;
     TelegramConfig telegram;
     LarkConfig lark;
     QQBotConfig qqbot;
@@ -75,6 +94,7 @@ struct ChannelsConfig {
     LarkConfig lark;
     QQBotConfig qqbot;
     WeixinConfig weixin;
+    ChannelSenderConfig sender;
     std::vector<ChannelInstanceConfig> instances;
 };
 
@@ -93,6 +113,9 @@ struct ProvidersConfig {
     ProviderConfig gemini;
     bool use_proxy_for_llm = false;
     std::string user_agent = "claude-code/0.2.1";
+    int max_connections_per_host = 8;
+    int connection_idle_timeout_s = 60;
+    bool prompt_caching = true;
 };
 
 struct AgentDefaults {
@@ -105,6 +128,19 @@ struct AgentDefaults {
     double temperature = 0.7;
     int max_tool_iterations = 20;
     int max_history_messages = 200;
+    bool stream_replies = true;
+    int stream_edit_interval_ms = 1000;
+    int session_cache_mb = 64;
+    int context_window_tokens = 128000;
+    // Model name (or substring of one) -> context window in tokens.
+    std::unordered_map<std::string, int> model_context_windows;
+    std::string tokenizer_vocab;
+    // -1 leaves memory journal syncing to the OS; see MemoryStoreOptions.
+    int memory_fsync_interval_ms = -1;
+    // Keep one shell per session for the bash tool instead of a fresh
+    // process per command; idle shells are closed after the timeout.
+    bool persistent_shell = false;
+    int shell_idle_timeout_s = 600;
 };
 
 struct AgentInstanceConfig : AgentDefaults {
@@ -114,6 +150,7 @@ struct AgentInstanceConfig : AgentDefaults {
 struct AgentsConfig {
     AgentDefaults defaults;
     std::vector<AgentInstanceConfig> instances;
+    int dispatch_workers = 4;
 };
 
 struct RelayConnectionDefaults {
@@ -126,6 +163,8 @@ struct RelayConnectionDefaults {
     int heartbeat_interval_s = 10;
     int reconnect_initial_delay_ms = 1000;
     int reconnect_max_delay_ms = 30000;
+    int max_concurrent_commands = 2;
+    int max_queued_commands = 16;
 };
 
 struct RelayManagedAgentConfig {
@@ -143,10 +182,16 @@ struct RelayManagedAgentConfig {
     int heartbeat_interval_s = 0;
     int reconnect_initial_delay_ms = 0;
     int reconnect_max_delay_ms = 0;
+    // Dispatched commands run on a per-worker pool of this many threads;
+    // dispatches beyond concurrency plus queue are rejected as busy.
+    int max_concurrent_commands = 0;
+    int max_queued_commands = -1;
     bool auto_claim_tasks = false;
 };
 
 struct RelayConfig {
+    // Threads serving every managed agent's connection.
+    int io_threads = 1;
     RelayConnectionDefaults defaults;
     std::vector<RelayManagedAgentConfig> managed_agents;
 };
@@ -161,7 +206,10 @@ struct HeartbeatConfig {
 
 struct TaskSystemConfig {
     bool enabled = false;
+    // Claims are pushed by the relay; polling is a fallback that starts at
+    // poll_interval_s and backs off to max_poll_interval_s while idle.
     int poll_interval_s = 30;
+    int max_poll_interval_s = 300;
     int daily_summary_hour_local = 22;
     int max_concurrent_tasks = 4;
     int task_timeout_s = 300;
@@ -170,8 +218,18 @@ struct TaskSystemConfig {
     int max_plan_output_tokens = 8192;
 };
 
+struct BusConfig {
+    int inbound_capacity = 1024;
+    int outbound_capacity = 1024;
+    int publish_timeout_ms = 2000;
+};
+
 struct QmdConfig {
     bool enabled = false;
+    // "builtin" searches an in-process BM25 index over `paths`; "qmd" shells
+    // out to `command` as before.
+    std::string engine = "builtin";
+    std::vector<std::string> paths{"memory"};
     std::string command = "qmd";
     std::string collection;
     std::string index;
@@ -194,6 +252,7 @@ struct Config {
     ChannelsConfig channels;
     HeartbeatConfig heartbeat;
     TaskSystemConfig task_system;
+    BusConfig bus;
     ProvidersConfig providers;
     QmdConfig qmd;
     LoggingConfig logging;
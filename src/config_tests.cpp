@@ -234,8 +234,11 @@ void TestAgentInstancesInheritRuntimeDefaults() {
       "maxTokens": 8192,
       "temperature": 0.7,
       "maxToolIterations": 20,
-      "maxHistoryMessages": 50
+      "maxHistoryMessages": 50,
+      "persistentShell": true,
+      "shellIdleTimeoutS": 120
     },
+    "dispatchWorkers": 8,
     "instances": [
       {
         "name": "ops-agent"
@@ -257,6 +260,9 @@ void TestAgentInstancesInheritRuntimeDefaults() {
     Expect(config.agents.instances.front().name == "ops-agent", "expected ops-agent instance name");
     Expect(config.agents.instances.front().brave_api_key == "test-brave-key",
            "expected runtime brave api key to be inherited by agent instance");
+    Expect(config.agents.dispatch_workers == 8, "expected agents.dispatchWorkers to be parsed");
+    Expect(config.agents.instances.front().persistent_shell, "expected persistentShell to be inherited");
+    Expect(config.agents.instances.front().shell_idle_timeout_s == 120, "expected shellIdleTimeoutS to be inherited");
 }
 
 void TestLoadConfigParsesRelayManagedAgents() {
@@ -277,6 +283,7 @@ void TestLoadConfigParsesRelayManagedAgents() {
     ]
   },
   "relay": {
+    "ioThreads": 2,
     "defaults": {
       "host": "relay.example.com",
       "port": 443,
@@ -284,7 +291,8 @@ void TestLoadConfigParsesRelayManagedAgents() {
       "useTls": true,
       "heartbeatIntervalS": 9,
       "reconnectInitialDelayMs": 1500,
-      "reconnectMaxDelayMs": 9000
+      "reconnectMaxDelayMs": 9000,
+      "maxConcurrentCommands": 3
     },
     "managedAgents": [
       {
@@ -299,7 +307,8 @@ void TestLoadConfigParsesRelayManagedAgents() {
         "agentId": "agent-ops",
         "token": "token-ops",
         "enabled": false,
-        "heartbeatIntervalS": 12
+        "heartbeatIntervalS": 12,
+        "maxQueuedCommands": 0
       }
     ]
   }
@@ -308,6 +317,7 @@ void TestLoadConfigParsesRelayManagedAgents() {
 
     const auto config = kabot::config::LoadConfig(config_path);
     Expect(config.relay.managed_agents.size() == 2, "expected two relay managed agents");
+    Expect(config.relay.io_threads == 2, "expected relay io threads to load");
     Expect(config.relay.managed_agents.front().host == "relay.example.com", "expected relay host to inherit defaults");
     Expect(config.relay.managed_agents.front().port == 443, "expected relay port to inherit defaults");
     Expect(config.relay.managed_agents.front().path == "/ws/agent", "expected relay path to inherit defaults");
@@ -316,6 +326,9 @@ void TestLoadConfigParsesRelayManagedAgents() {
     Expect(config.relay.managed_agents.front().heartbeat_interval_s == 9, "expected heartbeat interval to inherit defaults");
     Expect(!config.relay.managed_agents.back().enabled, "expected disabled relay managed agent to be preserved");
     Expect(config.relay.managed_agents.back().heartbeat_interval_s == 12, "expected per-agent relay heartbeat override to load");
+    Expect(config.relay.managed_agents.front().max_concurrent_commands == 3, "expected relay concurrency to inherit defaults");
+    Expect(config.relay.managed_agents.front().max_queued_commands == 16, "expected relay queue bound to default");
+    Expect(config.relay.managed_agents.back().max_queued_commands == 0, "expected per-agent relay queue override to load");
 }
 
 void TestLoadConfigDefaultsRelayLocalAgentToManagedAgentName() {
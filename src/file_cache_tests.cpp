@@ -0,0 +1,185 @@
+#include "agent/file_cache.hpp"
+#include "agent/skills_loader.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[file_cache_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_file_cache_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::trunc);
+    file << content;
+}
+
+void TestReadRevalidatesOnChange() {
+    const auto workspace = MakeWorkspace("read");
+    const auto path = workspace / "AGENTS.md";
+    kabot::agent::FileContentCache cache;
+
+    Expect(cache.Read(path).empty(), "expected a missing file to read as empty");
+    WriteFile(path, "first");
+    Expect(cache.Read(path) == "first", "expected a created file to be read");
+    Expect(cache.Read(path) == "first", "expected an unchanged file to be served from cache");
+    Expect(cache.Stats().hits == 1, "expected the second read to hit the cache");
+
+    WriteFile(path, "second version");
+    Expect(cache.Read(path) == "second version", "expected an edited file to be re-read");
+    std::filesystem::remove(path);
+    Expect(cache.Read(path).empty(), "expected a deleted file to read as empty");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestAppendKeepsCacheCurrent() {
+    const auto workspace = MakeWorkspace("append");
+    const auto path = workspace / "journal.md";
+    kabot::agent::FileContentCache cache;
+    WriteFile(path, "one\n");
+    Expect(cache.Read(path) == "one\n", "expected the initial read");
+
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "two\n";
+    }
+    cache.Append(path, "two\n");
+    const auto misses = cache.Stats().misses;
+    Expect(cache.Read(path) == "one\ntwo\n", "expected the appended bytes to be cached");
+    Expect(cache.Stats().misses == misses, "expected no re-read after a recorded append");
+
+    {
+        std::ofstream file(path, std::ios::app);
+        file << "three\nfour\n";
+    }
+    cache.Append(path, "three\n");
+    Expect(cache.Read(path) == "one\ntwo\nthree\nfour\n", "expected a foreign write to force a re-read");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestSkillsSnapshotFollowsFilesystem() {
+    const auto workspace = MakeWorkspace("skills");
+    WriteFile(workspace / "skills" / "alpha" / "SKILL.md", "---\ndescription: first skill\nalways: true\n---\nalpha body");
+    std::filesystem::create_directories(workspace / "skills" / "beta");
+    kabot::agent::SkillsLoader skills(workspace.string());
+
+    Expect(skills.LoadSkillNames().size() == 1, "expected only folders with SKILL.md to be listed");
+    Expect(skills.GetAlwaysSkills().size() == 1, "expected the always skill to be reported");
+    const auto summary = skills.BuildSkillsSummary();
+    Expect(summary.find("first skill") != std::string::npos, "expected the summary to carry the description");
+    Expect(skills.BuildSkillsSummary() == summary, "expected an unchanged tree to render the same summary");
+
+    WriteFile(workspace / "skills" / "beta" / "SKILL.md", "---\ndescription: late skill\n---\nbeta body");
+    Expect(skills.LoadSkillNames().size() == 2, "expected a new SKILL.md to invalidate the snapshot");
+    Expect(skills.LoadSkill("beta").find("beta body") != std::string::npos, "expected the new skill content");
+
+    WriteFile(workspace / "skills" / "alpha" / "SKILL.md", "---\ndescription: edited skill\n---\nalpha v2");
+    Expect(skills.BuildSkillsSummary().find("edited skill") != std::string::npos, "expected edits to refresh the summary");
+    Expect(skills.GetAlwaysSkills().empty(), "expected edited metadata to apply");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestIndexedFileLines() {
+    const auto workspace = MakeWorkspace("indexed");
+    const auto path = workspace / "lines.txt";
+    WriteFile(path, "alpha\nbeta\r\n\ngamma");
+    kabot::agent::IndexedFileCache cache(2);
+
+    const auto file = cache.Open(path);
+    Expect(file != nullptr, "expected an existing file to open");
+    Expect(file->LineCount() == 4, "expected getline-style line count");
+    Expect(file->Line(1) == "alpha", "expected the first line without its newline");
+    Expect(file->Line(2) == "beta\r", "expected carriage returns to be kept like getline");
+    Expect(file->Line(3).empty(), "expected an empty line");
+    Expect(file->Line(4) == "gamma", "expected an unterminated last line");
+    Expect(file->Line(5).empty(), "expected nothing past the end");
+    Expect(file->LineAt(0) == 1 && file->LineAt(7) == 2 && file->LineAt(17) == 4, "expected offsets to map to lines");
+
+    WriteFile(workspace / "trailing.txt", "one\ntwo\n");
+    const auto trailing = cache.Open(workspace / "trailing.txt");
+    Expect(trailing->LineCount() == 2 && trailing->Line(2) == "two", "expected a trailing newline not to add a line");
+    WriteFile(workspace / "empty.txt", "");
+    Expect(cache.Open(workspace / "empty.txt")->LineCount() == 0, "expected an empty file to have no lines");
+    Expect(cache.Open(workspace / "missing.txt") == nullptr, "expected a missing file to fail");
+    Expect(cache.Open(workspace) == nullptr, "expected a directory to fail");
+}
+
+void TestIndexedFileCacheRevalidates() {
+    const auto workspace = MakeWorkspace("indexed_cache");
+    const auto path = workspace / "data.txt";
+    WriteFile(path, "one\ntwo\n");
+    kabot::agent::IndexedFileCache cache(2);
+
+    const auto first = cache.Open(path);
+    Expect(cache.Open(path) == first, "expected an unchanged file to reuse its mapping");
+    Expect(cache.Stats().hits == 1, "expected a cache hit");
+
+    WriteFile(path, "one\ntwo\nthree\n");
+    const auto changed = cache.Open(path);
+    Expect(changed != first && changed->LineCount() == 3, "expected a changed file to be remapped");
+    Expect(first->LineCount() == 2, "expected an old mapping to stay valid for its holder");
+
+    cache.Invalidate(path);
+    Expect(cache.Open(path) != changed, "expected invalidate to drop the mapping");
+
+    WriteFile(workspace / "a.txt", "a");
+    WriteFile(workspace / "b.txt", "b");
+    cache.Open(workspace / "a.txt");
+    cache.Open(workspace / "b.txt");
+    const auto misses = cache.Stats().misses;
+    cache.Open(path);
+    Expect(cache.Stats().misses == misses + 1, "expected the least recently used file to be evicted");
+}
+
+void TestLargeFilesKeepOnlyTheirIndex() {
+    const auto workspace = MakeWorkspace("indexed_large");
+    const auto small = workspace / "small.txt";
+    const auto large = workspace / "large.txt";
+    WriteFile(small, "one\ntwo\n");
+    WriteFile(large, std::string(kabot::MappedFile::kMapThreshold, 'x') + "\nmiddle\ntail\n");
+
+    kabot::MappedFile copy;
+    Expect(copy.Open(small) && !copy.Mapped() && copy.View() == "one\ntwo\n", "expected a small file to be read");
+    kabot::agent::IndexedFileCache cache(4);
+    Expect(cache.Open(small)->Resident(), "expected a small file to be held in memory");
+
+    const auto first = cache.Open(large);
+    Expect(first && !first->Resident(), "expected a large file to keep only its index");
+    Expect(first->LineCount() == 3 && first->Line(3) == "tail", "expected windows read from the large file");
+    Expect(first->Lines(2, 3) == "middle\ntail", "expected a window of lines in one read");
+    Expect(cache.Open(large) == first, "expected the large file's index to be reused");
+    Expect(cache.Stats().hits == 1, "expected a cache hit for the large file");
+
+    std::filesystem::resize_file(large, 10);
+    Expect(first->Line(3).empty(), "expected a truncated file to read short instead of faulting");
+    Expect(cache.Open(large) != first, "expected the truncated file to be re-indexed");
+}
+
+}  // namespace
+
+int main() {
+    TestReadRevalidatesOnChange();
+    TestAppendKeepsCacheCurrent();
+    TestSkillsSnapshotFollowsFilesystem();
+    TestIndexedFileLines();
+    TestIndexedFileCacheRevalidates();
+    TestLargeFilesKeepOnlyTheirIndex();
+    std::cout << "file_cache_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,271 @@
+#include "agent/tools/file_walker.hpp"
+#include "agent/tools/filesystem.hpp"
+#include "agent/tools/glob_match.hpp"
+#include "agent/tools/text_search.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[file_search_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_file_search_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << content;
+}
+
+void TestMatchGlob() {
+    using kabot::agent::tools::MatchGlob;
+    Expect(MatchGlob("*.cpp", "main.cpp"), "expected * to match a name");
+    Expect(!MatchGlob("*.cpp", "src/main.cpp"), "expected * not to cross '/'");
+    Expect(MatchGlob("**/*.cpp", "main.cpp"), "expected **/ to match no directory");
+    Expect(MatchGlob("**/*.cpp", "a/b/main.cpp"), "expected **/ to match nested directories");
+    Expect(MatchGlob("src/**", "src/a/b"), "expected trailing ** to match everything below");
+    Expect(MatchGlob("a/**/b", "a/x/y/b"), "expected inner ** to match several directories");
+    Expect(MatchGlob("file?.[ch]", "file1.h"), "expected ? and classes to match");
+    Expect(!MatchGlob("file[!0-9].c", "file1.c"), "expected negated class to reject");
+    Expect(MatchGlob("\\*.txt", "*.txt"), "expected escaped * to be literal");
+}
+
+void TestGlobPattern() {
+    using kabot::agent::tools::ExpandBraces;
+    using kabot::agent::tools::GlobPattern;
+    const auto expanded = ExpandBraces("src/{a,b{1,2}}.{h,cpp}");
+    Expect(expanded.size() == 6, "expected nested brace sets to expand");
+    Expect(expanded.front() == "src/a.h" && expanded.back() == "src/b2.cpp", "expected expansion order to follow the pattern");
+    Expect(ExpandBraces("a{b").size() == 1, "expected an unterminated brace to stay literal");
+
+    const GlobPattern headers("src/**/*.{h,hpp}");
+    Expect(headers.Matches("src/a.hpp"), "expected ** to match no directory");
+    Expect(headers.Matches("src/x/y/a.h"), "expected ** to match nested directories");
+    Expect(!headers.Matches("test/a.hpp"), "expected other roots not to match");
+    Expect(headers.CouldMatchBelow("src/x"), "expected ** to keep descending");
+    Expect(!headers.CouldMatchBelow("node_modules"), "expected unrelated trees to be pruned");
+
+    const GlobPattern shallow("src/*.hpp");
+    Expect(shallow.CouldMatchBelow("src"), "expected the matching directory to be entered");
+    Expect(!shallow.CouldMatchBelow("src/nested"), "expected deeper directories to be pruned");
+}
+
+void TestGlobToolPrunesAndSorts() {
+    const auto root = MakeWorkspace("glob");
+    std::filesystem::create_directories(root / ".git");
+    WriteFile(root / ".gitignore", "build/\n");
+    WriteFile(root / "src" / "old.hpp", "x");
+    WriteFile(root / "src" / "new.hpp", "x");
+    WriteFile(root / "src" / "main.cpp", "x");
+    WriteFile(root / "src" / "nested" / "deep.hpp", "x");
+    WriteFile(root / "build" / "gen.hpp", "x");
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(root / "src" / "old.hpp", now - std::chrono::hours(2));
+    std::filesystem::last_write_time(root / "src" / "new.hpp", now - std::chrono::hours(1));
+
+    kabot::agent::tools::GlobTool tool;
+    std::unordered_map<std::string, std::string> params;
+    params["path"] = root.string();
+    params["pattern"] = "src/*.hpp";
+    Expect(tool.Execute(params) == "src/new.hpp\nsrc/old.hpp\n", "expected shallow matches, newest first");
+    params["pattern"] = "**/*.hpp";
+    const auto all = tool.Execute(params);
+    Expect(all.find("src/nested/deep.hpp") != std::string::npos, "expected ** to reach nested files");
+    Expect(all.find("build/") == std::string::npos, "expected ignored directories to be skipped");
+    params["pattern"] = "src/{main.cpp,missing.cpp}";
+    Expect(tool.Execute(params) == "src/main.cpp\n", "expected brace sets to match");
+    params["pattern"] = "*.md";
+    Expect(tool.Execute(params) == "No files matched.", "expected an empty result message");
+}
+
+void TestRequiredLiteral() {
+    using kabot::agent::tools::RequiredLiteral;
+    Expect(RequiredLiteral("TODO") == "TODO", "expected a plain pattern to be its own literal");
+    Expect(RequiredLiteral("foo\\(bar\\)") == "foo(bar)", "expected escaped punctuation to stay literal");
+    Expect(RequiredLiteral("struct\\s+Config") == "struct", "expected the longest required run");
+    Expect(RequiredLiteral("colou?r") == "colo", "expected an optional char to end the run");
+    Expect(RequiredLiteral("(foo|bar)Handler") == "Handler", "expected groups to be skipped");
+    Expect(RequiredLiteral("foo|bar").empty(), "expected top-level alternation to disable the prefilter");
+    Expect(RequiredLiteral("[A-Z]+").empty(), "expected a class-only pattern to have no literal");
+    Expect(RequiredLiteral("\\x41BC") == "BC", "expected a hex escape to end the run with its operand");
+    Expect(RequiredLiteral("foo\\u0041barbaz") == "barbaz", "expected a unicode escape to skip its operand");
+    Expect(RequiredLiteral("ab\\cJxyz") == "xyz", "expected a control escape to skip its operand");
+}
+
+void TestWalkHonoursGitignore() {
+    const auto root = MakeWorkspace("walk");
+    std::filesystem::create_directories(root / ".git");
+    WriteFile(root / ".gitignore", "build/\n*.log\n!keep.log\n/top.txt\n");
+    WriteFile(root / "src" / ".gitignore", "generated.cpp\n");
+    WriteFile(root / "src" / "main.cpp", "int main() {}\n");
+    WriteFile(root / "src" / "generated.cpp", "x\n");
+    WriteFile(root / "src" / "top.txt", "nested, not anchored\n");
+    WriteFile(root / "build" / "out.o", "x\n");
+    WriteFile(root / "debug.log", "x\n");
+    WriteFile(root / "keep.log", "x\n");
+    WriteFile(root / "top.txt", "x\n");
+    WriteFile(root / ".git" / "HEAD", "ref\n");
+
+    std::mutex mutex;
+    std::vector<std::string> seen;
+    kabot::agent::tools::WalkOptions options;
+    options.threads = 4;
+    kabot::agent::tools::WalkFiles(root, options, [&](const kabot::agent::tools::WalkEntry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.push_back(entry.relative);
+    });
+    std::sort(seen.begin(), seen.end());
+    const std::vector<std::string> expected = {".gitignore", "keep.log", "src/.gitignore", "src/main.cpp", "src/top.txt"};
+    Expect(seen == expected, "expected ignored files, build/ and .git to be skipped");
+
+    seen.clear();
+    kabot::agent::tools::WalkFiles(root / "src", options, [&](const kabot::agent::tools::WalkEntry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        seen.push_back(entry.relative);
+    });
+    Expect(std::find(seen.begin(), seen.end(), "generated.cpp") == seen.end(),
+           "expected rules to apply when walking a subdirectory");
+}
+
+void TestWalkRethrowsVisitErrors() {
+    const auto root = MakeWorkspace("walk_error");
+    for (int i = 0; i < 16; ++i) {
+        WriteFile(root / ("dir" + std::to_string(i)) / "file.txt", "x\n");
+    }
+    kabot::agent::tools::WalkOptions options;
+    options.threads = 4;
+    bool thrown = false;
+    try {
+        kabot::agent::tools::WalkFiles(root, options, [](const kabot::agent::tools::WalkEntry&) {
+            throw std::runtime_error("visit failed");
+        });
+    } catch (const std::runtime_error& ex) {
+        thrown = std::string(ex.what()) == "visit failed";
+    }
+    Expect(thrown, "expected the visit exception to reach the caller after the walk stops");
+}
+
+void TestSearchTextIsSortedAndCapped() {
+    const auto root = MakeWorkspace("grep");
+    for (int i = 0; i < 20; ++i) {
+        std::string content;
+        for (int line = 0; line < 5; ++line) {
+            content += "needle " + std::to_string(i) + "\nhay\n";
+        }
+        WriteFile(root / ("dir" + std::to_string(i % 3)) / ("f" + std::to_string(i) + ".txt"), content);
+    }
+    WriteFile(root / "binary.bin", std::string("needle\0needle\n", 14));
+    WriteFile(root / "crlf.txt", "first\r\nsecond needle\r\n");
+
+    kabot::agent::tools::TextSearchOptions options;
+    options.max_matches = 7;
+    options.threads = 4;
+    const auto first = kabot::agent::tools::SearchText("need+le \\d+", root, root, options);
+    Expect(first.truncated, "expected the result to be capped");
+    Expect(first.matches.size() == 7, "expected exactly max_matches results");
+    Expect(std::is_sorted(first.matches.begin(), first.matches.end(), [](const auto& a, const auto& b) {
+               return a.path < b.path || (a.path == b.path && a.line < b.line);
+           }),
+           "expected matches ordered by path and line");
+    Expect(first.matches.front().path == "dir0/f0.txt" && first.matches.front().line == 1,
+           "expected the first match in path order");
+    Expect(first.matches[1].line == 3, "expected line numbers to skip non-matching lines");
+    for (int run = 0; run < 5; ++run) {
+        const auto again = kabot::agent::tools::SearchText("need+le \\d+", root, root, options);
+        Expect(again.matches.size() == first.matches.size(), "expected a stable result size");
+        for (std::size_t i = 0; i < again.matches.size(); ++i) {
+            Expect(again.matches[i].path == first.matches[i].path && again.matches[i].line == first.matches[i].line,
+                   "expected identical results across runs");
+        }
+    }
+
+    options.max_matches = 50;
+    const auto crlf = kabot::agent::tools::SearchText("needle$", root / "crlf.txt", root, options);
+    Expect(crlf.matches.size() == 1 && crlf.matches.front().line == 2, "expected CRLF lines to match with $");
+    Expect(crlf.matches.front().text == "second needle", "expected the carriage return to be stripped");
+    Expect(crlf.matches.front().path == "crlf.txt", "expected paths relative to the display base");
+
+    const auto binary = kabot::agent::tools::SearchText("needle", root / "binary.bin", root, options);
+    Expect(binary.matches.empty(), "expected binary files to be skipped");
+}
+
+void TestReadFileWindowsAndGrepContext() {
+    const auto root = MakeWorkspace("read");
+    std::string content;
+    for (int i = 1; i <= 1000; ++i) {
+        content += "line " + std::to_string(i) + (i == 500 ? " marker" : "") + "\n";
+    }
+    WriteFile(root / "big.txt", content);
+
+    kabot::agent::tools::ReadFileTool read;
+    std::unordered_map<std::string, std::string> params;
+    params["path"] = (root / "big.txt").string();
+    params["line"] = "499";
+    params["limit"] = "2";
+    Expect(read.Execute(params) == "line 499\nline 500 marker\n... (truncated after 2 lines; total 1000 lines) ...",
+           "expected a windowed read with a truncation note");
+    params["line"] = "1000";
+    params["limit"] = "5";
+    Expect(read.Execute(params) == "line 1000", "expected the last line without a truncation note");
+    params["line"] = "1001";
+    Expect(read.Execute(params) == "[Empty file or start line beyond end of file]", "expected past-the-end reads to say so");
+
+    kabot::agent::tools::EditFileTool edit;
+    params.clear();
+    params["path"] = (root / "big.txt").string();
+    params["old_string"] = "line 500 marker";
+    params["new_string"] = "line 500 edited";
+    Expect(edit.Execute(params) == "OK", "expected edit to succeed");
+    params.clear();
+    params["path"] = (root / "big.txt").string();
+    params["line"] = "500";
+    params["limit"] = "1";
+    Expect(read.Execute(params).rfind("line 500 edited", 0) == 0, "expected reads to see the edit");
+
+    kabot::agent::tools::GrepTool grep;
+    params.clear();
+    params["pattern"] = "^line (50[13]|510)$";
+    params["path"] = (root / "big.txt").string();
+    params["context"] = "1";
+    const auto output = grep.Execute(params);
+    const auto display = std::filesystem::path(params["path"]).lexically_relative(std::filesystem::current_path()).generic_string();
+    Expect(output == display + "-500- line 500 edited\n" + display + ":501: line 501\n" + display + "-502- line 502\n" +
+                         display + ":503: line 503\n" + display + "-504- line 504\n" + "--\n" +
+                         display + "-509- line 509\n" + display + ":510: line 510\n" + display + "-511- line 511\n",
+           "expected overlapping context windows to merge");
+}
+
+}  // namespace
+
+int main() {
+    TestMatchGlob();
+    TestGlobPattern();
+    TestGlobToolPrunesAndSorts();
+    TestRequiredLiteral();
+    TestWalkHonoursGitignore();
+    TestWalkRethrowsVisitErrors();
+    TestSearchTextIsSortedAndCapped();
+    TestReadFileWindowsAndGrepContext();
+    std::cout << "file_search_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "task/git_workspace.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[git_workspace_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeDir(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_git_workspace_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+void Commit(const std::filesystem::path& repo, const std::string& file, const std::string& content) {
+    std::ofstream(repo / file) << content;
+    Expect(kabot::task::RunProcess(repo, {"git", "add", file}).Ok(), "expected git add to succeed");
+    Expect(kabot::task::RunProcess(repo, {"git", "-c", "user.name=kabot", "-c", "user.email=kabot@example.com",
+                                          "commit", "-q", "-m", "update " + file}).Ok(),
+           "expected git commit to succeed");
+}
+
+void TestRunProcessPassesArgumentsVerbatim() {
+    const auto result = kabot::task::RunProcess(".", {"printf", "%s", "a \"quoted\" $HOME; arg"});
+    Expect(result.Ok(), "expected printf to succeed");
+    Expect(result.output == "a \"quoted\" $HOME; arg", "expected no shell interpretation");
+    Expect(kabot::task::RunProcess(".", {"kabot-no-such-binary"}).exit_code == 127, "expected missing binary to fail");
+}
+
+void TestRunProcessDisablesGitPrompts() {
+    const auto result = kabot::task::RunProcess(".", {"sh", "-c", "printf %s \"$GIT_TERMINAL_PROMPT\""});
+    Expect(result.Ok() && result.output == "0", "expected git terminal prompts to be disabled");
+}
+
+void TestWorktreesShareOneMirror() {
+    const auto root = MakeDir("root");
+    const auto origin = root / "origin";
+    std::filesystem::create_directories(origin);
+    Expect(kabot::task::RunProcess(origin, {"git", "init", "-q", "-b", "main"}).Ok(), "expected git init");
+    Commit(origin, "README.md", "v1\n");
+
+    const auto projects = root / "projects";
+    kabot::task::GitWorkspaceCache cache;
+    const auto first = cache.Acquire(projects, "demo app", origin.string(), "t1");
+    Expect(first.ok, "expected first worktree: " + first.error);
+    Expect(first.cloned, "expected the first task to clone the mirror");
+    Expect(first.base_branch == "main", "expected the remote default branch");
+    Expect(first.branch == "kabot-task-t1", "expected a task branch");
+
+    Commit(origin, "CHANGELOG.md", "v2\n");
+    const auto second = cache.Acquire(projects, "demo app", origin.string(), "t2");
+    Expect(second.ok, "expected second worktree: " + second.error);
+    Expect(!second.cloned, "expected the second task to reuse the mirror");
+    Expect(second.mirror == first.mirror, "expected both tasks to share one mirror");
+    Expect(second.path != first.path, "expected isolated worktrees");
+    Expect(std::filesystem::exists(second.path / "CHANGELOG.md"), "expected fetch to bring in new commits");
+    Expect(!std::filesystem::exists(first.path / "CHANGELOG.md"), "expected the first worktree to be untouched");
+
+    cache.Release(first);
+    cache.Release(second);
+    cache.Drain();
+    Expect(!std::filesystem::exists(first.path), "expected released worktree to be removed");
+    Expect(!std::filesystem::exists(second.path), "expected released worktree to be removed");
+    const auto branches = kabot::task::RunProcess(first.mirror, {"git", "branch", "--list", "kabot-task-*"});
+    Expect(branches.Ok() && branches.output.empty(), "expected task branches to be deleted on release");
+}
+
+void TestAcquireReportsCloneFailure() {
+    const auto root = MakeDir("missing");
+    kabot::task::GitWorkspaceCache cache;
+    const auto worktree = cache.Acquire(root / "projects", "missing", (root / "nope").string(), "t1");
+    Expect(!worktree.ok, "expected acquire to fail for a missing remote");
+    Expect(worktree.error.find("clone failed") == 0, "expected a clone error");
+    Expect(!std::filesystem::exists(worktree.mirror), "expected no half-cloned mirror");
+}
+
+}  // namespace
+
+int main() {
+    TestRunProcessPassesArgumentsVerbatim();
+    TestRunProcessDisablesGitPrompts();
+    TestWorktreesShareOneMirror();
+    TestAcquireReportsCloneFailure();
+    std::cout << "git_workspace_tests passed" << std::endl;
+    return 0;
+}
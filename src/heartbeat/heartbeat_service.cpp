@@ -67,10 +67,15 @@ void HeartbeatService::Stop() {
     if (!running_.exchange(false)) {
         return;
     }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
     cron_.Stop();
     if (worker_.joinable()) {
         worker_.join();
     }
+    wake_timer_.Cancel();
 }
 
 std::string HeartbeatService::TriggerNow() {
@@ -82,20 +87,12 @@ std::string HeartbeatService::TriggerNow() {
 
 void HeartbeatService::RunLoop() {
     while (running_) {
-        auto sleep_duration = interval_;
-        const auto next_wake = cron_.GetNextWakeMs();
-        if (next_wake.has_value()) {
-            const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::system_clock::now().time_since_epoch()).count();
-            if (next_wake.value() > now_ms) {
-                const auto delta_ms = next_wake.value() - now_ms;
-                sleep_duration = std::min(
-                    interval_,
-                    std::chrono::duration_cast<std::chrono::seconds>(
-                        std::chrono::milliseconds(delta_ms)));
-            }
+        ArmWakeTimer();
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait(lock, [this] { return !running_ || wake_; });
+            wake_ = false;
         }
-        std::this_thread::sleep_for(sleep_duration);
         if (!running_) {
             break;
         }
@@ -103,6 +100,28 @@ void HeartbeatService::RunLoop() {
     }
 }
 
+// Wakes at the next cron job or after one heartbeat interval, whichever
+// comes first.
+void HeartbeatService::ArmWakeTimer() {
+    std::chrono::milliseconds delay = interval_;
+    const auto next_wake = cron_.GetNextWakeMs();
+    if (next_wake.has_value()) {
+        const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (next_wake.value() > now_ms) {
+            delay = std::min(delay, std::chrono::milliseconds(next_wake.value() - now_ms));
+        }
+    }
+    auto& timers = kabot::TimerService::Shared();
+    wake_timer_ = kabot::ScopedTimer(timers, timers.ScheduleAfter(delay, [this] {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            wake_ = true;
+        }
+        wake_cv_.notify_all();
+    }));
+}
+
 void HeartbeatService::Tick() {
     cron_.RunDueJobs();
 
@@ -2,12 +2,15 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
 #include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
 
 #include "cron/cron_service.hpp"
+#include "utils/timer_service.hpp"
 
 namespace kabot::heartbeat {
 
@@ -39,8 +42,15 @@ private:
     std::atomic<bool> running_{false};
     std::thread worker_;
     kabot::cron::CronService cron_;
+    // The next heartbeat or cron deadline is a TimerService timer; it only
+    // wakes the worker, which runs the (blocking) jobs and LLM turn.
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool wake_ = false;
+    kabot::ScopedTimer wake_timer_;
 
     void RunLoop();
+    void ArmWakeTimer();
     void Tick();
     std::filesystem::path HeartbeatFile() const;
     std::string ReadHeartbeatFile() const;
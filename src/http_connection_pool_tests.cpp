@@ -0,0 +1,128 @@
+#include "providers/http_connection_pool.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[http_connection_pool_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+kabot::providers::HttpEndpoint LocalEndpoint(int port = 18080) {
+    kabot::providers::HttpEndpoint endpoint;
+    endpoint.https = false;
+    endpoint.host = "127.0.0.1";
+    endpoint.port = port;
+    return endpoint;
+}
+
+void TestReleasedLeaseIsReused() {
+    kabot::providers::HttpConnectionPool pool;
+    {
+        auto lease = pool.Acquire(LocalEndpoint());
+        Expect(static_cast<bool>(lease), "expected a lease from an empty pool");
+        Expect(!lease.Reused(), "expected the first lease to open a new client");
+        const auto stats = pool.Stats();
+        Expect(stats.created == 1 && stats.in_use == 1 && stats.idle == 0,
+               "expected one client in use while leased");
+    }
+    Expect(pool.Stats().idle == 1, "expected a released lease to return to the idle list");
+
+    auto lease = pool.Acquire(LocalEndpoint());
+    Expect(lease.Reused(), "expected the idle client to be reused");
+    const auto stats = pool.Stats();
+    Expect(stats.created == 1 && stats.reused == 1, "expected reuse instead of a second client");
+    Expect(stats.in_use == 1 && stats.idle == 0, "expected the reused client to be in use");
+}
+
+void TestEndpointsArePooledSeparately() {
+    kabot::providers::HttpConnectionPool pool;
+    {
+        auto lease = pool.Acquire(LocalEndpoint(18080));
+    }
+    auto other = pool.Acquire(LocalEndpoint(18081));
+    Expect(!other.Reused(), "expected a different port not to reuse the idle client");
+    Expect(pool.Stats().created == 2, "expected one client per endpoint");
+}
+
+void TestIdleClientsAreEvicted() {
+    kabot::providers::HttpPoolOptions options;
+    options.idle_timeout = std::chrono::seconds(0);
+    kabot::providers::HttpConnectionPool pool(options);
+    {
+        auto lease = pool.Acquire(LocalEndpoint());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    auto lease = pool.Acquire(LocalEndpoint());
+    Expect(!lease.Reused(), "expected an expired idle client not to be reused");
+    const auto stats = pool.Stats();
+    Expect(stats.evicted == 1, "expected the expired idle client to be evicted");
+    Expect(stats.created == 2 && stats.reused == 0, "expected a fresh client after eviction");
+}
+
+void TestBrokenLeaseDropsIdleSiblings() {
+    kabot::providers::HttpConnectionPool pool;
+    {
+        auto first = pool.Acquire(LocalEndpoint());
+        auto second = pool.Acquire(LocalEndpoint());
+        first = kabot::providers::HttpConnectionPool::Lease();
+        Expect(pool.Stats().idle == 1, "expected the first client to be idle");
+        second.MarkBroken();
+    }
+    const auto stats = pool.Stats();
+    Expect(stats.discarded == 1, "expected the broken client to be discarded");
+    Expect(stats.evicted == 1 && stats.idle == 0, "expected idle siblings of a stale client to be dropped");
+    Expect(stats.in_use == 0, "expected both leases to be released");
+
+    auto lease = pool.Acquire(LocalEndpoint());
+    Expect(!lease.Reused(), "expected a fresh client after a stale connection");
+}
+
+void TestAcquireWaitsForFreeSlot() {
+    kabot::providers::HttpPoolOptions options;
+    options.max_connections_per_host = 1;
+    options.acquire_timeout = std::chrono::seconds(0);
+    kabot::providers::HttpConnectionPool pool(options);
+
+    auto held = pool.Acquire(LocalEndpoint());
+    Expect(static_cast<bool>(held), "expected the first lease");
+    auto rejected = pool.Acquire(LocalEndpoint());
+    Expect(!rejected, "expected an empty lease when the host limit is reached");
+
+    held = kabot::providers::HttpConnectionPool::Lease();
+    auto next = pool.Acquire(LocalEndpoint());
+    Expect(static_cast<bool>(next) && next.Reused(), "expected the released slot to be handed out again");
+}
+
+void TestOnlyUnsentRequestsAreRetryable() {
+    Expect(kabot::providers::RequestNeverSent(httplib::Error::Connection),
+           "expected a failed connect to be safe to resend");
+    Expect(kabot::providers::RequestNeverSent(httplib::Error::Write),
+           "expected a failed write to be safe to resend");
+    Expect(!kabot::providers::RequestNeverSent(httplib::Error::Read),
+           "expected a failed read not to be resent");
+    Expect(!kabot::providers::RequestNeverSent(httplib::Error::Canceled),
+           "expected a canceled request not to be resent");
+}
+
+}  // namespace
+
+int main() {
+    TestReleasedLeaseIsReused();
+    TestEndpointsArePooledSeparately();
+    TestIdleClientsAreEvicted();
+    TestBrokenLeaseDropsIdleSiblings();
+    TestAcquireWaitsForFreeSlot();
+    TestOnlyUnsentRequestsAreRetryable();
+    std::cout << "http_connection_pool_tests passed" << std::endl;
+    return 0;
+}
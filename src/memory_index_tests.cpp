@@ -0,0 +1,92 @@
+#include "agent/memory_index.hpp"
+#include "agent/memory_store.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[memory_index_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_memory_index_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir / "memory");
+    return dir;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::trunc);
+    file << content;
+}
+
+void TestSearchRanksRelevantChunks() {
+    const auto workspace = MakeWorkspace("rank");
+    WriteFile(workspace / "memory" / "MEMORY.md",
+              "# Preferences\n\nUser prefers dark mode in every editor.\n\n"
+              "# Deploy\n\nProduction deploys run from the release branch on Fridays.\n");
+    WriteFile(workspace / "memory" / "2026-01-02.md",
+              "# 2026-01-02\n\n- [cli:1] asked about the weather in Paris\n");
+
+    kabot::agent::MemoryIndex index(workspace.string(), {"memory"});
+    const auto hits = index.Search("when do we deploy production?", 5, 0.1);
+    Expect(!hits.empty(), "expected a hit for deploy query");
+    Expect(hits.front().path == "memory/MEMORY.md", "expected MEMORY.md to rank first");
+    Expect(hits.front().text.find("release branch") != std::string::npos, "expected the deploy chunk");
+    Expect(hits.front().line == 5, "expected chunk to start at its heading");
+    Expect(hits.front().score > 0.0 && hits.front().score <= 1.0, "expected normalized score");
+
+    Expect(index.Search("when do we deploy production?", 1, 0.1).size() == 1, "expected max_results to cap hits");
+    Expect(index.Search("kubernetes", 5, 0.0).empty(), "expected no hits for unknown terms");
+    Expect(!index.Search("weather", 5, 0.8).empty(), "expected a full match to pass a high threshold");
+}
+
+void TestWritesAreIndexedIncrementally() {
+    const auto workspace = MakeWorkspace("incremental");
+    auto index = kabot::agent::MemoryIndex::Shared(workspace.string(), {"memory"});
+    kabot::agent::MemoryStore store(workspace.string());
+
+    Expect(index->Search("espresso", 5, 0.0).empty(), "expected empty index");
+    store.AppendToday("- [cli:1] likes espresso after lunch");
+    Expect(index->Search("espresso", 5, 0.0).size() == 1, "expected appended note to be searchable");
+
+    store.WriteLongTerm("Owns a bicycle.");
+    Expect(index->Search("bicycle", 5, 0.0).size() == 1, "expected long-term memory to be searchable");
+
+    std::filesystem::remove(workspace / "memory" / "MEMORY.md");
+    Expect(index->Search("bicycle", 5, 0.0).empty(), "expected removed file to leave the index");
+}
+
+void TestSnapshotRestoresIndex() {
+    const auto workspace = MakeWorkspace("snapshot");
+    WriteFile(workspace / "memory" / "MEMORY.md", "The wifi password is on the fridge.\n");
+    {
+        kabot::agent::MemoryIndex index(workspace.string(), {"memory"});
+        Expect(index.Search("wifi", 5, 0.0).size() == 1, "expected initial hit");
+    }
+    Expect(std::filesystem::exists(workspace / "memory" / ".bm25-index.json"), "expected snapshot to be written");
+
+    kabot::agent::MemoryIndex restored(workspace.string(), {"memory"});
+    Expect(restored.Search("fridge", 5, 0.0).size() == 1, "expected restored index to answer");
+    Expect(restored.ChunkCount() == 1, "expected unchanged file not to be duplicated");
+}
+
+}  // namespace
+
+int main() {
+    TestSearchRanksRelevantChunks();
+    TestWritesAreIndexedIncrementally();
+    TestSnapshotRestoresIndex();
+    std::cout << "memory_index_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "agent/memory_store.hpp"
+#include "utils/timer_service.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[memory_store_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_memory_store_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir / "memory");
+    return dir;
+}
+
+void TestJournalAppendsAcrossStores() {
+    const auto workspace = MakeWorkspace("journal");
+    kabot::agent::MemoryStore writer(workspace.string(), kabot::agent::MemoryStoreOptions{0});
+    kabot::agent::MemoryStore reader(workspace.string());
+
+    writer.AppendToday("- first\n");
+    reader.AppendToday("- second\n");
+    writer.Flush();
+    const auto today = reader.ReadToday();
+    Expect(today.rfind("# ", 0) == 0, "expected the day header to be written once");
+    Expect(today.find("- first\n\n- second\n") != std::string::npos, "expected entries in append order");
+    Expect(writer.ReadToday() == today, "expected stores on one workspace to agree");
+    Expect(today.find("# ", 1) == std::string::npos, "expected no repeated header");
+
+    writer.WriteLongTerm("long term");
+    Expect(reader.ReadLongTerm() == "long term", "expected long-term memory to be replaced");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestSkippedSyncSchedulesDeferredFlush() {
+    const auto workspace = MakeWorkspace("deferred");
+    auto& timers = kabot::TimerService::Shared();
+    const auto baseline = timers.PendingCount();
+    {
+        kabot::agent::MemoryStore store(workspace.string(), kabot::agent::MemoryStoreOptions{50});
+        store.AppendToday("- synced\n");
+        Expect(timers.PendingCount() == baseline, "expected the first append to sync inline");
+        store.AppendToday("- grouped\n");
+        store.AppendToday("- grouped again\n");
+        Expect(timers.PendingCount() == baseline + 1, "expected one deferred flush for skipped syncs");
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (timers.PendingCount() > baseline && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        Expect(timers.PendingCount() == baseline, "expected the deferred flush to fire");
+        Expect(store.ReadToday().find("- grouped again\n") != std::string::npos, "expected grouped appends to be kept");
+    }
+    std::filesystem::remove_all(workspace);
+}
+
+}  // namespace
+
+int main() {
+    TestJournalAppendsAcrossStores();
+    TestSkippedSyncSchedulesDeferredFlush();
+    std::cout << "memory_store_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "bus/message_bus.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[message_bus_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+void TestOutboundPublishWakesOutboundConsumer() {
+    kabot::bus::MessageBus bus;
+    std::thread inbound_waiter([&bus] {
+        kabot::bus::InboundMessage msg{};
+        bus.TryConsumeInbound(msg, std::chrono::milliseconds(300));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    const auto started = std::chrono::steady_clock::now();
+    std::thread publisher([&bus] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        kabot::bus::OutboundMessage msg{};
+        msg.content = "hello";
+        bus.PublishOutbound(std::move(msg));
+    });
+    kabot::bus::OutboundMessage received{};
+    const bool ok = bus.TryConsumeOutbound(received, std::chrono::milliseconds(1000));
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    publisher.join();
+    inbound_waiter.join();
+
+    Expect(ok && received.content == "hello", "expected outbound consumer to receive the message");
+    Expect(elapsed < std::chrono::milliseconds(250), "expected outbound publish to wake the outbound consumer immediately");
+}
+
+void TestPublishAppliesBackpressureWhenFull() {
+    kabot::config::BusConfig config{};
+    config.inbound_capacity = 2;
+    config.publish_timeout_ms = 50;
+    kabot::bus::MessageBus bus(config);
+
+    Expect(bus.PublishInbound(kabot::bus::InboundMessage{}), "expected first publish to be accepted");
+    Expect(bus.PublishInbound(kabot::bus::InboundMessage{}), "expected second publish to be accepted");
+    Expect(!bus.PublishInbound(kabot::bus::InboundMessage{}), "expected publish to fail once capacity is reached");
+
+    const auto stats = bus.InboundStats();
+    Expect(stats.size == 2 && stats.capacity == 2, "expected inbound stats to report size and capacity");
+    Expect(stats.dropped == 1, "expected inbound stats to count the dropped message");
+
+    std::thread consumer([&bus] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        kabot::bus::InboundMessage msg{};
+        bus.TryConsumeInbound(msg, std::chrono::milliseconds(100));
+    });
+    kabot::bus::InboundMessage blocked{};
+    blocked.content = "late";
+    Expect(bus.PublishInbound(std::move(blocked)), "expected publish to succeed once a slot frees up");
+    consumer.join();
+}
+
+void TestDrainReturnsMessagesInOrder() {
+    kabot::bus::MessageBus bus;
+    for (int i = 0; i < 5; ++i) {
+        kabot::bus::InboundMessage msg{};
+        msg.content = std::to_string(i);
+        bus.PublishInbound(std::move(msg));
+    }
+    std::vector<kabot::bus::InboundMessage> batch;
+    Expect(bus.DrainInbound(batch, 3, std::chrono::milliseconds(10)) == 3, "expected drain to respect max_messages");
+    Expect(bus.DrainInbound(batch, 10, std::chrono::milliseconds(10)) == 2, "expected drain to return the remainder");
+    for (int i = 0; i < 5; ++i) {
+        Expect(batch[static_cast<std::size_t>(i)].content == std::to_string(i), "expected drained messages in FIFO order");
+    }
+    Expect(bus.DrainInbound(batch, 10, std::chrono::milliseconds(10)) == 0, "expected drain on empty queue to time out");
+}
+
+}  // namespace
+
+int main() {
+    TestOutboundPublishWakesOutboundConsumer();
+    TestPublishAppliesBackpressureWhenFull();
+    TestDrainReturnsMessagesInOrder();
+    std::cout << "message_bus_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,276 @@
+#include "bus/message_bus.hpp"
+#include "channels/outbound_sender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[outbound_sender_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+// Records deliveries; chats listed in failures_ fail that many times first,
+// chats listed in slow_ block for the given delay on every send.
+class FakeChannel : public kabot::channels::ChannelBase {
+public:
+    explicit FakeChannel(kabot::bus::MessageBus& bus)
+        : ChannelBase("fake", bus, {}, "") {}
+
+    void Start() override { running_ = true; }
+    void Stop() override { running_ = false; }
+
+    bool Send(const kabot::bus::OutboundMessage& msg) override {
+        std::chrono::milliseconds delay{0};
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            attempts_ += 1;
+            auto failure = failures_.find(msg.chat_id);
+            if (failure != failures_.end() && failure->second > 0) {
+                failure->second -= 1;
+                return false;
+            }
+            auto slow = slow_.find(msg.chat_id);
+            if (slow != slow_.end()) {
+                delay = slow->second;
+            }
+            concurrent_ += 1;
+            max_concurrent_ = std::max(max_concurrent_, concurrent_);
+        }
+        std::this_thread::sleep_for(delay);
+        std::lock_guard<std::mutex> lock(mutex_);
+        concurrent_ -= 1;
+        delivered_.push_back(msg.chat_id + ":" + msg.content);
+        return true;
+    }
+
+    std::vector<std::string> Delivered() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return delivered_;
+    }
+
+    std::mutex mutex_;
+    int attempts_ = 0;
+    int concurrent_ = 0;
+    int max_concurrent_ = 0;
+    std::unordered_map<std::string, int> failures_;
+    std::unordered_map<std::string, std::chrono::milliseconds> slow_;
+    std::vector<std::string> delivered_;
+};
+
+kabot::bus::OutboundMessage MakeMessage(const std::string& chat_id, const std::string& content) {
+    kabot::bus::OutboundMessage msg{};
+    msg.channel = "fake";
+    msg.chat_id = chat_id;
+    msg.content = content;
+    return msg;
+}
+
+bool WaitFor(const std::function<bool()>& done, std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (done()) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return done();
+}
+
+void TestRetryKeepsChatOrderWithoutBlockingOthers() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    channel.failures_["a"] = 2;
+    kabot::channels::OutboundSenderOptions options{};
+    options.retry_delay = std::chrono::milliseconds(50);
+    options.coalesce_window = std::chrono::milliseconds(0);
+    kabot::channels::OutboundSender sender(channel, options);
+    sender.Start();
+
+    Expect(sender.Enqueue(MakeMessage("a", "1")), "expected enqueue to succeed");
+    Expect(sender.Enqueue(MakeMessage("a", "2")), "expected enqueue to succeed");
+    Expect(sender.Enqueue(MakeMessage("b", "1")), "expected enqueue to succeed");
+
+    Expect(WaitFor([&] { return channel.Delivered().size() == 3; }, std::chrono::seconds(2)),
+           "expected every message to be delivered");
+    const auto delivered = channel.Delivered();
+    Expect(delivered[0] == "b:1", "expected the healthy chat to go first while a backs off");
+    Expect(delivered[1] == "a:1" && delivered[2] == "a:2", "expected per-chat order to survive retries");
+
+    const auto stats = sender.Stats();
+    Expect(stats.sent == 3, "expected three sends");
+    Expect(stats.retried == 2, "expected two scheduled retries");
+    Expect(stats.failed == 0, "expected no permanent failures");
+    Expect(stats.queued == 0 && stats.in_flight == 0, "expected the queue to drain");
+    sender.Stop();
+}
+
+void TestGivesUpAfterMaxAttempts() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    channel.failures_["a"] = 100;
+    kabot::channels::OutboundSenderOptions options{};
+    options.max_attempts = 2;
+    options.retry_delay = std::chrono::milliseconds(10);
+    kabot::channels::OutboundSender sender(channel, options);
+    sender.Start();
+
+    auto typing = MakeMessage("a", "typing");
+    typing.metadata["action"] = "typing";
+    sender.Enqueue(typing);
+    Expect(WaitFor([&] { return sender.Stats().failed == 1; }, std::chrono::seconds(1)),
+           "expected typing to fail without a retry");
+    sender.Enqueue(MakeMessage("a", "reply"));
+    Expect(WaitFor([&] { return sender.Stats().failed == 2; }, std::chrono::seconds(2)),
+           "expected both messages to fail permanently");
+    Expect(channel.attempts_ == 3, "expected typing to be tried once and the reply twice");
+    sender.Stop();
+}
+
+void TestSendsAreNeverConcurrent() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    channel.slow_["a"] = std::chrono::milliseconds(30);
+    channel.slow_["b"] = std::chrono::milliseconds(30);
+    channel.slow_["c"] = std::chrono::milliseconds(30);
+    kabot::channels::OutboundSender sender(channel, {});
+    sender.Start();
+
+    sender.Enqueue(MakeMessage("a", "1"));
+    sender.Enqueue(MakeMessage("b", "1"));
+    sender.Enqueue(MakeMessage("c", "1"));
+    Expect(WaitFor([&] { return channel.Delivered().size() == 3; }, std::chrono::seconds(2)),
+           "expected every chat to be delivered");
+    Expect(channel.max_concurrent_ == 1, "expected one channel never to send concurrently");
+    sender.Stop();
+}
+
+void TestBacklogIsCoalesced() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    channel.slow_["a"] = std::chrono::milliseconds(100);
+    kabot::channels::OutboundSender sender(channel, {});
+    sender.Start();
+
+    sender.Enqueue(MakeMessage("a", "1"));
+    Expect(WaitFor([&] { return sender.Stats().in_flight == 1; }, std::chrono::seconds(1)),
+           "expected the first message to be in flight");
+    auto typing = MakeMessage("a", "");
+    typing.metadata["action"] = "typing";
+    sender.Enqueue(typing);
+    sender.Enqueue(MakeMessage("a", "2"));
+    sender.Enqueue(MakeMessage("a", "3"));
+    sender.Enqueue(typing);
+
+    auto partial = MakeMessage("a", "Hel");
+    partial.metadata["stream_id"] = "s1";
+    partial.metadata["stream_state"] = "partial";
+    sender.Enqueue(partial);
+    partial.content = "Hello";
+    sender.Enqueue(partial);
+    auto final_update = partial;
+    final_update.content = "Hello world";
+    final_update.metadata["stream_state"] = "final";
+    sender.Enqueue(final_update);
+
+    Expect(WaitFor([&] { return sender.Stats().queued == 0 && sender.Stats().in_flight == 0; },
+                   std::chrono::seconds(2)),
+           "expected the backlog to drain");
+    const auto delivered = channel.Delivered();
+    Expect(delivered.size() == 3, "expected text and stream updates to be merged");
+    Expect(delivered[0] == "a:1", "expected the in-flight message untouched");
+    Expect(delivered[1] == "a:2\n\n3", "expected queued text to be merged in order");
+    Expect(delivered[2] == "a:Hello world", "expected the newest stream update to win");
+    Expect(sender.Stats().coalesced == 5, "expected typing, text and stream merges to be counted");
+    sender.Stop();
+}
+
+void TestMergeComparesSendMetadataAndLimit() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    channel.slow_["a"] = std::chrono::milliseconds(100);
+    kabot::channels::OutboundSenderOptions options{};
+    options.max_message_chars = 8;
+    kabot::channels::OutboundSender sender(channel, options);
+    sender.Start();
+
+    sender.Enqueue(MakeMessage("a", "1"));
+    Expect(WaitFor([&] { return sender.Stats().in_flight == 1; }, std::chrono::seconds(1)),
+           "expected the first message to be in flight");
+    auto tagged = MakeMessage("a", "22");
+    tagged.metadata["message_id"] = "9";
+    sender.Enqueue(tagged);
+    sender.Enqueue(MakeMessage("a", "33"));
+    sender.Enqueue(MakeMessage("a", "44"));
+    auto routed = MakeMessage("a", "55");
+    routed.metadata["receive_id_type"] = "open_id";
+    sender.Enqueue(routed);
+
+    Expect(WaitFor([&] { return sender.Stats().queued == 0 && sender.Stats().in_flight == 0; },
+                   std::chrono::seconds(2)),
+           "expected the backlog to drain");
+    const auto delivered = channel.Delivered();
+    Expect(delivered.size() == 4, "expected only compatible text within the limit to merge");
+    Expect(delivered[1] == "a:22\n\n33", "expected bookkeeping metadata not to prevent merging");
+    Expect(delivered[2] == "a:44", "expected merging to stop at the message limit");
+    Expect(delivered[3] == "a:55", "expected different routing metadata not to merge");
+    sender.Stop();
+}
+
+void TestChatRateLimitSpacesSends() {
+    kabot::bus::MessageBus bus;
+    FakeChannel channel(bus);
+    kabot::channels::OutboundSenderOptions options{};
+    options.chat_rate_per_second = 20;
+    options.chat_burst = 1;
+    options.coalesce_window = std::chrono::milliseconds(0);
+    kabot::channels::OutboundSender sender(channel, options);
+    sender.Start();
+
+    const auto started = std::chrono::steady_clock::now();
+    sender.Enqueue(MakeMessage("a", "1"));
+    sender.Enqueue(MakeMessage("a", "2"));
+    sender.Enqueue(MakeMessage("a", "3"));
+    sender.Enqueue(MakeMessage("b", "1"));
+    Expect(WaitFor([&] { return channel.Delivered().size() == 4; }, std::chrono::seconds(2)),
+           "expected every message to be delivered");
+    Expect(std::chrono::steady_clock::now() - started >= std::chrono::milliseconds(90),
+           "expected sends to one chat to be spaced by its rate");
+    const auto delivered = channel.Delivered();
+    Expect(delivered[1] == "b:1", "expected another chat not to wait on a throttled one");
+    Expect(sender.Stats().throttled > 0, "expected throttling to be counted");
+    sender.Stop();
+}
+
+}  // namespace
+
+void TestTypingIsDeliverableWhenEmpty() {
+    auto typing = MakeMessage("a", "");
+    typing.metadata["action"] = "typing";
+    Expect(kabot::channels::IsDeliverable(typing), "expected an empty typing action to be delivered");
+    Expect(!kabot::channels::IsDeliverable(MakeMessage("a", "")), "expected an empty message to be skipped");
+    Expect(kabot::channels::IsDeliverable(MakeMessage("a", "hi")), "expected a text message to be delivered");
+}
+
+int main() {
+    TestRetryKeepsChatOrderWithoutBlockingOthers();
+    TestGivesUpAfterMaxAttempts();
+    TestSendsAreNeverConcurrent();
+    TestBacklogIsCoalesced();
+    TestMergeComparesSendMetadataAndLimit();
+    TestChatRateLimitSpacesSends();
+    TestTypingIsDeliverableWhenEmpty();
+    std::cout << "outbound_sender_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "providers/http_connection_pool.hpp"
+
+#include <utility>
+
+#include "utils/logging.hpp"
+
+namespace kabot::providers {
+
+std::string HttpEndpoint::SchemeHostPort() const {
+    return std::string(https ? "https://" : "http://") + host + ":" + std::to_string(port);
+}
+
+std::string HttpEndpoint::Key() const {
+    auto key = SchemeHostPort();
+    if (!proxy_host.empty()) {
+        key += "|proxy=" + proxy_host + ":" + std::to_string(proxy_port);
+    }
+    return key;
+}
+
+bool RequestNeverSent(httplib::Error error) {
+    switch (error) {
+        case httplib::Error::Connection:
+        case httplib::Error::BindIPAddress:
+        case httplib::Error::ConnectionTimeout:
+        case httplib::Error::ProxyConnection:
+        case httplib::Error::SSLConnection:
+        case httplib::Error::Write:
+            return true;
+        default:
+            return false;
+    }
+}
+
+HttpConnectionPool::Lease::Lease(HttpConnectionPool* pool,
+                                 std::string key,
+                                 std::unique_ptr<httplib::Client> client,
+                                 bool reused)
+    : pool_(pool)
+    , key_(std::move(key))
+    , client_(std::move(client))
+    , reused_(reused) {}
+
+HttpConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_)
+    , key_(std::move(other.key_))
+    , client_(std::move(other.client_))
+    , reused_(other.reused_)
+    , broken_(other.broken_) {
+    other.pool_ = nullptr;
+}
+
+HttpConnectionPool::Lease& HttpConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        Release();
+        pool_ = other.pool_;
+        key_ = std::move(other.key_);
+        client_ = std::move(other.client_);
+        reused_ = other.reused_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+    }
+    return *this;
+}
+
+HttpConnectionPool::Lease::~Lease() {
+    Release();
+}
+
+void HttpConnectionPool::Lease::Release() {
+    if (pool_ && client_) {
+        pool_->Return(key_, std::move(client_), broken_);
+    }
+    pool_ = nullptr;
+    client_.reset();
+}
+
+HttpConnectionPool::HttpConnectionPool(HttpPoolOptions options)
+    : options_(std::move(options)) {
+    if (options_.max_connections_per_host == 0) {
+        options_.max_connections_per_host = 1;
+    }
+}
+
+HttpConnectionPool::Lease HttpConnectionPool::Acquire(const HttpEndpoint& endpoint) {
+    const auto key = endpoint.Key();
+    std::vector<IdleClient> expired;
+    std::unique_ptr<httplib::Client> client;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto& host = hosts_[key];
+        const bool has_slot = slot_freed_.wait_for(lock, options_.acquire_timeout, [this, &host] {
+            return host.in_use < options_.max_connections_per_host;
+        });
+        if (!has_slot) {
+            LOG_WARN("[llm] connection pool exhausted host={} in_use={}", key, host.in_use);
+            return {};
+        }
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = host.idle.begin(); it != host.idle.end();) {
+            if (now - it->idle_since > options_.idle_timeout) {
+                expired.push_back(std::move(*it));
+                it = host.idle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        stats_.evicted += expired.size();
+        host.in_use += 1;
+        if (!host.idle.empty()) {
+            // Most recently returned first: it is the least likely to have
+            // been closed by the server.
+            client = std::move(host.idle.back().client);
+            host.idle.pop_back();
+            stats_.reused += 1;
+        } else {
+            stats_.created += 1;
+        }
+    }
+    if (client) {
+        return Lease(this, key, std::move(client), true);
+    }
+    LOG_DEBUG("[llm] opening pooled connection host={}", key);
+    return Lease(this, key, CreateClient(endpoint), false);
+}
+
+HttpPoolStats HttpConnectionPool::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = stats_;
+    for (const auto& [key, host] : hosts_) {
+        stats.idle += host.idle.size();
+        stats.in_use += host.in_use;
+    }
+    return stats;
+}
+
+std::unique_ptr<httplib::Client> HttpConnectionPool::CreateClient(const HttpEndpoint& endpoint) const {
+    auto client = std::make_unique<httplib::Client>(endpoint.SchemeHostPort());
+    client->set_keep_alive(true);
+    client->set_connection_timeout(options_.connect_timeout);
+    client->set_read_timeout(options_.read_timeout);
+    if (!endpoint.proxy_host.empty()) {
+        client->set_proxy(endpoint.proxy_host, endpoint.proxy_port);
+    }
+    return client;
+}
+
+void HttpConnectionPool::Return(const std::string& key, std::unique_ptr<httplib::Client> client, bool broken) {
+    std::vector<IdleClient> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& host = hosts_[key];
+        if (host.in_use > 0) {
+            host.in_use -= 1;
+        }
+        if (broken) {
+            // A connection the peer dropped usually means its idle siblings
+            // were dropped too (server restart, idle reaping, network change).
+            stats_.discarded += 1;
+            stats_.evicted += host.idle.size();
+            dropped.swap(host.idle);
+        } else {
+            host.idle.push_back(IdleClient{std::move(client), std::chrono::steady_clock::now()});
+        }
+    }
+    slot_freed_.notify_all();
+    // Broken and dropped clients are destroyed here, outside the lock, since
+    // closing a TLS session may block on the socket.
+}
+
+}  // namespace kabot::providers
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "httplib.h"
+
+namespace kabot::providers {
+
+struct HttpEndpoint {
+    bool https = true;
+    std::string host;
+    int port = 443;
+    std::string proxy_host;
+    int proxy_port = 0;
+
+    std::string SchemeHostPort() const;
+    std::string Key() const;
+};
+
+struct HttpPoolOptions {
+    std::size_t max_connections_per_host = 8;
+    std::chrono::seconds idle_timeout{60};
+    std::chrono::seconds connect_timeout{60};
+    std::chrono::seconds read_timeout{60};
+    std::chrono::seconds acquire_timeout{60};
+};
+
+struct HttpPoolStats {
+    std::uint64_t created = 0;
+    std::uint64_t reused = 0;
+    std::uint64_t evicted = 0;
+    std::uint64_t discarded = 0;
+    std::size_t idle = 0;
+    std::size_t in_use = 0;
+};
+
+// True when the request failed before it was completely written (no
+// connection, or the write itself failed), so the server cannot have acted
+// on it and resending is safe even for a non-idempotent POST.
+bool RequestNeverSent(httplib::Error error);
+
+// Keep-alive httplib clients shared by concurrent LLM calls. Clients are
+// grouped by scheme/host/port/proxy; at most max_connections_per_host leases
+// per group are handed out at once and callers beyond that wait. Clients idle
+// longer than idle_timeout are closed instead of reused, and a lease marked
+// broken is dropped rather than returned.
+class HttpConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        explicit operator bool() const { return client_ != nullptr; }
+        httplib::Client& operator*() const { return *client_; }
+        httplib::Client* operator->() const { return client_.get(); }
+        // True when the connection was used by an earlier request.
+        bool Reused() const { return reused_; }
+        // Drops the client (and its socket) instead of returning it to the pool.
+        void MarkBroken() { broken_ = true; }
+
+    private:
+        friend class HttpConnectionPool;
+        Lease(HttpConnectionPool* pool, std::string key, std::unique_ptr<httplib::Client> client, bool reused);
+        void Release();
+
+        HttpConnectionPool* pool_ = nullptr;
+        std::string key_;
+        std::unique_ptr<httplib::Client> client_;
+        bool reused_ = false;
+        bool broken_ = false;
+    };
+
+    explicit HttpConnectionPool(HttpPoolOptions options = {});
+    HttpConnectionPool(const HttpConnectionPool&) = delete;
+    HttpConnectionPool& operator=(const HttpConnectionPool&) = delete;
+
+    // Returns an empty lease when no slot frees up within acquire_timeout.
+    Lease Acquire(const HttpEndpoint& endpoint);
+    HttpPoolStats Stats() const;
+
+private:
+    struct IdleClient {
+        std::unique_ptr<httplib::Client> client;
+        std::chrono::steady_clock::time_point idle_since;
+    };
+
+    struct HostPool {
+        std::vector<IdleClient> idle;
+        std::size_t in_use = 0;
+    };
+
+    HttpPoolOptions options_;
+    mutable std::mutex mutex_;
+    std::condition_variable slot_freed_;
+    std::unordered_map<std::string, HostPool> hosts_;
+    HttpPoolStats stats_;
+
+    std::unique_ptr<httplib::Client> CreateClient(const HttpEndpoint& endpoint) const;
+    void Return(const std::string& key, std::unique_ptr<httplib::Client> client, bool broken);
+};
+
+}  // namespace kabot::providers
@@ -2,12 +2,15 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <sstream>
 #include <string>
 
 #include "httplib.h"
 #include "nlohmann/json.hpp"
+#include "providers/sse_stream.hpp"
 #include "utils/logging.hpp"
 
 namespace kabot::providers {
@@ -95,6 +98,22 @@ bool ParseProxyHostPort(const std::string& proxy, std::string& host, int& port)
     return !host.empty() && port > 0;
 }
 
+// Resolves the HTTP proxy for LLM traffic from the environment. cpp-httplib
+// only speaks HTTP CONNECT, so ALL_PROXY (usually socks) is reported and
+// ignored.
+bool ResolveLlmProxy(std::string& host, int& port) {
+    for (const char* name : {"HTTPS_PROXY", "HTTP_PROXY", "https_proxy", "http_proxy"}) {
+        const auto value = GetEnv(name);
+        if (!value.empty() && ParseProxyHostPort(value, host, port)) {
+            return true;
+        }
+    }
+    if (!GetEnv("ALL_PROXY").empty() || !GetEnv("all_proxy").empty()) {
+        LOG_WARN("[llm] ALL_PROXY is set but cpp-httplib only supports HTTP proxy");
+    }
+    return false;
+}
+
 std::string MaskKey(const std::string& key) {
     if (key.size() <= 8) {
         return "****";
@@ -154,23 +173,280 @@ std::unordered_map<std::string, std::string> ParseArguments(const nlohmann::json
     return parsed;
 }
 
+LLMResponse ParseCompletion(const nlohmann::json& json, bool use_anthropic) {
+    LLMResponse parsed_response{};
+    if (use_anthropic) {
+        if (json.contains("content") && json["content"].is_array()) {
+            for (const auto& block : json["content"]) {
+                const auto type = block.value("type", "");
+                if (type == "text") {
+                    parsed_response.content += block.value("text", "");
+                } else if (type == "tool_use") {
+                    ToolCallRequest call{};
+                    call.id = block.value("id", "");
+                    call.name = block.value("name", "");
+                    if (block.contains("input")) {
+                        const auto& input = block["input"];
+                        if (input.is_object()) {
+                            for (const auto& item : input.items()) {
+                                if (item.value().is_string()) {
+                                    call.arguments[item.key()] = item.value().get<std::string>();
+                                } else {
+                                    call.arguments[item.key()] = item.value().dump();
+                                }
+                            }
+                        }
+                    }
+                    parsed_response.tool_calls.push_back(call);
+                }
+            }
+        }
+        if (json.contains("stop_reason") && json["stop_reason"].is_string()) {
+            parsed_response.finish_reason = json["stop_reason"].get<std::string>();
+        }
+        if (json.contains("usage") && json["usage"].is_object()) {
+            AnthropicUsage usage;
+            usage.Merge(json["usage"]);
+            usage.ApplyTo(parsed_response.usage);
+        }
+        return parsed_response;
+    }
+
+    if (!json.contains("choices") || json["choices"].empty()) {
+        LLMResponse error_response{};
+        error_response.content = "Error calling LLM: invalid response";
+        error_response.finish_reason = "error";
+        return error_response;
+    }
+
+    const auto& choice = json["choices"][0];
+    const auto& message = choice["message"];
+    if (message.contains("content") && !message["content"].is_null()) {
+        parsed_response.content = message["content"].get<std::string>();
+    }
+
+    if (message.contains("tool_calls")) {
+        for (const auto& tc : message["tool_calls"]) {
+            ToolCallRequest call{};
+            call.id = tc.value("id", "");
+            if (tc.contains("function")) {
+                call.name = tc["function"].value("name", "");
+                if (tc["function"].contains("arguments")) {
+                    auto args = tc["function"]["arguments"];
+                    if (args.is_string()) {
+                        auto parsed_args = nlohmann::json::parse(args.get<std::string>(), nullptr, false);
+                        if (parsed_args.is_discarded()) {
+                            call.arguments = ParseArguments(args);
+                        } else {
+                            call.arguments = ParseArguments(parsed_args);
+                        }
+                    } else {
+                        call.arguments = ParseArguments(args);
+                    }
+                }
+            }
+            parsed_response.tool_calls.push_back(call);
+        }
+    }
+
+    if (choice.contains("finish_reason") && !choice["finish_reason"].is_null()) {
+        parsed_response.finish_reason = choice["finish_reason"].get<std::string>();
+    }
+
+    if (json.contains("usage")) {
+        ApplyOpenAIUsage(json["usage"], parsed_response.usage);
+    }
+
+    return parsed_response;
+}
+
+constexpr int kMaxRequestAttempts = 2;
+
+int UsageValue(const LLMResponse& response, const char* key) {
+    const auto it = response.usage.find(key);
+    return it == response.usage.end() ? 0 : it->second;
+}
+
+void LogUsage(const LLMResponse& response) {
+    if (response.usage.empty()) {
+        return;
+    }
+    LOG_INFO("[llm] usage prompt={} cache_read={} cache_write={} completion={}",
+             UsageValue(response, "prompt_tokens"),
+             UsageValue(response, "cache_read_tokens"),
+             UsageValue(response, "cache_creation_tokens"),
+             UsageValue(response, "completion_tokens"));
+}
+
+// Anthropic accepts at most four cache_control breakpoints per request.
+constexpr int kMaxCacheBreakpoints = 4;
+const nlohmann::json kEphemeralCache = {{"type", "ephemeral"}};
+
+// Splices "tools":[...] into a serialized payload object from the tools'
+// precompiled fragments, so schemas are not reparsed for every request.
+void AppendTools(std::string& body,
+                 const std::vector<ToolDefinition>& tools,
+                 bool use_anthropic,
+                 bool cache_last_tool) {
+    if (tools.empty() || body.size() < 2 || body.back() != '}') {
+        return;
+    }
+    std::string list = "\"tools\":[";
+    for (std::size_t i = 0; i < tools.size(); ++i) {
+        const auto* fragment = use_anthropic ? tools[i].anthropic_json.get() : tools[i].openai_json.get();
+        std::string compiled;
+        if (!fragment) {
+            auto copy = tools[i];
+            CompileToolDefinition(copy);
+            compiled = use_anthropic ? *copy.anthropic_json : *copy.openai_json;
+            fragment = &compiled;
+        }
+        if (i > 0) {
+            list += ',';
+        }
+        if (cache_last_tool && i + 1 == tools.size()) {
+            list.append(*fragment, 0, fragment->size() - 1);
+            list += ",\"cache_control\":" + kEphemeralCache.dump() + "}";
+        } else {
+            list += *fragment;
+        }
+    }
+    list += ']';
+    body.pop_back();
+    if (body.size() > 1) {
+        body += ',';
+    }
+    body += list;
+    body += '}';
+}
+
+// Sends the request with a chunked body receiver and feeds each SSE event to
+// the matching assembler. The read timeout only bounds the gap between
+// chunks, so long replies no longer run into it. Servers that ignore
+// "stream": true and answer with a plain JSON body are handled as well.
+LLMResponse PostStreaming(HttpConnectionPool::Lease& client,
+                          const std::string& endpoint,
+                          const httplib::Headers& headers,
+                          const std::string& body,
+                          bool use_anthropic,
+                          const StreamDeltaCallback& on_delta,
+                          bool& stale_connection) {
+    const auto started = std::chrono::steady_clock::now();
+    OpenAIStreamAssembler openai;
+    AnthropicStreamAssembler anthropic;
+    std::string raw_body;
+    bool saw_event = false;
+    bool saw_text = false;
+    SseParser parser([&](const std::string& event, const std::string& data) {
+        saw_event = true;
+        const auto text = use_anthropic ? anthropic.Consume(event, data) : openai.Consume(data);
+        if (text.empty()) {
+            return;
+        }
+        if (!saw_text) {
+            saw_text = true;
+            const auto first_token_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - started).count();
+            LOG_INFO("[llm] first token after {}ms", first_token_ms);
+        }
+        on_delta(text);
+    });
+
+    httplib::Request request;
+    request.method = "POST";
+    request.path = endpoint;
+    request.headers = headers;
+    request.headers.emplace("Accept", "text/event-stream");
+    request.body = body;
+    request.content_receiver = [&](const char* data, std::size_t size, std::uint64_t, std::uint64_t) {
+        if (!saw_event) {
+            raw_body.append(data, size);
+        }
+        parser.Feed(data, size);
+        return true;
+    };
+
+    auto response = client->send(request);
+    parser.Finish();
+    if (!response) {
+        client.MarkBroken();
+        const auto err = response.error();
+        if (client.Reused() && raw_body.empty() && !saw_event && RequestNeverSent(err)) {
+            stale_connection = true;
+        }
+        const auto err_text = HttpLibErrorToString(err);
+        LOG_ERROR("[llm] stream request failed: httplib error={}({})",
+                  static_cast<int>(err),
+                  err_text);
+        LLMResponse error_response{};
+        error_response.content = "Error calling LLM: request failed (httplib error=" + std::to_string(static_cast<int>(err)) +
+            ", " + err_text + ")";
+        error_response.finish_reason = "error";
+        return error_response;
+    }
+    if (response->status >= 400) {
+        LOG_ERROR("[llm] request body={}", body);
+        LOG_ERROR("[llm] HTTP {} body={}", response->status, raw_body);
+        LLMResponse error_response{};
+        error_response.content = "Error calling LLM: HTTP " + std::to_string(response->status);
+        error_response.finish_reason = "error";
+        return error_response;
+    }
+    if (!saw_event) {
+        auto json = nlohmann::json::parse(raw_body, nullptr, false);
+        if (json.is_discarded()) {
+            LLMResponse error_response{};
+            error_response.content = "Error calling LLM: invalid response";
+            error_response.finish_reason = "error";
+            return error_response;
+        }
+        auto parsed_response = ParseCompletion(json, use_anthropic);
+        if (parsed_response.finish_reason != "error" && !parsed_response.content.empty()) {
+            on_delta(parsed_response.content);
+        }
+        return parsed_response;
+    }
+
+    const bool done = use_anthropic ? anthropic.Done() : openai.Done();
+    auto parsed_response = use_anthropic ? anthropic.Finish() : openai.Finish();
+    const auto total_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    if (!done) {
+        LOG_WARN("[llm] stream ended without a terminal event after {}ms", total_ms);
+    }
+    LOG_INFO("[llm] stream completed in {}ms finish_reason={} tool_calls={}",
+             total_ms,
+             parsed_response.finish_reason,
+             parsed_response.tool_calls.size());
+    return parsed_response;
+}
+
 }  // namespace
 
 LiteLLMProvider::LiteLLMProvider(std::string api_key,
                                  std::string api_base,
                                  std::string default_model,
                                  bool use_proxy_for_llm,
-                                 std::string user_agent)
+                                 std::string user_agent,
+                                 HttpPoolOptions pool_options,
+                                 bool prompt_caching)
     : api_key_(std::move(api_key))
     , api_base_(std::move(api_base))
     , default_model_(std::move(default_model))
     , user_agent_(std::move(user_agent))
-    , use_proxy_for_llm_(use_proxy_for_llm) {
+    , use_proxy_for_llm_(use_proxy_for_llm)
+    , prompt_caching_(prompt_caching)
+    , pool_(std::make_unique<HttpConnectionPool>(std::move(pool_options))) {
     is_openrouter_ = (!api_key_.empty() && api_key_.rfind("sk-or-", 0) == 0) ||
         (api_base_.find("openrouter") != std::string::npos);
     is_vllm_ = !api_base_.empty() && !is_openrouter_;
+    if (use_proxy_for_llm_ && ResolveLlmProxy(proxy_host_, proxy_port_)) {
+        LOG_INFO("[llm] using HTTP proxy {}:{}", proxy_host_, proxy_port_);
+    }
 }
 
+LiteLLMProvider::~LiteLLMProvider() = default;
+
 std::string LiteLLMProvider::NormalizeModel(
     const std::string& model,
     bool is_openrouter,
@@ -187,6 +463,29 @@ LLMResponse LiteLLMProvider::Chat(
     const std::string& model,
     int max_tokens,
     double temperature) {
+    return Complete(messages, tools, model, max_tokens, temperature, nullptr);
+}
+
+LLMResponse LiteLLMProvider::ChatStream(
+    const std::vector<Message>& messages,
+    const std::vector<ToolDefinition>& tools,
+    const std::string& model,
+    int max_tokens,
+    double temperature,
+    const StreamDeltaCallback& on_delta) {
+    if (!on_delta) {
+        return Complete(messages, tools, model, max_tokens, temperature, nullptr);
+    }
+    return Complete(messages, tools, model, max_tokens, temperature, &on_delta);
+}
+
+LLMResponse LiteLLMProvider::Complete(
+    const std::vector<Message>& messages,
+    const std::vector<ToolDefinition>& tools,
+    const std::string& model,
+    int max_tokens,
+    double temperature,
+    const StreamDeltaCallback* on_delta) {
     try {
         const auto chosen_model = NormalizeModel(
             model.empty() ? default_model_ : model,
@@ -196,8 +495,11 @@ LLMResponse LiteLLMProvider::Chat(
         const bool use_anthropic = ShouldUseAnthropicMessages(chosen_model, api_base_);
 
         nlohmann::json payload;
+        bool cache_last_tool = false;
         if (use_anthropic) {
             std::string system_prompt;
+            nlohmann::json system_blocks = nlohmann::json::array();
+            int breakpoints_left = prompt_caching_ ? kMaxCacheBreakpoints : 0;
             payload["model"] = chosen_model;
             payload["max_tokens"] = max_tokens;
             payload["temperature"] = temperature;
@@ -210,12 +512,21 @@ LLMResponse LiteLLMProvider::Chat(
                     }
                     if (!msg.content_parts.empty()) {
                         for (const auto& part : msg.content_parts) {
-                            if (part.type == "text") {
-                                system_prompt.append(part.text);
+                            if (part.type != "text") {
+                                continue;
+                            }
+                            system_prompt.append(part.text);
+                            nlohmann::json block = {{"type", "text"}, {"text", part.text}};
+                            if (part.cache_breakpoint && breakpoints_left > 1) {
+                                // Keep one breakpoint in reserve for the conversation tail.
+                                block["cache_control"] = kEphemeralCache;
+                                breakpoints_left -= 1;
                             }
+                            system_blocks.push_back(std::move(block));
                         }
                     } else {
                         system_prompt.append(msg.content);
+                        system_blocks.push_back({{"type", "text"}, {"text", msg.content}});
                     }
                     continue;
                 }
@@ -246,27 +557,26 @@ LLMResponse LiteLLMProvider::Chat(
                 payload["messages"].push_back(entry);
             }
 
-            if (!system_prompt.empty()) {
+            // The cache prefix runs tools -> system -> messages, so the
+            // breakpoints go on the last tool, the end of the stable system
+            // prefix, and the newest message (which lets the next tool-loop
+            // iteration read the whole conversation from cache).
+            if (!tools.empty() && breakpoints_left > 1) {
+                cache_last_tool = true;
+                breakpoints_left -= 1;
+            }
+
+            if (prompt_caching_ && !system_blocks.empty()) {
+                payload["system"] = system_blocks;
+            } else if (!system_prompt.empty()) {
                 payload["system"] = system_prompt;
             }
 
-            if (!tools.empty()) {
-                nlohmann::json tool_defs = nlohmann::json::array();
-                for (const auto& tool : tools) {
-                    nlohmann::json params = nlohmann::json::object();
-                    if (!tool.parameters_json.empty()) {
-                        params = nlohmann::json::parse(tool.parameters_json, nullptr, false);
-                        if (params.is_discarded()) {
-                            params = nlohmann::json::object();
-                        }
-                    }
-                    tool_defs.push_back({
-                        {"name", tool.name},
-                        {"description", tool.description},
-                        {"input_schema", params}
-                    });
+            if (breakpoints_left > 0 && !payload["messages"].empty()) {
+                auto& tail = payload["messages"].back()["content"];
+                if (tail.is_array() && !tail.empty()) {
+                    tail.back()["cache_control"] = kEphemeralCache;
                 }
-                payload["tools"] = tool_defs;
             }
         } else {
             payload["model"] = chosen_model;
@@ -285,7 +595,18 @@ LLMResponse LiteLLMProvider::Chat(
                     entry["tool_call_id"] = msg.tool_call_id;
                 }
 
-                if (!msg.content_parts.empty()) {
+                if (msg.role == "system" && !msg.content_parts.empty()) {
+                    // Not every OpenAI-compatible server accepts part arrays
+                    // for system messages; the joined text keeps the same
+                    // byte-stable prefix for automatic prefix caching.
+                    std::string text;
+                    for (const auto& part : msg.content_parts) {
+                        if (part.type == "text") {
+                            text.append(part.text);
+                        }
+                    }
+                    entry["content"] = text;
+                } else if (!msg.content_parts.empty()) {
                     nlohmann::json content = nlohmann::json::array();
                     for (const auto& part : msg.content_parts) {
                         if (part.type == "text") {
@@ -322,29 +643,18 @@ LLMResponse LiteLLMProvider::Chat(
             }
 
             if (!tools.empty()) {
-                nlohmann::json tool_defs = nlohmann::json::array();
-                for (const auto& tool : tools) {
-                    nlohmann::json params = nlohmann::json::object();
-                    if (!tool.parameters_json.empty()) {
-                        params = nlohmann::json::parse(tool.parameters_json, nullptr, false);
-                        if (params.is_discarded()) {
-                            params = nlohmann::json::object();
-                        }
-                    }
-                    tool_defs.push_back({
-                        {"type", "function"},
-                        {"function", {
-                            {"name", tool.name},
-                            {"description", tool.description},
-                            {"parameters", params}
-                        }}
-                    });
-                }
-                payload["tools"] = tool_defs;
                 payload["tool_choice"] = "auto";
             }
         }
 
+        const bool streaming = on_delta != nullptr;
+        if (streaming) {
+            payload["stream"] = true;
+            if (!use_anthropic) {
+                payload["stream_options"] = {{"include_usage", true}};
+            }
+        }
+
         std::string base_url = api_base_;
         if (base_url.empty()) {
             if (use_anthropic) {
@@ -359,40 +669,21 @@ LLMResponse LiteLLMProvider::Chat(
         auto parsed = ParseUrl(base_url);
         const std::string endpoint = parsed.base_path + (use_anthropic ? "/messages" : "/chat/completions");
 
-        std::string scheme_host_port = parsed.https ? "https://" : "http://";
-        scheme_host_port += parsed.host + ":" + std::to_string(parsed.port);
-        auto client = std::make_unique<httplib::Client>(scheme_host_port);
-        client->set_connection_timeout(60);
-        client->set_read_timeout(60);
-
-        if (use_proxy_for_llm_) {
-            const auto https_proxy = GetEnv("HTTPS_PROXY");
-            const auto http_proxy = GetEnv("HTTP_PROXY");
-            const auto all_proxy = GetEnv("ALL_PROXY");
-            const auto https_proxy_l = GetEnv("https_proxy");
-            const auto http_proxy_l = GetEnv("http_proxy");
-            const auto all_proxy_l = GetEnv("all_proxy");
-            std::string proxy_host;
-            int proxy_port = 0;
-            if (!https_proxy.empty() && ParseProxyHostPort(https_proxy, proxy_host, proxy_port)) {
-                client->set_proxy(proxy_host, proxy_port);
-            } else if (!http_proxy.empty() && ParseProxyHostPort(http_proxy, proxy_host, proxy_port)) {
-                client->set_proxy(proxy_host, proxy_port);
-            } else if (!https_proxy_l.empty() && ParseProxyHostPort(https_proxy_l, proxy_host, proxy_port)) {
-                client->set_proxy(proxy_host, proxy_port);
-            } else if (!http_proxy_l.empty() && ParseProxyHostPort(http_proxy_l, proxy_host, proxy_port)) {
-                client->set_proxy(proxy_host, proxy_port);
-            } else if (!all_proxy.empty() || !all_proxy_l.empty()) {
-                LOG_WARN("[llm] ALL_PROXY is set but cpp-httplib only supports HTTP proxy");
-            }
-        }
+        HttpEndpoint http_endpoint{};
+        http_endpoint.https = parsed.https;
+        http_endpoint.host = parsed.host;
+        http_endpoint.port = parsed.port;
+        http_endpoint.proxy_host = proxy_host_;
+        http_endpoint.proxy_port = proxy_port_;
+        const auto scheme_host_port = http_endpoint.SchemeHostPort();
 
-        LOG_INFO("[llm] POST {}{} model={} api_key={} style={}",
+        LOG_INFO("[llm] POST {}{} model={} api_key={} style={} stream={}",
                  scheme_host_port,
                  endpoint,
                  chosen_model,
                  MaskKey(api_key_),
-                 (use_anthropic ? "anthropic" : "openai"));
+                 (use_anthropic ? "anthropic" : "openai"),
+                 (streaming ? "true" : "false"));
 
         httplib::Headers headers{{"Content-Type", "application/json"}};
         headers.emplace("User-Agent", user_agent_);
@@ -405,138 +696,69 @@ LLMResponse LiteLLMProvider::Chat(
             }
         }
 
-        const auto payload_body = payload.dump();
-        auto response = client->Post(endpoint.c_str(), headers, payload_body, "application/json");
-        if (!response) {
-            const auto err = response.error();
-            const auto err_text = HttpLibErrorToString(err);
-            LOG_ERROR("[llm] request failed: httplib error={}({})",
-                      static_cast<int>(err),
-                      err_text);
-            LLMResponse error_response{};
-            error_response.content = "Error calling LLM: request failed (httplib error=" + std::to_string(static_cast<int>(err)) +
-                ", " + err_text + ")";
-            error_response.finish_reason = "error";
-            return error_response;
-        }
-        if (response->status >= 400) {
-            LOG_ERROR("[llm] request body={}", payload_body);
-            LOG_ERROR("[llm] HTTP {} body={}", response->status, response->body);
-            LLMResponse error_response{};
-            error_response.content = "Error calling LLM: HTTP " + std::to_string(response->status);
-            error_response.finish_reason = "error";
-            return error_response;
-        }
-
-        auto json = nlohmann::json::parse(response->body, nullptr, false);
-        if (json.is_discarded()) {
-            LLMResponse error_response{};
-            error_response.content = "Error calling LLM: invalid response";
-            error_response.finish_reason = "error";
-            return error_response;
-        }
-
-        LLMResponse parsed_response{};
-        if (use_anthropic) {
-            if (json.contains("content") && json["content"].is_array()) {
-                for (const auto& block : json["content"]) {
-                    const auto type = block.value("type", "");
-                    if (type == "text") {
-                        parsed_response.content += block.value("text", "");
-                    } else if (type == "tool_use") {
-                        ToolCallRequest call{};
-                        call.id = block.value("id", "");
-                        call.name = block.value("name", "");
-                        if (block.contains("input")) {
-                            const auto& input = block["input"];
-                            if (input.is_object()) {
-                                for (const auto& item : input.items()) {
-                                    if (item.value().is_string()) {
-                                        call.arguments[item.key()] = item.value().get<std::string>();
-                                    } else {
-                                        call.arguments[item.key()] = item.value().dump();
-                                    }
-                                }
-                            }
-                        }
-                        parsed_response.tool_calls.push_back(call);
-                    }
-                }
+        auto payload_body = payload.dump();
+        AppendTools(payload_body, tools, use_anthropic, cache_last_tool);
+        // A pooled connection the server has already closed fails on first
+        // use; such a failure is retried once on a freshly opened connection,
+        // but only when the request never reached the server: a completion
+        // request is not idempotent and must not be sent twice.
+        for (int attempt = 1;; ++attempt) {
+            auto client = pool_->Acquire(http_endpoint);
+            if (!client) {
+                LLMResponse error_response{};
+                error_response.content = "Error calling LLM: no connection available for " + scheme_host_port;
+                error_response.finish_reason = "error";
+                return error_response;
             }
-            if (json.contains("stop_reason") && json["stop_reason"].is_string()) {
-                parsed_response.finish_reason = json["stop_reason"].get<std::string>();
-            }
-            if (json.contains("usage")) {
-                const auto& usage = json["usage"];
-                if (usage.contains("input_tokens")) {
-                    parsed_response.usage["prompt_tokens"] = usage["input_tokens"].get<int>();
-                }
-                if (usage.contains("output_tokens")) {
-                    parsed_response.usage["completion_tokens"] = usage["output_tokens"].get<int>();
-                }
-                if (usage.contains("input_tokens") && usage.contains("output_tokens")) {
-                    parsed_response.usage["total_tokens"] =
-                        usage["input_tokens"].get<int>() + usage["output_tokens"].get<int>();
+            if (streaming) {
+                bool stale_connection = false;
+                auto streamed = PostStreaming(client, endpoint, headers, payload_body, use_anthropic, *on_delta, stale_connection);
+                if (stale_connection && attempt < kMaxRequestAttempts) {
+                    LOG_WARN("[llm] pooled connection was closed by peer, retrying host={}", scheme_host_port);
+                    continue;
                 }
+                LogUsage(streamed);
+                return streamed;
             }
-            return parsed_response;
-        }
-
-        if (!json.contains("choices") || json["choices"].empty()) {
-            LLMResponse error_response{};
-            error_response.content = "Error calling LLM: invalid response";
-            error_response.finish_reason = "error";
-            return error_response;
-        }
-
-        const auto& choice = json["choices"][0];
-        const auto& message = choice["message"];
-        if (message.contains("content") && !message["content"].is_null()) {
-            parsed_response.content = message["content"].get<std::string>();
-        }
-
-        if (message.contains("tool_calls")) {
-            for (const auto& tc : message["tool_calls"]) {
-                ToolCallRequest call{};
-                call.id = tc.value("id", "");
-                if (tc.contains("function")) {
-                    call.name = tc["function"].value("name", "");
-                    if (tc["function"].contains("arguments")) {
-                        auto args = tc["function"]["arguments"];
-                        if (args.is_string()) {
-                            auto parsed_args = nlohmann::json::parse(args.get<std::string>(), nullptr, false);
-                            if (parsed_args.is_discarded()) {
-                                call.arguments = ParseArguments(args);
-                            } else {
-                                call.arguments = ParseArguments(parsed_args);
-                            }
-                        } else {
-                            call.arguments = ParseArguments(args);
-                        }
-                    }
+            auto response = client->Post(endpoint.c_str(), headers, payload_body, "application/json");
+            if (!response) {
+                client.MarkBroken();
+                const auto err = response.error();
+                if (client.Reused() && RequestNeverSent(err) && attempt < kMaxRequestAttempts) {
+                    LOG_WARN("[llm] pooled connection was closed by peer, retrying host={}", scheme_host_port);
+                    continue;
                 }
-                parsed_response.tool_calls.push_back(call);
+                const auto err_text = HttpLibErrorToString(err);
+                LOG_ERROR("[llm] request failed: httplib error={}({})",
+                          static_cast<int>(err),
+                          err_text);
+                LLMResponse error_response{};
+                error_response.content = "Error calling LLM: request failed (httplib error=" + std::to_string(static_cast<int>(err)) +
+                    ", " + err_text + ")";
+                error_response.finish_reason = "error";
+                return error_response;
             }
-        }
-
-        if (choice.contains("finish_reason") && !choice["finish_reason"].is_null()) {
-            parsed_response.finish_reason = choice["finish_reason"].get<std::string>();
-        }
-
-        if (json.contains("usage")) {
-            const auto& usage = json["usage"];
-            if (usage.contains("prompt_tokens")) {
-                parsed_response.usage["prompt_tokens"] = usage["prompt_tokens"].get<int>();
-            }
-            if (usage.contains("completion_tokens")) {
-                parsed_response.usage["completion_tokens"] = usage["completion_tokens"].get<int>();
+            if (response->status >= 400) {
+                LOG_ERROR("[llm] request body={}", payload_body);
+                LOG_ERROR("[llm] HTTP {} body={}", response->status, response->body);
+                LLMResponse error_response{};
+                error_response.content = "Error calling LLM: HTTP " + std::to_string(response->status);
+                error_response.finish_reason = "error";
+                return error_response;
             }
-            if (usage.contains("total_tokens")) {
-                parsed_response.usage["total_tokens"] = usage["total_tokens"].get<int>();
+
+            auto json = nlohmann::json::parse(response->body, nullptr, false);
+            if (json.is_discarded()) {
+                LLMResponse error_response{};
+                error_response.content = "Error calling LLM: invalid response";
+                error_response.finish_reason = "error";
+                return error_response;
             }
-        }
 
-        return parsed_response;
+            auto parsed_response = ParseCompletion(json, use_anthropic);
+            LogUsage(parsed_response);
+            return parsed_response;
+        }
     } catch (const std::exception& ex) {
         LLMResponse error_response{};
         error_response.content = std::string("Error calling LLM: ") + ex.what();
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "providers/http_connection_pool.hpp"
 #include "providers/llm_provider.hpp"
 
 namespace kabot::providers {
@@ -14,7 +16,10 @@ public:
                     std::string api_base,
                     std::string default_model,
                     bool use_proxy_for_llm,
-                    std::string user_agent);
+                    std::string user_agent,
+                    HttpPoolOptions pool_options = {},
+                    bool prompt_caching = true);
+    ~LiteLLMProvider() override;
 
     LLMResponse Chat(
         const std::vector<Message>& messages,
@@ -23,6 +28,14 @@ public:
         int max_tokens,
         double temperature) override;
 
+    LLMResponse ChatStream(
+        const std::vector<Message>& messages,
+        const std::vector<ToolDefinition>& tools,
+        const std::string& model,
+        int max_tokens,
+        double temperature,
+        const StreamDeltaCallback& on_delta) override;
+
     std::string GetDefaultModel() const override { return default_model_; }
 
 private:
@@ -33,6 +46,19 @@ private:
     bool is_openrouter_ = false;
     bool is_vllm_ = false;
     bool use_proxy_for_llm_ = false;
+    bool prompt_caching_ = true;
+    // Resolved once from the environment when use_proxy_for_llm is set.
+    std::string proxy_host_;
+    int proxy_port_ = 0;
+    std::unique_ptr<HttpConnectionPool> pool_;
+
+    LLMResponse Complete(
+        const std::vector<Message>& messages,
+        const std::vector<ToolDefinition>& tools,
+        const std::string& model,
+        int max_tokens,
+        double temperature,
+        const StreamDeltaCallback* on_delta);
 
     static std::string NormalizeModel(
         const std::string& model,
@@ -1,9 +1,51 @@
 #include "providers/llm_provider.hpp"
 
+#include <chrono>
+
+#include "nlohmann/json.hpp"
 #include "providers/litellm_provider.hpp"
 
 namespace kabot::providers {
 
+void CompileToolDefinition(ToolDefinition& def) {
+    nlohmann::json params = nlohmann::json::object();
+    if (!def.parameters_json.empty()) {
+        params = nlohmann::json::parse(def.parameters_json, nullptr, false);
+        if (params.is_discarded()) {
+            params = nlohmann::json::object();
+        }
+    }
+    const nlohmann::json openai = {
+        {"type", "function"},
+        {"function", {
+            {"name", def.name},
+            {"description", def.description},
+            {"parameters", params}
+        }}
+    };
+    const nlohmann::json anthropic = {
+        {"name", def.name},
+        {"description", def.description},
+        {"input_schema", params}
+    };
+    def.openai_json = std::make_shared<const std::string>(openai.dump());
+    def.anthropic_json = std::make_shared<const std::string>(anthropic.dump());
+}
+
+LLMResponse LLMProvider::ChatStream(
+    const std::vector<Message>& messages,
+    const std::vector<ToolDefinition>& tools,
+    const std::string& model,
+    int max_tokens,
+    double temperature,
+    const StreamDeltaCallback& on_delta) {
+    auto response = Chat(messages, tools, model, max_tokens, temperature);
+    if (on_delta && response.finish_reason != "error" && !response.content.empty()) {
+        on_delta(response.content);
+    }
+    return response;
+}
+
 ProviderSettings ResolveProviderSettings(const kabot::config::Config& config) {
     ProviderSettings settings{};
     settings.model = config.agents.defaults.model.empty()
@@ -11,6 +53,9 @@ ProviderSettings ResolveProviderSettings(const kabot::config::Config& config) {
         : config.agents.defaults.model;
     settings.use_proxy_for_llm = config.providers.use_proxy_for_llm;
     settings.user_agent = config.providers.user_agent;
+    settings.max_connections_per_host = config.providers.max_connections_per_host;
+    settings.connection_idle_timeout_s = config.providers.connection_idle_timeout_s;
+    settings.prompt_caching = config.providers.prompt_caching;
 
     if (!config.providers.openrouter.api_key.empty()) {
         settings.api_key = config.providers.openrouter.api_key;
@@ -60,12 +105,21 @@ ProviderSettings ResolveProviderSettings(const kabot::config::Config& config) {
 
 std::unique_ptr<LLMProvider> CreateProvider(const kabot::config::Config& config) {
     const auto settings = ResolveProviderSettings(config);
+    HttpPoolOptions pool_options{};
+    if (settings.max_connections_per_host > 0) {
+        pool_options.max_connections_per_host = static_cast<std::size_t>(settings.max_connections_per_host);
+    }
+    if (settings.connection_idle_timeout_s > 0) {
+        pool_options.idle_timeout = std::chrono::seconds(settings.connection_idle_timeout_s);
+    }
     return std::make_unique<LiteLLMProvider>(
         settings.api_key,
         settings.api_base,
         settings.model,
         settings.use_proxy_for_llm,
-        settings.user_agent);
+        settings.user_agent,
+        pool_options,
+        settings.prompt_caching);
 }
 
 }  // namespace kabot::providers
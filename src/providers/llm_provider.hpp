@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -13,12 +15,24 @@ struct ToolDefinition {
     std::string name;
     std::string description;
     std::string parameters_json;
+    // Request-ready JSON for this tool in each wire style, filled in by
+    // CompileToolDefinition. Providers splice these into the payload as-is;
+    // definitions without them are compiled per request.
+    std::shared_ptr<const std::string> openai_json;
+    std::shared_ptr<const std::string> anthropic_json;
 };
 
+// Parses parameters_json once and stores the serialized tool entries.
+void CompileToolDefinition(ToolDefinition& def);
+
 struct ContentPart {
     std::string type;
     std::string text;
     std::string image_url;
+    // Set on the last part of a prompt prefix that stays byte-identical
+    // across requests; providers with explicit prompt caching place a cache
+    // breakpoint after it.
+    bool cache_breakpoint = false;
 };
 
 struct ToolCallRequest {
@@ -36,6 +50,10 @@ struct Message {
     std::vector<ContentPart> content_parts;
     std::unordered_map<std::string, int> usage;
     bool is_virtual = false;
+    // Filled by ContextBuilder::AnnotateTokenCounts. token_count_bytes is the
+    // payload size the count was taken at, so an edited message is recounted.
+    std::size_t token_count = 0;
+    std::size_t token_count_bytes = 0;
 };
 
 struct LLMResponse {
@@ -53,8 +71,14 @@ struct ProviderSettings {
     std::string model;
     bool use_proxy_for_llm = false;
     std::string user_agent = "claude-code/0.2.1";
+    int max_connections_per_host = 8;
+    int connection_idle_timeout_s = 60;
+    bool prompt_caching = true;
 };
 
+// Receives assistant text fragments in generation order.
+using StreamDeltaCallback = std::function<void(const std::string& delta)>;
+
 class LLMProvider {
 public:
     virtual ~LLMProvider() = default;
@@ -64,6 +88,16 @@ public:
         const std::string& model,
         int max_tokens,
         double temperature) = 0;
+    // Same contract as Chat, but forwards text to on_delta as it arrives. The
+    // returned response is complete, including assembled tool calls. The
+    // default implementation delivers the whole reply as a single delta.
+    virtual LLMResponse ChatStream(
+        const std::vector<Message>& messages,
+        const std::vector<ToolDefinition>& tools,
+        const std::string& model,
+        int max_tokens,
+        double temperature,
+        const StreamDeltaCallback& on_delta);
     virtual std::string GetDefaultModel() const = 0;
 };
 
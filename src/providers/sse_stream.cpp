@@ -0,0 +1,318 @@
+#include "providers/sse_stream.hpp"
+
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+namespace kabot::providers {
+namespace {
+
+std::unordered_map<std::string, std::string> ParseArgumentsString(const std::string& raw) {
+    std::unordered_map<std::string, std::string> parsed;
+    if (raw.empty()) {
+        return parsed;
+    }
+    const auto json = nlohmann::json::parse(raw, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        parsed["raw"] = raw;
+        return parsed;
+    }
+    for (const auto& item : json.items()) {
+        if (item.value().is_string()) {
+            parsed[item.key()] = item.value().get<std::string>();
+        } else {
+            parsed[item.key()] = item.value().dump();
+        }
+    }
+    return parsed;
+}
+
+int IntOr(const nlohmann::json& object, const char* key, int fallback) {
+    if (object.is_object() && object.contains(key) && object[key].is_number_integer()) {
+        return object[key].get<int>();
+    }
+    return fallback;
+}
+
+std::string StreamErrorMessage(const nlohmann::json& json) {
+    if (json.contains("error")) {
+        const auto& error = json["error"];
+        if (error.is_object() && error.contains("message") && error["message"].is_string()) {
+            return error["message"].get<std::string>();
+        }
+        return error.dump();
+    }
+    return json.dump();
+}
+
+}  // namespace
+
+void AnthropicUsage::Merge(const nlohmann::json& usage) {
+    input_tokens = IntOr(usage, "input_tokens", input_tokens);
+    output_tokens = IntOr(usage, "output_tokens", output_tokens);
+    cache_read_tokens = IntOr(usage, "cache_read_input_tokens", cache_read_tokens);
+    cache_creation_tokens = IntOr(usage, "cache_creation_input_tokens", cache_creation_tokens);
+}
+
+bool AnthropicUsage::Empty() const {
+    return input_tokens == 0 && output_tokens == 0 && cache_read_tokens == 0 && cache_creation_tokens == 0;
+}
+
+void AnthropicUsage::ApplyTo(std::unordered_map<std::string, int>& usage) const {
+    const int prompt_tokens = input_tokens + cache_read_tokens + cache_creation_tokens;
+    usage["prompt_tokens"] = prompt_tokens;
+    usage["completion_tokens"] = output_tokens;
+    usage["total_tokens"] = prompt_tokens + output_tokens;
+    if (cache_read_tokens > 0) {
+        usage["cache_read_tokens"] = cache_read_tokens;
+    }
+    if (cache_creation_tokens > 0) {
+        usage["cache_creation_tokens"] = cache_creation_tokens;
+    }
+}
+
+void ApplyOpenAIUsage(const nlohmann::json& usage, std::unordered_map<std::string, int>& out) {
+    if (!usage.is_object()) {
+        return;
+    }
+    for (const char* key : {"prompt_tokens", "completion_tokens", "total_tokens"}) {
+        if (usage.contains(key) && usage[key].is_number_integer()) {
+            out[key] = usage[key].get<int>();
+        }
+    }
+    if (usage.contains("prompt_tokens_details")) {
+        const auto cached = IntOr(usage["prompt_tokens_details"], "cached_tokens", 0);
+        if (cached > 0) {
+            out["cache_read_tokens"] = cached;
+        }
+    }
+}
+
+SseParser::SseParser(EventHandler on_event)
+    : on_event_(std::move(on_event)) {}
+
+void SseParser::Feed(const char* data, std::size_t size) {
+    buffer_.append(data, size);
+    std::size_t start = 0;
+    while (true) {
+        const auto newline = buffer_.find('\n', start);
+        if (newline == std::string::npos) {
+            break;
+        }
+        auto line_end = newline;
+        if (line_end > start && buffer_[line_end - 1] == '\r') {
+            line_end -= 1;
+        }
+        ProcessLine(buffer_.substr(start, line_end - start));
+        start = newline + 1;
+    }
+    buffer_.erase(0, start);
+}
+
+void SseParser::Finish() {
+    if (!buffer_.empty()) {
+        auto line = std::move(buffer_);
+        buffer_.clear();
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        ProcessLine(line);
+    }
+    Dispatch();
+}
+
+void SseParser::ProcessLine(const std::string& line) {
+    if (line.empty()) {
+        Dispatch();
+        return;
+    }
+    if (line[0] == ':') {
+        return;
+    }
+    const auto colon = line.find(':');
+    const auto field = line.substr(0, colon);
+    std::string value;
+    if (colon != std::string::npos) {
+        value = line.substr(colon + 1);
+        if (!value.empty() && value[0] == ' ') {
+            value.erase(0, 1);
+        }
+    }
+    if (field == "event") {
+        event_ = value;
+    } else if (field == "data") {
+        if (has_data_) {
+            data_.push_back('\n');
+        }
+        data_.append(value);
+        has_data_ = true;
+    }
+}
+
+void SseParser::Dispatch() {
+    if (has_data_ && on_event_) {
+        on_event_(event_, data_);
+    }
+    event_.clear();
+    data_.clear();
+    has_data_ = false;
+}
+
+std::string OpenAIStreamAssembler::Consume(const std::string& data) {
+    if (data == "[DONE]") {
+        done_ = true;
+        return {};
+    }
+    const auto json = nlohmann::json::parse(data, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        return {};
+    }
+    if (json.contains("error")) {
+        response_.content = "Error calling LLM: " + StreamErrorMessage(json);
+        response_.finish_reason = "error";
+        done_ = true;
+        return {};
+    }
+    if (json.contains("usage")) {
+        ApplyOpenAIUsage(json["usage"], response_.usage);
+    }
+    if (!json.contains("choices") || !json["choices"].is_array() || json["choices"].empty()) {
+        return {};
+    }
+    const auto& choice = json["choices"][0];
+    if (choice.contains("finish_reason") && choice["finish_reason"].is_string()) {
+        response_.finish_reason = choice["finish_reason"].get<std::string>();
+    }
+    if (!choice.contains("delta") || !choice["delta"].is_object()) {
+        return {};
+    }
+    const auto& delta = choice["delta"];
+    std::string text;
+    if (delta.contains("content") && delta["content"].is_string()) {
+        text = delta["content"].get<std::string>();
+        response_.content += text;
+    }
+    if (delta.contains("tool_calls") && delta["tool_calls"].is_array()) {
+        for (const auto& fragment : delta["tool_calls"]) {
+            const auto index = IntOr(fragment, "index", static_cast<int>(tool_calls_.size()));
+            auto& pending = tool_calls_[index];
+            if (fragment.contains("id") && fragment["id"].is_string()) {
+                pending.id = fragment["id"].get<std::string>();
+            }
+            if (fragment.contains("function") && fragment["function"].is_object()) {
+                const auto& function = fragment["function"];
+                if (function.contains("name") && function["name"].is_string()) {
+                    pending.name += function["name"].get<std::string>();
+                }
+                if (function.contains("arguments") && function["arguments"].is_string()) {
+                    pending.arguments += function["arguments"].get<std::string>();
+                }
+            }
+        }
+    }
+    return text;
+}
+
+LLMResponse OpenAIStreamAssembler::Finish() {
+    for (auto& [index, pending] : tool_calls_) {
+        ToolCallRequest call{};
+        call.id = std::move(pending.id);
+        call.name = std::move(pending.name);
+        call.arguments = ParseArgumentsString(pending.arguments);
+        response_.tool_calls.push_back(std::move(call));
+    }
+    tool_calls_.clear();
+    return std::move(response_);
+}
+
+std::string AnthropicStreamAssembler::Consume(const std::string& event, const std::string& data) {
+    const auto json = nlohmann::json::parse(data, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        return {};
+    }
+    const auto type = event.empty() ? json.value("type", "") : event;
+    if (type == "message_start") {
+        if (json.contains("message") && json["message"].is_object()) {
+            const auto& message = json["message"];
+            if (message.contains("usage")) {
+                usage_.Merge(message["usage"]);
+            }
+        }
+        return {};
+    }
+    if (type == "content_block_start") {
+        const auto index = IntOr(json, "index", static_cast<int>(blocks_.size()));
+        auto& block = blocks_[index];
+        if (json.contains("content_block") && json["content_block"].is_object()) {
+            const auto& content_block = json["content_block"];
+            block.type = content_block.value("type", "");
+            block.id = content_block.value("id", "");
+            block.name = content_block.value("name", "");
+            if (block.type == "text" && content_block.contains("text") && content_block["text"].is_string()) {
+                const auto text = content_block["text"].get<std::string>();
+                response_.content += text;
+                return text;
+            }
+        }
+        return {};
+    }
+    if (type == "content_block_delta") {
+        const auto index = IntOr(json, "index", 0);
+        if (!json.contains("delta") || !json["delta"].is_object()) {
+            return {};
+        }
+        const auto& delta = json["delta"];
+        const auto delta_type = delta.value("type", "");
+        if (delta_type == "text_delta" && delta.contains("text") && delta["text"].is_string()) {
+            const auto text = delta["text"].get<std::string>();
+            response_.content += text;
+            return text;
+        }
+        if (delta_type == "input_json_delta" && delta.contains("partial_json") && delta["partial_json"].is_string()) {
+            blocks_[index].partial_json += delta["partial_json"].get<std::string>();
+        }
+        return {};
+    }
+    if (type == "message_delta") {
+        if (json.contains("delta") && json["delta"].is_object()) {
+            const auto& delta = json["delta"];
+            if (delta.contains("stop_reason") && delta["stop_reason"].is_string()) {
+                response_.finish_reason = delta["stop_reason"].get<std::string>();
+            }
+        }
+        if (json.contains("usage")) {
+            usage_.Merge(json["usage"]);
+        }
+        return {};
+    }
+    if (type == "message_stop") {
+        done_ = true;
+        return {};
+    }
+    if (type == "error") {
+        response_.content = "Error calling LLM: " + StreamErrorMessage(json);
+        response_.finish_reason = "error";
+        done_ = true;
+    }
+    return {};
+}
+
+LLMResponse AnthropicStreamAssembler::Finish() {
+    for (auto& [index, block] : blocks_) {
+        if (block.type != "tool_use") {
+            continue;
+        }
+        ToolCallRequest call{};
+        call.id = std::move(block.id);
+        call.name = std::move(block.name);
+        call.arguments = ParseArgumentsString(block.partial_json);
+        response_.tool_calls.push_back(std::move(call));
+    }
+    blocks_.clear();
+    if (!usage_.Empty()) {
+        usage_.ApplyTo(response_.usage);
+    }
+    return std::move(response_);
+}
+
+}  // namespace kabot::providers
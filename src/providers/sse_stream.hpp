@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "nlohmann/json.hpp"
+#include "providers/llm_provider.hpp"
+
+namespace kabot::providers {
+
+// Incremental text/event-stream parser. Bytes can arrive split anywhere; every
+// complete event (terminated by a blank line) is handed to the callback with
+// its event name and the joined data lines.
+class SseParser {
+public:
+    using EventHandler = std::function<void(const std::string& event, const std::string& data)>;
+
+    explicit SseParser(EventHandler on_event);
+
+    void Feed(const char* data, std::size_t size);
+    // Flushes a trailing event that was not followed by a blank line.
+    void Finish();
+
+private:
+    EventHandler on_event_;
+    std::string buffer_;
+    std::string event_;
+    std::string data_;
+    bool has_data_ = false;
+
+    void ProcessLine(const std::string& line);
+    void Dispatch();
+};
+
+// Usage counters reported by Anthropic-style APIs. input_tokens there excludes
+// prompt tokens read from or written to the prompt cache, so prompt_tokens
+// adds them back to stay comparable with OpenAI-style usage; the cached
+// shares are reported as cache_read_tokens / cache_creation_tokens.
+struct AnthropicUsage {
+    int input_tokens = 0;
+    int output_tokens = 0;
+    int cache_read_tokens = 0;
+    int cache_creation_tokens = 0;
+
+    // Later events only carry the counters that changed.
+    void Merge(const nlohmann::json& usage);
+    bool Empty() const;
+    void ApplyTo(std::unordered_map<std::string, int>& usage) const;
+};
+
+// Copies OpenAI-style usage counters, including
+// prompt_tokens_details.cached_tokens as cache_read_tokens.
+void ApplyOpenAIUsage(const nlohmann::json& usage, std::unordered_map<std::string, int>& out);
+
+// Folds OpenAI-style chat.completion.chunk payloads into an LLMResponse.
+// Tool call fragments are keyed by their stream index and their argument
+// strings are concatenated until the stream ends.
+class OpenAIStreamAssembler {
+public:
+    // Returns the assistant text contained in this chunk, if any.
+    std::string Consume(const std::string& data);
+    bool Done() const { return done_; }
+    LLMResponse Finish();
+
+private:
+    struct PendingToolCall {
+        std::string id;
+        std::string name;
+        std::string arguments;
+    };
+
+    LLMResponse response_;
+    std::map<int, PendingToolCall> tool_calls_;
+    bool done_ = false;
+};
+
+// Folds Anthropic /messages stream events into an LLMResponse, assembling
+// tool_use input from input_json_delta fragments per content block.
+class AnthropicStreamAssembler {
+public:
+    std::string Consume(const std::string& event, const std::string& data);
+    bool Done() const { return done_; }
+    LLMResponse Finish();
+
+private:
+    struct PendingBlock {
+        std::string type;
+        std::string id;
+        std::string name;
+        std::string partial_json;
+    };
+
+    LLMResponse response_;
+    std::map<int, PendingBlock> blocks_;
+    AnthropicUsage usage_;
+    bool done_ = false;
+};
+
+}  // namespace kabot::providers
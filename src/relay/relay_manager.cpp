@@ -6,17 +6,26 @@
 #include <condition_variable>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iomanip>
 #include <optional>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include <boost/asio/connect.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/ip/address.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/beast/core.hpp>
@@ -28,7 +37,9 @@
 #include <openssl/ssl.h>
 
 #include "nlohmann/json.hpp"
+#include "utils/cancel_token.hpp"
 #include "utils/logging.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace kabot::relay {
 namespace {
@@ -277,158 +288,180 @@ std::string DescribeHandshakeResponse(const Response& response) {
     return oss.str();
 }
 
+// A relay websocket driven entirely by async operations on the owning
+// worker's strand. Handlers get an empty error string on success.
 class IWebSocketSession {
 public:
+    using Handler = std::function<void(const std::string& error)>;
+    using ReadHandler = std::function<void(const std::string& error, std::string text)>;
+
     virtual ~IWebSocketSession() = default;
-    virtual void Connect() = 0;
+    virtual void AsyncConnect(Handler handler) = 0;
+    virtual void AsyncRead(ReadHandler handler) = 0;
+    // At most one write may be outstanding; the session keeps payload alive.
+    virtual void AsyncWrite(std::string payload, Handler handler) = 0;
+    // Sends a close frame when the connection is idle enough to allow it,
+    // and drops the socket either way shortly after.
     virtual void Close() = 0;
-    virtual void WriteText(const std::string& payload) = 0;
-    virtual std::string ReadText() = 0;
 };
 
-class PlainWebSocketSession final : public IWebSocketSession {
+template <bool Tls>
+class WebSocketSession final : public IWebSocketSession,
+                               public std::enable_shared_from_this<WebSocketSession<Tls>> {
 public:
-    explicit PlainWebSocketSession(const kabot::config::RelayManagedAgentConfig& config)
-        : config_(config)
-        , resolver_(ioc_)
-        , ws_(ioc_) {}
-
-    void Connect() override {
-        const auto port = std::to_string(config_.port);
-        tcp::resolver::results_type endpoints;
-        try {
-            endpoints = resolver_.resolve(config_.host, port);
-        } catch (const std::exception& ex) {
-            throw std::runtime_error(std::string("resolve failed: ") + ex.what());
-        }
-
-        tcp::endpoint endpoint;
-        try {
-            endpoint = net::connect(ws_.next_layer(), endpoints);
-        } catch (const std::exception& ex) {
-            throw std::runtime_error(std::string("tcp connect failed: ") + ex.what());
-        }
-
-        auto host = config_.host + ":" + std::to_string(endpoint.port());
-        ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
-        ws_.set_option(websocket::stream_base::decorator([](websocket::request_type& req) {
-            req.set(http::field::user_agent, "kabot-relay/1.0");
-        }));
+    using Executor = net::strand<net::io_context::executor_type>;
+    using NextLayer = std::conditional_t<Tls, beast::ssl_stream<beast::tcp_stream>, beast::tcp_stream>;
 
-        http::response<http::string_body> response;
-        beast::error_code ec;
-        ws_.handshake(response, host, BuildTarget(config_), ec);
-        if (ec) {
-            throw std::runtime_error(std::string("websocket handshake failed: ")
-                                     + ec.message() + " (" + DescribeHandshakeResponse(response) + ")");
-        }
-        ws_.text(true);
-    }
-
-    void Close() override {
-        beast::error_code ec;
-        ws_.close(websocket::close_code::normal, ec);
+    WebSocketSession(const kabot::config::RelayManagedAgentConfig& config,
+                     Executor executor,
+                     ssl::context& ssl_ctx)
+        : config_(config)
+        , resolver_(executor)
+        , close_timer_(executor)
+        , ws_(MakeStream(executor, ssl_ctx)) {}
+
+    void AsyncConnect(Handler handler) override {
+        auto self = this->shared_from_this();
+        resolver_.async_resolve(
+            config_.host,
+            std::to_string(config_.port),
+            [self, handler](beast::error_code ec, tcp::resolver::results_type endpoints) {
+                if (ec) {
+                    handler("resolve failed: " + ec.message());
+                    return;
+                }
+                beast::get_lowest_layer(self->ws_).expires_after(std::chrono::seconds(30));
+                beast::get_lowest_layer(self->ws_).async_connect(
+                    endpoints,
+                    [self, handler](beast::error_code ec, const tcp::endpoint& endpoint) {
+                        if (ec) {
+                            handler("tcp connect failed: " + ec.message());
+                            return;
+                        }
+                        self->host_ = self->config_.host + ":" + std::to_string(endpoint.port());
+                        self->SecureHandshake(handler);
+                    });
+            });
+    }
+
+    void AsyncRead(ReadHandler handler) override {
+        auto self = this->shared_from_this();
+        ws_.async_read(read_buffer_, [self, handler](beast::error_code ec, std::size_t) {
+            if (ec) {
+                handler(ec.message(), {});
+                return;
+            }
+            auto text = beast::buffers_to_string(self->read_buffer_.data());
+            self->read_buffer_.consume(self->read_buffer_.size());
+            handler({}, std::move(text));
+        });
     }
 
-    void WriteText(const std::string& payload) override {
-        ws_.write(net::buffer(payload));
+    void AsyncWrite(std::string payload, Handler handler) override {
+        auto self = this->shared_from_this();
+        auto buffer = std::make_shared<std::string>(std::move(payload));
+        writing_ = true;
+        ws_.async_write(net::buffer(*buffer), [self, buffer, handler](beast::error_code ec, std::size_t) {
+            self->writing_ = false;
+            handler(ec ? ec.message() : std::string());
+        });
     }
 
-    std::string ReadText() override {
-        beast::flat_buffer buffer;
-        ws_.read(buffer);
-        return beast::buffers_to_string(buffer.data());
+    void Close() override {
+        resolver_.cancel();
+        if (!open_ || writing_) {
+            Shutdown();
+            return;
+        }
+        open_ = false;
+        auto self = this->shared_from_this();
+        close_timer_.expires_after(std::chrono::seconds(1));
+        close_timer_.async_wait([self](beast::error_code ec) {
+            if (!ec) {
+                self->Shutdown();
+            }
+        });
+        ws_.async_close(websocket::close_code::normal, [self](beast::error_code) {
+            self->Shutdown();
+        });
     }
 
 private:
-    kabot::config::RelayManagedAgentConfig config_;
-    net::io_context ioc_;
-    tcp::resolver resolver_;
-    websocket::stream<tcp::socket> ws_;
-};
-
-class TlsWebSocketSession final : public IWebSocketSession {
-public:
-    explicit TlsWebSocketSession(const kabot::config::RelayManagedAgentConfig& config)
-        : config_(config)
-        , resolver_(ioc_)
-        , ssl_ctx_(ssl::context::tls_client)
-        , ws_(ioc_, ssl_ctx_) {
-        ssl_ctx_.set_default_verify_paths();
-        ssl_ctx_.set_verify_mode(config_.skip_tls_verify ? ssl::verify_none : ssl::verify_peer);
-    }
-
-    void Connect() override {
-        const auto port = std::to_string(config_.port);
-        tcp::resolver::results_type endpoints;
-        try {
-            endpoints = resolver_.resolve(config_.host, port);
-        } catch (const std::exception& ex) {
-            throw std::runtime_error(std::string("resolve failed: ") + ex.what());
-        }
-
-        tcp::endpoint endpoint;
-        try {
-            endpoint = beast::get_lowest_layer(ws_).connect(endpoints);
-        } catch (const std::exception& ex) {
-            throw std::runtime_error(std::string("tcp connect failed: ") + ex.what());
+    static websocket::stream<NextLayer> MakeStream(Executor executor, ssl::context& ssl_ctx) {
+        if constexpr (Tls) {
+            return websocket::stream<NextLayer>(executor, ssl_ctx);
+        } else {
+            (void)ssl_ctx;
+            return websocket::stream<NextLayer>(executor);
         }
+    }
 
-        auto host = config_.host + ":" + std::to_string(endpoint.port());
-        if (!IsIpLiteral(config_.host)) {
-            if (!SSL_set_tlsext_host_name(ws_.next_layer().native_handle(), config_.host.c_str())) {
-                throw std::runtime_error("failed to set TLS SNI host");
+    void SecureHandshake(Handler handler) {
+        if constexpr (Tls) {
+            if (!IsIpLiteral(config_.host)) {
+                if (!SSL_set_tlsext_host_name(ws_.next_layer().native_handle(), config_.host.c_str())) {
+                    handler("failed to set TLS SNI host");
+                    return;
+                }
             }
+            auto self = this->shared_from_this();
+            ws_.next_layer().async_handshake(ssl::stream_base::client, [self, handler](beast::error_code ec) {
+                if (ec) {
+                    handler("tls handshake failed: " + ec.message());
+                    return;
+                }
+                self->WebSocketHandshake(handler);
+            });
+        } else {
+            WebSocketHandshake(std::move(handler));
         }
+    }
+
+    void WebSocketHandshake(Handler handler) {
+        // The websocket layer manages its own timeouts from here on.
+        beast::get_lowest_layer(ws_).expires_never();
         ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
         ws_.set_option(websocket::stream_base::decorator([](websocket::request_type& req) {
             req.set(http::field::user_agent, "kabot-relay/1.0");
         }));
-        try {
-            ws_.next_layer().handshake(ssl::stream_base::client);
-        } catch (const std::exception& ex) {
-            throw std::runtime_error(std::string("tls handshake failed: ") + ex.what());
-        }
-
-        http::response<http::string_body> response;
-        beast::error_code ec;
-        ws_.handshake(response, host, BuildTarget(config_), ec);
-        if (ec) {
-            throw std::runtime_error(std::string("websocket handshake failed: ")
-                                     + ec.message() + " (" + DescribeHandshakeResponse(response) + ")");
-        }
-        ws_.text(true);
+        auto self = this->shared_from_this();
+        ws_.async_handshake(response_, host_, BuildTarget(config_), [self, handler](beast::error_code ec) {
+            if (ec) {
+                handler("websocket handshake failed: " + ec.message()
+                        + " (" + DescribeHandshakeResponse(self->response_) + ")");
+                return;
+            }
+            self->ws_.text(true);
+            self->open_ = true;
+            handler({});
+        });
     }
 
-    void Close() override {
+    void Shutdown() {
+        close_timer_.cancel();
         beast::error_code ec;
-        ws_.close(websocket::close_code::normal, ec);
-        ws_.next_layer().shutdown(ec);
+        beast::get_lowest_layer(ws_).socket().shutdown(tcp::socket::shutdown_both, ec);
+        beast::get_lowest_layer(ws_).socket().close(ec);
     }
 
-    void WriteText(const std::string& payload) override {
-        ws_.write(net::buffer(payload));
-    }
-
-    std::string ReadText() override {
-        beast::flat_buffer buffer;
-        ws_.read(buffer);
-        return beast::buffers_to_string(buffer.data());
-    }
-
-private:
     kabot::config::RelayManagedAgentConfig config_;
-    net::io_context ioc_;
     tcp::resolver resolver_;
-    ssl::context ssl_ctx_;
-    websocket::stream<beast::ssl_stream<beast::tcp_stream>> ws_;
+    net::steady_timer close_timer_;
+    websocket::stream<NextLayer> ws_;
+    beast::flat_buffer read_buffer_;
+    http::response<http::string_body> response_;
+    std::string host_;
+    bool open_ = false;
+    bool writing_ = false;
 };
 
-std::shared_ptr<IWebSocketSession> CreateSession(const kabot::config::RelayManagedAgentConfig& config) {
+std::shared_ptr<IWebSocketSession> CreateSession(const kabot::config::RelayManagedAgentConfig& config,
+                                                 net::strand<net::io_context::executor_type> executor,
+                                                 ssl::context& ssl_ctx) {
     if (config.scheme == "wss" || config.use_tls) {
-        return std::make_shared<TlsWebSocketSession>(config);
+        return std::make_shared<WebSocketSession<true>>(config, executor, ssl_ctx);
     }
-    return std::make_shared<PlainWebSocketSession>(config);
+    return std::make_shared<WebSocketSession<false>>(config, executor, ssl_ctx);
 }
 
 class IRelayHttpSession {
@@ -440,9 +473,10 @@ public:
 
 class PlainRelayHttpSession final : public IRelayHttpSession {
 public:
-    explicit PlainRelayHttpSession(const kabot::config::RelayManagedAgentConfig& config)
+    PlainRelayHttpSession(const kabot::config::RelayManagedAgentConfig& config, net::io_context& ioc)
         : config_(config)
-        , resolver_(ioc_) {}
+        , resolver_(ioc)
+        , stream_(ioc) {}
 
     http::response<http::string_body> DoRequest(http::request<http::string_body> request) override {
         request.set(http::field::connection, "keep-alive");
@@ -482,17 +516,17 @@ private:
     }
 
     kabot::config::RelayManagedAgentConfig config_;
-    net::io_context ioc_;
     tcp::resolver resolver_;
-    beast::tcp_stream stream_{ioc_};
+    beast::tcp_stream stream_;
     bool connected_ = false;
 };
 
 class TlsRelayHttpSession final : public IRelayHttpSession {
 public:
-    explicit TlsRelayHttpSession(const kabot::config::RelayManagedAgentConfig& config)
+    TlsRelayHttpSession(const kabot::config::RelayManagedAgentConfig& config, net::io_context& ioc)
         : config_(config)
-        , resolver_(ioc_)
+        , ioc_(ioc)
+        , resolver_(ioc)
         , ssl_ctx_(ssl::context::tls_client) {
         ssl_ctx_.set_default_verify_paths();
         ssl_ctx_.set_verify_mode(config_.skip_tls_verify ? ssl::verify_none : ssl::verify_peer);
@@ -546,18 +580,21 @@ private:
     }
 
     kabot::config::RelayManagedAgentConfig config_;
-    net::io_context ioc_;
+    net::io_context& ioc_;
     tcp::resolver resolver_;
     ssl::context ssl_ctx_;
     std::unique_ptr<beast::ssl_stream<beast::tcp_stream>> stream_;
     bool connected_ = false;
 };
 
-std::unique_ptr<IRelayHttpSession> CreateHttpSession(const kabot::config::RelayManagedAgentConfig& config) {
+// HTTP calls stay synchronous for their callers; the sessions only borrow the
+// relay's io_context so no worker owns a context of its own.
+std::unique_ptr<IRelayHttpSession> CreateHttpSession(const kabot::config::RelayManagedAgentConfig& config,
+                                                     net::io_context& ioc) {
     if (config.use_tls || config.scheme == "wss") {
-        return std::make_unique<TlsRelayHttpSession>(config);
+        return std::make_unique<TlsRelayHttpSession>(config, ioc);
     }
-    return std::make_unique<PlainRelayHttpSession>(config);
+    return std::make_unique<PlainRelayHttpSession>(config, ioc);
 }
 
 Json BuildActivityPayload(const std::string& status,
@@ -711,43 +748,87 @@ http::request<http::string_body> BuildTaskStatusRequest(
 
 }  // namespace
 
-class RelayManager::Worker {
+// All connection state of a worker lives on its strand of the shared relay
+// io_context: connects, reads, the write queue, the heartbeat and the
+// reconnect backoff are async operations and timers rather than threads.
+// Only relay commands run elsewhere, on the relay's shared command pool, with
+// at most max_concurrent_commands of this worker's commands running at once.
+class RelayManager::Worker : public std::enable_shared_from_this<RelayManager::Worker> {
 public:
     Worker(kabot::config::RelayManagedAgentConfig config,
-           kabot::agent::AgentRegistry& agents)
+           kabot::agent::AgentRegistry& agents,
+           net::io_context& ioc,
+           std::function<void()> on_task_available)
         : config_(std::move(config))
-        , agents_(agents) {}
-
-    ~Worker() {
-        Stop();
+        , agents_(agents)
+        , on_task_available_(std::move(on_task_available))
+        , ioc_(ioc)
+        , strand_(net::make_strand(ioc))
+        , ssl_ctx_(ssl::context::tls_client)
+        , heartbeat_timer_(strand_)
+        , reconnect_timer_(strand_) {
+        ssl_ctx_.set_default_verify_paths();
+        ssl_ctx_.set_verify_mode(config_.skip_tls_verify ? ssl::verify_none : ssl::verify_peer);
     }
 
     const kabot::config::RelayManagedAgentConfig& Config() const {
         return config_;
     }
 
-    void Start() {
+    void Start(kabot::ThreadPool& command_pool) {
         if (running_ || !config_.enabled) {
             return;
         }
         running_ = true;
-        StartOutboundWriter();
-        worker_ = std::thread([this] { Run(); });
+        {
+            std::lock_guard<std::mutex> guard(commands_mutex_);
+            command_pool_ = &command_pool;
+        }
+        net::post(strand_, [self = shared_from_this()] {
+            self->reconnect_delay_ms_ = std::max(100, self->config_.reconnect_initial_delay_ms);
+            self->Connect();
+        });
     }
 
-    void Stop() {
-        running_ = false;
-        StopHeartbeat();
-        StopOutboundWriter();
-        reconnect_cv_.notify_all();
-        CloseSession();
-        if (worker_.joinable()) {
-            worker_.join();
+    // Closes the connection on the strand while the event loop serves it.
+    // When the loop is not running nothing else can touch the strand state,
+    // so the close then runs inline; whichever path claims it first does it.
+    // Commands already running see their token cancelled and only report back.
+    void Stop(bool loop_running) {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        CancelCommands();
+        auto claimed = std::make_shared<std::atomic<bool>>(false);
+        auto stopped = std::make_shared<std::promise<void>>();
+        auto done = stopped->get_future();
+        auto close = [self = shared_from_this(), claimed, stopped] {
+            if (claimed->exchange(true)) {
+                return;
+            }
+            self->heartbeat_timer_.cancel();
+            self->reconnect_timer_.cancel();
+            self->CloseSession();
+            stopped->set_value();
+        };
+        if (loop_running) {
+            net::post(strand_, close);
+        }
+        while (done.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready) {
+            if (!loop_running || ioc_.stopped()) {
+                close();
+            }
         }
     }
 
     http::response<http::string_body> DoHttpRequest(http::request<http::string_body> request) const {
-        return HttpSession()->DoRequest(std::move(request));
+        // Commands on the pool, claims and status updates share one
+        // keep-alive connection; requests on it run one at a time.
+        std::lock_guard<std::mutex> lock(http_mutex_);
+        if (!http_session_) {
+            http_session_ = CreateHttpSession(config_, ioc_);
+        }
+        return http_session_->DoRequest(std::move(request));
     }
 
     void ReportInboundPhase(kabot::agent::DirectExecutionPhase phase) {
@@ -799,7 +880,7 @@ public:
             const auto request = BuildDailySummaryRequest(
                 config_, trimmed_date, trimmed_content,
                 trimmed_reported_at.empty() ? IsoNow() : trimmed_reported_at);
-            const auto response = HttpSession()->DoRequest(request);
+            const auto response = DoHttpRequest(request);
             const auto success = response.result_int() >= 200 && response.result_int() < 300;
             std::string message;
             if (!success) {
@@ -822,7 +903,7 @@ public:
 
         try {
             const auto request = BuildClaimNextTaskRequest(config_, supports_interaction);
-            const auto response = HttpSession()->DoRequest(request);
+            const auto response = DoHttpRequest(request);
             const auto http_status = static_cast<int>(response.result_int());
             if (http_status < 200 || http_status >= 300) {
                 return {false, false, http_status,
@@ -864,7 +945,7 @@ public:
 
         try {
             const auto request = BuildTaskStatusRequest(config_, trimmed_task_id, update);
-            const auto response = HttpSession()->DoRequest(request);
+            const auto response = DoHttpRequest(request);
             const auto success = response.result_int() >= 200 && response.result_int() < 300;
             std::string message;
             if (!success) {
@@ -881,75 +962,95 @@ public:
     }
 
 private:
-    IRelayHttpSession* HttpSession() const {
-        if (!http_session_) {
-            http_session_ = CreateHttpSession(config_);
-        }
-        return http_session_.get();
-    }
+    struct PendingCommand {
+        std::string command_id;
+        std::string payload;
+        std::shared_ptr<kabot::CancelToken> cancel_token;
+    };
 
-    void Run() {
-        auto reconnect_delay_ms = std::max(100, config_.reconnect_initial_delay_ms);
-        while (running_) {
-            try {
-                Connect();
-                reconnect_delay_ms = std::max(100, config_.reconnect_initial_delay_ms);
-                ReadLoop();
-            } catch (const std::exception& ex) {
-                LOG_WARN("[relay] worker={} connection loop failed: {}", config_.name, ex.what());
-            } catch (...) {
-                LOG_WARN("[relay] worker={} connection loop failed", config_.name);
+    void Connect() {
+        if (!running_) {
+            return;
+        }
+        auto session = CreateSession(config_, strand_, ssl_ctx_);
+        session_ = session;
+        session->AsyncConnect([self = shared_from_this(), session](const std::string& error) {
+            if (!self->running_ || session != self->session_) {
+                return;
             }
-
-            StopHeartbeat();
-            CloseSession();
-            if (!running_) {
-                break;
+            if (!error.empty()) {
+                LOG_WARN("[relay] worker={} connection loop failed: {}", self->config_.name, error);
+                self->ScheduleReconnect();
+                return;
             }
-            LOG_INFO("[relay] worker={} reconnecting in {} ms", config_.name, reconnect_delay_ms);
-            std::unique_lock<std::mutex> reconnect_lock(reconnect_mutex_);
-            reconnect_cv_.wait_for(
-                reconnect_lock,
-                std::chrono::milliseconds(reconnect_delay_ms),
-                [this] { return !running_; });
-            reconnect_delay_ms = std::min(config_.reconnect_max_delay_ms,
-                                          reconnect_delay_ms * 2);
-        }
+            LOG_INFO("[relay] worker={} connected to {}:{}{}",
+                     self->config_.name,
+                     self->config_.host,
+                     self->config_.port,
+                     self->config_.path);
+            self->connected_ = true;
+            self->reconnect_delay_ms_ = std::max(100, self->config_.reconnect_initial_delay_ms);
+            self->Write(DumpJson(BuildActivityPayload("idle", "Connected and idle")));
+            self->ArmHeartbeat();
+            self->Read();
+            // task.available notices sent while disconnected were missed;
+            // let the claim loop look for work now.
+            self->on_task_available_();
+        });
     }
 
-    void Connect() {
-        auto session = CreateSession(config_);
-        session->Connect();
-        {
-            std::lock_guard<std::mutex> guard(session_mutex_);
-            session_ = std::move(session);
-        }
-        LOG_INFO("[relay] worker={} connected to {}:{}{}",
-                 config_.name,
-                 config_.host,
-                 config_.port,
-                 config_.path);
-        SendJson(BuildActivityPayload("idle", "Connected and idle"));
-        StartHeartbeat();
-    }
-
-    void ReadLoop() {
-        while (running_) {
-            const auto text = ReadText();
-            if (text.empty()) {
-                continue;
+    void Read() {
+        session_->AsyncRead([self = shared_from_this(), session = session_](const std::string& error,
+                                                                             std::string text) {
+            if (!self->running_ || session != self->session_) {
+                return;
             }
-            auto json = Json::parse(text, nullptr, false);
-            if (json.is_discarded() || !json.is_object()) {
-                LOG_WARN("[relay] worker={} ignored invalid message", config_.name);
-                continue;
+            if (!error.empty()) {
+                LOG_WARN("[relay] worker={} connection loop failed: {}", self->config_.name, error);
+                self->ScheduleReconnect();
+                return;
+            }
+            if (!text.empty()) {
+                auto json = Json::parse(text, nullptr, false);
+                if (json.is_discarded() || !json.is_object()) {
+                    LOG_WARN("[relay] worker={} ignored invalid message", self->config_.name);
+                } else {
+                    self->HandleMessage(json);
+                }
             }
-            HandleMessage(json);
+            self->Read();
+        });
+    }
+
+    void ScheduleReconnect() {
+        heartbeat_timer_.cancel();
+        CloseSession();
+        if (!running_) {
+            return;
         }
+        LOG_INFO("[relay] worker={} reconnecting in {} ms", config_.name, reconnect_delay_ms_);
+        reconnect_timer_.expires_after(std::chrono::milliseconds(reconnect_delay_ms_));
+        reconnect_timer_.async_wait([self = shared_from_this()](beast::error_code ec) {
+            if (!ec) {
+                self->Connect();
+            }
+        });
+        reconnect_delay_ms_ = std::min(config_.reconnect_max_delay_ms, reconnect_delay_ms_ * 2);
     }
 
     void HandleMessage(const Json& json) {
         const auto type = json.value("type", std::string());
+        if (type == "command.cancel") {
+            HandleCancel(json);
+            return;
+        }
+        if (type == "task.available") {
+            const auto agent_id = json.value("agentId", std::string());
+            if (agent_id.empty() || agent_id == config_.agent_id) {
+                on_task_available_();
+            }
+            return;
+        }
         if (type != "command.dispatch") {
             LOG_DEBUG("[relay] worker={} ignored message type={}", config_.name, type);
             return;
@@ -957,7 +1058,7 @@ private:
 
         const auto command_id = json.value("commandId", std::string());
         const auto agent_id = json.value("agentId", std::string());
-        const auto payload = json.value("payload", std::string());
+        auto payload = json.value("payload", std::string());
         if (command_id.empty()) {
             LOG_WARN("[relay] worker={} received dispatch without commandId", config_.name);
             return;
@@ -967,15 +1068,76 @@ private:
             return;
         }
 
-        SendJson(BuildAckPayload(command_id));
-        SendJson(BuildActivityPayload("busy", "Executing relay command", command_id));
-        SendJson(BuildResultPayload(command_id, "running", std::string(), std::string(), 0));
+        auto cancel_token = std::make_shared<kabot::CancelToken>();
+        {
+            std::lock_guard<std::mutex> guard(commands_mutex_);
+            if (command_pool_ == nullptr) {
+                LOG_WARN("[relay] worker={} ignored dispatch while stopping commandId={}", config_.name, command_id);
+                return;
+            }
+            if (commands_.count(command_id) > 0) {
+                LOG_WARN("[relay] worker={} ignored duplicate dispatch commandId={}", config_.name, command_id);
+                return;
+            }
+            const auto capacity = static_cast<std::size_t>(
+                std::max(1, config_.max_concurrent_commands) + std::max(0, config_.max_queued_commands));
+            if (commands_.size() >= capacity) {
+                LOG_WARN("[relay] worker={} rejected dispatch commandId={} active={}",
+                         config_.name,
+                         command_id,
+                         commands_.size());
+                EnqueueJson(BuildResultPayload(command_id, "failed", "error", "relay worker is busy"));
+                return;
+            }
+            commands_.emplace(command_id, cancel_token);
+            EnqueueJson(BuildAckPayload(command_id));
+            PendingCommand command{command_id, std::move(payload), cancel_token};
+            if (running_commands_ < static_cast<std::size_t>(std::max(1, config_.max_concurrent_commands))) {
+                running_commands_ += 1;
+                SubmitLocked(std::move(command));
+            } else {
+                queued_commands_.push_back(std::move(command));
+            }
+        }
+    }
+
+    // The pool reference is taken under commands_mutex_ so a command
+    // finishing during Stop never submits to a pool that is shutting down.
+    void SubmitLocked(PendingCommand command) {
+        command_pool_->Submit([self = shared_from_this(), command = std::move(command)] {
+            self->RunCommand(command.command_id, command.payload, *command.cancel_token);
+        });
+    }
+
+    void HandleCancel(const Json& json) {
+        const auto command_id = json.value("commandId", std::string());
+        std::lock_guard<std::mutex> guard(commands_mutex_);
+        auto it = commands_.find(command_id);
+        if (it == commands_.end()) {
+            LOG_DEBUG("[relay] worker={} cancel for unknown commandId={}", config_.name, command_id);
+            return;
+        }
+        LOG_INFO("[relay] worker={} cancelling commandId={}", config_.name, command_id);
+        it->second->Cancel();
+    }
+
+    // Runs on the command pool; everything it reports goes through the
+    // outbound writer so a dropped connection cannot throw into the pool.
+    void RunCommand(const std::string& command_id,
+                    const std::string& payload,
+                    const kabot::CancelToken& cancel_token) {
+        if (cancel_token.IsCancelled()) {
+            EnqueueJson(BuildResultPayload(command_id, "failed", "error", "command cancelled"));
+            FinishCommand(command_id);
+            return;
+        }
+        EnqueueJson(BuildActivityPayload("busy", "Executing relay command", command_id));
+        EnqueueJson(BuildResultPayload(command_id, "running", std::string(), std::string(), 0));
 
         try {
             const auto observer = [this, &command_id](kabot::agent::DirectExecutionPhase phase) {
-                SendJson(BuildActivityPayload("busy", PhaseActivitySummary(phase), command_id));
+                EnqueueJson(BuildActivityPayload("busy", PhaseActivitySummary(phase), command_id));
             };
-            kabot::CancelToken cancel_token{};
             const auto result = agents_.ProcessDirect(config_.local_agent,
                                                       payload,
                                                       BuildSessionKey(config_, command_id),
@@ -983,178 +1145,208 @@ private:
                                                       {},
                                                       {},
                                                       cancel_token);
-            SendJson(BuildResultPayload(command_id, "completed", "result", result, 100));
-            SendJson(BuildActivityPayload("idle", "Idle"));
+            if (cancel_token.IsCancelled()) {
+                EnqueueJson(BuildResultPayload(command_id, "failed", "error", "command cancelled"));
+            } else {
+                EnqueueJson(BuildResultPayload(command_id, "completed", "result", result, 100));
+            }
         } catch (const std::exception& ex) {
-            SendJson(BuildResultPayload(command_id, "failed", "error", ex.what()));
-            SendJson(BuildActivityPayload("error", ex.what(), command_id));
+            EnqueueJson(BuildResultPayload(command_id, "failed", "error", ex.what()));
+            EnqueueJson(BuildActivityPayload("error", ex.what(), command_id));
         } catch (...) {
-            SendJson(BuildResultPayload(command_id, "failed", "error", "unknown relay execution error"));
-            SendJson(BuildActivityPayload("error", "unknown relay execution error", command_id));
+            EnqueueJson(BuildResultPayload(command_id, "failed", "error", "unknown relay execution error"));
+            EnqueueJson(BuildActivityPayload("error", "unknown relay execution error", command_id));
+        }
+        FinishCommand(command_id);
+    }
+
+    void FinishCommand(const std::string& command_id) {
+        std::lock_guard<std::mutex> guard(commands_mutex_);
+        commands_.erase(command_id);
+        if (!queued_commands_.empty()) {
+            auto next = std::move(queued_commands_.front());
+            queued_commands_.pop_front();
+            SubmitLocked(std::move(next));
+        } else if (running_commands_ > 0) {
+            running_commands_ -= 1;
+        }
+        if (commands_.empty()) {
+            EnqueueJson(BuildActivityPayload("idle", "Idle"));
         }
     }
 
-    void StartHeartbeat() {
-        StopHeartbeat();
-        {
-            std::lock_guard<std::mutex> guard(heartbeat_mutex_);
-            heartbeat_running_ = true;
-        }
-        heartbeat_thread_ = std::thread([this] {
-            std::unique_lock<std::mutex> lock(heartbeat_mutex_);
-            while (heartbeat_running_ && running_) {
-                if (heartbeat_cv_.wait_for(
-                        lock,
-                        std::chrono::seconds(config_.heartbeat_interval_s),
-                        [this] { return !heartbeat_running_ || !running_; })) {
-                    break;
-                }
-                lock.unlock();
-                try {
-                    SendJson(Json{{"type", "heartbeat"}});
-                } catch (const std::exception& ex) {
-                    LOG_WARN("[relay] worker={} heartbeat failed: {}", config_.name, ex.what());
-                    break;
-                } catch (...) {
-                    LOG_WARN("[relay] worker={} heartbeat failed", config_.name);
-                    break;
-                }
-                lock.lock();
-            }
-        });
-    }
-
-    void StopHeartbeat() {
-        {
-            std::lock_guard<std::mutex> guard(heartbeat_mutex_);
-            heartbeat_running_ = false;
+    // Queued commands that never started are dropped; running ones are
+    // cancelled and finish on the pool.
+    void CancelCommands() {
+        std::lock_guard<std::mutex> guard(commands_mutex_);
+        for (const auto& command : queued_commands_) {
+            LOG_INFO("[relay] worker={} dropped queued commandId={} on stop", config_.name, command.command_id);
+            commands_.erase(command.command_id);
         }
-        heartbeat_cv_.notify_all();
-        if (heartbeat_thread_.joinable()) {
-            heartbeat_thread_.join();
+        queued_commands_.clear();
+        command_pool_ = nullptr;
+        for (auto& [_, cancel_token] : commands_) {
+            cancel_token->Cancel();
         }
     }
 
-    void StartOutboundWriter() {
-        StopOutboundWriter();
-        {
-            std::lock_guard<std::mutex> guard(outbound_writer_mutex_);
-            outbound_writer_running_ = true;
-        }
-        outbound_writer_thread_ = std::thread([this] {
-            std::unique_lock<std::mutex> lock(outbound_writer_mutex_);
-            while (outbound_writer_running_) {
-                outbound_writer_cv_.wait(lock, [this] {
-                    return !outbound_writer_running_ || !outbound_queue_.empty();
-                });
-                if (!outbound_writer_running_) {
-                    break;
-                }
-                std::queue<Json> local;
-                local.swap(outbound_queue_);
-                lock.unlock();
-                while (!local.empty()) {
-                    try {
-                        SendJson(local.front());
-                    } catch (const std::exception& ex) {
-                        LOG_WARN("[relay] worker={} outbound write failed: {}", config_.name, ex.what());
-                    } catch (...) {
-                        LOG_WARN("[relay] worker={} outbound write failed", config_.name);
-                    }
-                    local.pop();
-                }
-                lock.lock();
+    void ArmHeartbeat() {
+        heartbeat_timer_.expires_after(std::chrono::seconds(config_.heartbeat_interval_s));
+        heartbeat_timer_.async_wait([self = shared_from_this(), session = session_](beast::error_code ec) {
+            if (ec || !self->running_ || session != self->session_) {
+                return;
             }
+            self->Write(DumpJson(Json{{"type", "heartbeat"}}));
+            self->ArmHeartbeat();
         });
     }
 
-    void StopOutboundWriter() {
-        {
-            std::lock_guard<std::mutex> guard(outbound_writer_mutex_);
-            outbound_writer_running_ = false;
+    // Safe from any thread; the payload is written in order on the strand.
+    void EnqueueJson(const Json& payload) {
+        net::post(strand_, [self = shared_from_this(), text = DumpJson(payload)]() mutable {
+            self->Write(std::move(text));
+        });
+    }
+
+    void Write(std::string text) {
+        if (!running_ || !connected_) {
+            LOG_DEBUG("[relay] worker={} dropped outbound message while disconnected", config_.name);
+            return;
         }
-        outbound_writer_cv_.notify_all();
-        if (outbound_writer_thread_.joinable()) {
-            outbound_writer_thread_.join();
+        write_queue_.push_back(std::move(text));
+        if (!writing_) {
+            WriteNext();
         }
     }
 
-    void EnqueueJson(const Json& payload) {
-        {
-            std::lock_guard<std::mutex> guard(outbound_writer_mutex_);
-            if (!outbound_writer_running_) {
+    void WriteNext() {
+        writing_ = true;
+        auto text = std::move(write_queue_.front());
+        write_queue_.pop_front();
+        session_->AsyncWrite(std::move(text), [self = shared_from_this(), session = session_](const std::string& error) {
+            if (session != self->session_) {
+                return;
+            }
+            self->writing_ = false;
+            if (!error.empty()) {
+                LOG_WARN("[relay] worker={} outbound write failed: {}", self->config_.name, error);
+                self->ScheduleReconnect();
                 return;
             }
-            outbound_queue_.push(payload);
+            if (!self->write_queue_.empty()) {
+                self->WriteNext();
+            }
+        });
+    }
+
+    void CloseSession() {
+        connected_ = false;
+        writing_ = false;
+        write_queue_.clear();
+        if (session_) {
+            session_->Close();
+            session_.reset();
         }
-        outbound_writer_cv_.notify_one();
     }
 
-    void SendJson(const Json& payload) {
-        SendText(payload.dump());
+    static std::string DumpJson(const Json& payload) {
+        return payload.dump(-1, ' ', false, Json::error_handler_t::replace);
     }
 
-    void SendText(const std::string& payload) {
-        auto session = GetSession();
-        if (!session) {
-            throw std::runtime_error("relay websocket session is not connected");
-        }
-        std::lock_guard<std::mutex> guard(write_mutex_);
-        session->WriteText(payload);
+    kabot::config::RelayManagedAgentConfig config_;
+    kabot::agent::AgentRegistry& agents_;
+    std::function<void()> on_task_available_;
+    net::io_context& ioc_;
+    net::strand<net::io_context::executor_type> strand_;
+    ssl::context ssl_ctx_;
+    std::atomic<bool> running_{false};
+    mutable std::mutex http_mutex_;
+    mutable std::unique_ptr<IRelayHttpSession> http_session_;  // guarded by http_mutex_
+    // Strand-only state.
+    std::shared_ptr<IWebSocketSession> session_;
+    bool connected_ = false;
+    bool writing_ = false;
+    std::deque<std::string> write_queue_;
+    net::steady_timer heartbeat_timer_;
+    net::steady_timer reconnect_timer_;
+    int reconnect_delay_ms_ = 0;
+    std::mutex commands_mutex_;
+    kabot::ThreadPool* command_pool_ = nullptr;
+    std::unordered_map<std::string, std::shared_ptr<kabot::CancelToken>> commands_;
+    std::size_t running_commands_ = 0;
+    std::deque<PendingCommand> queued_commands_;
+};
+
+// The io_context every worker's connection runs on, served by a fixed set of
+// threads regardless of how many agents are managed.
+class RelayManager::EventLoop {
+public:
+    explicit EventLoop(std::size_t threads)
+        : thread_count_(std::max<std::size_t>(1, threads)) {}
+
+    ~EventLoop() {
+        Stop();
     }
 
-    std::string ReadText() {
-        auto session = GetSession();
-        if (!session) {
-            throw std::runtime_error("relay websocket session is not connected");
+    net::io_context& Context() {
+        return ioc_;
+    }
+
+    void Start() {
+        if (!threads_.empty()) {
+            return;
+        }
+        ioc_.restart();
+        work_.emplace(net::make_work_guard(ioc_));
+        for (std::size_t i = 0; i < thread_count_; ++i) {
+            threads_.emplace_back([this] {
+                for (;;) {
+                    try {
+                        ioc_.run();
+                        return;
+                    } catch (const std::exception& ex) {
+                        LOG_ERROR("[relay] event loop handler failed: {}", ex.what());
+                    } catch (...) {
+                        LOG_ERROR("[relay] event loop handler failed");
+                    }
+                }
+            });
         }
-        return session->ReadText();
     }
 
-    std::shared_ptr<IWebSocketSession> GetSession() {
-        std::lock_guard<std::mutex> guard(session_mutex_);
-        return session_;
+    // Lets in-flight closes finish, then joins the threads.
+    bool Running() const {
+        return !threads_.empty() && !ioc_.stopped();
     }
 
-    void CloseSession() {
-        std::shared_ptr<IWebSocketSession> session;
-        {
-            std::lock_guard<std::mutex> guard(session_mutex_);
-            session = std::move(session_);
-        }
-        if (session) {
-            std::lock_guard<std::mutex> guard(write_mutex_);
-            session->Close();
+    void Stop() {
+        work_.reset();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) {
+                thread.join();
+            }
         }
+        threads_.clear();
     }
 
-    kabot::config::RelayManagedAgentConfig config_;
-    kabot::agent::AgentRegistry& agents_;
-    std::atomic<bool> running_{false};
-    std::atomic<bool> heartbeat_running_{false};
-    std::thread worker_;
-    std::thread heartbeat_thread_;
-    std::mutex heartbeat_mutex_;
-    std::condition_variable heartbeat_cv_;
-    std::mutex reconnect_mutex_;
-    std::condition_variable reconnect_cv_;
-    std::mutex session_mutex_;
-    std::mutex write_mutex_;
-    std::shared_ptr<IWebSocketSession> session_;
-    mutable std::unique_ptr<IRelayHttpSession> http_session_;
-    std::queue<Json> outbound_queue_;
-    std::mutex outbound_writer_mutex_;
-    std::condition_variable outbound_writer_cv_;
-    std::thread outbound_writer_thread_;
-    bool outbound_writer_running_ = false;
+private:
+    std::size_t thread_count_;
+    net::io_context ioc_;
+    std::optional<net::executor_work_guard<net::io_context::executor_type>> work_;
+    std::vector<std::thread> threads_;
 };
 
 RelayManager::RelayManager(const kabot::config::Config& config,
                            kabot::agent::AgentRegistry& agents)
     : config_(config)
-    , agents_(agents) {
+    , agents_(agents)
+    , loop_(std::make_unique<EventLoop>(static_cast<std::size_t>(std::max(1, config_.relay.io_threads)))) {
     for (const auto& relay_agent : config_.relay.managed_agents) {
-        workers_.push_back(std::make_unique<Worker>(relay_agent, agents_));
+        workers_.push_back(std::make_shared<Worker>(
+            relay_agent,
+            agents_,
+            loop_->Context(),
+            [this, local_agent = relay_agent.local_agent] { NotifyTaskAvailable(local_agent); }));
         if (!relay_agent.local_agent.empty()) {
             workers_by_local_agent_[relay_agent.local_agent] = workers_.back().get();
         }
@@ -1185,8 +1377,16 @@ void RelayManager::Start() {
         return;
     }
     running_ = true;
+    loop_->Start();
+    std::size_t command_threads = 0;
+    for (const auto& worker : workers_) {
+        if (worker->Config().enabled) {
+            command_threads += static_cast<std::size_t>(std::max(1, worker->Config().max_concurrent_commands));
+        }
+    }
+    command_pool_ = std::make_unique<kabot::ThreadPool>(std::max<std::size_t>(1, command_threads));
     for (auto& worker : workers_) {
-        worker->Start();
+        worker->Start(*command_pool_);
     }
 }
 
@@ -1195,8 +1395,30 @@ void RelayManager::Stop() {
         return;
     }
     running_ = false;
+    const bool loop_running = loop_->Running();
     for (auto& worker : workers_) {
-        worker->Stop();
+        worker->Stop(loop_running);
+    }
+    if (command_pool_) {
+        // Waits for running commands; their tokens are already cancelled.
+        command_pool_->Shutdown();
+        command_pool_.reset();
+    }
+    loop_->Stop();
+}
+
+void RelayManager::SetTaskAvailableHandler(TaskAvailableHandler handler) {
+    std::lock_guard<std::mutex> guard(task_available_mutex_);
+    task_available_handler_ = std::move(handler);
+}
+
+void RelayManager::NotifyTaskAvailable(const std::string& local_agent) {
+    if (local_agent.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(task_available_mutex_);
+    if (task_available_handler_) {
+        task_available_handler_(local_agent);
     }
 }
 
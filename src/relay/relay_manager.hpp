@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -11,6 +12,7 @@
 
 #include "agent/agent_registry.hpp"
 #include "config/config_schema.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace kabot::relay {
 
@@ -122,6 +124,9 @@ struct RelayProjectQueryResult {
 
 class RelayManager {
 public:
+    // Called with the local agent when the relay announces claimable work.
+    using TaskAvailableHandler = std::function<void(const std::string& local_agent)>;
+
     RelayManager(const kabot::config::Config& config,
                  kabot::agent::AgentRegistry& agents);
     ~RelayManager();
@@ -143,15 +148,25 @@ public:
     RelayTaskSubmissionResult SubmitProjectTask(const std::string& project_id,
                                                  const RelayTaskCreate& task);
     RelayProjectQueryResult QueryProject(const std::string& project_id);
+    void SetTaskAvailableHandler(TaskAvailableHandler handler);
 
 private:
+    class EventLoop;
     class Worker;
 
     kabot::config::Config config_;
     kabot::agent::AgentRegistry& agents_;
-    std::vector<std::unique_ptr<Worker>> workers_;
+    std::unique_ptr<EventLoop> loop_;
+    // Relay commands of every worker run here; each worker caps its own
+    // share at max_concurrent_commands.
+    std::unique_ptr<kabot::ThreadPool> command_pool_;
+    std::vector<std::shared_ptr<Worker>> workers_;
     std::unordered_map<std::string, Worker*> workers_by_local_agent_;
     std::atomic<bool> running_{false};
+    std::mutex task_available_mutex_;
+    TaskAvailableHandler task_available_handler_;
+
+    void NotifyTaskAvailable(const std::string& local_agent);
 };
 
 }  // namespace kabot::relay
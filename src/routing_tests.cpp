@@ -1,15 +1,23 @@
 #include "agent/agent_loop.hpp"
 #include "agent/agent_registry.hpp"
+#include "agent/subagent/subagent_runner.hpp"
 #include "agent/tools/cron.hpp"
+#include "agent/tools/message.hpp"
 #include "agent/tools/plan_work.hpp"
+#include "agent/tools/tool_context.hpp"
 #include "cron/cron_service.hpp"
 #include "relay/relay_manager.hpp"
 #include "task/task_runtime.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <filesystem>
+#include <future>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -65,6 +73,32 @@ private:
     std::vector<kabot::providers::LLMResponse> responses_;
 };
 
+class RendezvousProvider : public kabot::providers::LLMProvider {
+public:
+    kabot::providers::LLMResponse Chat(const std::vector<kabot::providers::Message>&,
+                                       const std::vector<kabot::providers::ToolDefinition>&,
+                                       const std::string&,
+                                       int,
+                                       double) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++arrived_;
+        cv_.notify_all();
+        const bool met = cv_.wait_for(lock, std::chrono::seconds(3), [this] { return arrived_ >= 2; });
+        kabot::providers::LLMResponse response{};
+        response.content = met ? "parallel" : "serialized";
+        return response;
+    }
+
+    std::string GetDefaultModel() const override {
+        return "stub-model";
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int arrived_ = 0;
+};
+
 class PlanWorkStubProvider : public kabot::providers::LLMProvider {
 public:
     kabot::providers::LLMResponse Chat(
@@ -376,6 +410,167 @@ void TestProcessDirectEmitsObservedOutboundMessage() {
     Expect(result == "Done", "expected ProcessDirect to continue after tool call and return final result");
 }
 
+void TestProcessDirectRunsDifferentSessionsConcurrently() {
+    kabot::bus::MessageBus bus;
+    RendezvousProvider provider;
+    kabot::config::AgentDefaults agent_config{};
+    agent_config.tool_profile = "message_only";
+    agent_config.workspace = (std::filesystem::temp_directory_path() / "kabot_process_direct_concurrency").string();
+    kabot::config::QmdConfig qmd{};
+
+    kabot::agent::AgentLoop agent_loop(
+        bus,
+        provider,
+        agent_config.workspace,
+        agent_config,
+        qmd,
+        {},
+        nullptr);
+
+    std::string first;
+    std::string second;
+    std::thread first_thread([&] {
+        first = agent_loop.ProcessDirect("hello", "task:concurrency:1");
+    });
+    std::thread second_thread([&] {
+        second = agent_loop.ProcessDirect("hello", "task:concurrency:2");
+    });
+    first_thread.join();
+    second_thread.join();
+
+    Expect(first == "parallel" && second == "parallel",
+           "expected turns for different sessions to run concurrently");
+}
+
+void TestRegistryDispatchesDifferentChatsConcurrently() {
+    kabot::bus::MessageBus bus;
+    RendezvousProvider provider;
+    auto config = BuildConfig();
+    config.agents.dispatch_workers = 4;
+    kabot::agent::AgentRegistry registry(bus, provider, config, nullptr);
+    registry.Start();
+
+    // Pick two chats that are guaranteed to land on different shards.
+    const auto shard_of = [](const std::string& chat) {
+        return std::hash<std::string>{}("lark_sales:sales-agent:" + chat) % 4;
+    };
+    std::vector<std::string> chats{"chat-0"};
+    for (int i = 1; chats.size() < 2; ++i) {
+        const auto candidate = "chat-" + std::to_string(i);
+        if (shard_of(candidate) != shard_of(chats.front())) {
+            chats.push_back(candidate);
+        }
+    }
+    for (const auto& chat : chats) {
+        kabot::bus::InboundMessage msg{};
+        msg.channel = "lark";
+        msg.channel_instance = "lark_sales";
+        msg.chat_id = chat;
+        msg.content = "hello";
+        bus.PublishInbound(msg);
+    }
+
+    std::vector<std::string> replies;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (replies.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+        kabot::bus::OutboundMessage outbound{};
+        if (bus.TryConsumeOutbound(outbound, std::chrono::milliseconds(100)) && !outbound.content.empty()) {
+            replies.push_back(outbound.content);
+        }
+    }
+    registry.Stop();
+    const auto stats = registry.DispatchStats();
+
+    Expect(replies.size() == 2, "expected both inbound messages to be answered");
+    Expect(replies[0] == "parallel" && replies[1] == "parallel",
+           "expected different chats to be dispatched to workers concurrently");
+    Expect(stats.size() == 4, "expected one stats entry per dispatch shard");
+    std::uint64_t processed = 0;
+    for (const auto& shard : stats) {
+        processed += shard.processed;
+    }
+    Expect(processed == 2, "expected shard stats to count processed messages");
+}
+
+void TestSendMessageToolUsesPerTurnContext() {
+    std::vector<kabot::bus::OutboundMessage> sent;
+    kabot::agent::tools::SendMessageTool tool([&](const kabot::bus::OutboundMessage& msg) {
+        sent.push_back(msg);
+    });
+    tool.SetContext("telegram", "default-chat");
+
+    std::unordered_map<std::string, std::string> params;
+    params["content"] = "hello";
+    {
+        kabot::agent::tools::ToolInvocationContext context{};
+        context.channel = "lark";
+        context.channel_instance = "lark_sales";
+        context.chat_id = "scoped-chat";
+        kabot::agent::tools::ToolContextScope scope(std::move(context));
+        tool.Execute(params);
+    }
+    tool.Execute(params);
+
+    Expect(sent.size() == 2, "expected both send_message calls to be delivered");
+    Expect(sent[0].channel_instance == "lark_sales" && sent[0].chat_id == "scoped-chat",
+           "expected send_message to target the scoped turn context");
+    Expect(sent[1].channel == "telegram" && sent[1].chat_id == "default-chat",
+           "expected send_message to fall back to SetContext outside a turn");
+}
+
+void TestSubagentThreadInheritsInvocationContext() {
+    std::mutex sent_mutex;
+    std::vector<kabot::bus::OutboundMessage> sent;
+    kabot::agent::tools::ToolRegistry tools;
+    tools.Register(std::make_unique<kabot::agent::tools::SendMessageTool>(
+        [&](const kabot::bus::OutboundMessage& msg) {
+            std::lock_guard<std::mutex> lock(sent_mutex);
+            sent.push_back(msg);
+        }));
+
+    kabot::providers::LLMResponse tool_turn{};
+    tool_turn.tool_calls.push_back({"call-1", "send_message", {{"content", "from subagent"}}});
+    kabot::providers::LLMResponse final_turn{};
+    final_turn.content = "done";
+    SequenceProvider provider({tool_turn, final_turn});
+
+    const auto workspace = std::filesystem::temp_directory_path() / "kabot_routing_tests_subagent";
+    std::filesystem::remove_all(workspace);
+    kabot::subagent::SubagentTaskManager task_manager;
+    kabot::subagent::SubagentTranscriptStore transcripts(workspace.string());
+    kabot::subagent::SubagentRunner runner(
+        provider, tools, task_manager, transcripts, workspace.string(), kabot::config::AgentDefaults{});
+    std::promise<void> finished;
+    runner.SetTaskCompletionHandler([&](const kabot::subagent::AgentTaskRecord&) {
+        finished.set_value();
+    });
+
+    kabot::subagent::RunAgentParams params;
+    params.agent_definition.agent_type = "general-purpose";
+    params.tool_use_context.agent_id = "agent-ctx";
+    params.is_async = true;
+    params.max_turns = 4;
+    auto observed = std::make_shared<std::atomic<bool>>(false);
+    {
+        kabot::agent::tools::ToolInvocationContext context{};
+        context.outbound_observer = [observed](const kabot::bus::OutboundMessage&) { observed->store(true); };
+        context.channel = "lark";
+        context.channel_instance = "lark_sales";
+        context.chat_id = "parent-chat";
+        kabot::agent::tools::ToolContextScope scope(std::move(context));
+        runner.RunAsync(params);
+    }
+    const auto status = finished.get_future().wait_for(std::chrono::seconds(5));
+    std::filesystem::remove_all(workspace);
+
+    Expect(status == std::future_status::ready, "expected async subagent to finish");
+    std::lock_guard<std::mutex> lock(sent_mutex);
+    Expect(sent.size() == 1, "expected subagent send_message to be delivered");
+    Expect(sent[0].channel_instance == "lark_sales" && sent[0].chat_id == "parent-chat",
+           "expected subagent thread to inherit the parent turn context");
+    Expect(!observed->load(), "expected async subagent not to call the parent turn's outbound observer");
+}
+
 void TestTaskRuntimeRecordsAndResumesWaitingTask() {
     kabot::bus::MessageBus bus;
 
@@ -622,6 +817,10 @@ int main() {
     TestCronToolCapturesAgentChannelAndToContext();
     TestMessageOnlyToolProfileRegistersOnlySendMessageTool();
     TestProcessDirectEmitsObservedOutboundMessage();
+    TestProcessDirectRunsDifferentSessionsConcurrently();
+    TestRegistryDispatchesDifferentChatsConcurrently();
+    TestSendMessageToolUsesPerTurnContext();
+    TestSubagentThreadInheritsInvocationContext();
     TestTaskRuntimeRecordsAndResumesWaitingTask();
     TestTaskRuntimeDoesNotRecordCompletedReplyAsWaiting();
     TestTaskRuntimeClearsWaitingTaskOnNonWaitingReply();
@@ -0,0 +1,85 @@
+#include "sandbox/output_capture.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace kabot::sandbox {
+
+BoundedOutput::BoundedOutput(std::size_t max_bytes)
+    : head_capacity_(max_bytes / 2)
+    , ring_(max_bytes - max_bytes / 2) {}
+
+void BoundedOutput::Append(const char* data, std::size_t size) {
+    total_ += size;
+    const auto to_head = std::min(size, head_capacity_ - head_.size());
+    head_.append(data, to_head);
+    data += to_head;
+    size -= to_head;
+    const auto capacity = ring_.size();
+    if (size == 0 || capacity == 0) {
+        return;
+    }
+    if (size >= capacity) {
+        data += size - capacity;
+        size = capacity;
+        ring_start_ = 0;
+        ring_size_ = 0;
+    }
+    while (size > 0) {
+        const auto end = (ring_start_ + ring_size_) % capacity;
+        const auto n = std::min(size, capacity - end);
+        std::copy(data, data + n, ring_.begin() + static_cast<std::ptrdiff_t>(end));
+        ring_size_ += n;
+        if (ring_size_ > capacity) {
+            ring_start_ = (ring_start_ + ring_size_ - capacity) % capacity;
+            ring_size_ = capacity;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+std::string BoundedOutput::Take() const {
+    std::string text = head_;
+    if (Truncated()) {
+        text += "\n... [" + std::to_string(total_ - head_.size() - ring_size_) + " bytes truncated] ...\n";
+    }
+    const auto capacity = ring_.size();
+    for (std::size_t i = 0; i < ring_size_; ++i) {
+        text.push_back(ring_[(ring_start_ + i) % capacity]);
+    }
+    return text;
+}
+
+LineSplitter::LineSplitter(LineCallback callback, bool is_stderr)
+    : callback_(std::move(callback))
+    , is_stderr_(is_stderr) {}
+
+void LineSplitter::Append(const char* data, std::size_t size) {
+    if (!callback_) {
+        return;
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+        if (data[i] == '\n') {
+            Flush();
+        } else {
+            pending_.push_back(data[i]);
+            if (pending_.size() >= kMaxPendingLine) {
+                Flush();
+            }
+        }
+    }
+}
+
+void LineSplitter::Finish() {
+    if (callback_ && !pending_.empty()) {
+        Flush();
+    }
+}
+
+void LineSplitter::Flush() {
+    callback_(pending_, is_stderr_);
+    pending_.clear();
+}
+
+}  // namespace kabot::sandbox
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kabot::sandbox {
+
+// Called with each line (without its newline) as the command produces it.
+using LineCallback = std::function<void(const std::string& line, bool is_stderr)>;
+
+// Keeps the first half of the cap verbatim and the most recent bytes in a
+// ring, so a runaway command costs bounded memory but its final error
+// lines still survive.
+class BoundedOutput {
+public:
+    explicit BoundedOutput(std::size_t max_bytes);
+
+    void Append(const char* data, std::size_t size);
+    bool Truncated() const { return total_ > head_.size() + ring_size_; }
+    std::string Take() const;
+
+private:
+    std::size_t head_capacity_;
+    std::string head_;
+    std::vector<char> ring_;
+    std::size_t ring_start_ = 0;
+    std::size_t ring_size_ = 0;
+    std::size_t total_ = 0;
+};
+
+// Splits one stream into lines for a LineCallback. Overlong lines are
+// flushed in pieces so the pending buffer stays bounded too.
+class LineSplitter {
+public:
+    LineSplitter(LineCallback callback, bool is_stderr);
+
+    void Append(const char* data, std::size_t size);
+    void Finish();
+
+private:
+    static constexpr std::size_t kMaxPendingLine = 64 * 1024;
+
+    void Flush();
+
+    LineCallback callback_;
+    bool is_stderr_;
+    std::string pending_;
+};
+
+struct StreamCapture {
+    StreamCapture(std::size_t max_bytes, LineCallback on_line, bool is_stderr)
+        : buffer(max_bytes)
+        , lines(std::move(on_line), is_stderr) {}
+
+    void Append(const char* data, std::size_t size) {
+        buffer.Append(data, size);
+        lines.Append(data, size);
+    }
+
+    BoundedOutput buffer;
+    LineSplitter lines;
+};
+
+}  // namespace kabot::sandbox
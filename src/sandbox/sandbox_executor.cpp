@@ -1,5 +1,6 @@
 #include "sandbox/sandbox_executor.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <array>
@@ -7,7 +8,6 @@
 #include <fstream>
 #include <string>
 #include <sstream>
-#include <thread>
 #include <vector>
 #ifdef _WIN32
 #include <windows.h>
@@ -16,7 +16,9 @@
 #include <cerrno>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
 #include <signal.h>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #endif
@@ -63,20 +65,30 @@ bool IsBlockedCommand(const std::string& command) {
     return false;
 }
 
+void FinishCapture(StreamCapture& out, StreamCapture& err, ExecResult& result) {
+    out.lines.Finish();
+    err.lines.Finish();
+    result.output = out.buffer.Take();
+    result.error = err.buffer.Take();
+    result.truncated = out.buffer.Truncated() || err.buffer.Truncated();
+}
+
+#ifdef _WIN32
 std::string BuildTempLogPath(const char* prefix, const char* suffix) {
     const auto stamp = std::to_string(
         std::chrono::steady_clock::now().time_since_epoch().count());
     return (std::filesystem::temp_directory_path() / (std::string(prefix) + stamp + suffix)).string();
 }
 
-void ReadFileToString(const std::filesystem::path& path, std::string& target) {
+void ReadFileInto(const std::filesystem::path& path, StreamCapture& capture) {
     std::ifstream input(path, std::ios::binary);
     if (!input.is_open()) {
         return;
     }
-    std::ostringstream stream;
-    stream << input.rdbuf();
-    target = stream.str();
+    std::array<char, 8192> buffer{};
+    while (input.read(buffer.data(), buffer.size()) || input.gcount() > 0) {
+        capture.Append(buffer.data(), static_cast<std::size_t>(input.gcount()));
+    }
 }
 
 void CleanupLogFiles(const std::filesystem::path& stdout_path,
@@ -88,16 +100,78 @@ void CleanupLogFiles(const std::filesystem::path& stdout_path,
 
 void PopulateCapturedOutput(const std::filesystem::path& stdout_path,
                             const std::filesystem::path& stderr_path,
+                            const ExecOptions& options,
                             ExecResult& result) {
-    ReadFileToString(stdout_path, result.output);
-    ReadFileToString(stderr_path, result.error);
+    StreamCapture out(options.max_output_bytes, options.on_line, false);
+    StreamCapture err(options.max_output_bytes, options.on_line, true);
+    ReadFileInto(stdout_path, out);
+    ReadFileInto(stderr_path, err);
+    FinishCapture(out, err, result);
+}
+#else
+void SetNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+int OpenPidFd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// Reads whatever the pipe holds right now. Closes it on EOF or error.
+void DrainPipe(int& fd, StreamCapture& capture) {
+    std::array<char, 16384> buffer{};
+    while (fd >= 0) {
+        const auto n = ::read(fd, buffer.data(), buffer.size());
+        if (n > 0) {
+            capture.Append(buffer.data(), static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+int ExitCodeFromStatus(int status) {
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return -1;
 }
+#endif
 
 } // namespace
 
+bool SandboxExecutor::IsBlocked(const std::string& command) {
+    return IsBlockedCommand(command);
+}
+
 ExecResult SandboxExecutor::Run(const std::string& command,
                                 const std::string& working_dir,
                                 std::chrono::seconds timeout) {
+    return Run(command, working_dir, timeout, ExecOptions{});
+}
+
+ExecResult SandboxExecutor::Run(const std::string& command,
+                                const std::string& working_dir,
+                                std::chrono::seconds timeout,
+                                const ExecOptions& options) {
     ExecResult result{};
     if (IsBlockedCommand(command)) {
         result.exit_code = kBlockedExitCode;
@@ -106,10 +180,10 @@ ExecResult SandboxExecutor::Run(const std::string& command,
         return result;
     }
 
+#ifdef _WIN32
     const auto stdout_path = std::filesystem::path(BuildTempLogPath("kabot_stdout_", ".log"));
     const auto stderr_path = std::filesystem::path(BuildTempLogPath("kabot_stderr_", ".log"));
 
-#ifdef _WIN32
     SECURITY_ATTRIBUTES sa{};
     sa.nLength = sizeof(sa);
     sa.lpSecurityDescriptor = nullptr;
@@ -200,7 +274,7 @@ ExecResult SandboxExecutor::Run(const std::string& command,
     ::CloseHandle(process_info.hThread);
     ::CloseHandle(process_info.hProcess);
 
-    PopulateCapturedOutput(stdout_path, stderr_path, result);
+    PopulateCapturedOutput(stdout_path, stderr_path, options, result);
     CleanupLogFiles(stdout_path, stderr_path);
     if (result.timed_out && result.exit_code == 0) {
         result.exit_code = kTimedOutExitCode;
@@ -218,41 +292,39 @@ ExecResult SandboxExecutor::Run(const std::string& command,
         "no_proxy"
     };
 
-    const int stdout_fd = ::open(stdout_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
-    if (stdout_fd < 0) {
-        result.exit_code = -1;
-        result.error = std::string("Error: failed to open stdout log: ") + std::strerror(errno);
-        return result;
-    }
-
-    const int stderr_fd = ::open(stderr_path.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
-    if (stderr_fd < 0) {
+    int stdout_pipe[2] = {-1, -1};
+    int stderr_pipe[2] = {-1, -1};
+    if (::pipe2(stdout_pipe, O_CLOEXEC) != 0 || ::pipe2(stderr_pipe, O_CLOEXEC) != 0) {
         const int saved_errno = errno;
-        ::close(stdout_fd);
-        std::error_code ec;
-        std::filesystem::remove(stdout_path, ec);
+        for (const int fd : {stdout_pipe[0], stdout_pipe[1], stderr_pipe[0], stderr_pipe[1]}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
         result.exit_code = -1;
-        result.error = std::string("Error: failed to open stderr log: ") + std::strerror(saved_errno);
+        result.error = std::string("Error: failed to create pipes: ") + std::strerror(saved_errno);
         return result;
     }
 
     const pid_t pid = ::fork();
     if (pid < 0) {
         const int saved_errno = errno;
-        ::close(stdout_fd);
-        ::close(stderr_fd);
-        std::error_code ec;
-        std::filesystem::remove(stdout_path, ec);
-        std::filesystem::remove(stderr_path, ec);
+        ::close(stdout_pipe[0]);
+        ::close(stdout_pipe[1]);
+        ::close(stderr_pipe[0]);
+        ::close(stderr_pipe[1]);
         result.exit_code = -1;
         result.error = std::string("Error: exec failed: ") + std::strerror(saved_errno);
         return result;
     }
 
     if (pid == 0) {
+        // Own process group, so a timeout also takes down anything the
+        // command spawned.
+        ::setpgid(0, 0);
         if (!working_dir.empty() && ::chdir(working_dir.c_str()) != 0) {
             const auto message = std::string("Error: failed to change directory: ") + std::strerror(errno) + "\n";
-            ::write(stderr_fd, message.c_str(), message.size());
+            ::write(stderr_pipe[1], message.c_str(), message.size());
             _exit(125);
         }
 
@@ -262,15 +334,12 @@ ExecResult SandboxExecutor::Run(const std::string& command,
             }
         }
 
-        if (::dup2(stdout_fd, STDOUT_FILENO) < 0 || ::dup2(stderr_fd, STDERR_FILENO) < 0) {
+        if (::dup2(stdout_pipe[1], STDOUT_FILENO) < 0 || ::dup2(stderr_pipe[1], STDERR_FILENO) < 0) {
             const auto message = std::string("Error: failed to redirect output: ") + std::strerror(errno) + "\n";
-            ::write(stderr_fd, message.c_str(), message.size());
+            ::write(stderr_pipe[1], message.c_str(), message.size());
             _exit(125);
         }
 
-        ::close(stdout_fd);
-        ::close(stderr_fd);
-
         ::execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
 
         const auto message = std::string("Error: exec failed: ") + std::strerror(errno) + "\n";
@@ -278,57 +347,97 @@ ExecResult SandboxExecutor::Run(const std::string& command,
         _exit(127);
     }
 
-    ::close(stdout_fd);
-    ::close(stderr_fd);
-
+    ::setpgid(pid, pid);
+    ::close(stdout_pipe[1]);
+    ::close(stderr_pipe[1]);
+    int stdout_fd = stdout_pipe[0];
+    int stderr_fd = stderr_pipe[0];
+    SetNonBlocking(stdout_fd);
+    SetNonBlocking(stderr_fd);
+    // Without pidfd (pre-5.3 kernels) an exit that leaves the pipes open is
+    // only noticed by re-checking waitpid on a short tick.
+    const int pid_fd = OpenPidFd(pid);
+    constexpr int kFallbackTickMs = 20;
+
+    StreamCapture out(options.max_output_bytes, options.on_line, false);
+    StreamCapture err(options.max_output_bytes, options.on_line, true);
     const auto deadline = std::chrono::steady_clock::now() + timeout;
-    bool finished = false;
+    auto kill_deadline = std::chrono::steady_clock::time_point::max();
+    bool exited = false;
     int status = 0;
-    while (std::chrono::steady_clock::now() < deadline) {
-        const auto waited = ::waitpid(pid, &status, WNOHANG);
-        if (waited == pid) {
-            finished = true;
-            break;
+    std::string poll_error;
+    while (!exited) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!result.timed_out && now >= deadline) {
+            result.timed_out = true;
+            ::kill(-pid, SIGTERM);
+            kill_deadline = now + std::chrono::seconds(2);
         }
-        if (waited < 0) {
+        if (now >= kill_deadline) {
+            ::kill(-pid, SIGKILL);
+            while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+            }
+            exited = true;
             break;
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-    }
-    if (!finished) {
-        result.timed_out = true;
-        ::kill(pid, SIGTERM);
-        const auto grace_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
-        while (std::chrono::steady_clock::now() < grace_deadline) {
-            const auto waited = ::waitpid(pid, &status, WNOHANG);
-            if (waited == pid) {
-                finished = true;
-                break;
-            }
-            if (waited < 0) {
-                break;
+
+        std::array<pollfd, 3> fds{};
+        nfds_t count = 0;
+        if (stdout_fd >= 0) {
+            fds[count++] = pollfd{stdout_fd, POLLIN, 0};
+        }
+        if (stderr_fd >= 0) {
+            fds[count++] = pollfd{stderr_fd, POLLIN, 0};
+        }
+        if (pid_fd >= 0) {
+            fds[count++] = pollfd{pid_fd, POLLIN, 0};
+        }
+        const auto next_deadline = result.timed_out ? kill_deadline : deadline;
+        auto wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(next_deadline - now).count() + 1;
+        if (pid_fd < 0) {
+            wait_ms = std::min<long long>(wait_ms, kFallbackTickMs);
+        }
+        const int ready = ::poll(fds.data(), count, static_cast<int>(wait_ms));
+        if (ready < 0 && errno != EINTR) {
+            // Nothing can be waited on any more; do not leave the command
+            // running or unreaped behind the error.
+            poll_error = std::string("Error: poll failed: ") + std::strerror(errno) + "\n";
+            ::kill(-pid, SIGKILL);
+            while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            exited = true;
+            break;
         }
-        if (!finished) {
-            ::kill(pid, SIGKILL);
-            ::waitpid(pid, &status, 0);
-            finished = true;
+
+        DrainPipe(stdout_fd, out);
+        DrainPipe(stderr_fd, err);
+        const auto waited = ::waitpid(pid, &status, WNOHANG);
+        if (waited == pid) {
+            exited = true;
+        } else if (waited < 0 && errno != EINTR) {
+            break;
         }
     }
-
-    if (finished) {
-        if (WIFEXITED(status)) {
-            result.exit_code = WEXITSTATUS(status);
-        } else if (WIFSIGNALED(status)) {
-            result.exit_code = 128 + WTERMSIG(status);
+    // Pick up output written just before exit, but do not wait on pipes a
+    // background grandchild may still hold open.
+    DrainPipe(stdout_fd, out);
+    DrainPipe(stderr_fd, err);
+    for (const int fd : {stdout_fd, stderr_fd, pid_fd}) {
+        if (fd >= 0) {
+            ::close(fd);
         }
-    } else if (result.exit_code == -1) {
+    }
+
+    if (exited) {
+        result.exit_code = ExitCodeFromStatus(status);
+    } else if (result.timed_out) {
         result.exit_code = kTimedOutExitCode;
     }
 
-    PopulateCapturedOutput(stdout_path, stderr_path, result);
-    CleanupLogFiles(stdout_path, stderr_path);
+    FinishCapture(out, err, result);
+    if (!poll_error.empty()) {
+        result.error += poll_error;
+    }
     if (result.timed_out && result.exit_code == 0) {
         result.exit_code = kTimedOutExitCode;
     }
@@ -1,23 +1,39 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include <string>
 
+#include "sandbox/output_capture.hpp"
+
 namespace kabot::sandbox {
 
 struct ExecResult {
     int exit_code = -1;
     bool timed_out = false;
     bool blocked = false;
+    bool truncated = false;  // output or error dropped bytes past the cap
     std::string output;
     std::string error;
 };
 
+struct ExecOptions {
+    // Per stream. Once exceeded, the first and last halves are kept.
+    std::size_t max_output_bytes = 1024 * 1024;
+    LineCallback on_line;
+};
+
 class SandboxExecutor {
 public:
     static ExecResult Run(const std::string& command,
                           const std::string& working_dir,
                           std::chrono::seconds timeout);
+    static ExecResult Run(const std::string& command,
+                          const std::string& working_dir,
+                          std::chrono::seconds timeout,
+                          const ExecOptions& options);
+    // True when the command matches the deny list Run enforces.
+    static bool IsBlocked(const std::string& command);
 };
 
 }  // namespace kabot::sandbox
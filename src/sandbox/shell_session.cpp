@@ -0,0 +1,428 @@
+#include "sandbox/shell_session.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "utils/logging.hpp"
+
+namespace kabot::sandbox {
+namespace {
+
+constexpr int kTimedOutExitCode = 124;
+
+std::string MakeNonce() {
+    std::random_device device;
+    std::mt19937_64 engine((static_cast<std::uint64_t>(device()) << 32) ^ device());
+    static const char* kHex = "0123456789abcdef";
+    std::string nonce;
+    auto value = engine();
+    for (int i = 0; i < 16; ++i) {
+        nonce.push_back(kHex[value & 0xF]);
+        value >>= 4;
+    }
+    return nonce;
+}
+
+std::string SingleQuote(const std::string& value) {
+    std::string quoted = "'";
+    for (const auto ch : value) {
+        if (ch == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted.push_back(ch);
+        }
+    }
+    quoted.push_back('\'');
+    return quoted;
+}
+
+#ifndef _WIN32
+void CloseFd(int& fd) {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void SetNonBlocking(int fd) {
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+}
+
+// Forwards everything ahead of the sentinel to the capture, holding back a
+// marker-sized tail in case the sentinel is split across reads.
+class FramedStream {
+public:
+    FramedStream(std::string marker, StreamCapture& capture)
+        : marker_(std::move(marker))
+        , capture_(capture) {}
+
+    void Feed(const char* data, std::size_t size) {
+        if (found_) {
+            trailer_.append(data, size);
+            return;
+        }
+        pending_.append(data, size);
+        const auto pos = pending_.find(marker_);
+        if (pos != std::string::npos) {
+            capture_.Append(pending_.data(), pos);
+            trailer_ = pending_.substr(pos + marker_.size());
+            pending_.clear();
+            found_ = true;
+            return;
+        }
+        if (pending_.size() > marker_.size()) {
+            const auto ready = pending_.size() - marker_.size();
+            capture_.Append(pending_.data(), ready);
+            pending_.erase(0, ready);
+        }
+    }
+
+    // The sentinel line is complete once its trailing newline has arrived.
+    bool Complete() const { return found_ && trailer_.find('\n') != std::string::npos; }
+    const std::string& Trailer() const { return trailer_; }
+
+    void Flush() {
+        capture_.Append(pending_.data(), pending_.size());
+        pending_.clear();
+    }
+
+private:
+    std::string marker_;
+    StreamCapture& capture_;
+    std::string pending_;
+    std::string trailer_;
+    bool found_ = false;
+};
+
+// Returns false once the pipe reports EOF or an error.
+bool ReadAvailable(int fd, FramedStream& stream) {
+    std::array<char, 16384> buffer{};
+    for (;;) {
+        const auto n = ::read(fd, buffer.data(), buffer.size());
+        if (n > 0) {
+            stream.Feed(buffer.data(), static_cast<std::size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+bool SendAll(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        const auto n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+#endif
+
+}  // namespace
+
+ShellSession::ShellSession(std::string working_dir)
+    : working_dir_(std::move(working_dir))
+    , last_used_(Clock::now().time_since_epoch().count()) {}
+
+#ifdef _WIN32
+ShellSession::~ShellSession() = default;
+
+ExecResult ShellSession::Run(const std::string& command,
+                             std::chrono::seconds timeout,
+                             const ExecOptions& options) {
+    // No persistent shell on Windows; every command gets its own process.
+    return SandboxExecutor::Run(command, working_dir_, timeout, options);
+}
+#else
+ShellSession::~ShellSession() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ >= 0) {
+        Terminate(SIGKILL);
+    }
+}
+
+bool ShellSession::Start(std::string& error) {
+    int stdin_pair[2] = {-1, -1};
+    int stdout_pipe[2] = {-1, -1};
+    int stderr_pipe[2] = {-1, -1};
+    // A socket rather than a pipe for stdin, so writing to a dead shell can
+    // use MSG_NOSIGNAL instead of raising SIGPIPE in the agent.
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, stdin_pair) != 0
+        || ::pipe2(stdout_pipe, O_CLOEXEC) != 0
+        || ::pipe2(stderr_pipe, O_CLOEXEC) != 0) {
+        error = std::strerror(errno);
+        for (auto* fd : {&stdin_pair[0], &stdin_pair[1], &stdout_pipe[0], &stdout_pipe[1],
+                         &stderr_pipe[0], &stderr_pipe[1]}) {
+            CloseFd(*fd);
+        }
+        return false;
+    }
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        error = std::strerror(errno);
+        for (auto* fd : {&stdin_pair[0], &stdin_pair[1], &stdout_pipe[0], &stdout_pipe[1],
+                         &stderr_pipe[0], &stderr_pipe[1]}) {
+            CloseFd(*fd);
+        }
+        return false;
+    }
+    if (pid == 0) {
+        ::setpgid(0, 0);
+        if (!working_dir_.empty() && ::chdir(working_dir_.c_str()) != 0) {
+            const auto message = std::string("Error: failed to change directory: ") + std::strerror(errno) + "\n";
+            ::write(stderr_pipe[1], message.c_str(), message.size());
+            _exit(125);
+        }
+        if (::dup2(stdin_pair[1], STDIN_FILENO) < 0
+            || ::dup2(stdout_pipe[1], STDOUT_FILENO) < 0
+            || ::dup2(stderr_pipe[1], STDERR_FILENO) < 0) {
+            _exit(125);
+        }
+        ::execl("/bin/sh", "sh", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    ::setpgid(pid, pid);
+    CloseFd(stdin_pair[1]);
+    CloseFd(stdout_pipe[1]);
+    CloseFd(stderr_pipe[1]);
+    pid_ = pid;
+    stdin_fd_ = stdin_pair[0];
+    stdout_fd_ = stdout_pipe[0];
+    stderr_fd_ = stderr_pipe[0];
+    SetNonBlocking(stdout_fd_);
+    SetNonBlocking(stderr_fd_);
+    nonce_ = MakeNonce();
+    sequence_ = 0;
+    LOG_DEBUG("[shell] started pid={} cwd={}", pid_, working_dir_);
+    return true;
+}
+
+int ShellSession::Terminate(int signal_number) {
+    if (signal_number != 0) {
+        ::kill(-pid_, signal_number);
+    }
+    // Wait for the shell without reaping it, so its process group id stays
+    // reserved while the rest of the group is killed below.
+    const auto grace_deadline = Clock::now() + std::chrono::seconds(2);
+    while (Clock::now() < grace_deadline) {
+        siginfo_t info{};
+        if (::waitid(P_PID, static_cast<id_t>(pid_), &info, WEXITED | WNOHANG | WNOWAIT) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (info.si_pid == pid_) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ::kill(-pid_, SIGKILL);
+    int status = 0;
+    while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR) {
+    }
+    CloseFd(stdin_fd_);
+    CloseFd(stdout_fd_);
+    CloseFd(stderr_fd_);
+    pid_ = -1;
+    if (WIFEXITED(status)) {
+        return WEXITSTATUS(status);
+    }
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return -1;
+}
+
+ExecResult ShellSession::Run(const std::string& command,
+                             std::chrono::seconds timeout,
+                             const ExecOptions& options) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    busy_ = true;
+    ExecResult result{};
+    if (SandboxExecutor::IsBlocked(command)) {
+        busy_ = false;
+        result.exit_code = 126;
+        result.blocked = true;
+        result.error = "Error: command blocked by policy";
+        return result;
+    }
+
+    if (pid_ >= 0) {
+        // Pick up a shell that died while idle, e.g. killed from outside.
+        siginfo_t info{};
+        if (::waitid(P_PID, static_cast<id_t>(pid_), &info, WEXITED | WNOHANG | WNOWAIT) == 0
+            && info.si_pid == pid_) {
+            Terminate(0);
+        }
+    }
+    std::string start_error;
+    if (pid_ < 0 && !Start(start_error)) {
+        busy_ = false;
+        result.error = "Error: failed to start shell: " + start_error;
+        return result;
+    }
+
+    const auto marker = "__KABOT_" + nonce_ + "_" + std::to_string(++sequence_) + "__";
+    const auto script = "command eval " + SingleQuote(command) + " </dev/null\n"
+        + "printf '%s:%d\\n' '" + marker + "' \"$?\"\n"
+        + "printf '%s\\n' '" + marker + "' >&2\n";
+
+    StreamCapture out(options.max_output_bytes, options.on_line, false);
+    StreamCapture err(options.max_output_bytes, options.on_line, true);
+    FramedStream out_frame(marker, out);
+    FramedStream err_frame(marker, err);
+    bool shell_exited = !SendAll(stdin_fd_, script);
+
+    const auto deadline = Clock::now() + timeout;
+    while (!shell_exited && !(out_frame.Complete() && err_frame.Complete())) {
+        const auto now = Clock::now();
+        if (now >= deadline) {
+            result.timed_out = true;
+            break;
+        }
+        std::array<pollfd, 2> fds{};
+        nfds_t count = 0;
+        if (!out_frame.Complete()) {
+            fds[count++] = pollfd{stdout_fd_, POLLIN, 0};
+        }
+        if (!err_frame.Complete()) {
+            fds[count++] = pollfd{stderr_fd_, POLLIN, 0};
+        }
+        const auto wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1;
+        if (::poll(fds.data(), count, static_cast<int>(wait_ms)) < 0 && errno != EINTR) {
+            shell_exited = true;
+            break;
+        }
+        if (!ReadAvailable(stdout_fd_, out_frame) || !ReadAvailable(stderr_fd_, err_frame)) {
+            shell_exited = true;
+        }
+    }
+
+    if (out_frame.Complete() && err_frame.Complete()) {
+        result.exit_code = std::atoi(out_frame.Trailer().c_str() + 1);
+    } else if (result.timed_out) {
+        Terminate(SIGTERM);
+        result.exit_code = kTimedOutExitCode;
+        LOG_WARN("[shell] command timed out, shell restarted on next use");
+    } else {
+        // `exit`, exec or a crash ended the shell; report it like a one-shot run.
+        ReadAvailable(stdout_fd_, out_frame);
+        ReadAvailable(stderr_fd_, err_frame);
+        result.exit_code = Terminate(0);
+    }
+    out_frame.Flush();
+    err_frame.Flush();
+    out.lines.Finish();
+    err.lines.Finish();
+    result.output = out.buffer.Take();
+    result.error = err.buffer.Take();
+    result.truncated = out.buffer.Truncated() || err.buffer.Truncated();
+
+    last_used_ = Clock::now().time_since_epoch().count();
+    busy_ = false;
+    return result;
+}
+#endif
+
+ShellSessionPool::ShellSessionPool(std::string working_dir, std::chrono::seconds idle_timeout)
+    : working_dir_(std::move(working_dir))
+    , idle_timeout_(idle_timeout) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    ArmReaperLocked();
+}
+
+ShellSessionPool::~ShellSessionPool() {
+    kabot::ScopedTimer reaper;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stopping_ = true;
+        reaper = std::move(reaper_);
+    }
+    reaper.Cancel();
+}
+
+ExecResult ShellSessionPool::Run(const std::string& session_key,
+                                 const std::string& command,
+                                 std::chrono::seconds timeout,
+                                 const ExecOptions& options) {
+    std::shared_ptr<ShellSession> session;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto& slot = sessions_[session_key];
+        if (!slot) {
+            slot = std::make_shared<ShellSession>(working_dir_);
+        }
+        session = slot;
+    }
+    return session->Run(command, timeout, options);
+}
+
+std::size_t ShellSessionPool::SessionCount() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return sessions_.size();
+}
+
+void ShellSessionPool::ReapIdle() {
+    std::vector<std::shared_ptr<ShellSession>> expired;
+    kabot::ScopedTimer previous;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        const auto now = ShellSession::Clock::now();
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (!it->second->Busy() && now - it->second->LastUsed() >= idle_timeout_) {
+                expired.push_back(std::move(it->second));
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        previous = ArmReaperLocked();
+    }
+    if (!expired.empty()) {
+        LOG_DEBUG("[shell] reaped idle sessions count={}", expired.size());
+    }
+}
+
+kabot::ScopedTimer ShellSessionPool::ArmReaperLocked() {
+    if (stopping_) {
+        return {};
+    }
+    const auto interval = std::clamp<std::chrono::seconds>(
+        idle_timeout_ / 2, std::chrono::seconds(1), std::chrono::seconds(60));
+    auto& timers = kabot::TimerService::Shared();
+    auto previous = std::move(reaper_);
+    reaper_ = kabot::ScopedTimer(timers, timers.ScheduleAfter(interval, [this] { ReapIdle(); }));
+    return previous;
+}
+
+}  // namespace kabot::sandbox
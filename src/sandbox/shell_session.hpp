@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "sandbox/sandbox_executor.hpp"
+#include "utils/timer_service.hpp"
+
+namespace kabot::sandbox {
+
+// One long-lived `/bin/sh` whose cwd and environment carry over between
+// commands. Each command is run through `command eval` with stdin from
+// /dev/null and is followed by a sentinel line carrying its exit code, so
+// output is framed without restarting the shell. A timeout or an `exit`
+// ends the shell; the next Run starts a fresh one.
+class ShellSession {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ShellSession(std::string working_dir);
+    ~ShellSession();
+    ShellSession(const ShellSession&) = delete;
+    ShellSession& operator=(const ShellSession&) = delete;
+
+    ExecResult Run(const std::string& command,
+                   std::chrono::seconds timeout,
+                   const ExecOptions& options);
+    bool Busy() const { return busy_.load(); }
+    Clock::time_point LastUsed() const { return Clock::time_point(Clock::duration(last_used_.load())); }
+
+private:
+    std::string working_dir_;
+    std::mutex mutex_;
+    std::atomic<bool> busy_{false};
+    std::atomic<Clock::rep> last_used_;
+    std::string nonce_;
+    std::uint64_t sequence_ = 0;
+#ifndef _WIN32
+    int pid_ = -1;
+    int stdin_fd_ = -1;
+    int stdout_fd_ = -1;
+    int stderr_fd_ = -1;
+
+    bool Start(std::string& error);
+    // Kills the shell's process group and reaps it; returns its exit code.
+    int Terminate(int signal_number);
+#endif
+};
+
+// Maps session keys to shells and closes the ones left idle.
+class ShellSessionPool {
+public:
+    ShellSessionPool(std::string working_dir, std::chrono::seconds idle_timeout);
+    ~ShellSessionPool();
+    ShellSessionPool(const ShellSessionPool&) = delete;
+    ShellSessionPool& operator=(const ShellSessionPool&) = delete;
+
+    ExecResult Run(const std::string& session_key,
+                   const std::string& command,
+                   std::chrono::seconds timeout,
+                   const ExecOptions& options = {});
+    std::size_t SessionCount() const;
+    void ReapIdle();
+
+private:
+    std::string working_dir_;
+    std::chrono::seconds idle_timeout_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<ShellSession>> sessions_;
+    kabot::ScopedTimer reaper_;
+    bool stopping_ = false;
+
+    // Returns the timer it replaces, to be cancelled once mutex_ is released.
+    kabot::ScopedTimer ArmReaperLocked();
+};
+
+}  // namespace kabot::sandbox
@@ -1,11 +1,16 @@
 #include "agent/tools/shell.hpp"
+#include "agent/tools/tool_context.hpp"
 #include "sandbox/sandbox_executor.hpp"
+#include "sandbox/shell_session.hpp"
 
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -102,6 +107,116 @@ void TestTimeout() {
     Expect(result.exit_code != 0, "expected timed out command to return non-zero exit code");
 }
 
+#ifndef _WIN32
+void TestOutputIsBoundedHeadAndTail() {
+    kabot::sandbox::ExecOptions options;
+    options.max_output_bytes = 1000;
+    const auto result = kabot::sandbox::SandboxExecutor::Run(
+        "printf START; head -c 200000 /dev/zero | tr '\\0' x; printf END",
+        std::filesystem::current_path().string(),
+        std::chrono::seconds(5),
+        options);
+    Expect(result.exit_code == 0, "expected bounded command exit code 0");
+    Expect(result.truncated, "expected output to be marked truncated");
+    Expect(result.output.rfind("START", 0) == 0, "expected head of output to be kept");
+    Expect(result.output.size() >= 3 && result.output.compare(result.output.size() - 3, 3, "END") == 0,
+           "expected tail of output to be kept");
+    Expect(result.output.size() < 1100, "expected output to stay near the cap");
+    Expect(result.output.find("bytes truncated") != std::string::npos, "expected a truncation marker");
+}
+
+void TestLineCallbackStreamsBothPipes() {
+    std::vector<std::pair<std::string, bool>> lines;
+    kabot::sandbox::ExecOptions options;
+    options.on_line = [&lines](const std::string& line, bool is_stderr) {
+        lines.emplace_back(line, is_stderr);
+    };
+    const auto result = kabot::sandbox::SandboxExecutor::Run(
+        "printf 'one\\ntwo\\n'; printf 'oops' 1>&2",
+        std::filesystem::current_path().string(),
+        std::chrono::seconds(5),
+        options);
+    Expect(result.exit_code == 0, "expected streaming command exit code 0");
+    Expect(!result.truncated, "expected small output not to be truncated");
+    Expect(lines.size() == 3, "expected three streamed lines");
+    Expect(lines[0] == std::make_pair(std::string("one"), false), "expected first stdout line");
+    Expect(lines[1] == std::make_pair(std::string("two"), false), "expected second stdout line");
+    Expect(lines[2] == std::make_pair(std::string("oops"), true), "expected unterminated stderr line");
+}
+
+void TestBackgroundChildDoesNotDelayCompletion() {
+    const auto started = std::chrono::steady_clock::now();
+    const auto result = kabot::sandbox::SandboxExecutor::Run(
+        "sleep 5 & printf done",
+        std::filesystem::current_path().string(),
+        std::chrono::seconds(10));
+    const auto elapsed = std::chrono::steady_clock::now() - started;
+    Expect(result.exit_code == 0, "expected background command exit code 0");
+    Expect(!result.timed_out, "expected background command not to time out");
+    Expect(result.output == "done", "expected foreground output");
+    Expect(elapsed < std::chrono::seconds(3), "expected completion on shell exit, not pipe close");
+}
+
+void TestShellSessionKeepsState() {
+    const auto temp_dir = std::filesystem::temp_directory_path() / "kabot_sandbox_tests_session";
+    std::filesystem::create_directories(temp_dir);
+    kabot::sandbox::ShellSessionPool pool(std::filesystem::current_path().string(), std::chrono::seconds(60));
+
+    auto result = pool.Run("s1", "cd '" + temp_dir.string() + "' && export KABOT_TEST_VAR=kept", std::chrono::seconds(5));
+    Expect(result.exit_code == 0, "expected cd/export to succeed");
+    result = pool.Run("s1", "printf '%s %s' \"$(pwd)\" \"$KABOT_TEST_VAR\"", std::chrono::seconds(5));
+    Expect(result.output == temp_dir.string() + " kept", "expected cwd and env to persist in a session");
+    result = pool.Run("s2", "printf '%s' \"$KABOT_TEST_VAR\"", std::chrono::seconds(5));
+    Expect(result.output.empty(), "expected sessions not to share state");
+    Expect(pool.SessionCount() == 2, "expected one shell per session key");
+
+    result = pool.Run("s1", "printf partial; printf oops 1>&2; false", std::chrono::seconds(5));
+    Expect(result.exit_code == 1, "expected the command's own exit code");
+    Expect(result.output == "partial", "expected unterminated stdout to be framed");
+    Expect(result.error == "oops", "expected stderr to be framed");
+    result = pool.Run("s1", "if then", std::chrono::seconds(5));
+    Expect(result.exit_code != 0, "expected a syntax error to fail the command");
+    result = pool.Run("s1", "printf '%s' \"$KABOT_TEST_VAR\"", std::chrono::seconds(5));
+    Expect(result.output == "kept", "expected a syntax error not to kill the shell");
+}
+
+void TestShellSessionRecoversFromExitAndTimeout() {
+    kabot::sandbox::ShellSessionPool pool(std::filesystem::current_path().string(), std::chrono::seconds(60));
+    auto result = pool.Run("s", "export KABOT_TEST_VAR=gone; exit 3", std::chrono::seconds(5));
+    Expect(result.exit_code == 3, "expected exit status of a shell that exited");
+    result = pool.Run("s", "printf '%s' \"${KABOT_TEST_VAR:-fresh}\"", std::chrono::seconds(5));
+    Expect(result.output == "fresh", "expected a fresh shell after exit");
+
+    result = pool.Run("s", "sleep 5", std::chrono::seconds(1));
+    Expect(result.timed_out, "expected session command to time out");
+    Expect(result.exit_code != 0, "expected timed out session command to fail");
+    result = pool.Run("s", "printf again", std::chrono::seconds(5));
+    Expect(result.exit_code == 0 && result.output == "again", "expected a fresh shell after timeout");
+    result = pool.Run("s", "rm -rf /tmp/test", std::chrono::seconds(5));
+    Expect(result.blocked, "expected session commands to honour the deny list");
+}
+
+void TestShellSessionPoolReapsIdle() {
+    kabot::sandbox::ShellSessionPool pool(std::filesystem::current_path().string(), std::chrono::seconds(0));
+    pool.Run("s", "true", std::chrono::seconds(5));
+    Expect(pool.SessionCount() == 1, "expected a session after first use");
+    pool.ReapIdle();
+    Expect(pool.SessionCount() == 0, "expected idle session to be reaped");
+}
+
+void TestShellToolUsesSessionShell() {
+    kabot::agent::tools::BashTool tool(std::filesystem::current_path().string(), true, std::chrono::seconds(60));
+    kabot::agent::tools::ToolInvocationContext context{};
+    context.session_key = "cli:direct";
+    kabot::agent::tools::ToolContextScope scope(std::move(context));
+    std::unordered_map<std::string, std::string> params;
+    params["command"] = "KABOT_TOOL_VAR=yes";
+    tool.Execute(params);
+    params["command"] = "printf '%s' \"$KABOT_TOOL_VAR\"";
+    Expect(tool.Execute(params) == "yes", "expected bash tool to reuse the session shell");
+}
+#endif
+
 void TestShellToolBlocked() {
     kabot::agent::tools::BashTool tool(std::filesystem::current_path().string());
     std::unordered_map<std::string, std::string> params;
@@ -118,6 +233,15 @@ int main() {
     TestWorkingDirectory();
     TestBlockedCommand();
     TestTimeout();
+#ifndef _WIN32
+    TestOutputIsBoundedHeadAndTail();
+    TestLineCallbackStreamsBothPipes();
+    TestBackgroundChildDoesNotDelayCompletion();
+    TestShellSessionKeepsState();
+    TestShellSessionRecoversFromExitAndTimeout();
+    TestShellSessionPoolReapsIdle();
+    TestShellToolUsesSessionShell();
+#endif
     TestShellToolBlocked();
     std::cout << "sandbox_tests passed" << std::endl;
     return 0;
@@ -70,6 +70,19 @@ std::string SerializeToolCalls(const std::vector<kabot::providers::ToolCallReque
     return json.dump();
 }
 
+std::size_t MessageBytes(const SessionMessage& msg) {
+    std::size_t bytes = sizeof(SessionMessage) + msg.role.size() + msg.content.size() + msg.timestamp.size() +
+        msg.name.size() + msg.tool_call_id.size() + msg.usage_json.size();
+    for (const auto& call : msg.tool_calls) {
+        bytes += sizeof(call) + call.id.size() + call.name.size();
+        for (const auto& [key, value] : call.arguments) {
+            // Key, value and a hash node's worth of bookkeeping.
+            bytes += key.size() + value.size() + 64;
+        }
+    }
+    return bytes;
+}
+
 }  // namespace
 
 Session::Session(std::string key)
@@ -87,10 +100,19 @@ Session::Session(
     , messages_(std::move(messages))
     , created_at_(std::move(created_at))
     , updated_at_(std::move(updated_at))
-    , metadata_(std::move(metadata)) {}
+    , metadata_(std::move(metadata)) {
+    for (const auto& msg : messages_) {
+        approximate_bytes_ += MessageBytes(msg);
+    }
+}
+
+void Session::PushMessage(SessionMessage msg) {
+    approximate_bytes_ += MessageBytes(msg);
+    messages_.push_back(std::move(msg));
+}
 
 void Session::AddMessage(const std::string& role, const std::string& content) {
-    messages_.push_back(SessionMessage{role, content, NowIso()});
+    PushMessage(SessionMessage{role, content, NowIso()});
     updated_at_ = NowIso();
 }
 
@@ -113,7 +135,7 @@ void Session::AddMessage(const std::string& role,
         }
         msg.usage_json = j.dump();
     }
-    messages_.push_back(std::move(msg));
+    PushMessage(std::move(msg));
     updated_at_ = NowIso();
 }
 
@@ -123,10 +145,20 @@ void Session::AddToolMessage(const std::string& tool_call_id,
     SessionMessage msg{"tool", content, NowIso()};
     msg.tool_call_id = tool_call_id;
     msg.name = tool_name;
-    messages_.push_back(std::move(msg));
+    PushMessage(std::move(msg));
     updated_at_ = NowIso();
 }
 
+void Session::ReplaceMessages(std::vector<SessionMessage> messages) {
+    messages_ = std::move(messages);
+    approximate_bytes_ = 0;
+    for (const auto& msg : messages_) {
+        approximate_bytes_ += MessageBytes(msg);
+    }
+    updated_at_ = NowIso();
+    rewrite_required_ = true;
+}
+
 void Session::RecordFileRead(const std::string& path) {
     read_file_paths_.insert(path);
 }
@@ -212,120 +244,298 @@ std::vector<kabot::providers::Message> Session::GetHistory(std::size_t max_messa
     return history;
 }
 
-SessionManager::SessionManager(std::string workspace)
+SessionManager::SessionManager(std::string workspace, SessionCacheOptions cache_options)
     : workspace_(std::move(workspace))
-    , db_path_(std::filesystem::path(workspace_) / "sessions.db") {
+    , db_path_(std::filesystem::path(workspace_) / "sessions.db")
+    , cache_options_(cache_options) {
     EnsureSchema();
 }
 
 SessionManager::~SessionManager() {
+    sqlite3_finalize(upsert_session_stmt_);
+    sqlite3_finalize(touch_session_stmt_);
+    sqlite3_finalize(insert_message_stmt_);
     if (db_) {
         sqlite3_close(db_);
         db_ = nullptr;
     }
 }
 
-Session SessionManager::GetOrCreate(const std::string& key) {
+SessionHandle SessionManager::GetOrCreate(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end()) {
-        return it->second;
+    if (auto cached = Lookup(key)) {
+        return cached;
     }
     auto loaded = Load(key);
+    SessionHandle session;
     if (loaded.has_value()) {
-        cache_.emplace(key, *loaded);
-        return *loaded;
+        session = std::make_shared<Session>(std::move(*loaded));
+        MarkPersisted(*session, session->Metadata().dump());
+    } else {
+        session = std::make_shared<Session>(key);
     }
-    Session session(key);
-    cache_.emplace(key, session);
+    Insert(session);
     return session;
 }
 
-std::optional<Session> SessionManager::Get(const std::string& key) {
+SessionHandle SessionManager::Get(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto it = cache_.find(key);
-    if (it != cache_.end()) {
-        return it->second;
+    if (auto cached = Lookup(key)) {
+        return cached;
     }
     auto loaded = Load(key);
-    if (loaded.has_value()) {
-        cache_.emplace(key, *loaded);
+    if (!loaded.has_value()) {
+        return nullptr;
     }
-    return loaded;
+    auto session = std::make_shared<Session>(std::move(*loaded));
+    MarkPersisted(*session, session->Metadata().dump());
+    Insert(session);
+    return session;
 }
 
-void SessionManager::Save(const Session& session) {
+void SessionManager::Save(Session& session) {
     std::lock_guard<std::mutex> lock(mutex_);
     if (!db_) {
         return;
     }
-    Exec(db_, "BEGIN TRANSACTION;");
-    sqlite3_stmt* stmt = nullptr;
-    const std::string upsert_sql =
+    const auto& key = session.Key();
+    auto it = cache_.find(key);
+    const bool cached_here = it != cache_.end() && it->second.session.get() == &session;
+    if (it != cache_.end() && !cached_here) {
+        // Another object owns this key (e.g. a copy made before /new); the
+        // save wins and the cached one is reloaded on next access.
+        cache_stats_.bytes -= it->second.bytes;
+        lru_.erase(it->second.lru_position);
+        cache_.erase(it);
+    }
+    // Only a session whose watermark is known to match the stored rows can be
+    // appended to; anything else rewrites its history.
+    const bool rewrite = session.rewrite_required_ || !cached_here ||
+        session.messages_.size() < session.persisted_messages_;
+    const auto metadata_text = session.metadata_.dump();
+    const bool row_changed = !session.stored_ ||
+        metadata_text != session.persisted_metadata_ ||
+        session.created_at_ != session.persisted_created_at_;
+    const bool touched = session.updated_at_ != session.persisted_updated_at_;
+    const auto total = session.messages_.size();
+    if (!rewrite && session.persisted_messages_ == total && !row_changed && !touched) {
+        return;
+    }
+
+    if (!Exec(db_, "BEGIN TRANSACTION;")) {
+        return;
+    }
+    bool ok = true;
+    if (row_changed) {
+        ok = UpsertSessionRow(session, metadata_text);
+    } else if (touched) {
+        ok = TouchSessionRow(session);
+    }
+    if (ok && rewrite) {
+        LOG_INFO("[session] rewriting stored history session={} messages={}", key, total);
+        ok = DeleteMessages(key) && InsertMessages(session, 0);
+    } else if (ok) {
+        ok = InsertMessages(session, session.persisted_messages_);
+    }
+    if (!ok || !Exec(db_, "COMMIT;")) {
+        // Nothing of this save is stored, so the watermark stays put and the
+        // next save retries the same rows.
+        LOG_ERROR("[session] save failed, rolled back session={}", key);
+        Exec(db_, "ROLLBACK;");
+        return;
+    }
+
+    MarkPersisted(session, metadata_text);
+    if (cached_here) {
+        Refresh(it->second);
+        EvictOverBudget();
+    }
+}
+
+SessionCacheStats SessionManager::CacheStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stats = cache_stats_;
+    stats.entries = cache_.size();
+    stats.max_bytes = cache_options_.max_bytes;
+    return stats;
+}
+
+SessionHandle SessionManager::Lookup(const std::string& key) {
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        cache_stats_.misses += 1;
+        return nullptr;
+    }
+    cache_stats_.hits += 1;
+    Refresh(it->second);
+    return it->second.session;
+}
+
+void SessionManager::Insert(const SessionHandle& session) {
+    lru_.push_front(session->Key());
+    CacheEntry entry{};
+    entry.session = session;
+    entry.lru_position = lru_.begin();
+    entry.bytes = session->ApproximateBytes();
+    cache_stats_.bytes += entry.bytes;
+    cache_.insert_or_assign(session->Key(), std::move(entry));
+    EvictOverBudget();
+}
+
+void SessionManager::Refresh(CacheEntry& entry) {
+    const auto bytes = entry.session->ApproximateBytes();
+    cache_stats_.bytes = cache_stats_.bytes - entry.bytes + bytes;
+    entry.bytes = bytes;
+    lru_.splice(lru_.begin(), lru_, entry.lru_position);
+}
+
+void SessionManager::EvictOverBudget() {
+    auto position = lru_.end();
+    while (cache_stats_.bytes > cache_options_.max_bytes && position != lru_.begin()) {
+        --position;
+        auto it = cache_.find(*position);
+        if (it == cache_.end()) {
+            position = lru_.erase(position);
+            continue;
+        }
+        // The cache holds one reference; anything above that is a caller
+        // still working on the session.
+        if (it->second.session.use_count() > 1) {
+            continue;
+        }
+        cache_stats_.evictions += 1;
+        cache_stats_.evicted_bytes += it->second.bytes;
+        cache_stats_.bytes -= it->second.bytes;
+        LOG_DEBUG("[session] evicted session={} bytes={}", it->first, it->second.bytes);
+        cache_.erase(it);
+        position = lru_.erase(position);
+    }
+}
+
+void SessionManager::MarkPersisted(Session& session, std::string metadata_text) {
+    session.stored_ = true;
+    session.persisted_messages_ = session.messages_.size();
+    session.persisted_metadata_ = std::move(metadata_text);
+    session.persisted_created_at_ = session.created_at_;
+    session.persisted_updated_at_ = session.updated_at_;
+    session.rewrite_required_ = false;
+}
+
+bool SessionManager::UpsertSessionRow(const Session& session, const std::string& metadata_text) {
+    auto* stmt = Prepare(
+        upsert_session_stmt_,
         "INSERT INTO sessions(key, created_at, updated_at, metadata) VALUES(?, ?, ?, ?) "
         "ON CONFLICT(key) DO UPDATE SET created_at=excluded.created_at, "
-        "updated_at=excluded.updated_at, metadata=excluded.metadata;";
-    if (sqlite3_prepare_v2(db_, upsert_sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        const auto meta_text = session.Metadata().dump();
-        sqlite3_bind_text(stmt, 1, session.Key().c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 2, session.CreatedAt().c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 3, session.UpdatedAt().c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_bind_text(stmt, 4, meta_text.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+        "updated_at=excluded.updated_at, metadata=excluded.metadata;");
+    if (!stmt) {
+        return false;
     }
-    sqlite3_finalize(stmt);
+    sqlite3_bind_text(stmt, 1, session.Key().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, session.CreatedAt().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, session.UpdatedAt().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, metadata_text.c_str(), -1, SQLITE_TRANSIENT);
+    return StepDone(stmt);
+}
 
-    const std::string delete_sql = "DELETE FROM messages WHERE session_key = ?;";
-    if (sqlite3_prepare_v2(db_, delete_sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, session.Key().c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
+bool SessionManager::TouchSessionRow(const Session& session) {
+    auto* stmt = Prepare(touch_session_stmt_, "UPDATE sessions SET updated_at = ? WHERE key = ?;");
+    if (!stmt) {
+        return false;
     }
-    sqlite3_finalize(stmt);
+    sqlite3_bind_text(stmt, 1, session.UpdatedAt().c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, session.Key().c_str(), -1, SQLITE_TRANSIENT);
+    return StepDone(stmt);
+}
 
-    const std::string insert_sql =
+bool SessionManager::InsertMessages(const Session& session, std::size_t from) {
+    const auto& messages = session.Messages();
+    if (from >= messages.size()) {
+        return true;
+    }
+    auto* stmt = Prepare(
+        insert_message_stmt_,
         "INSERT INTO messages(session_key, role, content, timestamp, name, tool_call_id, tool_calls, usage_json) "
-        "VALUES(?, ?, ?, ?, ?, ?, ?, ?);";
-    if (sqlite3_prepare_v2(db_, insert_sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-        for (const auto& msg : session.Messages()) {
-            const auto tool_calls_text = SerializeToolCalls(msg.tool_calls);
-            sqlite3_bind_text(stmt, 1, session.Key().c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 2, msg.role.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 3, msg.content.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 4, msg.timestamp.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 5, msg.name.c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 6, msg.tool_call_id.c_str(), -1, SQLITE_TRANSIENT);
-            if (tool_calls_text.empty()) {
-                sqlite3_bind_null(stmt, 7);
-            } else {
-                sqlite3_bind_text(stmt, 7, tool_calls_text.c_str(), -1, SQLITE_TRANSIENT);
-            }
-            if (msg.usage_json.empty()) {
-                sqlite3_bind_null(stmt, 8);
-            } else {
-                sqlite3_bind_text(stmt, 8, msg.usage_json.c_str(), -1, SQLITE_TRANSIENT);
-            }
-            sqlite3_step(stmt);
-            sqlite3_reset(stmt);
-            sqlite3_clear_bindings(stmt);
+        "VALUES(?, ?, ?, ?, ?, ?, ?, ?);");
+    if (!stmt) {
+        return false;
+    }
+    for (std::size_t i = from; i < messages.size(); ++i) {
+        const auto& msg = messages[i];
+        const auto tool_calls_text = SerializeToolCalls(msg.tool_calls);
+        sqlite3_bind_text(stmt, 1, session.Key().c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, msg.role.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, msg.content.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, msg.timestamp.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 5, msg.name.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 6, msg.tool_call_id.c_str(), -1, SQLITE_TRANSIENT);
+        if (tool_calls_text.empty()) {
+            sqlite3_bind_null(stmt, 7);
+        } else {
+            sqlite3_bind_text(stmt, 7, tool_calls_text.c_str(), -1, SQLITE_TRANSIENT);
+        }
+        if (msg.usage_json.empty()) {
+            sqlite3_bind_null(stmt, 8);
+        } else {
+            sqlite3_bind_text(stmt, 8, msg.usage_json.c_str(), -1, SQLITE_TRANSIENT);
         }
+        if (!StepDone(stmt)) {
+            return false;
+        }
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    return true;
+}
+
+bool SessionManager::DeleteMessages(const std::string& key) {
+    sqlite3_stmt* stmt = nullptr;
+    bool ok = false;
+    if (sqlite3_prepare_v2(db_, "DELETE FROM messages WHERE session_key = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        ok = StepDone(stmt);
     }
     sqlite3_finalize(stmt);
-    Exec(db_, "COMMIT;");
-    cache_.insert_or_assign(session.Key(), session);
+    return ok;
+}
+
+// Runs a write statement; on failure logs the error and resets the statement
+// so it releases its locks before the caller rolls back.
+bool SessionManager::StepDone(sqlite3_stmt* stmt) {
+    if (sqlite3_step(stmt) == SQLITE_DONE) {
+        return true;
+    }
+    LOG_ERROR("[session] sqlite write failed: {}", sqlite3_errmsg(db_));
+    sqlite3_reset(stmt);
+    return false;
+}
+
+sqlite3_stmt* SessionManager::Prepare(sqlite3_stmt*& cached, const char* sql) {
+    if (cached) {
+        sqlite3_reset(cached);
+        sqlite3_clear_bindings(cached);
+        return cached;
+    }
+    if (sqlite3_prepare_v2(db_, sql, -1, &cached, nullptr) != SQLITE_OK) {
+        LOG_ERROR("[session] failed to prepare statement: {}", sqlite3_errmsg(db_));
+        sqlite3_finalize(cached);
+        cached = nullptr;
+    }
+    return cached;
 }
 
 bool SessionManager::Delete(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex_);
-    cache_.erase(key);
+    auto it = cache_.find(key);
+    if (it != cache_.end()) {
+        cache_stats_.bytes -= it->second.bytes;
+        lru_.erase(it->second.lru_position);
+        cache_.erase(it);
+    }
     if (!db_) {
         return false;
     }
+    DeleteMessages(key);
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, "DELETE FROM messages WHERE session_key = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
-        sqlite3_step(stmt);
-    }
-    sqlite3_finalize(stmt);
     if (sqlite3_prepare_v2(db_, "DELETE FROM sessions WHERE key = ?;", -1, &stmt, nullptr) == SQLITE_OK) {
         sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
         sqlite3_step(stmt);
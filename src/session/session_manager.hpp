@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
@@ -51,6 +55,8 @@ public:
     bool HasReadFile(const std::string& path) const;
 
     const std::string& Key() const { return key_; }
+    // Rough heap footprint of the history, used for the cache budget.
+    std::size_t ApproximateBytes() const { return approximate_bytes_; }
     const std::vector<SessionMessage>& Messages() const { return messages_; }
     const std::string& CreatedAt() const { return created_at_; }
     const std::string& UpdatedAt() const { return updated_at_; }
@@ -59,6 +65,10 @@ public:
     void SetCreatedAt(std::string created_at) { created_at_ = std::move(created_at); }
     void SetUpdatedAt(std::string updated_at) { updated_at_ = std::move(updated_at); }
     void SetMetadata(nlohmann::json metadata) { metadata_ = std::move(metadata); }
+    // Replaces the whole history (e.g. after compaction). The next Save
+    // rewrites the stored rows instead of appending.
+    void ReplaceMessages(std::vector<SessionMessage> messages);
+    bool RewriteRequired() const { return rewrite_required_; }
 
     void AddPendingNotification(const std::string& notification);
     std::vector<std::string> TakePendingNotifications();
@@ -70,6 +80,40 @@ private:
     std::string updated_at_;
     nlohmann::json metadata_ = nlohmann::json::object();
     std::unordered_set<std::string> read_file_paths_;
+    std::size_t approximate_bytes_ = 0;
+
+    // Persistence watermark, maintained by SessionManager: what the database
+    // already holds for this session.
+    bool stored_ = false;
+    std::size_t persisted_messages_ = 0;
+    std::string persisted_metadata_;
+    std::string persisted_created_at_;
+    std::string persisted_updated_at_;
+    bool rewrite_required_ = false;
+
+    void PushMessage(SessionMessage msg);
+
+    friend class SessionManager;
+};
+
+// Shared handle to a cached session. Handles refer to the cached object
+// itself, so callers serialize mutation per session key (AgentLoop holds its
+// per-session lock for the whole turn). A session with outstanding handles
+// is never evicted.
+using SessionHandle = std::shared_ptr<Session>;
+
+struct SessionCacheOptions {
+    std::size_t max_bytes = 64ull * 1024 * 1024;
+};
+
+struct SessionCacheStats {
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+    std::size_t max_bytes = 0;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t evicted_bytes = 0;
 };
 
 struct SessionInfo {
@@ -81,26 +125,52 @@ struct SessionInfo {
 
 class SessionManager {
 public:
-    explicit SessionManager(std::string workspace);
+    explicit SessionManager(std::string workspace, SessionCacheOptions cache_options = {});
     ~SessionManager();
 
-    Session GetOrCreate(const std::string& key);
-    std::optional<Session> Get(const std::string& key);
-    void Save(const Session& session);
+    SessionHandle GetOrCreate(const std::string& key);
+    // Returns nullptr when the session is neither cached nor stored.
+    SessionHandle Get(const std::string& key);
+    void Save(Session& session);
     bool Delete(const std::string& key);
     std::vector<SessionInfo> ListSessions() const;
+    SessionCacheStats CacheStats() const;
 
 private:
+    struct CacheEntry {
+        SessionHandle session;
+        std::list<std::string>::iterator lru_position;
+        std::size_t bytes = 0;
+    };
+
     std::optional<Session> Load(const std::string& key) const;
+    SessionHandle Lookup(const std::string& key);
+    void Insert(const SessionHandle& session);
+    void Refresh(CacheEntry& entry);
+    void EvictOverBudget();
+    static void MarkPersisted(Session& session, std::string metadata_text);
+    bool UpsertSessionRow(const Session& session, const std::string& metadata_text);
+    bool TouchSessionRow(const Session& session);
+    bool InsertMessages(const Session& session, std::size_t from);
+    bool DeleteMessages(const std::string& key);
+    bool StepDone(sqlite3_stmt* stmt);
     void EnsureSchema();
+    sqlite3_stmt* Prepare(sqlite3_stmt*& cached, const char* sql);
     static bool Exec(sqlite3* db, const std::string& sql);
     static std::string SafeText(const unsigned char* text);
 
     std::string workspace_;
     std::filesystem::path db_path_;
     sqlite3* db_ = nullptr;
-    std::unordered_map<std::string, Session> cache_;
-    std::mutex mutex_;
+    SessionCacheOptions cache_options_;
+    // Most recently used key first.
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, CacheEntry> cache_;
+    SessionCacheStats cache_stats_;
+    sqlite3_stmt* upsert_session_stmt_ = nullptr;
+    sqlite3_stmt* touch_session_stmt_ = nullptr;
+    sqlite3_stmt* insert_message_stmt_ = nullptr;
+    mutable std::mutex mutex_;
 };
 
 }  // namespace kabot::session
@@ -0,0 +1,194 @@
+#include "session/session_manager.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[session_manager_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_session_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+int QueryInt(const std::filesystem::path& workspace, const std::string& sql, const std::string& key) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open((workspace / "sessions.db").string().c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return -1;
+    }
+    sqlite3_stmt* stmt = nullptr;
+    int count = -1;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int(stmt, 0);
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return count;
+}
+
+int CountRows(const std::filesystem::path& workspace, const std::string& key) {
+    return QueryInt(workspace, "SELECT COUNT(*) FROM messages WHERE session_key = ?;", key);
+}
+
+int FirstRowId(const std::filesystem::path& workspace, const std::string& key) {
+    return QueryInt(workspace, "SELECT MIN(id) FROM messages WHERE session_key = ?;", key);
+}
+
+void TestSaveAppendsOnlyNewMessages() {
+    const auto workspace = MakeWorkspace("append");
+    {
+        kabot::session::SessionManager sessions(workspace.string());
+        auto session = sessions.GetOrCreate("telegram:default:1");
+        session->AddMessage("user", "hello");
+        session->AddMessage("assistant", "hi");
+        sessions.Save(*session);
+        Expect(CountRows(workspace, "telegram:default:1") == 2, "expected first save to store two rows");
+        const auto first_id = FirstRowId(workspace, "telegram:default:1");
+
+        auto next = sessions.GetOrCreate("telegram:default:1");
+        Expect(next == session, "expected GetOrCreate to hand out the cached session");
+        next->AddMessage("user", "again");
+        sessions.Save(*next);
+        sessions.Save(*next);
+        Expect(CountRows(workspace, "telegram:default:1") == 3, "expected later saves to append only the new row");
+        Expect(FirstRowId(workspace, "telegram:default:1") == first_id, "expected existing rows to be left in place");
+    }
+    kabot::session::SessionManager reopened(workspace.string());
+    const auto loaded = reopened.Get("telegram:default:1");
+    Expect(loaded != nullptr, "expected session to reload from disk");
+    Expect(loaded->Messages().size() == 3, "expected reloaded history to contain every message");
+    Expect(loaded->Messages()[2].content == "again", "expected reloaded history in insertion order");
+
+    auto continued = reopened.GetOrCreate("telegram:default:1");
+    continued->AddMessage("assistant", "welcome back");
+    reopened.Save(*continued);
+    Expect(CountRows(workspace, "telegram:default:1") == 4, "expected append to continue after reload");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestFailedSaveIsRetried() {
+    const auto workspace = MakeWorkspace("failed_save");
+    kabot::session::SessionManager sessions(workspace.string());
+    auto session = sessions.GetOrCreate("telegram:default:busy");
+    session->AddMessage("user", "hello");
+    sessions.Save(*session);
+
+    // Another connection holding the write lock makes the next save fail.
+    sqlite3* other = nullptr;
+    Expect(sqlite3_open((workspace / "sessions.db").string().c_str(), &other) == SQLITE_OK,
+           "expected a second connection");
+    Expect(sqlite3_exec(other, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK,
+           "expected the second connection to take the write lock");
+    session->AddMessage("assistant", "hi");
+    sessions.Save(*session);
+    sqlite3_exec(other, "ROLLBACK;", nullptr, nullptr, nullptr);
+    sqlite3_close(other);
+    Expect(CountRows(workspace, "telegram:default:busy") == 1, "expected the blocked save to store nothing");
+
+    sessions.Save(*session);
+    Expect(CountRows(workspace, "telegram:default:busy") == 2, "expected the next save to retry the lost row");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestDetachedCopyRewritesHistory() {
+    const auto workspace = MakeWorkspace("detached");
+    kabot::session::SessionManager sessions(workspace.string());
+    auto base = sessions.GetOrCreate("lark:default:2");
+    base->AddMessage("user", "start");
+    sessions.Save(*base);
+
+    kabot::session::Session detached = *base;
+    base->AddMessage("assistant", "from cache");
+    sessions.Save(*base);
+    detached.AddMessage("assistant", "from copy");
+    sessions.Save(detached);
+
+    Expect(CountRows(workspace, "lark:default:2") == 2, "expected detached save to rewrite instead of append");
+    const auto loaded = sessions.Get("lark:default:2");
+    Expect(loaded != nullptr && loaded != base, "expected the stale cached session to be dropped");
+    Expect(loaded->Messages().back().content == "from copy", "expected last save to win");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestReplaceMessagesRewritesAndMetadataPersists() {
+    const auto workspace = MakeWorkspace("replace");
+    {
+        kabot::session::SessionManager sessions(workspace.string());
+        auto session = sessions.GetOrCreate("qqbot:default:3");
+        for (int i = 0; i < 5; ++i) {
+            session->AddMessage("user", "message " + std::to_string(i));
+        }
+        sessions.Save(*session);
+
+        std::vector<kabot::session::SessionMessage> summary;
+        summary.push_back(kabot::session::SessionMessage{"user", "summary", "2026-01-01T00:00:00", "", "", {}, ""});
+        session->ReplaceMessages(std::move(summary));
+        Expect(session->RewriteRequired(), "expected ReplaceMessages to request a rewrite");
+        session->AddPendingNotification("task finished");
+        sessions.Save(*session);
+        Expect(!session->RewriteRequired(), "expected save to clear the rewrite request");
+        Expect(CountRows(workspace, "qqbot:default:3") == 1, "expected compaction to replace stored rows");
+    }
+    kabot::session::SessionManager reopened(workspace.string());
+    auto loaded = reopened.GetOrCreate("qqbot:default:3");
+    const auto notifications = loaded->TakePendingNotifications();
+    Expect(notifications.size() == 1 && notifications[0] == "task finished", "expected changed metadata to be stored");
+    std::filesystem::remove_all(workspace);
+}
+
+void TestCacheEvictsLeastRecentlyUsedWithinBudget() {
+    const auto workspace = MakeWorkspace("lru");
+    kabot::session::SessionCacheOptions options{};
+    options.max_bytes = 6000;
+    kabot::session::SessionManager sessions(workspace.string(), options);
+    const std::string payload(2000, 'x');
+
+    auto pinned = sessions.GetOrCreate("pinned");
+    pinned->AddMessage("user", payload);
+    sessions.Save(*pinned);
+    for (const std::string key : {"a", "b", "c", "d"}) {
+        auto session = sessions.GetOrCreate(key);
+        session->AddMessage("user", payload + key);
+        sessions.Save(*session);
+    }
+
+    const auto stats = sessions.CacheStats();
+    Expect(stats.evictions >= 2, "expected sessions beyond the budget to be evicted");
+    Expect(stats.bytes <= options.max_bytes, "expected cached bytes to stay within the budget");
+    Expect(sessions.Get("pinned") == pinned, "expected a session with an open handle to stay cached");
+
+    const auto misses_before = sessions.CacheStats().misses;
+    const auto reloaded = sessions.Get("a");
+    Expect(sessions.CacheStats().misses == misses_before + 1, "expected the evicted session to miss the cache");
+    Expect(reloaded != nullptr && reloaded->Messages().size() == 1 && reloaded->Messages()[0].content == payload + "a",
+           "expected an evicted session to reload from disk");
+    std::filesystem::remove_all(workspace);
+}
+
+}  // namespace
+
+int main() {
+    TestSaveAppendsOnlyNewMessages();
+    TestFailedSaveIsRetried();
+    TestDetachedCopyRewritesHistory();
+    TestReplaceMessagesRewritesAndMetadataPersists();
+    TestCacheEvictsLeastRecentlyUsedWithinBudget();
+    std::cout << "session_manager_tests passed" << std::endl;
+    return 0;
+}
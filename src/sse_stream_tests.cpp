@@ -0,0 +1,139 @@
+#include "providers/sse_stream.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[sse_stream_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+void FeedInPieces(kabot::providers::SseParser& parser, const std::string& payload, std::size_t piece) {
+    for (std::size_t offset = 0; offset < payload.size(); offset += piece) {
+        const auto size = std::min(piece, payload.size() - offset);
+        parser.Feed(payload.data() + offset, size);
+    }
+}
+
+void TestParserHandlesSplitChunks() {
+    std::vector<std::pair<std::string, std::string>> events;
+    kabot::providers::SseParser parser([&events](const std::string& event, const std::string& data) {
+        events.emplace_back(event, data);
+    });
+    const std::string payload =
+        ": keep-alive\r\n"
+        "event: ping\r\n"
+        "data: {\"a\":1}\r\n"
+        "\r\n"
+        "data: line one\n"
+        "data: line two\n"
+        "\n"
+        "data: [DONE]";
+    FeedInPieces(parser, payload, 3);
+    parser.Finish();
+
+    Expect(events.size() == 3, "expected three events");
+    Expect(events[0].first == "ping" && events[0].second == "{\"a\":1}", "expected named event with CRLF framing");
+    Expect(events[1].first.empty() && events[1].second == "line one\nline two", "expected multi-line data to be joined");
+    Expect(events[2].second == "[DONE]", "expected trailing event to be flushed on finish");
+}
+
+void TestOpenAIAssemblerBuildsToolCalls() {
+    kabot::providers::OpenAIStreamAssembler assembler;
+    std::string text;
+    text += assembler.Consume(R"({"choices":[{"index":0,"delta":{"role":"assistant","content":"Hel"}}]})");
+    text += assembler.Consume(R"({"choices":[{"index":0,"delta":{"content":"lo"}}]})");
+    assembler.Consume(R"({"choices":[{"index":0,"delta":{"tool_calls":[{"index":0,"id":"call_1","type":"function","function":{"name":"read_file","arguments":""}}]}}]})");
+    assembler.Consume(R"({"choices":[{"index":0,"delta":{"tool_calls":[{"index":0,"function":{"arguments":"{\"path\":"}}]}}]})");
+    assembler.Consume(R"({"choices":[{"index":0,"delta":{"tool_calls":[{"index":0,"function":{"arguments":"\"a.txt\",\"limit\":5}"}}]}}]})");
+    assembler.Consume(R"({"choices":[{"index":0,"delta":{},"finish_reason":"tool_calls"}]})");
+    assembler.Consume(R"({"choices":[],"usage":{"prompt_tokens":10,"completion_tokens":4,"total_tokens":14}})");
+    assembler.Consume("[DONE]");
+
+    Expect(text == "Hello", "expected streamed text deltas");
+    Expect(assembler.Done(), "expected [DONE] to end the stream");
+    const auto response = assembler.Finish();
+    Expect(response.content == "Hello", "expected accumulated content");
+    Expect(response.finish_reason == "tool_calls", "expected finish reason");
+    Expect(response.tool_calls.size() == 1, "expected one tool call");
+    Expect(response.tool_calls[0].id == "call_1" && response.tool_calls[0].name == "read_file", "expected tool call identity");
+    Expect(response.tool_calls[0].arguments.at("path") == "a.txt", "expected string argument");
+    Expect(response.tool_calls[0].arguments.at("limit") == "5", "expected non-string argument dumped as json");
+    Expect(response.usage.at("total_tokens") == 14, "expected usage from the final chunk");
+}
+
+void TestAnthropicAssemblerBuildsToolUse() {
+    kabot::providers::AnthropicStreamAssembler assembler;
+    std::string text;
+    text += assembler.Consume("message_start", R"({"type":"message_start","message":{"usage":{"input_tokens":25,"output_tokens":1}}})");
+    text += assembler.Consume("content_block_start", R"({"type":"content_block_start","index":0,"content_block":{"type":"text","text":""}})");
+    text += assembler.Consume("content_block_delta", R"({"type":"content_block_delta","index":0,"delta":{"type":"text_delta","text":"Checking"}})");
+    text += assembler.Consume("ping", R"({"type":"ping"})");
+    assembler.Consume("content_block_stop", R"({"type":"content_block_stop","index":0})");
+    assembler.Consume("content_block_start", R"({"type":"content_block_start","index":1,"content_block":{"type":"tool_use","id":"toolu_1","name":"grep","input":{}}})");
+    assembler.Consume("content_block_delta", R"({"type":"content_block_delta","index":1,"delta":{"type":"input_json_delta","partial_json":"{\"pattern\": \"TODO"}})");
+    assembler.Consume("content_block_delta", R"({"type":"content_block_delta","index":1,"delta":{"type":"input_json_delta","partial_json":"\"}"}})");
+    assembler.Consume("message_delta", R"({"type":"message_delta","delta":{"stop_reason":"tool_use"},"usage":{"output_tokens":17}})");
+    assembler.Consume("message_stop", R"({"type":"message_stop"})");
+
+    Expect(text == "Checking", "expected text deltas only");
+    Expect(assembler.Done(), "expected message_stop to end the stream");
+    const auto response = assembler.Finish();
+    Expect(response.finish_reason == "tool_use", "expected stop reason");
+    Expect(response.tool_calls.size() == 1, "expected one tool call");
+    Expect(response.tool_calls[0].id == "toolu_1" && response.tool_calls[0].name == "grep", "expected tool use identity");
+    Expect(response.tool_calls[0].arguments.at("pattern") == "TODO", "expected assembled tool input");
+    Expect(response.usage.at("prompt_tokens") == 25 && response.usage.at("completion_tokens") == 17, "expected usage");
+}
+
+void TestCacheUsageIsReported() {
+    kabot::providers::AnthropicStreamAssembler anthropic;
+    anthropic.Consume("message_start", R"({"type":"message_start","message":{"usage":{"input_tokens":40,"cache_read_input_tokens":3000,"cache_creation_input_tokens":200,"output_tokens":1}}})");
+    anthropic.Consume("message_delta", R"({"type":"message_delta","delta":{"stop_reason":"end_turn"},"usage":{"output_tokens":12}})");
+    anthropic.Consume("message_stop", R"({"type":"message_stop"})");
+    const auto anthropic_response = anthropic.Finish();
+    Expect(anthropic_response.usage.at("prompt_tokens") == 3240, "expected cached tokens to count toward the prompt");
+    Expect(anthropic_response.usage.at("cache_read_tokens") == 3000, "expected cache reads");
+    Expect(anthropic_response.usage.at("cache_creation_tokens") == 200, "expected cache writes");
+    Expect(anthropic_response.usage.at("total_tokens") == 3252, "expected total to include cached tokens");
+
+    kabot::providers::OpenAIStreamAssembler openai;
+    openai.Consume(R"({"choices":[],"usage":{"prompt_tokens":900,"completion_tokens":5,"total_tokens":905,"prompt_tokens_details":{"cached_tokens":768}}})");
+    const auto openai_response = openai.Finish();
+    Expect(openai_response.usage.at("cache_read_tokens") == 768, "expected openai cached tokens");
+    Expect(openai_response.usage.count("cache_creation_tokens") == 0, "expected no cache writes for openai");
+}
+
+void TestStreamErrorsAreReported() {
+    kabot::providers::AnthropicStreamAssembler anthropic;
+    anthropic.Consume("error", R"({"type":"error","error":{"type":"overloaded_error","message":"Overloaded"}})");
+    const auto anthropic_response = anthropic.Finish();
+    Expect(anthropic_response.finish_reason == "error", "expected anthropic error finish reason");
+    Expect(anthropic_response.content.find("Overloaded") != std::string::npos, "expected anthropic error message");
+
+    kabot::providers::OpenAIStreamAssembler openai;
+    openai.Consume(R"({"error":{"message":"rate limited"}})");
+    const auto openai_response = openai.Finish();
+    Expect(openai_response.finish_reason == "error", "expected openai error finish reason");
+    Expect(openai_response.content.find("rate limited") != std::string::npos, "expected openai error message");
+}
+
+}  // namespace
+
+int main() {
+    TestParserHandlesSplitChunks();
+    TestOpenAIAssemblerBuildsToolCalls();
+    TestAnthropicAssemblerBuildsToolUse();
+    TestCacheUsageIsReported();
+    TestStreamErrorsAreReported();
+    std::cout << "sse_stream_tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,282 @@
+#include "task/git_workspace.hpp"
+
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#include "utils/logging.hpp"
+
+namespace kabot::task {
+namespace {
+
+std::string SafeName(const std::string& value) {
+    std::string name;
+    name.reserve(value.size());
+    for (const auto ch : value) {
+        const auto byte = static_cast<unsigned char>(ch);
+        name.push_back(std::isalnum(byte) || ch == '-' || ch == '_' || ch == '.' ? ch : '_');
+    }
+    if (name.empty() || name.front() == '.') {
+        name.insert(name.begin(), '_');
+    }
+    return name;
+}
+
+std::string TrimLine(std::string value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+        value.pop_back();
+    }
+    return value;
+}
+
+ProcessResult Git(const std::filesystem::path& dir, std::vector<std::string> args) {
+    args.insert(args.begin(), "git");
+    return RunProcess(dir, args);
+}
+
+}  // namespace
+
+#if defined(_WIN32)
+ProcessResult RunProcess(const std::filesystem::path& working_dir,
+                         const std::vector<std::string>& argv) {
+    std::string command = "cd /d \"" + working_dir.string() + "\" &&";
+    for (const auto& arg : argv) {
+        command += " \"" + arg + "\"";
+    }
+    command += " 2>&1";
+    ProcessResult result;
+    FILE* pipe = _popen(command.c_str(), "r");
+    if (!pipe) {
+        result.output = "failed to start " + (argv.empty() ? std::string() : argv.front());
+        return result;
+    }
+    std::array<char, 4096> buffer{};
+    std::size_t read = 0;
+    while ((read = std::fread(buffer.data(), 1, buffer.size(), pipe)) > 0) {
+        result.output.append(buffer.data(), read);
+    }
+    result.exit_code = _pclose(pipe);
+    return result;
+}
+#else
+namespace {
+
+// PATH lookup done before fork(), since the child of a multithreaded process
+// may only make async-signal-safe calls.
+std::string ResolveExecutable(const std::string& name) {
+    if (name.find('/') != std::string::npos) {
+        return name;
+    }
+    const char* path = std::getenv("PATH");
+    std::string dirs = path ? path : "/usr/local/bin:/usr/bin:/bin";
+    std::size_t start = 0;
+    while (start <= dirs.size()) {
+        auto end = dirs.find(':', start);
+        if (end == std::string::npos) {
+            end = dirs.size();
+        }
+        const auto dir = dirs.substr(start, end - start);
+        const auto candidate = (dir.empty() ? std::string(".") : dir) + "/" + name;
+        if (access(candidate.c_str(), X_OK) == 0) {
+            return candidate;
+        }
+        start = end + 1;
+    }
+    return name;
+}
+
+}  // namespace
+
+ProcessResult RunProcess(const std::filesystem::path& working_dir,
+                         const std::vector<std::string>& argv) {
+    ProcessResult result;
+    if (argv.empty()) {
+        return result;
+    }
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        result.output = std::error_code(errno, std::generic_category()).message();
+        return result;
+    }
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const auto& arg : argv) {
+        args.push_back(const_cast<char*>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    const auto dir = working_dir.string();
+    const auto executable = ResolveExecutable(argv.front());
+
+    // Never block a task on a credential prompt.
+    static constexpr char kNoPrompt[] = "GIT_TERMINAL_PROMPT=0";
+    std::vector<char*> env;
+    for (char** entry = environ; entry && *entry; ++entry) {
+        if (std::strncmp(*entry, "GIT_TERMINAL_PROMPT=", 20) != 0) {
+            env.push_back(*entry);
+        }
+    }
+    env.push_back(const_cast<char*>(kNoPrompt));
+    env.push_back(nullptr);
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        result.output = std::error_code(errno, std::generic_category()).message();
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+    if (pid == 0) {
+        const int null_fd = open("/dev/null", O_RDONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+        }
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        if (!dir.empty() && chdir(dir.c_str()) != 0) {
+            _exit(127);
+        }
+        execve(executable.c_str(), args.data(), env.data());
+        _exit(127);
+    }
+
+    close(fds[1]);
+    std::array<char, 4096> buffer{};
+    for (;;) {
+        const auto n = read(fds[0], buffer.data(), buffer.size());
+        if (n > 0) {
+            result.output.append(buffer.data(), static_cast<std::size_t>(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    close(fds[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return result;
+}
+#endif
+
+GitWorkspaceCache::GitWorkspaceCache()
+    : cleanup_(1) {}
+
+GitWorkspaceCache::~GitWorkspaceCache() {
+    cleanup_.Shutdown();
+}
+
+std::shared_ptr<std::mutex> GitWorkspaceCache::MirrorLock(const std::filesystem::path& mirror) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& lock = mirror_locks_[mirror.string()];
+    if (!lock) {
+        lock = std::make_shared<std::mutex>();
+    }
+    return lock;
+}
+
+GitWorktree GitWorkspaceCache::Acquire(const std::filesystem::path& projects_root,
+                                       const std::string& project,
+                                       const std::string& git_url,
+                                       const std::string& task_id) {
+    GitWorktree worktree;
+    const auto name = SafeName(project);
+    worktree.mirror = projects_root / ".mirrors" / (name + ".git");
+    worktree.path = projects_root / name / SafeName(task_id);
+    worktree.branch = "kabot-task-" + SafeName(task_id);
+
+    const auto lock = MirrorLock(worktree.mirror);
+    std::lock_guard<std::mutex> guard(*lock);
+
+    std::error_code ec;
+    std::filesystem::create_directories(worktree.mirror.parent_path(), ec);
+    std::filesystem::create_directories(worktree.path.parent_path(), ec);
+    if (!std::filesystem::exists(worktree.mirror / "HEAD")) {
+        std::filesystem::remove_all(worktree.mirror, ec);
+        const auto clone = Git(projects_root, {"clone", "--bare", "--", git_url, worktree.mirror.string()});
+        if (!clone.Ok()) {
+            worktree.error = "clone failed: " + clone.output;
+            std::filesystem::remove_all(worktree.mirror, ec);
+            return worktree;
+        }
+        worktree.cloned = true;
+    } else {
+        // Keep the mirror pointed at the URL the relay handed us.
+        Git(worktree.mirror, {"remote", "set-url", "origin", git_url});
+    }
+
+    // Remote branches live under refs/remotes/origin so pruning never
+    // touches task branches, which only exist locally until pushed.
+    const auto fetch = Git(worktree.mirror,
+                           {"fetch", "--prune", "origin", "+refs/heads/*:refs/remotes/origin/*"});
+    if (!fetch.Ok()) {
+        worktree.error = "fetch failed: " + fetch.output;
+        return worktree;
+    }
+    const auto head = Git(worktree.mirror, {"symbolic-ref", "--short", "HEAD"});
+    worktree.base_branch = head.Ok() ? TrimLine(head.output) : "main";
+
+    if (std::filesystem::exists(worktree.path)) {
+        Git(worktree.mirror, {"worktree", "remove", "--force", worktree.path.string()});
+        std::filesystem::remove_all(worktree.path, ec);
+    }
+    Git(worktree.mirror, {"worktree", "prune"});
+    const auto add = Git(worktree.mirror, {"worktree",
+                                           "add",
+                                           "-B",
+                                           worktree.branch,
+                                           worktree.path.string(),
+                                           "refs/remotes/origin/" + worktree.base_branch});
+    if (!add.Ok()) {
+        worktree.error = "worktree add failed: " + add.output;
+        return worktree;
+    }
+    worktree.ok = true;
+    return worktree;
+}
+
+void GitWorkspaceCache::Release(const GitWorktree& worktree) {
+    if (!worktree.ok) {
+        return;
+    }
+    cleanup_.Submit([this, worktree] {
+        const auto lock = MirrorLock(worktree.mirror);
+        std::lock_guard<std::mutex> guard(*lock);
+        const auto removed = Git(worktree.mirror, {"worktree", "remove", "--force", worktree.path.string()});
+        if (!removed.Ok()) {
+            LOG_WARN("[git] worktree remove failed path={} output={}", worktree.path.string(), removed.output);
+            std::error_code ec;
+            std::filesystem::remove_all(worktree.path, ec);
+            Git(worktree.mirror, {"worktree", "prune"});
+        }
+        if (!worktree.branch.empty()) {
+            const auto deleted = Git(worktree.mirror, {"branch", "-D", "--", worktree.branch});
+            if (!deleted.Ok()) {
+                LOG_WARN("[git] branch delete failed branch={} output={}", worktree.branch, deleted.output);
+            }
+        }
+    });
+}
+
+void GitWorkspaceCache::Drain() {
+    auto done = std::make_shared<std::promise<void>>();
+    auto future = done->get_future();
+    cleanup_.Submit([done] { done->set_value(); });
+    future.wait();
+}
+
+}  // namespace kabot::task
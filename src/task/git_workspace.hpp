@@ -0,0 +1,59 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/thread_pool.hpp"
+
+namespace kabot::task {
+
+struct ProcessResult {
+    int exit_code = -1;
+    std::string output;  // stdout and stderr interleaved
+
+    bool Ok() const { return exit_code == 0; }
+};
+
+// Runs argv directly, without a shell, so arguments never need quoting.
+ProcessResult RunProcess(const std::filesystem::path& working_dir,
+                         const std::vector<std::string>& argv);
+
+struct GitWorktree {
+    bool ok = false;
+    std::string error;
+    std::filesystem::path path;
+    std::filesystem::path mirror;
+    std::string branch;
+    std::string base_branch;  // remote default branch the task branch starts from
+    bool cloned = false;      // false when an existing mirror was only fetched
+};
+
+// One bare mirror per project under <projects>/.mirrors, refreshed with an
+// incremental fetch, and one `git worktree` per task so concurrent tasks on
+// a project never share a checkout. Worktrees are removed in the background.
+class GitWorkspaceCache {
+public:
+    GitWorkspaceCache();
+    ~GitWorkspaceCache();
+
+    GitWorktree Acquire(const std::filesystem::path& projects_root,
+                        const std::string& project,
+                        const std::string& git_url,
+                        const std::string& task_id);
+    void Release(const GitWorktree& worktree);
+    // Blocks until queued releases have run.
+    void Drain();
+
+private:
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<std::mutex>> mirror_locks_;
+    kabot::ThreadPool cleanup_;
+
+    std::shared_ptr<std::mutex> MirrorLock(const std::filesystem::path& mirror);
+};
+
+}  // namespace kabot::task
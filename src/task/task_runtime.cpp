@@ -1,10 +1,8 @@
 #include "task/task_runtime.hpp"
 
 #include <algorithm>
-#include <array>
 #include <cctype>
 #include <chrono>
-#include <cstdio>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
@@ -14,7 +12,9 @@
 #include "agent/memory_store.hpp"
 #include "nlohmann/json.hpp"
 #include "session/session_manager.hpp"
+#include "task/git_workspace.hpp"
 #include "utils/cancel_token.hpp"
+#include "utils/timer_service.hpp"
 #include "utils/logging.hpp"
 
 namespace kabot::task {
@@ -30,29 +30,6 @@ std::string BuildWaitingKey(const std::string& channel_instance,
     return channel_instance + ":" + agent_name + ":" + chat_id;
 }
 
-// Execute a shell command and return stdout
-std::string ExecuteCommand(const std::string& cmd) {
-    std::array<char, 128> buffer{};
-    std::string result;
-#if defined(_WIN32)
-    FILE* pipe = _popen(cmd.c_str(), "r");
-#else
-    FILE* pipe = popen(cmd.c_str(), "r");
-#endif
-    if (!pipe) {
-        return "";
-    }
-    while (fgets(buffer.data(), static_cast<int>(buffer.size()), pipe) != nullptr) {
-        result += buffer.data();
-    }
-#if defined(_WIN32)
-    _pclose(pipe);
-#else
-    pclose(pipe);
-#endif
-    return result;
-}
-
 std::string ToLower(std::string value) {
     std::transform(value.begin(), value.end(), value.begin(), [](unsigned char ch) {
         return static_cast<char>(std::tolower(ch));
@@ -218,7 +195,9 @@ void TaskRuntime::Start() {
     running_ = true;
     const auto pool_size = std::max(1, config_.task_system.max_concurrent_tasks);
     task_pool_ = std::make_unique<kabot::ThreadPool>(static_cast<std::size_t>(pool_size));
+    abandon_pool_ = std::make_unique<kabot::ThreadPool>(1);
     EnsureDailySummaryJobs();
+    relay_.SetTaskAvailableHandler([this](const std::string& local_agent) { WakeClaimLoop(local_agent); });
     const auto auto_claim_agents = relay_.AutoClaimLocalAgents();
     for (const auto& local_agent : auto_claim_agents) {
         poll_threads_.emplace_back([this, local_agent] { AgentPollLoop(local_agent); });
@@ -231,6 +210,11 @@ void TaskRuntime::Stop() {
         return;
     }
     running_ = false;
+    relay_.SetTaskAvailableHandler(nullptr);
+    {
+        std::lock_guard<std::mutex> guard(claim_mutex_);
+    }
+    claim_cv_.notify_all();
     for (auto& t : poll_threads_) {
         if (t.joinable()) {
             t.join();
@@ -241,6 +225,17 @@ void TaskRuntime::Stop() {
         task_pool_->Shutdown();
         task_pool_->WaitForEmpty(std::chrono::seconds(config_.task_system.shutdown_timeout_s));
     }
+    // Cancelling waits out a callback already running, so none can reach
+    // abandon_pool_ once it is shut down.
+    std::unordered_map<std::string, kabot::ScopedTimer> grace_timers;
+    {
+        std::lock_guard<std::mutex> guard(grace_mutex_);
+        grace_timers.swap(grace_timers_);
+    }
+    grace_timers.clear();
+    if (abandon_pool_) {
+        abandon_pool_->Shutdown();
+    }
     RemoveDailySummaryJobs();
     SaveState();
 }
@@ -277,6 +272,8 @@ std::string TaskRuntime::DumpStateJson() const {
     json["enabled"] = config_.task_system.enabled;
     json["running"] = running_.load();
     json["pollIntervalS"] = config_.task_system.poll_interval_s;
+    json["maxPollIntervalS"] = config_.task_system.max_poll_interval_s;
+    json["pendingTimers"] = kabot::TimerService::Shared().PendingCount();
     json["dailySummaryHourLocal"] = config_.task_system.daily_summary_hour_local;
     json["dailySummaries"] = nlohmann::json::array();
     json["waitingTasks"] = nlohmann::json::array();
@@ -301,18 +298,26 @@ std::string TaskRuntime::DumpStateJson() const {
             {"channelInstance", task.channel_instance},
             {"chatId", task.chat_id},
             {"agentName", task.agent_name},
-            {"updatedAt", task.updated_at}
+            {"updatedAt", task.updated_at},
+            {"worktreePath", task.worktree.ok ? task.worktree.path.string() : std::string()},
+            {"worktreeMirror", task.worktree.ok ? task.worktree.mirror.string() : std::string()},
+            {"worktreeBranch", task.worktree.ok ? task.worktree.branch : std::string()}
         });
     }
     return json.dump(2);
 }
 
 void TaskRuntime::AgentPollLoop(const std::string& local_agent) {
-    const auto poll_interval = std::max(5, config_.task_system.poll_interval_s);
+    // A relay "task.available" push or a freed local slot wakes the loop at
+    // once; the timer is only a fallback and backs off while nothing is queued.
+    const auto min_interval = std::chrono::seconds(std::max(5, config_.task_system.poll_interval_s));
+    const auto max_interval = std::max(min_interval, std::chrono::seconds(config_.task_system.max_poll_interval_s));
+    auto interval = min_interval;
     while (running_) {
         if (!HasPendingTaskForLocalAgent(local_agent)) {
             const auto claim = relay_.ClaimNextTask(local_agent, true);
             if (claim.success && claim.found && !claim.task.task_id.empty()) {
+                interval = min_interval;
                 const auto session_key = claim.task.session_key.empty()
                     ? "task:" + local_agent + ":" + claim.task.task_id
                     : claim.task.session_key;
@@ -330,13 +335,30 @@ void TaskRuntime::AgentPollLoop(const std::string& local_agent) {
                         ExecuteClaimedTask(local_agent, task);
                     });
                 }
-            } else if (!claim.success) {
-                LOG_WARN("[task] claim next task failed for local_agent={} http_status={} message={}",
-                         local_agent, claim.http_status, claim.message);
+            } else {
+                if (!claim.success) {
+                    LOG_WARN("[task] claim next task failed for local_agent={} http_status={} message={}",
+                             local_agent, claim.http_status, claim.message);
+                }
+                interval = std::min(max_interval, interval * 2);
             }
         }
-        std::this_thread::sleep_for(std::chrono::seconds(poll_interval));
+        std::unique_lock<std::mutex> lock(claim_mutex_);
+        if (claim_cv_.wait_for(lock, interval, [this, &local_agent] {
+                return !running_ || claim_wakeups_.count(local_agent) > 0;
+            })) {
+            claim_wakeups_.erase(local_agent);
+            interval = min_interval;
+        }
+    }
+}
+
+void TaskRuntime::WakeClaimLoop(const std::string& local_agent) {
+    {
+        std::lock_guard<std::mutex> guard(claim_mutex_);
+        claim_wakeups_.insert(local_agent);
     }
+    claim_cv_.notify_all();
 }
 
 void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
@@ -424,44 +446,59 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
     bool waiting = false;
     kabot::relay::RelayTaskInteraction waiting_user{};
     std::string waiting_question;
-    kabot::CancelToken cancel_token;
-    std::atomic<bool> finished{false};
+    // Shared with the timeout timers, which may fire after this returns.
+    auto cancel_token = std::make_shared<kabot::CancelToken>();
+    auto finished = std::make_shared<std::atomic<bool>>(false);
 
-    // Git workflow setup
+    // Git workflow setup: a worktree of the cached project mirror, private to
+    // this task. It is released when the task ends, unless the task parks
+    // waiting for the user and may continue in it later.
     std::filesystem::path project_dir;
     bool has_git_workflow = false;
+    GitWorktree worktree;
+    bool keep_worktree = false;
+    struct WorktreeRelease {
+        GitWorkspaceCache& cache;
+        const GitWorktree& worktree;
+        const bool& keep;
+        ~WorktreeRelease() {
+            if (!keep) {
+                cache.Release(worktree);
+            }
+        }
+    } worktree_release{git_workspaces_, worktree, keep_worktree};
     if (!project_git_url.empty() && !project_name.empty()) {
         has_git_workflow = true;
-        project_dir = std::filesystem::path(workspace) / "projects" / project_name;
-        
-        // 2.1 Create projects/ directory
-        std::filesystem::create_directories(project_dir.parent_path());
-        
-        // 2.2 Clone repository
-        const auto clone_cmd = "git clone --depth 1 \"" + project_git_url + "\" \"" + project_dir.string() + "\" 2>&1";
-        const auto clone_output = ExecuteCommand(clone_cmd);
-        if (!std::filesystem::exists(project_dir / ".git")) {
-            // 2.3 Handle clone failure
-            LOG_ERROR("[task_runtime] Failed to clone repository: {}", clone_output);
+        const auto started = std::chrono::steady_clock::now();
+        worktree = git_workspaces_.Acquire(std::filesystem::path(workspace) / "projects",
+                                           project_name,
+                                           project_git_url,
+                                           task.task_id);
+        if (!worktree.ok) {
+            LOG_ERROR("[task_runtime] Failed to prepare repository: {}", worktree.error);
             WriteTaskMemory(workspace, task.task_id, project_name, "failed",
-                           "[git] Clone failed: " + clone_output);
+                           "[git] Checkout failed: " + worktree.error);
             CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task.task_id, {
                 "failed",
-                "Failed to clone repository: " + clone_output,
+                "Failed to prepare repository: " + worktree.error,
                 -1,
                 NowIso(),
                 session_key
             }), task.task_id, "failed");
             ClearActiveTask(local_agent);
-            finished.store(true);
+            finished->store(true);
             return;
         }
-
-        // Log successful clone
+        project_dir = worktree.path;
+        const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        LOG_INFO("[task_runtime] task {} worktree ready path={} cloned={} elapsed_ms={}",
+                 task.task_id, project_dir.string(), worktree.cloned, elapsed_ms);
         WriteTaskMemory(workspace, task.task_id, project_name, "running",
-                       "[git] Cloned " + project_git_url + " to " + project_dir.string());
-        
-        // 2.4 Verify .gitignore
+                       std::string("[git] ") + (worktree.cloned ? "Cloned " : "Fetched ") + project_git_url +
+                       " and checked out branch " + worktree.branch + " at " + project_dir.string());
+
+        // Verify .gitignore
         const auto gitignore_path = project_dir / ".gitignore";
         std::string gitignore_content;
         if (std::filesystem::exists(gitignore_path)) {
@@ -469,12 +506,12 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
             gitignore_content = std::string((std::istreambuf_iterator<char>(gitignore_file)),
                                             std::istreambuf_iterator<char>());
         }
-        
+
         const std::vector<std::string> required_patterns = {
-            "build/", "*.exe", "*.tmp", ".env", ".vscode/", ".idea/", 
+            "build/", "*.exe", "*.tmp", ".env", ".vscode/", ".idea/",
             "*.log", "node_modules/", "__pycache__/", ".DS_Store", "Thumbs.db"
         };
-        
+
         bool needs_update = false;
         std::string patterns_to_add;
         for (const auto& pattern : required_patterns) {
@@ -483,58 +520,76 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
                 patterns_to_add += pattern + "\n";
             }
         }
-        
-        // 2.5 Update .gitignore if needed
+
+        // Update .gitignore on the task branch if needed
         if (needs_update) {
             std::ofstream gitignore_out(gitignore_path, std::ios::app);
             if (gitignore_out) {
                 gitignore_out << "\n# Added by kabot agent\n" << patterns_to_add;
                 gitignore_out.close();
-                
-                // Commit .gitignore update to default branch
-                ExecuteCommand("cd \"" + project_dir.string() + "\" && git add .gitignore && git commit -m \"chore: update .gitignore\"");
+                RunProcess(project_dir, {"git", "add", ".gitignore"});
+                RunProcess(project_dir, {"git", "commit", "-m", "chore: update .gitignore"});
             }
         }
-        
-        // 2.6 Create task branch
-        const auto branch_name = "kabot-task-" + task.task_id;
-        const auto branch_cmd = "cd \"" + project_dir.string() + "\" && git checkout -b " + branch_name + " 2>&1";
-        const auto branch_output = ExecuteCommand(branch_cmd);
-
-        // Log branch creation
-        WriteTaskMemory(workspace, task.task_id, project_name, "running",
-                       "[git] Created branch " + branch_name);
-
-        // 2.7 Handle existing branch
-        if (branch_output.find("already exists") != std::string::npos) {
-            ExecuteCommand("cd \"" + project_dir.string() + "\" && git checkout " + branch_name + " && git reset --hard HEAD");
-            WriteTaskMemory(workspace, task.task_id, project_name, "running",
-                           "[git] Reset existing branch " + branch_name);
-        }
     }
 
     const auto timeout_s = std::max(0, config_.task_system.task_timeout_s);
     const auto grace_s = std::max(0, config_.task_system.shutdown_timeout_s);
 
-    if (timeout_s > 0) {
-        std::thread([this, &cancel_token, &finished, local_agent, task_id = task.task_id, session_key, timeout_s, grace_s] {
-            std::this_thread::sleep_for(std::chrono::seconds(timeout_s));
-            if (finished.load()) return;
-            cancel_token.Cancel();
-            if (grace_s > 0) {
-                std::this_thread::sleep_for(std::chrono::seconds(grace_s));
+    // Declared before timeout_timer so it runs after that timer is cancelled
+    // and no new grace timer can be armed for this task.
+    struct GraceTimerRelease {
+        TaskRuntime& runtime;
+        const std::string& task_id;
+        ~GraceTimerRelease() {
+            kabot::ScopedTimer timer;
+            {
+                std::lock_guard<std::mutex> guard(runtime.grace_mutex_);
+                auto it = runtime.grace_timers_.find(task_id);
+                if (it == runtime.grace_timers_.end()) {
+                    return;
+                }
+                timer = std::move(it->second);
+                runtime.grace_timers_.erase(it);
             }
-            if (finished.load()) return;
-            LOG_WARN("[task_runtime] task {} on agent {} hard-abandoned after timeout", task_id, local_agent);
-            ClearActiveTask(local_agent);
-            CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task_id, {
-                "failed",
-                "Task " + task_id + " timed out and was abandoned",
-                -1,
-                NowIso(),
-                session_key
-            }), task_id, "failed");
-        }).detach();
+        }
+    } grace_timer_release{*this, task.task_id};
+    kabot::ScopedTimer timeout_timer;
+    if (timeout_s > 0) {
+        auto& timers = kabot::TimerService::Shared();
+        const auto timer_id = timers.ScheduleAfter(
+            std::chrono::seconds(timeout_s),
+            [this, &timers, cancel_token, finished, local_agent, task_id = task.task_id, session_key, grace_s] {
+                if (finished->load()) {
+                    return;
+                }
+                cancel_token->Cancel();
+                const auto grace_id = timers.ScheduleAfter(
+                    std::chrono::seconds(grace_s), [this, finished, local_agent, task_id, session_key] {
+                        if (finished->load()) {
+                            return;
+                        }
+                        LOG_WARN("[task_runtime] task {} on agent {} hard-abandoned after timeout",
+                                 task_id, local_agent);
+                        // The status report is an HTTP call; keep it off the timer thread.
+                        abandon_pool_->Submit([this, local_agent, task_id, session_key] {
+                            ClearActiveTask(local_agent);
+                            CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task_id, {
+                                "failed",
+                                "Task " + task_id + " timed out and was abandoned",
+                                -1,
+                                NowIso(),
+                                session_key
+                            }), task_id, "failed");
+                        });
+                    });
+                kabot::ScopedTimer grace_timer(timers, grace_id);
+                std::lock_guard<std::mutex> guard(grace_mutex_);
+                if (running_) {  // otherwise Stop already swept the timers
+                    grace_timers_[task_id] = std::move(grace_timer);
+                }
+            });
+        timeout_timer = kabot::ScopedTimer(timers, timer_id);
     }
 
     try {
@@ -590,7 +645,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
                                                   observer,
                                                   target,
                                                   outbound_observer,
-                                                  cancel_token);
+                                                  *cancel_token);
 
         if (waiting && !waiting_user.chat_id.empty()) {
             WaitingTask waiting_task{};
@@ -606,6 +661,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
             waiting_task.reply_to = waiting_user.reply_to;
             waiting_task.agent_name = local_agent;
             waiting_task.updated_at = NowIso();
+            waiting_task.worktree = worktree;
             {
                 std::lock_guard<std::mutex> guard(mutex_);
                 waiting_tasks_[BuildWaitingKey(waiting_task.channel_instance,
@@ -614,6 +670,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
                 active_tasks_.erase(local_agent);
                 SaveState();
             }
+            keep_worktree = true;
             CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task.task_id, {
                 "waiting_user",
                 waiting_question.empty() ? "Waiting for user input on task " + task.task_id
@@ -625,7 +682,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
                 {},
                 waiting_user
             }), task.task_id, "waiting_user");
-            finished.store(true);
+            finished->store(true);
             return;
         }
 
@@ -633,31 +690,40 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
         std::string mr_url;
         std::string mr_created_at;
         if (has_git_workflow && !project_dir.empty()) {
-            const auto branch_name = "kabot-task-" + task.task_id;
-            const auto project_path = project_dir.string();
-            
+            const auto& branch_name = worktree.branch;
+
             // 3.1 Detect uncommitted changes
-            const auto status_output = ExecuteCommand("cd \"" + project_path + "\" && git status --porcelain");
+            const auto status_output = RunProcess(project_dir, {"git", "status", "--porcelain"}).output;
             const bool has_changes = !Trim(status_output).empty();
-            
+
             if (has_changes) {
                 // 3.2 Commit changes
                 const auto commit_msg = "kabot: " + task.title + " [task-" + task.task_id + "]";
-                ExecuteCommand("cd \"" + project_path + "\" && git add -A && git commit -m \"" + commit_msg + "\"");
+                RunProcess(project_dir, {"git", "add", "-A"});
+                RunProcess(project_dir, {"git", "commit", "-m", commit_msg});
                 WriteTaskMemory(workspace, task.task_id, project_name, "running",
                                "[git] Committed changes with message: " + commit_msg);
-                
+
                 // 3.3 Push branch
-                ExecuteCommand("cd \"" + project_path + "\" && git push origin " + branch_name);
+                RunProcess(project_dir, {"git", "push", "origin", branch_name});
                 WriteTaskMemory(workspace, task.task_id, project_name, "running",
                                "[git] Pushed branch " + branch_name);
-                
+
                 // 3.4 Create MR using platform CLI
-                const auto mr_cmd = "cd \"" + project_path + "\" && (glab mr create --source-branch " + branch_name + 
-                                   " --target-branch main --title \"" + task.title + "\" --description \"Automated MR from kabot task " + task.task_id + "\" 2>&1 || " +
-                                   "gh pr create --head " + branch_name + " --base main --title \"" + task.title + "\" --body \"Automated PR from kabot task " + task.task_id + "\" 2>&1)";
-                const auto mr_output = ExecuteCommand(mr_cmd);
-                
+                auto mr = RunProcess(project_dir, {"glab", "mr", "create",
+                                                   "--source-branch", branch_name,
+                                                   "--target-branch", worktree.base_branch,
+                                                   "--title", task.title,
+                                                   "--description", "Automated MR from kabot task " + task.task_id});
+                if (!mr.Ok()) {
+                    mr = RunProcess(project_dir, {"gh", "pr", "create",
+                                                  "--head", branch_name,
+                                                  "--base", worktree.base_branch,
+                                                  "--title", task.title,
+                                                  "--body", "Automated PR from kabot task " + task.task_id});
+                }
+                const auto& mr_output = mr.output;
+
                 // Extract MR URL from output
                 const auto url_pos = mr_output.find("http");
                 if (url_pos != std::string::npos) {
@@ -753,7 +819,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
     } catch (const std::exception& ex) {
         ClearActiveTask(local_agent);
 
-        const bool cancelled = cancel_token.IsCancelled();
+        const bool cancelled = cancel_token->IsCancelled();
         CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task.task_id, {
             "failed",
             cancelled ? "Task " + task.task_id + " cancelled after timeout"
@@ -771,7 +837,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
     } catch (...) {
         ClearActiveTask(local_agent);
 
-        const bool cancelled = cancel_token.IsCancelled();
+        const bool cancelled = cancel_token->IsCancelled();
         CheckStatusUpdate(relay_.UpdateTaskStatus(local_agent, task.task_id, {
             "failed",
             cancelled ? "Task " + task.task_id + " cancelled after timeout"
@@ -787,7 +853,7 @@ void TaskRuntime::ExecuteClaimedTask(const std::string& local_agent,
                        cancelled ? "Task cancelled by timeout" : "Task failed with unknown error");
     }
 
-    finished.store(true);
+    finished->store(true);
 }
 
 bool TaskRuntime::ResumeWaitingTask(const WaitingTask& waiting_task,
@@ -879,8 +945,11 @@ void TaskRuntime::MarkActiveTask(const std::string& local_agent,
 }
 
 void TaskRuntime::ClearActiveTask(const std::string& local_agent) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    active_tasks_.erase(local_agent);
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        active_tasks_.erase(local_agent);
+    }
+    WakeClaimLoop(local_agent);
 }
 
 void TaskRuntime::EnsureDailySummaryJobs() {
@@ -1076,6 +1145,7 @@ bool TaskRuntime::TryResumeWaitingTask(const kabot::bus::InboundMessage& msg,
                 result
             }), waiting_task.task_id, "completed");
         }
+        git_workspaces_.Release(waiting_task.worktree);
     }
     return true;
 }
@@ -1094,21 +1164,35 @@ void TaskRuntime::UpsertWaitingTask(const kabot::bus::InboundMessage& msg,
     waiting_task.agent_name = msg.agent_name;
     waiting_task.updated_at = NowIso();
 
-    std::lock_guard<std::mutex> guard(mutex_);
-    waiting_tasks_[BuildWaitingKey(waiting_task.channel_instance,
-                                   waiting_task.agent_name,
-                                   waiting_task.chat_id)] = std::move(waiting_task);
-    SaveState();
+    GitWorktree replaced;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto& slot = waiting_tasks_[BuildWaitingKey(waiting_task.channel_instance,
+                                                    waiting_task.agent_name,
+                                                    waiting_task.chat_id)];
+        replaced = std::move(slot.worktree);
+        slot = std::move(waiting_task);
+        SaveState();
+    }
+    git_workspaces_.Release(replaced);
 }
 
 void TaskRuntime::ClearWaitingTask(const kabot::bus::InboundMessage& msg) {
-    std::lock_guard<std::mutex> guard(mutex_);
-    const auto it = waiting_tasks_.find(WaitingKey(msg));
-    if (it == waiting_tasks_.end()) {
-        return;
+    std::string local_agent;
+    GitWorktree worktree;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        const auto it = waiting_tasks_.find(WaitingKey(msg));
+        if (it == waiting_tasks_.end()) {
+            return;
+        }
+        local_agent = it->second.local_agent;
+        worktree = std::move(it->second.worktree);
+        waiting_tasks_.erase(it);
+        SaveState();
     }
-    waiting_tasks_.erase(it);
-    SaveState();
+    git_workspaces_.Release(worktree);
+    WakeClaimLoop(local_agent);
 }
 
 bool TaskRuntime::ShouldWaitForUser(const kabot::bus::InboundMessage& msg,
@@ -1363,6 +1447,11 @@ void TaskRuntime::LoadWaitingTasks() {
         waiting_task.reply_to = item.value("replyTo", std::string());
         waiting_task.agent_name = item.value("agentName", std::string());
         waiting_task.updated_at = item.value("updatedAt", std::string());
+        waiting_task.worktree.path = item.value("worktreePath", std::string());
+        waiting_task.worktree.mirror = item.value("worktreeMirror", std::string());
+        waiting_task.worktree.branch = item.value("worktreeBranch", std::string());
+        waiting_task.worktree.ok = !waiting_task.worktree.path.empty() &&
+                                   !waiting_task.worktree.mirror.empty();
         if (waiting_task.channel_instance.empty() || waiting_task.chat_id.empty()) {
             continue;
         }
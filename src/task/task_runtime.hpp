@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
 #include <filesystem>
 #include <mutex>
 #include <string>
@@ -15,7 +16,9 @@
 #include "config/config_schema.hpp"
 #include "cron/cron_service.hpp"
 #include "relay/relay_manager.hpp"
+#include "task/git_workspace.hpp"
 #include "utils/thread_pool.hpp"
+#include "utils/timer_service.hpp"
 
 namespace kabot::task {
 
@@ -56,6 +59,8 @@ private:
         std::string reply_to;
         std::string agent_name;
         std::string updated_at;
+        // Kept checked out while the task waits; released once it finishes.
+        GitWorktree worktree;
     };
 
     struct ActiveTask {
@@ -66,6 +71,7 @@ private:
     };
 
     void AgentPollLoop(const std::string& local_agent);
+    void WakeClaimLoop(const std::string& local_agent);
     void ExecuteClaimedTask(const std::string& local_agent,
                             const kabot::relay::RelayTask& task);
     bool ResumeWaitingTask(const WaitingTask& waiting_task,
@@ -115,12 +121,22 @@ private:
     std::atomic<bool> running_{false};
     std::vector<std::thread> poll_threads_;
     std::unique_ptr<kabot::ThreadPool> task_pool_;
+    // Hard-abandon timers armed when a task times out, keyed by task id, and
+    // the thread their status reports run on. Both are torn down in Stop so
+    // nothing outlives the runtime.
+    std::mutex grace_mutex_;
+    std::unordered_map<std::string, kabot::ScopedTimer> grace_timers_;
+    std::unique_ptr<kabot::ThreadPool> abandon_pool_;
+    GitWorkspaceCache git_workspaces_;
     std::vector<std::string> cron_job_ids_;
     std::unordered_map<std::string, DailySummaryRecord> daily_summary_records_;
     std::unordered_map<std::string, WaitingTask> waiting_tasks_;
     std::unordered_map<std::string, ActiveTask> active_tasks_;
     std::unordered_set<std::string> claimed_task_ids_;
     mutable std::mutex mutex_;
+    std::mutex claim_mutex_;
+    std::condition_variable claim_cv_;
+    std::unordered_set<std::string> claim_wakeups_;
 };
 
 }  // namespace kabot::task
@@ -0,0 +1,109 @@
+#include "utils/timer_service.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[timer_service_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+void TestFiresInDeadlineOrder() {
+    kabot::TimerService timers;
+    std::mutex mutex;
+    std::vector<int> fired;
+    const auto record = [&](int value) {
+        return [&, value] {
+            std::lock_guard<std::mutex> lock(mutex);
+            fired.push_back(value);
+        };
+    };
+    timers.ScheduleAfter(std::chrono::milliseconds(60), record(3));
+    timers.ScheduleAfter(std::chrono::milliseconds(20), record(1));
+    timers.ScheduleAfter(std::chrono::milliseconds(40), record(2));
+    Expect(timers.PendingCount() == 3, "expected three pending timers");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    std::lock_guard<std::mutex> lock(mutex);
+    Expect(fired == std::vector<int>({1, 2, 3}), "expected timers to fire by deadline");
+    Expect(timers.PendingCount() == 0, "expected no pending timers after firing");
+}
+
+void TestCancelBeforeDeadline() {
+    kabot::TimerService timers;
+    std::atomic<bool> fired{false};
+    const auto id = timers.ScheduleAfter(std::chrono::milliseconds(30), [&fired] { fired.store(true); });
+    Expect(timers.Cancel(id), "expected a pending timer to cancel");
+    Expect(!timers.Cancel(id), "expected a second cancel to report nothing pending");
+    Expect(timers.PendingCount() == 0, "expected cancel to drop the timer");
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    Expect(!fired.load(), "expected a cancelled timer not to fire");
+}
+
+void TestCancelWaitsForRunningCallback() {
+    kabot::TimerService timers;
+    std::atomic<bool> started{false};
+    auto state = std::make_unique<std::atomic<int>>(0);
+    const auto id = timers.ScheduleAfter(std::chrono::milliseconds(0), [&started, value = state.get()] {
+        started.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        value->store(1);
+    });
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    Expect(!timers.Cancel(id), "expected a running timer not to count as cancelled");
+    Expect(state->load() == 1, "expected cancel to wait for the running callback");
+    state.reset();
+}
+
+void TestScopedTimerCancelsOnExit() {
+    kabot::TimerService timers;
+    std::atomic<bool> fired{false};
+    {
+        kabot::ScopedTimer timer(timers, timers.ScheduleAfter(std::chrono::milliseconds(30), [&fired] {
+            fired.store(true);
+        }));
+        Expect(timers.PendingCount() == 1, "expected scoped timer to be pending");
+    }
+    Expect(timers.PendingCount() == 0, "expected scoped timer to cancel on exit");
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    Expect(!fired.load(), "expected scoped timer not to fire");
+}
+
+void TestCallbackCanReschedule() {
+    kabot::TimerService timers;
+    std::atomic<int> ticks{0};
+    std::function<void()> tick = [&] {
+        if (ticks.fetch_add(1) < 2) {
+            timers.ScheduleAfter(std::chrono::milliseconds(5), tick);
+        }
+    };
+    timers.ScheduleAfter(std::chrono::milliseconds(5), tick);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Expect(ticks.load() == 3, "expected a callback to schedule follow-up timers");
+}
+
+}  // namespace
+
+int main() {
+    TestFiresInDeadlineOrder();
+    TestCancelBeforeDeadline();
+    TestCancelWaitsForRunningCallback();
+    TestScopedTimerCancelsOnExit();
+    TestCallbackCanReschedule();
+    std::cout << "timer_service_tests passed" << std::endl;
+    return 0;
+}
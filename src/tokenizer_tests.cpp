@@ -0,0 +1,147 @@
+#include "agent/context_builder.hpp"
+#include "agent/tokenizer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[tokenizer_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+std::filesystem::path MakeWorkspace(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto dir = std::filesystem::temp_directory_path() / ("kabot_tokenizer_" + name + "_" + std::to_string(stamp));
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+std::string EncodeBase64(const std::string& input) {
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    int buffer = 0;
+    int bits = 0;
+    for (const char ch : input) {
+        buffer = (buffer << 8) | static_cast<unsigned char>(ch);
+        bits += 8;
+        while (bits >= 6) {
+            bits -= 6;
+            out.push_back(alphabet[(buffer >> bits) & 0x3F]);
+        }
+    }
+    if (bits > 0) {
+        out.push_back(alphabet[(buffer << (6 - bits)) & 0x3F]);
+    }
+    while (out.size() % 4 != 0) {
+        out.push_back('=');
+    }
+    return out;
+}
+
+// Every single byte plus a handful of merges, in tiktoken file format.
+std::filesystem::path WriteVocabulary(const std::filesystem::path& dir) {
+    const auto path = dir / "tiny.tiktoken";
+    std::ofstream file(path, std::ios::trunc);
+    int rank = 0;
+    for (int byte = 0; byte < 256; ++byte) {
+        file << EncodeBase64(std::string(1, static_cast<char>(byte))) << ' ' << rank++ << '\n';
+    }
+    for (const char* merge : {"he", "ll", "llo", "hello"}) {
+        file << EncodeBase64(merge) << ' ' << rank++ << '\n';
+    }
+    return path;
+}
+
+kabot::providers::Message MakeMessage(const std::string& role, const std::string& content) {
+    kabot::providers::Message msg{};
+    msg.role = role;
+    msg.content = content;
+    return msg;
+}
+
+void TestBpeMergesByRank() {
+    const auto workspace = MakeWorkspace("bpe");
+    kabot::agent::Tokenizer tokenizer;
+    Expect(tokenizer.LoadVocabulary(WriteVocabulary(workspace).string()), "expected vocabulary to load");
+    Expect(tokenizer.HasVocabulary(), "expected vocabulary to be present");
+    Expect(tokenizer.Count("hello") == 1, "expected a whole-token piece to count once");
+    Expect(tokenizer.Count("helloo") == 2, "expected merges to apply in rank order");
+    Expect(tokenizer.Count("hi there") == 7, "expected pieces to be split before merging");
+    Expect(tokenizer.Count("") == 0, "expected empty text to count zero");
+}
+
+void TestEstimateCountsCjkPerCharacter() {
+    kabot::agent::Tokenizer tokenizer;
+    Expect(!tokenizer.HasVocabulary(), "expected no vocabulary by default");
+    Expect(tokenizer.Count("abcdefgh") == 2, "expected ascii to estimate at four bytes per token");
+    Expect(tokenizer.Count("\xE4\xBD\xA0\xE5\xA5\xBD\xE4\xB8\x96\xE7\x95\x8C") == 4,
+           "expected each CJK character to count as a token");
+}
+
+void TestProjectionKeepsNewestTurnsWithinBudget() {
+    const auto workspace = MakeWorkspace("budget");
+    kabot::agent::ContextBuilder context(workspace.string(), kabot::config::QmdConfig{});
+
+    std::vector<kabot::providers::Message> messages;
+    messages.push_back(MakeMessage("system", "system prompt"));
+    for (int turn = 0; turn < 6; ++turn) {
+        messages.push_back(MakeMessage("user", "turn " + std::to_string(turn) + std::string(400, 'u')));
+        messages.push_back(MakeMessage("assistant", std::string(400, 'a')));
+    }
+    messages.push_back(MakeMessage("user", "current question"));
+    context.AnnotateTokenCounts(messages);
+    Expect(messages[1].token_count > 0, "expected counts to be annotated");
+
+    const auto full = context.EstimateTokens(messages);
+    const auto projected = context.ProjectMessages(messages, 500);
+    Expect(context.EstimateTokens(projected) <= 500, "expected projection to fit the budget");
+    Expect(projected.front().role == "system", "expected system prompt to be kept");
+    Expect(projected.back().content == "current question", "expected current turn to be kept");
+    Expect(projected.size() == 6, "expected the two newest whole turns to fit");
+    Expect(projected[1].content.rfind("turn 4", 0) == 0, "expected oldest kept turn to start at a user message");
+
+    const auto unlimited = context.ProjectMessages(messages);
+    Expect(context.EstimateTokens(unlimited) == full, "expected no budget to keep everything");
+}
+
+void TestOversizedCurrentTurnTruncatesToolResults() {
+    const auto workspace = MakeWorkspace("oversized");
+    kabot::agent::ContextBuilder context(workspace.string(), kabot::config::QmdConfig{});
+
+    std::vector<kabot::providers::Message> messages;
+    messages.push_back(MakeMessage("system", "system prompt"));
+    messages.push_back(MakeMessage("user", "read the log"));
+    auto call = MakeMessage("assistant", "");
+    call.tool_calls.push_back({"call_1", "read_file", {{"path", "app.log"}}});
+    messages.push_back(call);
+    auto result = MakeMessage("tool", std::string(40000, 'x'));
+    result.tool_call_id = "call_1";
+    result.name = "read_file";
+    messages.push_back(result);
+    context.AnnotateTokenCounts(messages);
+
+    const auto projected = context.ProjectMessages(messages, 2000);
+    Expect(projected.size() == 4, "expected the current turn to be kept whole");
+    Expect(context.EstimateTokens(projected) <= 2000, "expected truncation to reach the budget");
+    Expect(projected[3].content.find("[truncated") != std::string::npos, "expected tool result to be truncated");
+}
+
+}  // namespace
+
+int main() {
+    TestBpeMergesByRank();
+    TestEstimateCountsCjkPerCharacter();
+    TestProjectionKeepsNewestTurnsWithinBudget();
+    TestOversizedCurrentTurnTruncatesToolResults();
+    std::cout << "tokenizer_tests passed" << std::endl;
+    return 0;
+}
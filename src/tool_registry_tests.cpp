@@ -0,0 +1,92 @@
+#include "agent/tools/tool_registry.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+namespace {
+
+void Expect(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << "[tool_registry_tests] " << message << std::endl;
+        std::exit(1);
+    }
+}
+
+class FakeTool : public kabot::agent::tools::Tool {
+public:
+    FakeTool(std::string name, std::string schema)
+        : name_(std::move(name)), schema_(std::move(schema)) {}
+
+    std::string Name() const override { return name_; }
+    std::string Description() const override { return "fake " + name_; }
+    std::string ParametersJson() const override { return schema_; }
+    std::string Execute(const std::unordered_map<std::string, std::string>&) override { return "ok"; }
+
+private:
+    std::string name_;
+    std::string schema_;
+};
+
+constexpr const char* kSchema = R"({
+    "type": "object",
+    "properties": {
+        "path": {"type": "string"},
+        "limit": {"type": "integer"},
+        "mode": {"type": "string", "enum": ["fast", "slow"]},
+        "paths": {"type": "array"},
+        "recursive": {"type": "boolean"}
+    },
+    "required": ["path"]
+})";
+
+void TestDefinitionsAreSortedAndPrecompiled() {
+    kabot::agent::tools::ToolRegistry registry;
+    registry.Register(std::make_unique<FakeTool>("zeta", kSchema));
+    registry.Register(std::make_unique<FakeTool>("alpha", kSchema));
+    registry.Register(std::make_unique<FakeTool>("mid", "not json"));
+
+    const auto& defs = registry.GetDefinitions();
+    Expect(defs.size() == 3, "expected three definitions");
+    Expect(defs[0].name == "alpha" && defs[1].name == "mid" && defs[2].name == "zeta", "expected name order");
+    Expect(defs[0].openai_json && defs[0].anthropic_json, "expected precompiled fragments");
+
+    const auto openai = nlohmann::json::parse(*defs[0].openai_json);
+    Expect(openai["function"]["name"] == "alpha", "expected the openai fragment to carry the name");
+    Expect(openai["function"]["parameters"]["required"][0] == "path", "expected the schema in the openai fragment");
+    const auto anthropic = nlohmann::json::parse(*defs[1].anthropic_json);
+    Expect(anthropic["input_schema"].is_object() && anthropic["input_schema"].empty(),
+           "expected an unparsable schema to compile to an empty object");
+}
+
+void TestExecuteValidatesAgainstCompiledSchema() {
+    kabot::agent::tools::ToolRegistry registry;
+    registry.Register(std::make_unique<FakeTool>("read", kSchema));
+
+    Expect(registry.Execute("read", {{"path", "a.txt"}}) == "ok", "expected valid input to run");
+    Expect(registry.Execute("read", {{"limit", "3"}}).find("missing required parameter 'path'") != std::string::npos,
+           "expected a missing required parameter");
+    Expect(registry.Execute("read", {{"path", "a"}, {"limit", "3x"}}).find("expected type 'integer'") != std::string::npos,
+           "expected integer validation");
+    Expect(registry.Execute("read", {{"path", "a"}, {"mode", "medium"}}).find("invalid enum value") != std::string::npos,
+           "expected enum validation");
+    Expect(registry.Execute("read", {{"path", "a"}, {"paths", "{\"a\":1}"}}).find("expected type 'array'") != std::string::npos,
+           "expected array validation");
+    Expect(registry.Execute("read", {{"path", "a"}, {"paths", "[1, 2"}}).find("expected type 'array'") != std::string::npos,
+           "expected malformed arrays to be rejected");
+    Expect(registry.Execute("read", {{"path", "a"}, {"paths", " [1, 2]"}, {"recursive", "true"}}) == "ok",
+           "expected arrays and booleans to pass");
+    Expect(registry.Execute("missing", {}).find("not found") != std::string::npos, "expected unknown tools to fail");
+}
+
+}  // namespace
+
+int main() {
+    TestDefinitionsAreSortedAndPrecompiled();
+    TestExecuteValidatesAgainstCompiledSchema();
+    std::cout << "tool_registry_tests passed" << std::endl;
+    return 0;
+}
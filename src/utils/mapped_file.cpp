@@ -0,0 +1,109 @@
+#include "utils/mapped_file.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kabot {
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        mapped_ = std::exchange(other.mapped_, false);
+        size_ = std::exchange(other.size_, 0);
+        buffer_ = std::move(other.buffer_);
+        data_ = mapped_ ? std::exchange(other.data_, nullptr) : buffer_.data();
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
+void MappedFile::Close() {
+#if !defined(_WIN32)
+    if (mapped_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    buffer_.clear();
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+    Close();
+#if !defined(_WIN32)
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (size < kMapThreshold) {
+        // A private copy cannot be invalidated by a concurrent truncate.
+        buffer_.resize(size);
+        std::size_t filled = 0;
+        bool failed = false;
+        while (filled < size) {
+            const auto n = ::read(fd, buffer_.data() + filled, size - filled);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            failed = n < 0;
+            if (n <= 0) {
+                break;  // error, or the file shrank since fstat
+            }
+            filled += static_cast<std::size_t>(n);
+        }
+        ::close(fd);
+        if (failed) {
+            buffer_.clear();
+            return false;
+        }
+        buffer_.resize(filled);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return true;
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data != MAP_FAILED) {
+        data_ = static_cast<const char*>(data);
+        size_ = size;
+        mapped_ = true;
+        return true;
+    }
+#endif
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        return false;
+    }
+    std::ostringstream stream;
+    stream << input.rdbuf();
+    buffer_ = stream.str();
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+}
+
+}  // namespace kabot
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace kabot {
+
+// Read-only view of a whole file. Files of at least kMapThreshold bytes are
+// memory-mapped where the platform allows, so they are paged in on demand
+// instead of copied; smaller ones are read into memory. A mapping faults
+// with SIGBUS if the file is truncated underneath it, so keep mapped
+// instances for the duration of one operation only.
+class MappedFile {
+public:
+    static constexpr std::size_t kMapThreshold = 1024 * 1024;
+
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false when the file cannot be opened or mapped.
+    bool Open(const std::filesystem::path& path);
+    void Close();
+
+    std::string_view View() const { return {data_, size_}; }
+    std::size_t Size() const { return size_; }
+    bool Mapped() const { return mapped_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;  // used when the file is read instead of mapped
+};
+
+}  // namespace kabot
@@ -0,0 +1,111 @@
+#include "utils/timer_service.hpp"
+
+#include <exception>
+
+#include "utils/logging.hpp"
+
+namespace kabot {
+
+TimerService::TimerService()
+    : thread_([this] { Run(); }) {}
+
+TimerService::~TimerService() {
+    Stop();
+}
+
+TimerService& TimerService::Shared() {
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerId TimerService::ScheduleAt(Clock::time_point deadline, Callback callback) {
+    TimerId id = 0;
+    bool earliest = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return 0;
+        }
+        id = next_id_++;
+        auto position = queue_.emplace(deadline, id);
+        earliest = position == queue_.begin();
+        timers_.emplace(id, Entry{position, std::move(callback)});
+    }
+    if (earliest) {
+        cv_.notify_one();
+    }
+    return id;
+}
+
+TimerService::TimerId TimerService::ScheduleAfter(Clock::duration delay, Callback callback) {
+    return ScheduleAt(Clock::now() + delay, std::move(callback));
+}
+
+bool TimerService::Cancel(TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = timers_.find(id);
+    if (it != timers_.end()) {
+        queue_.erase(it->second.position);
+        timers_.erase(it);
+        return true;
+    }
+    if (running_id_ == id && std::this_thread::get_id() != thread_.get_id()) {
+        done_cv_.wait(lock, [this, id] { return running_id_ != id; });
+    }
+    return false;
+}
+
+std::size_t TimerService::PendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+void TimerService::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.clear();
+    timers_.clear();
+}
+
+void TimerService::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (queue_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        const auto deadline = queue_.begin()->first;
+        if (Clock::now() < deadline) {
+            cv_.wait_until(lock, deadline);
+            continue;
+        }
+        const auto id = queue_.begin()->second;
+        queue_.erase(queue_.begin());
+        auto node = timers_.extract(id);
+        running_id_ = id;
+        lock.unlock();
+        try {
+            node.mapped().callback();
+        } catch (const std::exception& ex) {
+            LOG_ERROR("[timer] callback failed timer_id={} error={}", id, ex.what());
+        } catch (...) {
+            LOG_ERROR("[timer] callback failed timer_id={}", id);
+        }
+        node = {};
+        lock.lock();
+        running_id_ = 0;
+        done_cv_.notify_all();
+    }
+}
+
+}  // namespace kabot
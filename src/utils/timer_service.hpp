@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace kabot {
+
+// One thread and a deadline-ordered queue for every timer in the process.
+// Callbacks run on the timer thread and must stay short; anything that
+// blocks should hand itself off to a pool.
+class TimerService {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+    using Callback = std::function<void()>;
+
+    TimerService();
+    ~TimerService();
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    static TimerService& Shared();
+
+    TimerId ScheduleAt(Clock::time_point deadline, Callback callback);
+    TimerId ScheduleAfter(Clock::duration delay, Callback callback);
+    // Returns true when the timer had not fired yet. If its callback is
+    // running on another thread, waits for it to finish, so state the
+    // callback touches may be released as soon as this returns.
+    bool Cancel(TimerId id);
+    std::size_t PendingCount() const;
+    void Stop();
+
+private:
+    using Queue = std::multimap<Clock::time_point, TimerId>;
+    struct Entry {
+        Queue::iterator position;
+        Callback callback;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_cv_;
+    Queue queue_;
+    std::unordered_map<TimerId, Entry> timers_;
+    TimerId next_id_ = 1;
+    TimerId running_id_ = 0;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    void Run();
+};
+
+// Cancels its timer when it goes out of scope.
+class ScopedTimer {
+public:
+    ScopedTimer() = default;
+    ScopedTimer(TimerService& service, TimerService::TimerId id)
+        : service_(&service)
+        , id_(id) {}
+    ~ScopedTimer() { Cancel(); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ScopedTimer(ScopedTimer&& other) noexcept
+        : service_(std::exchange(other.service_, nullptr))
+        , id_(std::exchange(other.id_, 0)) {}
+    ScopedTimer& operator=(ScopedTimer&& other) noexcept {
+        if (this != &other) {
+            Cancel();
+            service_ = std::exchange(other.service_, nullptr);
+            id_ = std::exchange(other.id_, 0);
+        }
+        return *this;
+    }
+
+    void Cancel() {
+        if (service_ && id_ != 0) {
+            service_->Cancel(id_);
+        }
+        service_ = nullptr;
+        id_ = 0;
+    }
+
+private:
+    TimerService* service_ = nullptr;
+    TimerService::TimerId id_ = 0;
+};
+
+}  // namespace kabot